@@ -0,0 +1,376 @@
+#include <string.h>
+
+#include "acpi.h"
+#include "paging.h"
+#include "system.h"
+#include "utils.h"
+
+namespace
+{
+
+/// Root System Description Pointer
+struct Rsdp
+{
+    char signature[8];
+    uint8_t checksum;
+    char oemId[6];
+    uint8_t revision;
+    uint32_t rsdtAddr;
+
+    // ACPI 2.0 and later
+    uint32_t length;
+    uint64_t xsdtAddr;
+    uint8_t extendedChecksum;
+    uint8_t reserved[3];
+} __attribute__((packed));
+
+/// the size of the ACPI 1.0 part of the RSDP, which the checksum covers
+constexpr size_t RSDP_V1_SIZE = 20;
+
+struct TableHeader
+{
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oemId[6];
+    char oemTableId[8];
+    uint32_t oemRevision;
+    uint32_t creatorId;
+    uint32_t creatorRevision;
+} __attribute__((packed));
+
+struct MadtHeader
+{
+    TableHeader header;
+    uint32_t localApicAddr;
+    uint32_t flags;
+} __attribute__((packed));
+
+constexpr uint32_t MADT_PCAT_COMPAT = 0x1;
+
+struct MadtEntryHeader
+{
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed));
+
+enum MadtEntryType : uint8_t
+{
+    eLocalApic               = 0,
+    eIoApic                  = 1,
+    eInterruptSourceOverride = 2,
+    eLocalApicAddrOverride   = 5,
+};
+
+struct MadtLocalApic
+{
+    MadtEntryHeader header;
+    uint8_t processorId;
+    uint8_t apicId;
+    uint32_t flags;
+} __attribute__((packed));
+
+constexpr uint32_t LOCAL_APIC_ENABLED = 0x1;
+
+struct MadtIoApic
+{
+    MadtEntryHeader header;
+    uint8_t ioApicId;
+    uint8_t reserved;
+    uint32_t ioApicAddr;
+    uint32_t gsiBase;
+} __attribute__((packed));
+
+struct MadtInterruptSourceOverride
+{
+    MadtEntryHeader header;
+    uint8_t bus;
+    uint8_t source;
+    uint32_t globalSystemInterrupt;
+    uint16_t flags;
+} __attribute__((packed));
+
+struct MadtLocalApicAddrOverride
+{
+    MadtEntryHeader header;
+    uint16_t reserved;
+    uint64_t localApicAddr;
+} __attribute__((packed));
+
+/// tables above this address can't be mapped
+constexpr uint64_t MAX_PHYSICAL_ADDR = 0xFFFF'FFFF;
+
+/// the largest table that is mapped
+constexpr size_t MAX_TABLE_SIZE = 16 * PAGE_SIZE;
+
+/**
+ * @brief Maps physical memory in the kernel's page table while it is in
+ * scope. ACPI tables can be anywhere in memory.
+ */
+class PhysicalMapping
+{
+public:
+    PhysicalMapping(uint32_t physicalAddr, size_t size)
+    {
+        uint32_t startPageAddr = align(physicalAddr, PAGE_SIZE, false);
+        uint32_t endPageAddr = align(physicalAddr + size, PAGE_SIZE);
+        numPages = (endPageAddr - startPageAddr) / PAGE_SIZE;
+
+        uint32_t virtualAddr = 0;
+        if (mapPages((KERNEL_VIRTUAL_BASE >> 22), getKernelPageTableStart(), virtualAddr, startPageAddr, numPages))
+        {
+            startVirtualAddr = virtualAddr;
+            ptr = reinterpret_cast<const uint8_t*>(virtualAddr + (physicalAddr - startPageAddr));
+        }
+        else
+        {
+            startVirtualAddr = 0;
+            ptr = nullptr;
+        }
+    }
+
+    ~PhysicalMapping()
+    {
+        if (ptr != nullptr)
+        {
+            for (size_t i = 0; i < numPages; ++i)
+            {
+                unmapPage(getKernelPageTableStart(), startVirtualAddr + i * PAGE_SIZE);
+            }
+        }
+    }
+
+    PhysicalMapping(const PhysicalMapping&) = delete;
+
+    PhysicalMapping& operator=(const PhysicalMapping&) = delete;
+
+    /**
+     * @brief Get the mapped memory, or nullptr if it could not be mapped.
+     */
+    const uint8_t* get() const
+    {
+        return ptr;
+    }
+
+private:
+    uint32_t startVirtualAddr;
+    size_t numPages;
+    const uint8_t* ptr;
+};
+
+bool isChecksumValid(const uint8_t* data, size_t size)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        sum += data[i];
+    }
+
+    return sum == 0;
+}
+
+/**
+ * @brief Search for the RSDP on 16-byte boundaries in a range of the first
+ * MiB of memory, which is mapped at KERNEL_VIRTUAL_BASE.
+ */
+const Rsdp* findRsdp(uint32_t startAddr, uint32_t endAddr)
+{
+    for (uint32_t addr = startAddr; addr + RSDP_V1_SIZE <= endAddr; addr += 16)
+    {
+        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(addr + KERNEL_VIRTUAL_BASE);
+        if (memcmp(ptr, "RSD PTR ", 8) == 0 && isChecksumValid(ptr, RSDP_V1_SIZE))
+        {
+            return reinterpret_cast<const Rsdp*>(ptr);
+        }
+    }
+
+    return nullptr;
+}
+
+const Rsdp* findRsdp()
+{
+    // the RSDP is either in the first KiB of the Extended BIOS Data Area,
+    // whose segment is in the BIOS Data Area, or in the BIOS ROM
+    uint32_t ebdaAddr = *reinterpret_cast<const uint16_t*>(0x40E + KERNEL_VIRTUAL_BASE) << 4;
+
+    const Rsdp* rsdp = nullptr;
+    if (ebdaAddr >= 0x80000 && ebdaAddr < 0xA0000)
+    {
+        rsdp = findRsdp(ebdaAddr, ebdaAddr + 1024);
+    }
+
+    if (rsdp == nullptr)
+    {
+        rsdp = findRsdp(0xE0000, 0x100000);
+    }
+
+    return rsdp;
+}
+
+/**
+ * @brief Get the length of the table at a physical address.
+ * @return the table's length, or 0 if it can't be read
+ */
+uint32_t getTableLength(uint32_t tableAddr)
+{
+    PhysicalMapping mapping(tableAddr, sizeof(TableHeader));
+    if (mapping.get() == nullptr)
+    {
+        return 0;
+    }
+
+    uint32_t length = reinterpret_cast<const TableHeader*>(mapping.get())->length;
+    if (length < sizeof(TableHeader) || length > MAX_TABLE_SIZE)
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Get the address of the table with a signature from the RSDT (4-byte
+ * entries) or XSDT (8-byte entries).
+ * @return the table's physical address, or 0 if it was not found
+ */
+uint32_t findTable(uint32_t sdtAddr, size_t entrySize, const char* signature)
+{
+    uint32_t sdtLength = getTableLength(sdtAddr);
+    if (sdtLength == 0)
+    {
+        return 0;
+    }
+
+    PhysicalMapping sdtMapping(sdtAddr, sdtLength);
+    const uint8_t* sdt = sdtMapping.get();
+    if (sdt == nullptr || !isChecksumValid(sdt, sdtLength))
+    {
+        return 0;
+    }
+
+    size_t numEntries = (sdtLength - sizeof(TableHeader)) / entrySize;
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        const uint8_t* entry = sdt + sizeof(TableHeader) + i * entrySize;
+
+        uint64_t tableAddr = 0;
+        memcpy(&tableAddr, entry, entrySize);
+        if (tableAddr == 0 || tableAddr > MAX_PHYSICAL_ADDR)
+        {
+            continue;
+        }
+
+        PhysicalMapping tableMapping(static_cast<uint32_t>(tableAddr), sizeof(TableHeader));
+        const TableHeader* header = reinterpret_cast<const TableHeader*>(tableMapping.get());
+        if (header != nullptr && memcmp(header->signature, signature, 4) == 0)
+        {
+            return static_cast<uint32_t>(tableAddr);
+        }
+    }
+
+    return 0;
+}
+
+void parseMadt(const uint8_t* madt, uint32_t length, MadtInfo& info)
+{
+    const MadtHeader* header = reinterpret_cast<const MadtHeader*>(madt);
+    info.localApicAddr = header->localApicAddr;
+    info.hasPic = (header->flags & MADT_PCAT_COMPAT) != 0;
+
+    uint32_t offset = sizeof(MadtHeader);
+    while (offset + sizeof(MadtEntryHeader) <= length)
+    {
+        const MadtEntryHeader* entry = reinterpret_cast<const MadtEntryHeader*>(madt + offset);
+        if (entry->length < sizeof(MadtEntryHeader) || offset + entry->length > length)
+        {
+            break;
+        }
+
+        if (entry->type == eLocalApic && entry->length >= sizeof(MadtLocalApic))
+        {
+            const MadtLocalApic* localApic = reinterpret_cast<const MadtLocalApic*>(entry);
+            if ( (localApic->flags & LOCAL_APIC_ENABLED) != 0 && info.numCpus < MadtInfo::MAX_NUM_CPUS )
+            {
+                info.cpuApicIds[info.numCpus++] = localApic->apicId;
+            }
+        }
+        else if (entry->type == eIoApic && entry->length >= sizeof(MadtIoApic))
+        {
+            // the first I/O APIC has the ISA IRQs
+            const MadtIoApic* ioApic = reinterpret_cast<const MadtIoApic*>(entry);
+            if (info.ioApicAddr == 0 || ioApic->gsiBase < info.ioApicGsiBase)
+            {
+                info.ioApicAddr = ioApic->ioApicAddr;
+                info.ioApicGsiBase = ioApic->gsiBase;
+            }
+        }
+        else if (entry->type == eInterruptSourceOverride && entry->length >= sizeof(MadtInterruptSourceOverride))
+        {
+            const MadtInterruptSourceOverride* irqOverride = reinterpret_cast<const MadtInterruptSourceOverride*>(entry);
+            if (info.numIrqOverrides < MadtInfo::MAX_NUM_IRQ_OVERRIDES)
+            {
+                MadtInfo::IrqOverride& infoOverride = info.irqOverrides[info.numIrqOverrides++];
+                infoOverride.irq = irqOverride->source;
+                infoOverride.globalSystemInterrupt = irqOverride->globalSystemInterrupt;
+                infoOverride.flags = irqOverride->flags;
+            }
+        }
+        else if (entry->type == eLocalApicAddrOverride && entry->length >= sizeof(MadtLocalApicAddrOverride))
+        {
+            const MadtLocalApicAddrOverride* addrOverride = reinterpret_cast<const MadtLocalApicAddrOverride*>(entry);
+            if (addrOverride->localApicAddr <= MAX_PHYSICAL_ADDR)
+            {
+                info.localApicAddr = static_cast<uint32_t>(addrOverride->localApicAddr);
+            }
+        }
+
+        offset += entry->length;
+    }
+}
+
+} // anonymous namespace
+
+bool readMadt(MadtInfo& info)
+{
+    memset(&info, 0, sizeof(info));
+
+    const Rsdp* rsdp = findRsdp();
+    if (rsdp == nullptr)
+    {
+        return false;
+    }
+
+    // use the XSDT if the RSDT isn't there
+    uint32_t madtAddr = 0;
+    if (rsdp->rsdtAddr != 0)
+    {
+        madtAddr = findTable(rsdp->rsdtAddr, sizeof(uint32_t), "APIC");
+    }
+    else if (rsdp->revision >= 2 && rsdp->xsdtAddr != 0 && rsdp->xsdtAddr <= MAX_PHYSICAL_ADDR)
+    {
+        madtAddr = findTable(static_cast<uint32_t>(rsdp->xsdtAddr), sizeof(uint64_t), "APIC");
+    }
+
+    if (madtAddr == 0)
+    {
+        return false;
+    }
+
+    uint32_t madtLength = getTableLength(madtAddr);
+    if (madtLength < sizeof(MadtHeader))
+    {
+        return false;
+    }
+
+    PhysicalMapping madtMapping(madtAddr, madtLength);
+    const uint8_t* madt = madtMapping.get();
+    if (madt == nullptr || !isChecksumValid(madt, madtLength))
+    {
+        return false;
+    }
+
+    parseMadt(madt, madtLength, info);
+
+    return true;
+}
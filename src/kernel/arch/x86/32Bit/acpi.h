@@ -0,0 +1,63 @@
+#ifndef ACPI_H_
+#define ACPI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The interrupt controllers and processors described by the ACPI
+ * Multiple APIC Description Table (MADT).
+ */
+struct MadtInfo
+{
+    static constexpr unsigned int MAX_NUM_CPUS = 16;
+    static constexpr unsigned int MAX_NUM_IRQ_OVERRIDES = 16;
+
+    // interrupt override flags (MPS INTI flags)
+    static constexpr uint16_t POLARITY_MASK        = 0x0003;
+    static constexpr uint16_t POLARITY_ACTIVE_HIGH = 0x0001;
+    static constexpr uint16_t POLARITY_ACTIVE_LOW  = 0x0003;
+    static constexpr uint16_t TRIGGER_MASK         = 0x000C;
+    static constexpr uint16_t TRIGGER_EDGE         = 0x0004;
+    static constexpr uint16_t TRIGGER_LEVEL        = 0x000C;
+
+    /**
+     * @brief An ISA IRQ that is not connected to the I/O APIC input with
+     * the same number, or whose polarity or trigger mode is not the ISA
+     * default (active high, edge triggered).
+     */
+    struct IrqOverride
+    {
+        uint8_t irq;
+        uint32_t globalSystemInterrupt;
+        uint16_t flags;
+    };
+
+    /// physical address of the local APICs' registers
+    uint32_t localApicAddr;
+
+    /// whether the system also has 8259 PICs
+    bool hasPic;
+
+    /// physical address of the first I/O APIC's registers (0 if there is
+    /// none)
+    uint32_t ioApicAddr;
+
+    /// the global system interrupt of the first I/O APIC's first input
+    uint32_t ioApicGsiBase;
+
+    /// local APIC IDs of the enabled processors
+    uint8_t cpuApicIds[MAX_NUM_CPUS];
+    unsigned int numCpus;
+
+    IrqOverride irqOverrides[MAX_NUM_IRQ_OVERRIDES];
+    unsigned int numIrqOverrides;
+};
+
+/**
+ * @brief Find the MADT and read the parts of it the kernel uses.
+ * @return true if the MADT was found; false, otherwise
+ */
+bool readMadt(MadtInfo& info);
+
+#endif // ACPI_H_
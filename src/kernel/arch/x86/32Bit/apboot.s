@@ -0,0 +1,92 @@
+; apboot.s
+; The code that application processors run when they are started. A startup
+; IPI starts a processor in real mode at a page below 1 MiB, so the code
+; between apTrampolineStart and apTrampolineEnd is copied to
+; AP_TRAMPOLINE_ADDR. It switches to protected mode, turns on paging with
+; the kernel's page directory, and calls apMain() on the processor's stack.
+
+; the physical address the trampoline is copied to (must match
+; Cpu::TRAMPOLINE_ADDR)
+AP_TRAMPOLINE_ADDR equ 0x7000
+
+; the address of a trampoline label once the trampoline is copied
+%define TRAMPOLINE_REL(label) (AP_TRAMPOLINE_ADDR + (label) - apTrampolineStart)
+
+KERNEL_CODE_SEGMENT_SELECTOR equ 0x08
+KERNEL_DATA_SEGMENT_SELECTOR equ 0x10
+
+CR0_PROTECTED_MODE equ 0x00000001
+CR0_PAGING         equ 0x80000000
+
+; defined in cpu.cpp
+extern apMain
+
+section .text
+
+global apTrampolineStart
+global apTrampolineEnd
+global apTrampolineParams
+
+; processors start in real mode
+[BITS 16]
+apTrampolineStart:
+	cli
+	cld
+
+	xor ax, ax
+	mov ds, ax
+
+	; load a flat GDT and switch to protected mode
+	lgdt [TRAMPOLINE_REL(trampolineGdtPtr)]
+	mov eax, cr0
+	or eax, CR0_PROTECTED_MODE
+	mov cr0, eax
+
+	jmp dword KERNEL_CODE_SEGMENT_SELECTOR:TRAMPOLINE_REL(.protectedMode)
+
+[BITS 32]
+.protectedMode:
+	mov ax, KERNEL_DATA_SEGMENT_SELECTOR
+	mov ds, ax
+	mov es, ax
+	mov fs, ax
+	mov gs, ax
+	mov ss, ax
+
+	; the page directory identity maps the trampoline while processors
+	; start, so execution continues here once paging is on
+	mov eax, [TRAMPOLINE_REL(apTrampolineParams.pageDir)]
+	mov cr3, eax
+	mov eax, cr0
+	or eax, CR0_PAGING
+	mov cr0, eax
+
+	; switch to the processor's kernel stack and jump to the higher half
+	mov esp, [TRAMPOLINE_REL(apTrampolineParams.stack)]
+	push dword [TRAMPOLINE_REL(apTrampolineParams.cpu)]
+	mov ecx, apMain
+	call ecx
+
+.Linfinite:					; apMain() doesn't return
+	cli
+	hlt
+	jmp .Linfinite
+
+align 8
+trampolineGdt:
+	dq 0					; null segment
+	dq 0x00CF9A000000FFFF	; kernel code segment
+	dq 0x00CF92000000FFFF	; kernel data segment
+
+trampolineGdtPtr:
+	dw (trampolineGdtPtr - trampolineGdt - 1)
+	dd TRAMPOLINE_REL(trampolineGdt)
+
+; set by the boot processor before it starts each processor (see
+; Cpu::TrampolineParams)
+align 4
+apTrampolineParams:
+.pageDir:	dd 0			; physical address of the page directory
+.stack:		dd 0			; the processor's kernel stack
+.cpu:		dd 0			; the processor's Cpu
+apTrampolineEnd:
@@ -0,0 +1,299 @@
+#include "apic.h"
+#include "paging.h"
+#include "system.h"
+
+bool Apic::enabled = false;
+MadtInfo Apic::madtInfo;
+volatile uint32_t* Apic::localApic = nullptr;
+volatile uint32_t* Apic::ioApic = nullptr;
+unsigned int Apic::numIoApicInputs = 0;
+uint32_t Apic::irqInputs[NUM_ISA_IRQS];
+
+bool Apic::init(uint8_t irqBaseVector)
+{
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if ( (edx & CPUID_APIC) == 0 )
+    {
+        return false;
+    }
+
+    if (!readMadt(madtInfo) || madtInfo.ioApicAddr == 0 || madtInfo.localApicAddr == 0)
+    {
+        return false;
+    }
+
+    localApic = mapRegisters(madtInfo.localApicAddr);
+    ioApic = mapRegisters(madtInfo.ioApicAddr);
+    if (localApic == nullptr || ioApic == nullptr)
+    {
+        return false;
+    }
+
+    numIoApicInputs = ((readIoApic(IOAPIC_VER) >> 16) & 0xFF) + 1;
+
+    routeIrqs(irqBaseVector);
+
+    initLocal();
+
+    enabled = true;
+
+    return true;
+}
+
+void Apic::initLocal()
+{
+    // the firmware may have disabled the local APIC
+    uint64_t apicBase = readMsr(MSR_APIC_BASE);
+    if ( (apicBase & MSR_APIC_BASE_ENABLE) == 0 )
+    {
+        writeMsr(MSR_APIC_BASE, apicBase | MSR_APIC_BASE_ENABLE);
+    }
+
+    // in virtual wire mode, the PIC's interrupts arrive on LINT0
+    writeLocal(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+
+    // accept every priority and enable the local APIC
+    writeLocal(LAPIC_TPR, 0);
+    writeLocal(LAPIC_SVR, LAPIC_SVR_ENABLE | SPURIOUS_VECTOR);
+}
+
+bool Apic::isEnabled()
+{
+    return enabled;
+}
+
+void Apic::sendEoi()
+{
+    writeLocal(LAPIC_EOI, 0);
+}
+
+bool Apic::isInService()
+{
+    // vectors 0-31 are exceptions, which are never in service
+    for (unsigned int i = 1; i < LAPIC_NUM_ISRS; ++i)
+    {
+        if (readLocal(LAPIC_ISR + i * 0x10) != 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Apic::setIrqMasked(uint8_t irq, bool masked)
+{
+    if (irq >= NUM_ISA_IRQS || irqInputs[irq] == NO_GSI)
+    {
+        return;
+    }
+
+    uint8_t reg = IOAPIC_REDTBL + 2 * irqInputs[irq];
+
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    uint32_t entry = readIoApic(reg);
+    if (masked)
+    {
+        entry |= REDTBL_MASKED;
+    }
+    else
+    {
+        entry &= ~REDTBL_MASKED;
+    }
+    writeIoApic(reg, entry);
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+}
+
+void Apic::startTimer(uint32_t initialCount, uint8_t vector, bool masked)
+{
+    writeLocal(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    writeLocal(LAPIC_LVT_TIMER, vector | (masked ? LAPIC_LVT_MASKED : 0));
+    writeLocal(LAPIC_TIMER_INITIAL_COUNT, initialCount);
+}
+
+void Apic::stopTimer()
+{
+    writeLocal(LAPIC_TIMER_INITIAL_COUNT, 0);
+}
+
+uint32_t Apic::getTimerCount()
+{
+    return readLocal(LAPIC_TIMER_CURRENT_COUNT);
+}
+
+uint8_t Apic::getLocalApicId()
+{
+    return static_cast<uint8_t>(readLocal(LAPIC_ID) >> 24);
+}
+
+void Apic::sendInitIpi(uint8_t apicId)
+{
+    sendIpi(apicId, LAPIC_ICR_INIT | LAPIC_ICR_ASSERT);
+}
+
+void Apic::sendStartupIpi(uint8_t apicId, uint8_t vector)
+{
+    sendIpi(apicId, LAPIC_ICR_STARTUP | LAPIC_ICR_ASSERT | vector);
+}
+
+void Apic::sendFixedIpi(uint8_t apicId, uint8_t vector)
+{
+    sendIpi(apicId, LAPIC_ICR_ASSERT | vector);
+}
+
+const MadtInfo& Apic::getMadtInfo()
+{
+    return madtInfo;
+}
+
+volatile uint32_t* Apic::mapRegisters(uint32_t physicalAddr)
+{
+    uint32_t* pageTable = getKernelPageTableStart();
+    uint32_t virtualAddr = 0;
+    if (!mapPages((KERNEL_VIRTUAL_BASE >> 22), pageTable, virtualAddr, physicalAddr & PAGE_BOUNDARY_MASK, 1))
+    {
+        return nullptr;
+    }
+
+    // device registers must not be cached
+    pageTable[(virtualAddr >> 12) & PAGE_TABLE_INDEX_MASK] |= PAGE_TABLE_CACHE_DISABLE | PAGE_TABLE_WRITE_THROUGH;
+    invalidatePage(virtualAddr);
+
+    return reinterpret_cast<volatile uint32_t*>(virtualAddr + (physicalAddr & PAGE_SIZE_MASK));
+}
+
+uint32_t Apic::readLocal(uint32_t offset)
+{
+    return localApic[offset / sizeof(uint32_t)];
+}
+
+void Apic::writeLocal(uint32_t offset, uint32_t value)
+{
+    localApic[offset / sizeof(uint32_t)] = value;
+}
+
+uint32_t Apic::readIoApic(uint8_t reg)
+{
+    ioApic[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+    return ioApic[IOAPIC_WIN / sizeof(uint32_t)];
+}
+
+void Apic::writeIoApic(uint8_t reg, uint32_t value)
+{
+    ioApic[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+    ioApic[IOAPIC_WIN / sizeof(uint32_t)] = value;
+}
+
+void Apic::sendIpi(uint8_t apicId, uint32_t command)
+{
+    // IPIs are also sent without the kernel lock (e.g. by the scheduler),
+    // so an interrupt handler on this processor must not send one between
+    // the two writes
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    // writing the low half sends the IPI
+    writeLocal(LAPIC_ICR_HIGH, static_cast<uint32_t>(apicId) << 24);
+    writeLocal(LAPIC_ICR_LOW, command);
+
+    while ( (readLocal(LAPIC_ICR_LOW) & LAPIC_ICR_DELIVERY_STATUS) != 0 )
+    {
+    }
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+}
+
+void Apic::routeIrqs(uint8_t irqBaseVector)
+{
+    // ISA IRQs are connected to the input with the same number, and are
+    // active high and edge triggered, unless the MADT overrides them
+    uint32_t irqFlags[NUM_ISA_IRQS];
+    bool isOverridden[NUM_ISA_IRQS];
+    for (unsigned int irq = 0; irq < NUM_ISA_IRQS; ++irq)
+    {
+        irqInputs[irq] = irq;
+        irqFlags[irq] = 0;
+        isOverridden[irq] = false;
+    }
+
+    for (unsigned int i = 0; i < madtInfo.numIrqOverrides; ++i)
+    {
+        const MadtInfo::IrqOverride& irqOverride = madtInfo.irqOverrides[i];
+        if (irqOverride.irq >= NUM_ISA_IRQS)
+        {
+            continue;
+        }
+
+        irqInputs[irqOverride.irq] = irqOverride.globalSystemInterrupt;
+        isOverridden[irqOverride.irq] = true;
+
+        if ( (irqOverride.flags & MadtInfo::POLARITY_MASK) == MadtInfo::POLARITY_ACTIVE_LOW )
+        {
+            irqFlags[irqOverride.irq] |= REDTBL_ACTIVE_LOW;
+        }
+
+        if ( (irqOverride.flags & MadtInfo::TRIGGER_MASK) == MadtInfo::TRIGGER_LEVEL )
+        {
+            irqFlags[irqOverride.irq] |= REDTBL_LEVEL;
+        }
+    }
+
+    // an IRQ is not connected if another IRQ was moved to its input (e.g.
+    // IRQ 2 when the timer is on input 2)
+    for (unsigned int irq = 0; irq < NUM_ISA_IRQS; ++irq)
+    {
+        if (!isOverridden[irq])
+        {
+            for (unsigned int other = 0; other < NUM_ISA_IRQS; ++other)
+            {
+                if (isOverridden[other] && irqInputs[other] == irqInputs[irq])
+                {
+                    irqInputs[irq] = NO_GSI;
+                    break;
+                }
+            }
+        }
+    }
+
+    // convert the global system interrupts to input numbers
+    for (unsigned int irq = 0; irq < NUM_ISA_IRQS; ++irq)
+    {
+        uint32_t gsi = irqInputs[irq];
+        if (gsi != NO_GSI)
+        {
+            bool isOnIoApic = gsi >= madtInfo.ioApicGsiBase && gsi - madtInfo.ioApicGsiBase < numIoApicInputs;
+            irqInputs[irq] = isOnIoApic ? gsi - madtInfo.ioApicGsiBase : NO_GSI;
+        }
+    }
+
+    // mask the inputs no ISA IRQ is connected to
+    for (unsigned int input = 0; input < numIoApicInputs; ++input)
+    {
+        writeIoApic(IOAPIC_REDTBL + 2 * input, REDTBL_MASKED);
+    }
+
+    // deliver every IRQ to this processor
+    uint32_t destination = static_cast<uint32_t>(getLocalApicId()) << 24;
+    for (unsigned int irq = 0; irq < NUM_ISA_IRQS; ++irq)
+    {
+        uint32_t input = irqInputs[irq];
+        if (input != NO_GSI)
+        {
+            writeIoApic(IOAPIC_REDTBL + 2 * input + 1, destination);
+            writeIoApic(IOAPIC_REDTBL + 2 * input, REDTBL_MASKED | irqFlags[irq] | (irqBaseVector + irq));
+        }
+    }
+}
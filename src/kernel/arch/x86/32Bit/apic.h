@@ -0,0 +1,219 @@
+#ifndef APIC_H_
+#define APIC_H_
+
+#include <stdint.h>
+
+#include "acpi.h"
+
+/**
+ * @brief The local APIC and the I/O APIC, which deliver IRQs instead of the
+ * 8259 PICs when the ACPI MADT describes them.
+ * @details The I/O APIC routes each ISA IRQ to its own vector on the boot
+ * processor, and the local APIC is acknowledged with a single MMIO write.
+ */
+class Apic
+{
+public:
+    /// vector of the local APIC's spurious interrupts, which must not be
+    /// acknowledged
+    static constexpr uint8_t SPURIOUS_VECTOR = 0xFF;
+
+    /// the number of ISA IRQs that are routed
+    static constexpr unsigned int NUM_ISA_IRQS = 16;
+
+    /// the local APIC timer counts down once every this many bus clocks
+    static constexpr unsigned int TIMER_DIVISOR = 16;
+
+    /**
+     * @brief Find the APICs, enable the local APIC, and route the ISA IRQs
+     * through the I/O APIC. The IRQs are masked until setIrqMasked() is
+     * called. Interrupts must be disabled.
+     * @param irqBaseVector The vector of IRQ 0. IRQ n is delivered on vector
+     * irqBaseVector + n.
+     * @return true if the APICs are in use; false, if the PIC must be used
+     */
+    static bool init(uint8_t irqBaseVector);
+
+    /**
+     * @brief Enable the calling processor's local APIC. init() does this for
+     * the boot processor; application processors call it when they start.
+     */
+    static void initLocal();
+
+    /**
+     * @brief Whether IRQs are delivered by the APICs.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Send an End Of Interrupt (EOI) to the local APIC.
+     */
+    static void sendEoi();
+
+    /**
+     * @brief Whether the local APIC has an interrupt in service (i.e. one
+     * that has not been acknowledged yet).
+     */
+    static bool isInService();
+
+    /**
+     * @brief Mask or unmask an ISA IRQ in the I/O APIC.
+     */
+    static void setIrqMasked(uint8_t irq, bool masked);
+
+    /**
+     * @brief Start the local APIC timer in one-shot mode. It counts down at
+     * the bus clock rate divided by TIMER_DIVISOR and interrupts when it
+     * reaches zero.
+     * @param initialCount The count to start from.
+     * @param vector The vector of the timer interrupt.
+     * @param masked Whether the timer interrupt is masked (e.g. to measure
+     * the timer's rate).
+     */
+    static void startTimer(uint32_t initialCount, uint8_t vector, bool masked = false);
+
+    /**
+     * @brief Stop the local APIC timer.
+     */
+    static void stopTimer();
+
+    /**
+     * @brief Get the local APIC timer's current count.
+     */
+    static uint32_t getTimerCount();
+
+    /**
+     * @brief Get the local APIC ID of the processor that calls this.
+     */
+    static uint8_t getLocalApicId();
+
+    /**
+     * @brief Send an INIT inter-processor interrupt, which resets a
+     * processor and makes it wait for a startup IPI.
+     * @param apicId The local APIC ID of the processor.
+     */
+    static void sendInitIpi(uint8_t apicId);
+
+    /**
+     * @brief Send a startup inter-processor interrupt, which starts a
+     * processor that is waiting after an INIT IPI in real mode.
+     * @param apicId The local APIC ID of the processor.
+     * @param vector The page number of the code the processor runs (i.e.
+     * it starts at physical address vector * 4096).
+     */
+    static void sendStartupIpi(uint8_t apicId, uint8_t vector);
+
+    /**
+     * @brief Send an interrupt to another processor.
+     * @param apicId The local APIC ID of the processor.
+     * @param vector The interrupt vector.
+     */
+    static void sendFixedIpi(uint8_t apicId, uint8_t vector);
+
+    /**
+     * @brief Get the interrupt controllers and processors the MADT
+     * describes.
+     */
+    static const MadtInfo& getMadtInfo();
+
+private:
+    // local APIC register offsets
+    static constexpr uint32_t LAPIC_ID                  = 0x020;
+    static constexpr uint32_t LAPIC_TPR                 = 0x080;
+    static constexpr uint32_t LAPIC_EOI                 = 0x0B0;
+    static constexpr uint32_t LAPIC_SVR                 = 0x0F0;
+    static constexpr uint32_t LAPIC_ISR                 = 0x100;
+    static constexpr uint32_t LAPIC_ICR_LOW             = 0x300;
+    static constexpr uint32_t LAPIC_ICR_HIGH            = 0x310;
+    static constexpr uint32_t LAPIC_LVT_TIMER           = 0x320;
+    static constexpr uint32_t LAPIC_LVT_LINT0           = 0x350;
+    static constexpr uint32_t LAPIC_TIMER_INITIAL_COUNT = 0x380;
+    static constexpr uint32_t LAPIC_TIMER_CURRENT_COUNT = 0x390;
+    static constexpr uint32_t LAPIC_TIMER_DIVIDE        = 0x3E0;
+
+    /// divide configuration register value for TIMER_DIVISOR
+    static constexpr uint32_t LAPIC_TIMER_DIVIDE_BY_16 = 0x3;
+
+    /// the number of 32-bit in-service registers (one bit per vector)
+    static constexpr unsigned int LAPIC_NUM_ISRS = 8;
+
+    // interrupt command register bits
+    static constexpr uint32_t LAPIC_ICR_INIT            = 0x500;
+    static constexpr uint32_t LAPIC_ICR_STARTUP         = 0x600;
+    static constexpr uint32_t LAPIC_ICR_DELIVERY_STATUS = 0x1000;
+    static constexpr uint32_t LAPIC_ICR_ASSERT          = 0x4000;
+
+    /// spurious interrupt vector register bit to enable the local APIC
+    static constexpr uint32_t LAPIC_SVR_ENABLE = 0x100;
+
+    /// local vector table bit to mask an interrupt
+    static constexpr uint32_t LAPIC_LVT_MASKED = 0x10000;
+
+    static constexpr uint32_t MSR_APIC_BASE = 0x1B;
+    static constexpr uint64_t MSR_APIC_BASE_ENABLE = 0x800;
+
+    /// CPUID leaf 1 EDX bit for an on-chip local APIC
+    static constexpr uint32_t CPUID_APIC = 0x200;
+
+    // I/O APIC register offsets
+    static constexpr uint32_t IOAPIC_REGSEL = 0x00;
+    static constexpr uint32_t IOAPIC_WIN    = 0x10;
+
+    // I/O APIC registers
+    static constexpr uint8_t IOAPIC_VER    = 0x01;
+    static constexpr uint8_t IOAPIC_REDTBL = 0x10;
+
+    // redirection table entry bits
+    static constexpr uint32_t REDTBL_ACTIVE_LOW = 0x2000;
+    static constexpr uint32_t REDTBL_LEVEL      = 0x8000;
+    static constexpr uint32_t REDTBL_MASKED     = 0x10000;
+
+    /// marks an IRQ that is not connected to the I/O APIC
+    static constexpr uint32_t NO_GSI = 0xFFFF'FFFF;
+
+    static bool enabled;
+
+    static MadtInfo madtInfo;
+
+    /// the mapped local APIC registers
+    static volatile uint32_t* localApic;
+
+    /// the mapped I/O APIC registers
+    static volatile uint32_t* ioApic;
+
+    /// the number of I/O APIC inputs
+    static unsigned int numIoApicInputs;
+
+    /// the I/O APIC input each ISA IRQ is connected to (relative to the
+    /// I/O APIC's first global system interrupt)
+    static uint32_t irqInputs[NUM_ISA_IRQS];
+
+    /**
+     * @brief Map the registers of an APIC (one uncached page).
+     * @return The registers' virtual address, or nullptr if they could not
+     * be mapped.
+     */
+    static volatile uint32_t* mapRegisters(uint32_t physicalAddr);
+
+    static uint32_t readLocal(uint32_t offset);
+
+    static void writeLocal(uint32_t offset, uint32_t value);
+
+    static uint32_t readIoApic(uint8_t reg);
+
+    static void writeIoApic(uint8_t reg, uint32_t value);
+
+    /**
+     * @brief Send an inter-processor interrupt and wait until the local
+     * APIC has sent it.
+     */
+    static void sendIpi(uint8_t apicId, uint32_t command);
+
+    /**
+     * @brief Find the I/O APIC input and redirection entry flags for each
+     * ISA IRQ, and program the redirection entries (masked).
+     */
+    static void routeIrqs(uint8_t irqBaseVector);
+};
+
+#endif // APIC_H_
@@ -0,0 +1,543 @@
+/**
+ * @brief ATA (IDE) disk driver
+ */
+
+#include "atadriver.h"
+#include "irq.h"
+#include "kernellogger.h"
+#include "pageframemgr.h"
+#include "paging.h"
+#include "pci.h"
+#include "processmgr.h"
+#include "system.h"
+
+namespace
+{
+
+// command block register offsets
+constexpr static uint8_t REG_DATA = 0;
+constexpr static uint8_t REG_SECTOR_COUNT = 2;
+constexpr static uint8_t REG_LBA_LOW = 3;
+constexpr static uint8_t REG_LBA_MID = 4;
+constexpr static uint8_t REG_LBA_HIGH = 5;
+constexpr static uint8_t REG_DRIVE = 6;
+constexpr static uint8_t REG_STATUS = 7;
+constexpr static uint8_t REG_COMMAND = 7;
+
+// status register bits
+constexpr static uint8_t STATUS_ERR = 0x01;
+constexpr static uint8_t STATUS_DRQ = 0x08;
+constexpr static uint8_t STATUS_DF = 0x20;
+constexpr static uint8_t STATUS_BSY = 0x80;
+
+// device control register bits
+constexpr static uint8_t CTRL_NIEN = 0x02;
+
+// drive register bits
+constexpr static uint8_t DRIVE_BASE = 0xA0;
+constexpr static uint8_t DRIVE_LBA = 0x40;
+constexpr static uint8_t DRIVE_SLAVE = 0x10;
+
+// commands
+constexpr static uint8_t COMMAND_READ_PIO = 0x20;
+constexpr static uint8_t COMMAND_WRITE_PIO = 0x30;
+constexpr static uint8_t COMMAND_READ_DMA = 0xC8;
+constexpr static uint8_t COMMAND_WRITE_DMA = 0xCA;
+constexpr static uint8_t COMMAND_FLUSH_CACHE = 0xE7;
+constexpr static uint8_t COMMAND_IDENTIFY = 0xEC;
+
+// bus master register offsets
+constexpr static uint8_t BM_COMMAND = 0;
+constexpr static uint8_t BM_STATUS = 2;
+constexpr static uint8_t BM_PRD_TABLE = 4;
+
+// bus master register bits
+constexpr static uint8_t BM_COMMAND_START = 0x01;
+constexpr static uint8_t BM_COMMAND_READ = 0x08;
+constexpr static uint8_t BM_STATUS_ERROR = 0x02;
+constexpr static uint8_t BM_STATUS_INTERRUPT = 0x04;
+
+// identify data word indices
+constexpr static int IDENTIFY_CAPABILITIES = 49;
+constexpr static int IDENTIFY_LBA28_SECTORS = 60;
+
+// capabilities bits
+constexpr static uint16_t CAPABILITY_DMA = 0x0100;
+constexpr static uint16_t CAPABILITY_LBA = 0x0200;
+
+constexpr static size_t WORDS_PER_SECTOR = BlockDevice::SECTOR_SIZE / 2;
+
+/// LBA28 can address this many sectors
+constexpr static uint32_t MAX_LBA28_SECTORS = 0x1000'0000;
+
+/// last entry in the physical region descriptor table
+constexpr static uint16_t PRD_END_OF_TABLE = 0x8000;
+
+/**
+ * @brief A DMA physical region descriptor
+ */
+struct PhysicalRegion
+{
+    uint32_t physicalAddr;
+    uint16_t byteCount;
+    uint16_t flags;
+} __attribute__((packed));
+
+// legacy channel ports
+constexpr static uint16_t PRIMARY_IO_BASE = 0x1F0;
+constexpr static uint16_t PRIMARY_CTRL = 0x3F6;
+constexpr static uint16_t SECONDARY_IO_BASE = 0x170;
+constexpr static uint16_t SECONDARY_CTRL = 0x376;
+
+// IDE controller PCI class
+constexpr static uint8_t PCI_CLASS_STORAGE = 0x01;
+constexpr static uint8_t PCI_SUBCLASS_IDE = 0x01;
+
+/// BAR holding the bus master registers
+constexpr static int BUS_MASTER_BAR = 4;
+
+/// I/O space BAR address mask
+constexpr static uint32_t BAR_IO_MASK = 0xFFFC;
+
+} // namespace
+
+AtaDrive::AtaDrive() :
+    channel(nullptr),
+    isSlaveDrive(false),
+    isDmaEnabled(false),
+    numSectors(0)
+{
+}
+
+void AtaDrive::init(AtaChannel* channelPtr, bool slave, uint32_t numSectorsOnDrive, bool dma)
+{
+    channel = channelPtr;
+    isSlaveDrive = slave;
+    numSectors = numSectorsOnDrive;
+    isDmaEnabled = dma;
+}
+
+bool AtaDrive::isPresent() const
+{
+    return channel != nullptr;
+}
+
+bool AtaDrive::isSlave() const
+{
+    return isSlaveDrive;
+}
+
+bool AtaDrive::usesDma() const
+{
+    return isDmaEnabled;
+}
+
+uint32_t AtaDrive::getNumSectors() const
+{
+    return numSectors;
+}
+
+bool AtaDrive::transfer(Request& request)
+{
+    if (request.numSectors == 0 || request.sector >= numSectors || request.numSectors > numSectors - request.sector)
+    {
+        request.ok = false;
+        return false;
+    }
+
+    return channel->transfer(this, request);
+}
+
+AtaChannel::AtaChannel() :
+    ioBase(0),
+    ctrl(0),
+    busMaster(0),
+    prdTable(0),
+    active(nullptr),
+    headSector(0),
+    irqReceived(false),
+    irqStatus(0),
+    irqBusMasterStatus(0)
+{
+}
+
+void AtaChannel::init(uint16_t ioBasePort, uint16_t ctrlPort, uint16_t busMasterPort, uintptr_t prdTableAddr)
+{
+    ioBase = ioBasePort;
+    ctrl = ctrlPort;
+    busMaster = busMasterPort;
+    prdTable = prdTableAddr;
+}
+
+bool AtaChannel::hasBusMaster() const
+{
+    return busMaster != 0 && prdTable != 0;
+}
+
+bool AtaChannel::identify(bool slave, uint16_t* data)
+{
+    // poll instead of using interrupts
+    outb(ctrl, CTRL_NIEN);
+
+    outb(ioBase + REG_DRIVE, DRIVE_BASE | (slave ? DRIVE_SLAVE : 0));
+    delay();
+
+    outb(ioBase + REG_SECTOR_COUNT, 0);
+    outb(ioBase + REG_LBA_LOW, 0);
+    outb(ioBase + REG_LBA_MID, 0);
+    outb(ioBase + REG_LBA_HIGH, 0);
+    outb(ioBase + REG_COMMAND, COMMAND_IDENTIFY);
+    delay();
+
+    bool found = false;
+
+    // a status of 0 means there is no drive; 0xFF means there is no channel
+    uint8_t status = inb(ioBase + REG_STATUS);
+    if (status != 0 && status != 0xFF)
+    {
+        status = waitWhileBusy();
+
+        // ATAPI and SATA drives set the LBA mid and high registers
+        if (inb(ioBase + REG_LBA_MID) == 0 && inb(ioBase + REG_LBA_HIGH) == 0)
+        {
+            while ((status & (STATUS_DRQ | STATUS_ERR)) == 0)
+            {
+                status = inb(ioBase + REG_STATUS);
+            }
+
+            if ((status & STATUS_ERR) == 0)
+            {
+                insw(ioBase + REG_DATA, data, WORDS_PER_SECTOR);
+                found = true;
+            }
+        }
+    }
+
+    outb(ctrl, 0);
+
+    return found;
+}
+
+bool AtaChannel::transfer(AtaDrive* drive, BlockDevice::Request& request)
+{
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    request.device = drive;
+    request.ok = false;
+    request.next = nullptr;
+
+    // wait for our turn if the channel is busy
+    if (active == nullptr)
+    {
+        active = &request;
+    }
+    else
+    {
+        queue.add(&request);
+        while (active != &request)
+        {
+            requestWaitQueue.wait();
+        }
+    }
+
+    // split the request into commands
+    bool ok = true;
+    for (size_t done = 0; ok && done < request.numSectors; done += MAX_SECTORS_PER_COMMAND)
+    {
+        size_t numSectors = request.numSectors - done;
+        if (numSectors > MAX_SECTORS_PER_COMMAND)
+        {
+            numSectors = MAX_SECTORS_PER_COMMAND;
+        }
+
+        const uintptr_t* frames = request.frames + done / BlockDevice::SECTORS_PER_PAGE;
+        ok = performCommand(*drive, request.type, request.sector + done, numSectors, frames);
+    }
+
+    // a write is only complete once the data is out of the drive's cache
+    if (ok && request.type == BlockDevice::Request::eWrite)
+    {
+        ok = flushCache(*drive);
+    }
+    request.ok = ok;
+
+    // start the next request in elevator order
+    headSector = request.sector + request.numSectors;
+    active = queue.next(headSector);
+    requestWaitQueue.wakeAll();
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+
+    if (!ok)
+    {
+        klog.logError(AtaDriver::LOG_TAG, "Could not {} {} sectors at sector {}",
+                      (request.type == BlockDevice::Request::eRead) ? "read" : "write",
+                      request.numSectors, request.sector);
+    }
+
+    return ok;
+}
+
+void AtaChannel::processInterrupt()
+{
+    if (busMaster != 0)
+    {
+        // clear the bus master interrupt and error bits by writing them
+        irqBusMasterStatus = inb(busMaster + BM_STATUS);
+        outb(busMaster + BM_STATUS, irqBusMasterStatus | BM_STATUS_INTERRUPT | BM_STATUS_ERROR);
+    }
+
+    // reading the status register acknowledges the interrupt
+    irqStatus = inb(ioBase + REG_STATUS);
+    irqReceived = true;
+
+    irqWaitQueue.wakeAll();
+}
+
+bool AtaChannel::performCommand(const AtaDrive& drive, BlockDevice::Request::EType type, uint32_t sector, size_t numSectors, const uintptr_t* frames)
+{
+    if (sector + numSectors > MAX_LBA28_SECTORS)
+    {
+        return false;
+    }
+
+    waitWhileBusy();
+    setUpCommand(drive.isSlave(), sector, numSectors);
+
+    if (drive.usesDma())
+    {
+        return performDma(type, numSectors, frames);
+    }
+    else
+    {
+        return performPio(type, numSectors, frames);
+    }
+}
+
+bool AtaChannel::performDma(BlockDevice::Request::EType type, size_t numSectors, const uintptr_t* frames)
+{
+    // describe each page frame with one physical region
+    PhysicalRegion* regions = reinterpret_cast<PhysicalRegion*>(processMgr.mapTempPage(prdTable));
+    if (regions == nullptr)
+    {
+        return false;
+    }
+
+    size_t numBytes = numSectors * BlockDevice::SECTOR_SIZE;
+    size_t numRegions = (numBytes + PAGE_SIZE - 1) / PAGE_SIZE;
+    for (size_t i = 0; i < numRegions; ++i)
+    {
+        size_t regionSize = numBytes - i * PAGE_SIZE;
+        if (regionSize > PAGE_SIZE)
+        {
+            regionSize = PAGE_SIZE;
+        }
+
+        regions[i].physicalAddr = frames[i];
+        regions[i].byteCount = static_cast<uint16_t>(regionSize);
+        regions[i].flags = (i == numRegions - 1) ? PRD_END_OF_TABLE : 0;
+    }
+
+    processMgr.unmapTempPage(reinterpret_cast<uint8_t*>(regions));
+
+    uint8_t direction = (type == BlockDevice::Request::eRead) ? BM_COMMAND_READ : 0;
+
+    outb(busMaster + BM_COMMAND, 0);
+    outl(busMaster + BM_PRD_TABLE, prdTable);
+    outb(busMaster + BM_COMMAND, direction);
+    outb(busMaster + BM_STATUS, inb(busMaster + BM_STATUS) | BM_STATUS_INTERRUPT | BM_STATUS_ERROR);
+
+    irqReceived = false;
+    outb(ioBase + REG_COMMAND, (type == BlockDevice::Request::eRead) ? COMMAND_READ_DMA : COMMAND_WRITE_DMA);
+    outb(busMaster + BM_COMMAND, direction | BM_COMMAND_START);
+
+    bool ok = waitForInterrupt();
+
+    outb(busMaster + BM_COMMAND, 0);
+
+    return ok && (irqBusMasterStatus & BM_STATUS_ERROR) == 0;
+}
+
+bool AtaChannel::performPio(BlockDevice::Request::EType type, size_t numSectors, const uintptr_t* frames)
+{
+    bool isRead = (type == BlockDevice::Request::eRead);
+
+    irqReceived = false;
+    outb(ioBase + REG_COMMAND, isRead ? COMMAND_READ_PIO : COMMAND_WRITE_PIO);
+
+    // the drive doesn't interrupt before the first sector is written
+    if (!isRead)
+    {
+        uint8_t status = waitWhileBusy();
+        if ((status & (STATUS_ERR | STATUS_DF)) != 0 || (status & STATUS_DRQ) == 0)
+        {
+            return false;
+        }
+    }
+
+    bool ok = true;
+    for (size_t pageIdx = 0; ok && pageIdx * BlockDevice::SECTORS_PER_PAGE < numSectors; ++pageIdx)
+    {
+        uint8_t* page = processMgr.mapTempPage(frames[pageIdx]);
+        if (page == nullptr)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; ok && i < BlockDevice::SECTORS_PER_PAGE; ++i)
+        {
+            size_t sector = pageIdx * BlockDevice::SECTORS_PER_PAGE + i;
+            if (sector >= numSectors)
+            {
+                break;
+            }
+
+            // the drive interrupts when each sector is ready to be read and
+            // after each sector is written
+            if (isRead)
+            {
+                ok = waitForInterrupt();
+                if (ok)
+                {
+                    insw(ioBase + REG_DATA, page + i * BlockDevice::SECTOR_SIZE, WORDS_PER_SECTOR);
+                }
+            }
+            else
+            {
+                outsw(ioBase + REG_DATA, page + i * BlockDevice::SECTOR_SIZE, WORDS_PER_SECTOR);
+                ok = waitForInterrupt();
+            }
+        }
+
+        processMgr.unmapTempPage(page);
+    }
+
+    return ok;
+}
+
+bool AtaChannel::flushCache(const AtaDrive& drive)
+{
+    waitWhileBusy();
+    outb(ioBase + REG_DRIVE, DRIVE_BASE | DRIVE_LBA | (drive.isSlave() ? DRIVE_SLAVE : 0));
+    delay();
+
+    irqReceived = false;
+    outb(ioBase + REG_COMMAND, COMMAND_FLUSH_CACHE);
+    return waitForInterrupt();
+}
+
+void AtaChannel::setUpCommand(bool slave, uint32_t sector, size_t numSectors)
+{
+    outb(ioBase + REG_DRIVE, DRIVE_BASE | DRIVE_LBA | (slave ? DRIVE_SLAVE : 0) | ((sector >> 24) & 0x0F));
+    delay();
+
+    // a sector count of 0 means 256 sectors
+    outb(ioBase + REG_SECTOR_COUNT, numSectors & 0xFF);
+    outb(ioBase + REG_LBA_LOW, sector & 0xFF);
+    outb(ioBase + REG_LBA_MID, (sector >> 8) & 0xFF);
+    outb(ioBase + REG_LBA_HIGH, (sector >> 16) & 0xFF);
+}
+
+bool AtaChannel::waitForInterrupt()
+{
+    while (!irqReceived)
+    {
+        irqWaitQueue.wait();
+    }
+    irqReceived = false;
+
+    return (irqStatus & (STATUS_ERR | STATUS_DF)) == 0;
+}
+
+uint8_t AtaChannel::waitWhileBusy()
+{
+    uint8_t status = inb(ioBase + REG_STATUS);
+    while ((status & STATUS_BSY) != 0)
+    {
+        status = inb(ioBase + REG_STATUS);
+    }
+
+    return status;
+}
+
+void AtaChannel::delay()
+{
+    // each read of the alternate status register takes about 100 ns
+    for (int i = 0; i < 4; ++i)
+    {
+        inb(ctrl);
+    }
+}
+
+const char* AtaDriver::LOG_TAG = "ATA";
+
+void AtaDriver::init(PageFrameMgr* pageFrameMgr)
+{
+    // find the bus master registers of the IDE controller
+    uint16_t busMasterBase = 0;
+    PciBus::Address address = {0, 0, 0};
+    if (pciBus.findByClass(PCI_CLASS_STORAGE, PCI_SUBCLASS_IDE, address))
+    {
+        busMasterBase = pciBus.getBar(address, BUS_MASTER_BAR) & BAR_IO_MASK;
+        if (busMasterBase != 0)
+        {
+            pciBus.enable(address, PciBus::COMMAND_IO_SPACE | PciBus::COMMAND_BUS_MASTER);
+        }
+    }
+
+    const uint16_t ioBases[NUM_CHANNELS] = {PRIMARY_IO_BASE, SECONDARY_IO_BASE};
+    const uint16_t ctrls[NUM_CHANNELS] = {PRIMARY_CTRL, SECONDARY_CTRL};
+
+    for (int i = 0; i < NUM_CHANNELS; ++i)
+    {
+        // each channel has its own set of bus master registers and PRD table
+        uint16_t channelBusMaster = (busMasterBase != 0) ? busMasterBase + i * 8 : 0;
+        uintptr_t prdTable = (channelBusMaster != 0) ? pageFrameMgr->allocPageFrame() : 0;
+        channels[i].init(ioBases[i], ctrls[i], channelBusMaster, prdTable);
+
+        for (int j = 0; j < 2; ++j)
+        {
+            uint16_t data[WORDS_PER_SECTOR];
+            bool slave = (j == 1);
+            if (!channels[i].identify(slave, data))
+            {
+                continue;
+            }
+
+            if ((data[IDENTIFY_CAPABILITIES] & CAPABILITY_LBA) == 0)
+            {
+                klog.logWarning(LOG_TAG, "Channel {} drive {} does not support LBA", i, j);
+                continue;
+            }
+
+            uint32_t numSectors = data[IDENTIFY_LBA28_SECTORS] | (static_cast<uint32_t>(data[IDENTIFY_LBA28_SECTORS + 1]) << 16);
+            bool dma = channels[i].hasBusMaster() && (data[IDENTIFY_CAPABILITIES] & CAPABILITY_DMA) != 0;
+
+            AtaDrive& drive = drives[i * 2 + j];
+            drive.init(&channels[i], slave, numSectors, dma);
+            blockDeviceTable.addDevice(&drive);
+
+            klog.logInfo(LOG_TAG, "Channel {} drive {}: {} sectors, {}", i, j, numSectors, dma ? "DMA" : "PIO");
+        }
+    }
+
+    registerIrqHandler(IRQ14, primaryInterruptHandler);
+    registerIrqHandler(IRQ15, secondaryInterruptHandler);
+}
+
+void AtaDriver::primaryInterruptHandler(const registers* /*regs*/)
+{
+    ataDriver.channels[0].processInterrupt();
+}
+
+void AtaDriver::secondaryInterruptHandler(const registers* /*regs*/)
+{
+    ataDriver.channels[1].processInterrupt();
+}
+
+// create AtaDriver instance
+AtaDriver ataDriver;
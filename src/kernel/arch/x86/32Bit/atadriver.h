@@ -0,0 +1,194 @@
+/**
+ * @brief ATA (IDE) disk driver
+ */
+
+#ifndef ATA_DRIVER_H_
+#define ATA_DRIVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "blockdevice.h"
+#include "waitqueue.h"
+
+class AtaChannel;
+class PageFrameMgr;
+struct registers;
+
+/**
+ * @brief A drive on an ATA channel.
+ */
+class AtaDrive : public BlockDevice
+{
+public:
+    AtaDrive();
+
+    void init(AtaChannel* channelPtr, bool slave, uint32_t numSectorsOnDrive, bool dma);
+
+    bool isPresent() const;
+
+    bool isSlave() const;
+
+    /**
+     * @brief Whether requests are transferred with bus master DMA (instead
+     * of PIO).
+     */
+    bool usesDma() const;
+
+    uint32_t getNumSectors() const override;
+
+    bool transfer(Request& request) override;
+
+private:
+    AtaChannel* channel;
+    bool isSlaveDrive;
+    bool isDmaEnabled;
+    uint32_t numSectors;
+};
+
+/**
+ * @brief An ATA channel (a controller with up to two drives).
+ * @details The channel performs one request at a time. The process that
+ * made the active request performs it, sleeping while it waits for the
+ * channel's interrupt. Requests made in the meantime wait in an elevator
+ * queue and are started in sector order when the active request completes.
+ */
+class AtaChannel
+{
+public:
+    AtaChannel();
+
+    /**
+     * @brief Initialize the channel.
+     * @param ioBasePort The base port of the command block registers.
+     * @param ctrlPort The port of the control block register.
+     * @param busMasterPort The base port of the bus master registers, or 0
+     * if the channel does not support DMA.
+     * @param prdTableAddr The physical address of a page frame for the DMA
+     * physical region descriptor table.
+     */
+    void init(uint16_t ioBasePort, uint16_t ctrlPort, uint16_t busMasterPort, uintptr_t prdTableAddr);
+
+    bool hasBusMaster() const;
+
+    /**
+     * @brief Identify a drive on the channel.
+     * @param slave Whether to identify the slave drive.
+     * @param [out] data The 256 words of identify data.
+     * @return true if an ATA drive is present; false, otherwise
+     */
+    bool identify(bool slave, uint16_t* data);
+
+    /**
+     * @brief Perform a request for a drive on the channel.
+     */
+    bool transfer(AtaDrive* drive, BlockDevice::Request& request);
+
+    /**
+     * @brief Handle the channel's interrupt.
+     */
+    void processInterrupt();
+
+private:
+    /// maximum number of sectors in one LBA28 command
+    constexpr static size_t MAX_SECTORS_PER_COMMAND = 256;
+
+    uint16_t ioBase;
+    uint16_t ctrl;
+    uint16_t busMaster;
+
+    /// physical address of the DMA physical region descriptor table
+    uintptr_t prdTable;
+
+    /// the request being performed
+    BlockDevice::Request* active;
+
+    /// requests waiting for the active request to complete
+    BlockRequestQueue queue;
+
+    /// the sector after the last sector transferred
+    uint32_t headSector;
+
+    /// processes waiting for their request to become active
+    WaitQueue requestWaitQueue;
+
+    /// whether an interrupt was received since the last command
+    volatile bool irqReceived;
+
+    /// the status register read by the interrupt handler
+    volatile uint8_t irqStatus;
+
+    /// the bus master status register read by the interrupt handler
+    volatile uint8_t irqBusMasterStatus;
+
+    /// processes waiting for the channel's interrupt
+    WaitQueue irqWaitQueue;
+
+    /**
+     * @brief Perform up to MAX_SECTORS_PER_COMMAND sectors of a request.
+     */
+    bool performCommand(const AtaDrive& drive, BlockDevice::Request::EType type, uint32_t sector, size_t numSectors, const uintptr_t* frames);
+
+    bool performDma(BlockDevice::Request::EType type, size_t numSectors, const uintptr_t* frames);
+
+    bool performPio(BlockDevice::Request::EType type, size_t numSectors, const uintptr_t* frames);
+
+    /**
+     * @brief Write the data in a drive's cache to the disk.
+     * @details Writes with DMA and PIO both finish with this.
+     */
+    bool flushCache(const AtaDrive& drive);
+
+    /**
+     * @brief Select a drive and load the LBA and sector count registers.
+     */
+    void setUpCommand(bool slave, uint32_t sector, size_t numSectors);
+
+    /**
+     * @brief Sleep until the channel's interrupt is received.
+     * @return true if the command did not fail; false, otherwise
+     */
+    bool waitForInterrupt();
+
+    /**
+     * @brief Poll the status register until the drive is not busy.
+     * @return The status register.
+     */
+    uint8_t waitWhileBusy();
+
+    /**
+     * @brief Wait 400 ns for the status register to become valid.
+     */
+    void delay();
+};
+
+/**
+ * @brief Finds ATA drives on the primary and secondary channels.
+ */
+class AtaDriver
+{
+public:
+    /// The tag used in the kernel log
+    static const char* LOG_TAG;
+
+    /**
+     * @brief Find and identify drives. Found drives are added to the block
+     * device table.
+     */
+    void init(PageFrameMgr* pageFrameMgr);
+
+private:
+    constexpr static int NUM_CHANNELS = 2;
+
+    AtaChannel channels[NUM_CHANNELS];
+
+    AtaDrive drives[NUM_CHANNELS * 2];
+
+    static void primaryInterruptHandler(const registers* regs);
+
+    static void secondaryInterruptHandler(const registers* regs);
+};
+
+extern AtaDriver ataDriver;
+
+#endif // ATA_DRIVER_H_
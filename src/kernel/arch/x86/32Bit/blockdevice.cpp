@@ -0,0 +1,97 @@
+/**
+ * @brief Block devices
+ */
+
+#include "blockdevice.h"
+
+bool BlockDevice::read(uint32_t sector, size_t numSectors, const uintptr_t* frames)
+{
+    Request request = {Request::eRead, sector, numSectors, frames, this, false, nullptr};
+    return transfer(request);
+}
+
+bool BlockDevice::write(uint32_t sector, size_t numSectors, const uintptr_t* frames)
+{
+    Request request = {Request::eWrite, sector, numSectors, frames, this, false, nullptr};
+    return transfer(request);
+}
+
+BlockRequestQueue::BlockRequestQueue() :
+    head(nullptr)
+{
+}
+
+bool BlockRequestQueue::isEmpty() const
+{
+    return head == nullptr;
+}
+
+void BlockRequestQueue::add(BlockDevice::Request* request)
+{
+    // insert after all requests with a lower or equal sector, so requests
+    // for the same sector are performed in the order they were added
+    BlockDevice::Request** link = &head;
+    while (*link != nullptr && (*link)->sector <= request->sector)
+    {
+        link = &(*link)->next;
+    }
+
+    request->next = *link;
+    *link = request;
+}
+
+BlockDevice::Request* BlockRequestQueue::next(uint32_t headSector)
+{
+    if (head == nullptr)
+    {
+        return nullptr;
+    }
+
+    // find the first request at or after the head
+    BlockDevice::Request** link = &head;
+    while (*link != nullptr && (*link)->sector < headSector)
+    {
+        link = &(*link)->next;
+    }
+
+    // wrap around to the lowest request
+    if (*link == nullptr)
+    {
+        link = &head;
+    }
+
+    BlockDevice::Request* request = *link;
+    *link = request->next;
+    request->next = nullptr;
+
+    return request;
+}
+
+BlockDeviceTable::BlockDeviceTable() :
+    numDevices(0)
+{
+}
+
+int BlockDeviceTable::addDevice(BlockDevice* device)
+{
+    if (numDevices >= MAX_NUM_DEVICES)
+    {
+        return -1;
+    }
+
+    devices[numDevices] = device;
+    return static_cast<int>(numDevices++);
+}
+
+BlockDevice* BlockDeviceTable::getDevice(size_t idx) const
+{
+    return (idx < numDevices) ? devices[idx] : nullptr;
+}
+
+size_t BlockDeviceTable::getNumDevices() const
+{
+    return numDevices;
+}
+
+// create BlockDeviceTable instance
+BlockDeviceTable blockDeviceTable;
@@ -0,0 +1,137 @@
+/**
+ * @brief Block devices
+ */
+
+#ifndef BLOCK_DEVICE_H_
+#define BLOCK_DEVICE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A device that is read and written in fixed-size sectors (e.g. a
+ * disk).
+ */
+class BlockDevice
+{
+public:
+    constexpr static size_t SECTOR_SIZE = 512;
+
+    /// number of sectors in a page
+    constexpr static size_t SECTORS_PER_PAGE = 4096 / SECTOR_SIZE;
+
+    /**
+     * @brief A request to read or write consecutive sectors.
+     * @details The sectors are transferred to or from page frames, which
+     * are filled consecutively (sector i is at offset
+     * (i % SECTORS_PER_PAGE) * SECTOR_SIZE in frame i / SECTORS_PER_PAGE).
+     */
+    struct Request
+    {
+        enum EType
+        {
+            eRead,
+            eWrite,
+        } type;
+
+        /// the first sector
+        uint32_t sector;
+
+        /// number of sectors
+        size_t numSectors;
+
+        /// physical addresses of the page frames
+        const uintptr_t* frames;
+
+        /// the device the request is for (set by the device)
+        BlockDevice* device;
+
+        /// whether the request completed successfully
+        bool ok;
+
+        /// the next request in a request queue
+        Request* next;
+    };
+
+    /**
+     * @brief Get the number of sectors on the device.
+     */
+    virtual uint32_t getNumSectors() const = 0;
+
+    /**
+     * @brief Perform a request. Blocks the calling process until the request
+     * has completed.
+     * @return true if the request completed successfully; false, otherwise
+     */
+    virtual bool transfer(Request& request) = 0;
+
+    /**
+     * @brief Read consecutive sectors into page frames.
+     */
+    bool read(uint32_t sector, size_t numSectors, const uintptr_t* frames);
+
+    /**
+     * @brief Write consecutive sectors from page frames.
+     */
+    bool write(uint32_t sector, size_t numSectors, const uintptr_t* frames);
+};
+
+/**
+ * @brief Pending requests for a device, ordered by an elevator (C-LOOK)
+ * algorithm.
+ * @details Requests are kept sorted by sector. The next request is the
+ * first one at or after the last sector transferred, so the disk head
+ * sweeps in one direction and then jumps back to the lowest request.
+ */
+class BlockRequestQueue
+{
+public:
+    BlockRequestQueue();
+
+    bool isEmpty() const;
+
+    /**
+     * @brief Add a request to the queue.
+     */
+    void add(BlockDevice::Request* request);
+
+    /**
+     * @brief Remove and return the next request to perform.
+     * @param headSector The sector after the last sector transferred.
+     * @return The request, or nullptr if the queue is empty.
+     */
+    BlockDevice::Request* next(uint32_t headSector);
+
+private:
+    /// requests sorted by sector
+    BlockDevice::Request* head;
+};
+
+/**
+ * @brief The block devices found in the system.
+ */
+class BlockDeviceTable
+{
+public:
+    BlockDeviceTable();
+
+    /**
+     * @brief Add a device.
+     * @return The device's index, or -1 if the table is full.
+     */
+    int addDevice(BlockDevice* device);
+
+    BlockDevice* getDevice(size_t idx) const;
+
+    size_t getNumDevices() const;
+
+private:
+    constexpr static size_t MAX_NUM_DEVICES = 8;
+
+    BlockDevice* devices[MAX_NUM_DEVICES];
+    size_t numDevices;
+};
+
+extern BlockDeviceTable blockDeviceTable;
+
+#endif // BLOCK_DEVICE_H_
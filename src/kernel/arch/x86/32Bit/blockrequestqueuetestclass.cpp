@@ -0,0 +1,102 @@
+#include "blockdevice.h"
+#include "unittests.h"
+
+namespace
+{
+
+BlockDevice::Request makeRequest(uint32_t sector)
+{
+    BlockDevice::Request request = {BlockDevice::Request::eRead, sector, 1, nullptr, nullptr, false, nullptr};
+    return request;
+}
+
+} // namespace
+
+BlockRequestQueueTestClass::BlockRequestQueueTestClass() :
+    TestClass("BlockRequestQueue")
+{
+}
+
+void BlockRequestQueueTestClass::runTests()
+{
+    runTest("Empty", []()
+    {
+        BlockRequestQueue queue;
+        ASSERT_TRUE(queue.isEmpty());
+        ASSERT_TRUE(queue.next(0) == nullptr);
+    });
+
+    runTest("SortedBySector", []()
+    {
+        BlockDevice::Request request1 = makeRequest(50);
+        BlockDevice::Request request2 = makeRequest(10);
+        BlockDevice::Request request3 = makeRequest(30);
+
+        BlockRequestQueue queue;
+        queue.add(&request1);
+        queue.add(&request2);
+        queue.add(&request3);
+        ASSERT_FALSE(queue.isEmpty());
+
+        ASSERT_TRUE(queue.next(0) == &request2);
+        ASSERT_TRUE(queue.next(11) == &request3);
+        ASSERT_TRUE(queue.next(31) == &request1);
+        ASSERT_TRUE(queue.isEmpty());
+        ASSERT_TRUE(queue.next(51) == nullptr);
+    });
+
+    runTest("Sweep", []()
+    {
+        BlockDevice::Request request1 = makeRequest(10);
+        BlockDevice::Request request2 = makeRequest(30);
+        BlockDevice::Request request3 = makeRequest(40);
+        BlockDevice::Request request4 = makeRequest(60);
+
+        BlockRequestQueue queue;
+        queue.add(&request4);
+        queue.add(&request2);
+        queue.add(&request1);
+        queue.add(&request3);
+
+        // the head moves up from where it is, and then jumps back to the
+        // lowest request
+        ASSERT_TRUE(queue.next(35) == &request3);
+        ASSERT_TRUE(queue.next(41) == &request4);
+        ASSERT_TRUE(queue.next(61) == &request1);
+        ASSERT_TRUE(queue.next(11) == &request2);
+        ASSERT_TRUE(queue.isEmpty());
+    });
+
+    runTest("RequestAtHead", []()
+    {
+        BlockDevice::Request request1 = makeRequest(20);
+        BlockDevice::Request request2 = makeRequest(25);
+
+        BlockRequestQueue queue;
+        queue.add(&request1);
+        queue.add(&request2);
+
+        // a request that starts at the head is next
+        ASSERT_TRUE(queue.next(25) == &request2);
+        ASSERT_TRUE(queue.next(26) == &request1);
+    });
+
+    runTest("SameSector", []()
+    {
+        BlockDevice::Request request1 = makeRequest(20);
+        BlockDevice::Request request2 = makeRequest(20);
+        BlockDevice::Request request3 = makeRequest(20);
+
+        BlockRequestQueue queue;
+        queue.add(&request1);
+        queue.add(&request2);
+        queue.add(&request3);
+
+        // requests for the same sector are performed in the order they
+        // were added
+        ASSERT_TRUE(queue.next(0) == &request1);
+        ASSERT_TRUE(queue.next(0) == &request2);
+        ASSERT_TRUE(queue.next(0) == &request3);
+        ASSERT_TRUE(queue.next(0) == nullptr);
+    });
+}
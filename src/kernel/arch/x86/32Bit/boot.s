@@ -4,12 +4,20 @@
 
 MBOOT_PAGE_ALIGN	equ 1 << 0 		; load kernel and modules on a page boundary
 MBOOT_MEM_INFO		equ 1 << 1 		; provide kernel with memory info
+MBOOT_VIDEO_MODE	equ 1 << 2		; provide kernel with a video mode
 MBOOT_OFFSETS		equ 1 << 16		; kernel offsets are provided in header
 MBOOT_HEADER_MAGIC	equ 0x1BADB002	; multiboot magic number
 
-MBOOT_HEADER_FLAGS	equ MBOOT_PAGE_ALIGN | MBOOT_MEM_INFO | MBOOT_OFFSETS
+MBOOT_HEADER_FLAGS	equ MBOOT_PAGE_ALIGN | MBOOT_MEM_INFO | MBOOT_VIDEO_MODE | MBOOT_OFFSETS
 MBOOT_CHECKSUM		equ -(MBOOT_HEADER_MAGIC + MBOOT_HEADER_FLAGS)
 
+; preferred video mode (the kernel falls back to VGA text mode if the
+; boot loader doesn't set up a linear framebuffer)
+MBOOT_MODE_TYPE		equ 0			; linear graphics mode
+MBOOT_MODE_WIDTH	equ 1024
+MBOOT_MODE_HEIGHT	equ 768
+MBOOT_MODE_DEPTH	equ 32
+
 ; the kernel's virtual base address
 KERNEL_VIRTUAL_BASE equ 0xC0000000
 
@@ -42,6 +50,10 @@ mboot:
 	dd loadEndAddr
 	dd bssEndAddr
 	dd start
+	dd MBOOT_MODE_TYPE
+	dd MBOOT_MODE_WIDTH
+	dd MBOOT_MODE_HEIGHT
+	dd MBOOT_MODE_DEPTH
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ; Start Section
@@ -152,5 +164,5 @@ global kernelStackEnd
 ; is at a higher address than the end
 alignb 4
 kernelStackEnd:
-	resb 4096			; reserve 4 KiB of memory
+	resb 16384			; reserve 16 KiB of memory (kmain's stream drivers live on this stack)
 kernelStackStart:
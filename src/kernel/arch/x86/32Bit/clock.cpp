@@ -0,0 +1,82 @@
+#include "clock.h"
+#include "pitclockevent.h"
+#include "system.h"
+
+uint64_t Clock::tscFrequency = 0;
+uint64_t Clock::tscStart = 0;
+bool Clock::tscInvariant = false;
+uint32_t Clock::mult = 0;
+uint32_t Clock::shift = 0;
+
+bool Clock::init()
+{
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+    cpuid(CPUID_FEATURES, &eax, &ebx, &ecx, &edx);
+    if ((edx & CPUID_FEATURES_EDX_TSC) == 0)
+    {
+        return false;
+    }
+
+    cpuid(CPUID_EXT_MAX_LEAF, &eax, &ebx, &ecx, &edx);
+    if (eax >= CPUID_EXT_POWER_MGMT)
+    {
+        cpuid(CPUID_EXT_POWER_MGMT, &eax, &ebx, &ecx, &edx);
+        tscInvariant = (edx & CPUID_EXT_POWER_MGMT_EDX_INVARIANT_TSC) != 0;
+    }
+
+    uint64_t numCycles = 0;
+    for (int i = 0; i < NUM_CALIBRATIONS; ++i)
+    {
+        uint64_t start = readTsc();
+        PitClockEvent::wait(CALIBRATION_PIT_COUNT);
+        uint64_t cycles = readTsc() - start;
+
+        if (i == 0 || cycles < numCycles)
+        {
+            numCycles = cycles;
+        }
+    }
+
+    tscFrequency = numCycles * PIT_FREQUENCY / CALIBRATION_PIT_COUNT;
+    if (tscFrequency == 0)
+    {
+        return false;
+    }
+
+    // use the largest shift whose multiplier fits in 32 bits
+    shift = 32;
+    while ((NS_PER_SEC << shift) / tscFrequency > 0xFFFF'FFFF)
+    {
+        --shift;
+    }
+    mult = (NS_PER_SEC << shift) / tscFrequency;
+
+    tscStart = readTsc();
+
+    return true;
+}
+
+uint64_t Clock::getNs()
+{
+    uint64_t cycles = readTsc() - tscStart;
+
+    // multiply each half of the count separately, so the product doesn't
+    // overflow 64 bits
+    uint64_t low = (cycles & 0xFFFF'FFFF) * mult;
+    uint64_t high = (cycles >> 32) * mult;
+
+    return (high << (32 - shift)) + (low >> shift);
+}
+
+uint64_t Clock::getTscFrequency()
+{
+    return tscFrequency;
+}
+
+bool Clock::isTscInvariant()
+{
+    return tscInvariant;
+}
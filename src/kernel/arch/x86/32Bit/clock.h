@@ -0,0 +1,64 @@
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <stdint.h>
+
+/**
+ * @brief The monotonic clock, counted by the time stamp counter (TSC).
+ * @details The TSC's rate is measured against the PIT at boot. Reading the
+ * clock takes no port I/O or division, so it is cheap enough to time
+ * short sections of kernel code.
+ */
+class Clock
+{
+public:
+    static constexpr uint64_t NS_PER_SEC = 1'000'000'000;
+
+    /**
+     * @brief Measure the TSC's rate and start the clock at 0.
+     * @return false if the CPU has no TSC
+     */
+    static bool init();
+
+    /**
+     * @brief Get the time since the clock was started in nanoseconds.
+     */
+    static uint64_t getNs();
+
+    /**
+     * @brief Get the TSC's rate in cycles per second.
+     */
+    static uint64_t getTscFrequency();
+
+    /**
+     * @brief Whether the TSC runs at a constant rate in all power states.
+     * @details If it doesn't, the clock may drift when the CPU changes
+     * frequency.
+     */
+    static bool isTscInvariant();
+
+private:
+    /// PIT cycles to measure the rate for (50 ms)
+    static constexpr uint16_t CALIBRATION_PIT_COUNT = 59'659;
+
+    /// the number of measurements; the shortest is used, since it was
+    /// delayed the least by the code around it
+    static constexpr int NUM_CALIBRATIONS = 3;
+
+    static constexpr uint32_t CPUID_FEATURES = 0x1;
+    static constexpr uint32_t CPUID_FEATURES_EDX_TSC = 1 << 4;
+    static constexpr uint32_t CPUID_EXT_MAX_LEAF = 0x8000'0000;
+    static constexpr uint32_t CPUID_EXT_POWER_MGMT = 0x8000'0007;
+    static constexpr uint32_t CPUID_EXT_POWER_MGMT_EDX_INVARIANT_TSC = 1 << 8;
+
+    static uint64_t tscFrequency;
+    static uint64_t tscStart;
+    static bool tscInvariant;
+
+    /// TSC cycles are converted to nanoseconds with
+    /// (cycles * mult) >> shift
+    static uint32_t mult;
+    static uint32_t shift;
+};
+
+#endif // CLOCK_H_
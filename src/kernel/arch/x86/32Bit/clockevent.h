@@ -0,0 +1,61 @@
+#ifndef CLOCK_EVENT_H_
+#define CLOCK_EVENT_H_
+
+#include <stdint.h>
+
+#include "irq.h"
+
+/**
+ * @brief A timer that interrupts once after a programmed delay.
+ * @details Nothing interrupts while no event is programmed, so an idle
+ * processor is not woken up to count ticks.
+ */
+class ClockEvent
+{
+public:
+    static constexpr uint64_t NS_PER_SEC = 1'000'000'000;
+
+    /**
+     * @brief Set up the device.
+     * @param eventHandler The function called when an event occurs.
+     * @return true if the device can be used; false, otherwise
+     */
+    virtual bool init(irqHandlerPtr eventHandler) = 0;
+
+    /**
+     * @brief Program an event, replacing any event that hasn't occurred
+     * yet.
+     * @param delayNs The delay in nanoseconds. It must be between
+     * getMinDelay() and getMaxDelay().
+     */
+    virtual void setNextEvent(uint64_t delayNs) = 0;
+
+    /**
+     * @brief Cancel the programmed event.
+     */
+    virtual void stop() = 0;
+
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief Get the shortest delay in nanoseconds.
+     */
+    uint64_t getMinDelay() const
+    {
+        return minDelay;
+    }
+
+    /**
+     * @brief Get the longest delay in nanoseconds.
+     */
+    uint64_t getMaxDelay() const
+    {
+        return maxDelay;
+    }
+
+protected:
+    uint64_t minDelay = 0;
+    uint64_t maxDelay = 0;
+};
+
+#endif // CLOCK_EVENT_H_
@@ -0,0 +1,237 @@
+#include <string.h>
+
+#include "apic.h"
+#include "clock.h"
+#include "cpu.h"
+#include "idt.h"
+#include "irq.h"
+#include "kernellogger.h"
+#include "paging.h"
+#include "system.h"
+
+// these symbols are defined in apboot.s
+extern "C" const uint8_t apTrampolineStart[];
+extern "C" const uint8_t apTrampolineEnd[];
+extern "C" const uint8_t apTrampolineParams[];
+
+namespace
+{
+
+const char* LOG_TAG = "CPU";
+
+/// the trampoline's page is saved while processors start, since it may
+/// hold boot loader data
+uint8_t savedTrampolinePage[PAGE_SIZE];
+
+} // namespace
+
+/**
+ * @brief Application processor entry point, which the trampoline calls on
+ * the processor's kernel stack.
+ */
+extern "C"
+void apMain(Cpu* cpu)
+{
+    initGdt(&cpu->gdt, reinterpret_cast<uint32_t>(cpu), sizeof(Cpu));
+    loadIdt();
+    Apic::initLocal();
+
+    // the trampoline switched to the boot processor's page directory
+    cpu->pageDir = getPageDirectory();
+    cpu->isOnline = true;
+
+    processMgr.apMainloop();
+}
+
+Cpu Cpu::cpus[MAX_NUM_CPUS];
+unsigned int Cpu::numCpus = 0;
+volatile uint32_t Cpu::shootdownAddr = 0;
+alignas(16) uint8_t Cpu::kernelStacks[MAX_NUM_CPUS - 1][KERNEL_STACK_SIZE];
+
+void Cpu::init()
+{
+    // the local APIC isn't enabled yet; the ID is set when the other
+    // processors are started
+    Cpu& cpu = cpus[0];
+    initCpu(cpu, 0, 0);
+    numCpus = 1;
+
+    initGdt(&cpu.gdt, reinterpret_cast<uint32_t>(&cpu), sizeof(Cpu));
+
+    cpu.pageDir = getPageDirectory();
+    cpu.isOnline = true;
+}
+
+unsigned int Cpu::startApplicationProcessors()
+{
+    if (!Apic::isEnabled())
+    {
+        return numCpus;
+    }
+
+    cpus[0].apicId = Apic::getLocalApicId();
+
+    // copy the trampoline to low memory
+    uint8_t* trampoline = reinterpret_cast<uint8_t*>(KERNEL_VIRTUAL_BASE + TRAMPOLINE_ADDR);
+    size_t trampolineSize = apTrampolineEnd - apTrampolineStart;
+    memcpy(savedTrampolinePage, trampoline, trampolineSize);
+    memcpy(trampoline, apTrampolineStart, trampolineSize);
+
+    // the processors turn on paging in the trampoline, so identity map low
+    // memory with the kernel page table, which maps it in the higher half
+    uint32_t* pageDir = getKernelPageDirStart();
+    pageDir[0] = pageDir[KERNEL_VIRTUAL_BASE >> 22];
+
+    TrampolineParams* params = reinterpret_cast<TrampolineParams*>(trampoline + (apTrampolineParams - apTrampolineStart));
+    params->pageDir = getPageDirectory();
+
+    const MadtInfo& madtInfo = Apic::getMadtInfo();
+    for (unsigned int i = 0; i < madtInfo.numCpus; ++i)
+    {
+        uint8_t apicId = madtInfo.cpuApicIds[i];
+        if (apicId == cpus[0].apicId)
+        {
+            continue;
+        }
+
+        if (numCpus >= MAX_NUM_CPUS)
+        {
+            klog.logWarning(LOG_TAG, "Too many processors; ignoring APIC ID {}", apicId);
+            continue;
+        }
+
+        Cpu& cpu = cpus[numCpus];
+        initCpu(cpu, numCpus, apicId);
+        params->stack = reinterpret_cast<uint32_t>(kernelStacks[numCpus - 1] + KERNEL_STACK_SIZE);
+        params->cpu = &cpu;
+
+        if (startProcessor(cpu))
+        {
+            ++numCpus;
+        }
+        else
+        {
+            klog.logError(LOG_TAG, "Processor with APIC ID {} did not start", apicId);
+        }
+    }
+
+    // remove the identity mapping; reloading the page directory flushes it
+    // from the TLB
+    pageDir[0] = 0;
+    setPageDirectory(getPageDirectory());
+
+    memcpy(trampoline, savedTrampolinePage, trampolineSize);
+
+    return numCpus;
+}
+
+unsigned int Cpu::getNumCpus()
+{
+    return numCpus;
+}
+
+Cpu* Cpu::get(unsigned int idx)
+{
+    return &cpus[idx];
+}
+
+void Cpu::switchPageDirectory(uint32_t pageDirAddr)
+{
+    // the page directory is recorded first: a processor that sees the old
+    // one when it invalidates a page has cleared the entry before the TLB
+    // is flushed here
+    getCurrent()->pageDir = pageDirAddr;
+    setPageDirectory(pageDirAddr);
+}
+
+void Cpu::invalidatePage(uint32_t addr)
+{
+    ::invalidatePage(addr);
+
+    if (numCpus == 1)
+    {
+        return;
+    }
+
+    Cpu* current = getCurrent();
+    shootdownAddr = addr;
+
+    // the page table entry must be cleared before the other processors'
+    // page directories are read
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // processors that use another page directory flush the page from their
+    // TLB when they switch to this one
+    for (unsigned int i = 0; i < numCpus; ++i)
+    {
+        Cpu& cpu = cpus[i];
+        if (&cpu != current && cpu.isOnline && cpu.pageDir == current->pageDir)
+        {
+            cpu.shootdownPending = true;
+            Apic::sendFixedIpi(cpu.apicId, IRQ_START_NUM + IRQ_TLB_SHOOTDOWN);
+        }
+    }
+
+    for (unsigned int i = 0; i < numCpus; ++i)
+    {
+        while (cpus[i].shootdownPending)
+        {
+            asm volatile ("pause");
+        }
+    }
+}
+
+void Cpu::handleShootdown()
+{
+    Cpu* cpu = getCurrent();
+    if (cpu->shootdownPending)
+    {
+        ::invalidatePage(shootdownAddr);
+        __atomic_store_n(&cpu->shootdownPending, false, __ATOMIC_RELEASE);
+    }
+}
+
+void Cpu::initCpu(Cpu& cpu, unsigned int idx, uint8_t apicId)
+{
+    cpu.self = &cpu;
+    cpu.index = idx;
+    cpu.apicId = apicId;
+    cpu.isOnline = false;
+    cpu.kernelStack = 0;
+    cpu.process = nullptr;
+    cpu.timeSliceRunning = false;
+    cpu.timeSliceEnd = 0;
+    cpu.pageDir = 0;
+    cpu.shootdownPending = false;
+}
+
+bool Cpu::startProcessor(Cpu& cpu)
+{
+    Apic::sendInitIpi(cpu.apicId);
+
+    uint64_t initEnd = Clock::getNs() + INIT_DELAY_NS;
+    while (Clock::getNs() < initEnd)
+    {
+    }
+
+    // the processor may miss the first startup IPI, so it is sent twice
+    uint8_t vector = TRAMPOLINE_ADDR / PAGE_SIZE;
+    Apic::sendStartupIpi(cpu.apicId, vector);
+    if (waitUntilOnline(cpu, STARTUP_RETRY_NS))
+    {
+        return true;
+    }
+
+    Apic::sendStartupIpi(cpu.apicId, vector);
+    return waitUntilOnline(cpu, STARTUP_TIMEOUT_NS);
+}
+
+bool Cpu::waitUntilOnline(const Cpu& cpu, uint64_t timeoutNs)
+{
+    uint64_t end = Clock::getNs() + timeoutNs;
+    while (!cpu.isOnline && Clock::getNs() < end)
+    {
+    }
+
+    return cpu.isOnline;
+}
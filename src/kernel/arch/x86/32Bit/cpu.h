@@ -0,0 +1,174 @@
+#ifndef CPU_H_
+#define CPU_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "acpi.h"
+#include "gdt.h"
+#include "processmgr.h"
+
+/**
+ * @brief A processor's per-CPU data.
+ * @details Each processor's GDT has a segment that covers its Cpu, and the
+ * segment is in GS whenever the processor is in the kernel, so getCurrent()
+ * is a single load. The boot processor sets itself up with init(), and
+ * startApplicationProcessors() starts the other processors the MADT lists.
+ */
+class Cpu
+{
+public:
+    /// the maximum number of processors that are started
+    static constexpr unsigned int MAX_NUM_CPUS = MadtInfo::MAX_NUM_CPUS;
+
+    /// the size of each application processor's kernel stack
+    static constexpr size_t KERNEL_STACK_SIZE = 8192;
+
+    /// the Cpu's own address, which is read through GS to find the calling
+    /// processor's Cpu (this must be the first member)
+    Cpu* self;
+
+    /// the processor's index; the boot processor is 0
+    unsigned int index;
+
+    /// the processor's local APIC ID
+    uint8_t apicId;
+
+    /// whether the processor has started
+    volatile bool isOnline;
+
+    /// saves the processor's kernel stack while it runs a process
+    uintptr_t kernelStack;
+
+    /// the process the processor is running, or the last one it ran
+    ProcessMgr::ProcessInfo* process;
+
+    /// whether the running process's time slice is timed
+    bool timeSliceRunning;
+
+    /// when the time slice ends on the Clock
+    uint64_t timeSliceEnd;
+
+    /// the physical address of the page directory the processor uses
+    volatile uint32_t pageDir;
+
+    /// whether the processor has to invalidate shootdownAddr in its TLB
+    volatile bool shootdownPending;
+
+    /// the processor's GDT and TSS
+    Gdt gdt;
+
+    /**
+     * @brief Set up the boot processor's per-CPU data, GDT, and TSS.
+     */
+    static void init();
+
+    /**
+     * @brief Start the application processors. Each one sets up its own
+     * GDT, TSS, and local APIC, and then runs processes.
+     * @details The local APICs must be enabled and the kernel's page
+     * directory must be active.
+     * @return The number of running processors, including the boot
+     * processor.
+     */
+    static unsigned int startApplicationProcessors();
+
+    /**
+     * @brief Get the number of running processors.
+     */
+    static unsigned int getNumCpus();
+
+    /**
+     * @brief Get a running processor's Cpu.
+     */
+    static Cpu* get(unsigned int idx);
+
+    /**
+     * @brief Switch the calling processor to a page directory.
+     * @details Page directories must be switched with this rather than
+     * setPageDirectory(), so invalidatePage() knows which processors use
+     * which page directory.
+     * @param pageDirAddr The physical address of the page directory.
+     */
+    static void switchPageDirectory(uint32_t pageDirAddr);
+
+    /**
+     * @brief Invalidate a page in the TLB of every processor that uses the
+     * calling processor's page directory, and wait until they have.
+     * @details The other processors are sent a TLB shootdown IPI. The
+     * caller must hold the kernel lock, so there is one shootdown at a
+     * time.
+     */
+    static void invalidatePage(uint32_t addr);
+
+    /**
+     * @brief Invalidate the page if the calling processor was sent a TLB
+     * shootdown. Processors call this when they get the IPI, and while they
+     * spin with interrupts disabled, so the sender doesn't wait forever.
+     */
+    static void handleShootdown();
+
+    /**
+     * @brief Get the calling processor's Cpu.
+     */
+    static Cpu* getCurrent()
+    {
+        Cpu* cpu;
+        asm volatile ("movl %%gs:0, %0" : "=r"(cpu));
+        return cpu;
+    }
+
+private:
+    /// the physical address the application processors start at (must
+    /// match AP_TRAMPOLINE_ADDR in apboot.s)
+    static constexpr uintptr_t TRAMPOLINE_ADDR = 0x7000;
+
+    /// how long to wait after an INIT IPI before the startup IPI
+    static constexpr uint64_t INIT_DELAY_NS = 10'000'000;
+
+    /// how long to wait for a processor before sending the startup IPI again
+    static constexpr uint64_t STARTUP_RETRY_NS = 200'000;
+
+    /// how long to wait for a processor before giving up on it
+    static constexpr uint64_t STARTUP_TIMEOUT_NS = 100'000'000;
+
+    /**
+     * @brief The parameters at apTrampolineParams in apboot.s
+     */
+    struct TrampolineParams
+    {
+        uint32_t pageDir;
+        uint32_t stack;
+        Cpu* cpu;
+    };
+
+    static Cpu cpus[MAX_NUM_CPUS];
+
+    static unsigned int numCpus;
+
+    /// the page the TLB shootdown invalidates
+    static volatile uint32_t shootdownAddr;
+
+    /// the application processors' kernel stacks
+    static uint8_t kernelStacks[MAX_NUM_CPUS - 1][KERNEL_STACK_SIZE];
+
+    /**
+     * @brief Initialize a Cpu before its processor uses it.
+     */
+    static void initCpu(Cpu& cpu, unsigned int idx, uint8_t apicId);
+
+    /**
+     * @brief Send the INIT-SIPI-SIPI sequence to a processor and wait for it
+     * to come online.
+     * @return true if the processor started; false, otherwise
+     */
+    static bool startProcessor(Cpu& cpu);
+
+    /**
+     * @brief Wait until a processor is online or a time has passed.
+     * @return Whether the processor is online.
+     */
+    static bool waitUntilOnline(const Cpu& cpu, uint64_t timeoutNs);
+};
+
+#endif // CPU_H_
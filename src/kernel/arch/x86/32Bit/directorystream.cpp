@@ -0,0 +1,46 @@
+#include <unistd.h>
+
+#include "directorystream.h"
+#include "filesystem.h"
+
+DirectoryStream::DirectoryStream() :
+    fileSystem(nullptr),
+    position(0)
+{
+}
+
+void DirectoryStream::open(FileSystem* fileSystemPtr)
+{
+    fileSystem = fileSystemPtr;
+    position = 0;
+}
+
+ssize_t DirectoryStream::getDirEntries(dirent* entries, size_t maxEntries)
+{
+    size_t numEntries = fileSystem->getDirEntries(position, entries, maxEntries);
+    position += numEntries;
+
+    return static_cast<ssize_t>(numEntries);
+}
+
+off_t DirectoryStream::seek(off_t offset, int whence)
+{
+    if (whence != SEEK_SET || offset < 0)
+    {
+        return -1;
+    }
+
+    position = offset;
+
+    return offset;
+}
+
+void DirectoryStream::close()
+{
+    fileSystem = nullptr;
+}
+
+bool DirectoryStream::isOpen() const
+{
+    return fileSystem != nullptr;
+}
@@ -0,0 +1,65 @@
+#ifndef DIRECTORY_STREAM_H_
+#define DIRECTORY_STREAM_H_
+
+#include "stream.h"
+
+class FileSystem;
+
+/**
+ * @brief A stream to the root directory of a file system, which is read
+ * with getDirEntries().
+ */
+class DirectoryStream : public Stream
+{
+public:
+    DirectoryStream();
+
+    /**
+     * @brief Open the stream to a file system's root directory.
+     */
+    void open(FileSystem* fileSystemPtr);
+
+    bool canRead() const override
+    {
+        return true;
+    }
+
+    bool canWrite() const override
+    {
+        return false;
+    }
+
+    ssize_t read(uint8_t*, size_t) override
+    {
+        return -1;
+    }
+
+    ssize_t write(const uint8_t*, size_t) override
+    {
+        return -1;
+    }
+
+    ssize_t getDirEntries(dirent* entries, size_t maxEntries) override;
+
+    /**
+     * @brief Set the index of the next entry to read. Only SEEK_SET is
+     * supported, so the directory can be rewound.
+     */
+    off_t seek(off_t offset, int whence) override;
+
+    void flush() override
+    {
+    }
+
+    void close() override;
+
+    bool isOpen() const;
+
+private:
+    FileSystem* fileSystem;
+
+    /// index of the next entry to read
+    size_t position;
+};
+
+#endif // DIRECTORY_STREAM_H_
@@ -0,0 +1,115 @@
+#include "ext2filestream.h"
+#include "ext2filesystem.h"
+
+Ext2FileStream::Ext2FileStream()
+{
+    close();
+}
+
+void Ext2FileStream::open(Ext2FileSystem* fileSystemPtr, uint32_t inodeNum, size_t size)
+{
+    fileSystem = fileSystemPtr;
+    inode = inodeNum;
+    fileSize = size;
+    position = 0;
+    readAhead.reset();
+}
+
+ssize_t Ext2FileStream::read(uint8_t* buff, size_t nbyte)
+{
+    ssize_t rv = readAt(buff, nbyte, static_cast<off_t>(position));
+    if (rv > 0)
+    {
+        position += rv;
+    }
+
+    return rv;
+}
+
+ssize_t Ext2FileStream::readAt(uint8_t* buff, size_t nbyte, off_t offset)
+{
+    if (!isOpen() || offset < 0)
+    {
+        return -1;
+    }
+
+    return pageCache.read(fileSystem, inode, fileSize, static_cast<size_t>(offset), buff, nbyte, readAhead);
+}
+
+ssize_t Ext2FileStream::send(Stream* outStream, size_t nbyte)
+{
+    ssize_t rv = sendAt(outStream, nbyte, static_cast<off_t>(position));
+    if (rv > 0)
+    {
+        position += rv;
+    }
+
+    return rv;
+}
+
+ssize_t Ext2FileStream::sendAt(Stream* outStream, size_t nbyte, off_t offset)
+{
+    if (!isOpen() || offset < 0)
+    {
+        return -1;
+    }
+
+    return pageCache.send(fileSystem, inode, fileSize, static_cast<size_t>(offset), outStream, nbyte, readAhead);
+}
+
+off_t Ext2FileStream::seek(off_t offset, int whence)
+{
+    if (!isOpen())
+    {
+        return -1;
+    }
+
+    off_t base = 0;
+    switch (whence)
+    {
+        case SEEK_SET:
+            base = 0;
+            break;
+
+        case SEEK_CUR:
+            base = static_cast<off_t>(position);
+            break;
+
+        case SEEK_END:
+            base = size();
+            break;
+
+        default:
+            return -1;
+    }
+
+    off_t newPosition = base + offset;
+    if (newPosition < 0)
+    {
+        return -1;
+    }
+
+    position = static_cast<size_t>(newPosition);
+
+    return newPosition;
+}
+
+off_t Ext2FileStream::size() const
+{
+    if (!isOpen())
+    {
+        return -1;
+    }
+
+    return static_cast<off_t>(fileSize);
+}
+
+void Ext2FileStream::close()
+{
+    open(nullptr, 0, 0);
+}
+
+bool Ext2FileStream::isOpen() const
+{
+    return inode != 0;
+}
@@ -0,0 +1,70 @@
+#ifndef EXT2_FILE_STREAM_H_
+#define EXT2_FILE_STREAM_H_
+
+#include "pagecache.h"
+#include "stream.h"
+
+class Ext2FileSystem;
+
+class Ext2FileStream : public Stream
+{
+public:
+    Ext2FileStream();
+
+    /**
+     * @brief Open the stream to a file.
+     * @param fileSystemPtr The file system the file is in.
+     * @param inodeNum The file's inode number.
+     * @param size The size of the file in bytes.
+     */
+    void open(Ext2FileSystem* fileSystemPtr, uint32_t inodeNum, size_t size);
+
+    bool canRead() const override
+    {
+        return true;
+    }
+
+    bool canWrite() const override
+    {
+        return false;
+    }
+
+    ssize_t read(uint8_t* buff, size_t nbyte) override;
+
+    ssize_t readAt(uint8_t* buff, size_t nbyte, off_t offset) override;
+
+    ssize_t write(const uint8_t*, size_t) override
+    {
+        return -1;
+    }
+
+    ssize_t send(Stream* outStream, size_t nbyte) override;
+
+    ssize_t sendAt(Stream* outStream, size_t nbyte, off_t offset) override;
+
+    off_t seek(off_t offset, int whence) override;
+
+    off_t size() const override;
+
+    void flush() override
+    {
+    }
+
+    void close() override;
+
+    bool isOpen() const;
+
+private:
+    Ext2FileSystem* fileSystem;
+    uint32_t inode;
+
+    /// size of the file in bytes
+    size_t fileSize;
+
+    /// offset from the start of the file
+    size_t position;
+
+    PageCache::ReadAhead readAhead;
+};
+
+#endif // EXT2_FILE_STREAM_H_
@@ -0,0 +1,753 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include "blockdevice.h"
+#include "ext2filesystem.h"
+#include "kernellogger.h"
+#include "pageframemgr.h"
+#include "paging.h"
+#include "processmgr.h"
+
+namespace
+{
+
+/// the superblock's offset from the start of the device
+constexpr static uint32_t SUPERBLOCK_OFFSET = 1024;
+
+/// revision 0 file systems have fixed-size inodes
+constexpr static uint32_t GOOD_OLD_INODE_SIZE = 128;
+
+/// directory entries have a file type field
+constexpr static uint32_t INCOMPAT_FILETYPE = 0x0002;
+
+// inode mode file types
+constexpr static uint16_t MODE_TYPE_MASK = 0xF000;
+constexpr static uint16_t MODE_DIRECTORY = 0x4000;
+constexpr static uint16_t MODE_REGULAR = 0x8000;
+
+// inode field offsets
+constexpr static size_t INODE_MODE = 0;
+constexpr static size_t INODE_SIZE = 4;
+constexpr static size_t INODE_BLOCKS = 40;
+
+/**
+ * @brief The fields of the superblock that are used
+ */
+struct Superblock
+{
+    uint32_t numInodes;
+    uint32_t numBlocks;
+    uint32_t numReservedBlocks;
+    uint32_t numFreeBlocks;
+    uint32_t numFreeInodes;
+    uint32_t firstDataBlock;
+    uint32_t logBlockSize;
+    uint32_t logFragmentSize;
+    uint32_t blocksPerGroup;
+    uint32_t fragmentsPerGroup;
+    uint32_t inodesPerGroup;
+    uint32_t mountTime;
+    uint32_t writeTime;
+    uint16_t mountCount;
+    uint16_t maxMountCount;
+    uint16_t magic;
+    uint16_t state;
+    uint16_t errors;
+    uint16_t minorRevision;
+    uint32_t lastCheck;
+    uint32_t checkInterval;
+    uint32_t creatorOs;
+    uint32_t revision;
+    uint16_t defaultReservedUid;
+    uint16_t defaultReservedGid;
+    uint32_t firstInode;
+    uint16_t inodeSize;
+    uint16_t blockGroup;
+    uint32_t compatibleFeatures;
+    uint32_t incompatibleFeatures;
+    uint32_t readOnlyCompatibleFeatures;
+};
+
+/**
+ * @brief The fixed part of a directory entry, which is followed by the name
+ */
+struct DirEntry
+{
+    uint32_t inode;
+    uint16_t recordSize;
+    uint8_t nameLength;
+    uint8_t fileType;
+};
+
+} // namespace
+
+const char* Ext2FileSystem::LOG_TAG = "Ext2";
+
+Ext2FileSystem::Ext2FileSystem() :
+    device(nullptr),
+    pageFrameMgr(nullptr),
+    blockSize(0),
+    sectorsPerBlock(0),
+    inodeSize(0),
+    inodesPerGroup(0),
+    numInodes(0),
+    numGroups(0),
+    useCounter(0),
+    dirPosition{0, 0}
+{
+}
+
+void Ext2FileSystem::setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr)
+{
+    pageFrameMgr = pageFrameMgrPtr;
+}
+
+bool Ext2FileSystem::mount(BlockDevice* blockDevice)
+{
+    device = blockDevice;
+
+    // read the superblock with the smallest block size
+    blockSize = 1024;
+    sectorsPerBlock = blockSize / BlockDevice::SECTOR_SIZE;
+
+    Superblock superblock;
+    if (!readBlock(SUPERBLOCK_OFFSET / blockSize, 0, &superblock, sizeof(superblock)))
+    {
+        device = nullptr;
+        return false;
+    }
+
+    if (superblock.magic != MAGIC)
+    {
+        device = nullptr;
+        return false;
+    }
+
+    if ((superblock.incompatibleFeatures & ~INCOMPAT_FILETYPE) != 0)
+    {
+        klog.logError(LOG_TAG, "Unsupported features: {x}", superblock.incompatibleFeatures);
+        device = nullptr;
+        return false;
+    }
+
+    blockSize = 1024u << superblock.logBlockSize;
+    if (blockSize > MAX_BLOCK_SIZE || superblock.blocksPerGroup == 0 || superblock.inodesPerGroup == 0)
+    {
+        klog.logError(LOG_TAG, "Unsupported block size: {}", blockSize);
+        device = nullptr;
+        return false;
+    }
+    sectorsPerBlock = blockSize / BlockDevice::SECTOR_SIZE;
+
+    inodeSize = (superblock.revision == 0) ? GOOD_OLD_INODE_SIZE : superblock.inodeSize;
+    inodesPerGroup = superblock.inodesPerGroup;
+    numInodes = superblock.numInodes;
+
+    numGroups = (superblock.numBlocks - superblock.firstDataBlock + superblock.blocksPerGroup - 1) / superblock.blocksPerGroup;
+    if (inodeSize < GOOD_OLD_INODE_SIZE || numGroups == 0 || numGroups > MAX_NUM_GROUPS)
+    {
+        klog.logError(LOG_TAG, "Unsupported layout: {} groups, {}-byte inodes", numGroups, inodeSize);
+        device = nullptr;
+        return false;
+    }
+
+    // the group descriptor table starts in the block after the superblock
+    uint32_t tableBlock = superblock.firstDataBlock + 1;
+    size_t tableSize = numGroups * sizeof(GroupDescriptor);
+    uint8_t* table = reinterpret_cast<uint8_t*>(groups);
+    for (size_t offset = 0; offset < tableSize; offset += blockSize)
+    {
+        size_t size = tableSize - offset;
+        if (size > blockSize)
+        {
+            size = blockSize;
+        }
+
+        if (!readBlock(tableBlock + offset / blockSize, 0, table + offset, size))
+        {
+            device = nullptr;
+            return false;
+        }
+    }
+
+    for (CachedInode& entry : inodeCache)
+    {
+        entry.number = 0;
+    }
+
+    for (CachedIndirectBlock& entry : indirectCache)
+    {
+        entry.block = 0;
+    }
+
+    dirPosition = {0, 0};
+
+    klog.logInfo(LOG_TAG, "Mounted: {} blocks of {} bytes, {} groups", superblock.numBlocks, blockSize, numGroups);
+
+    return true;
+}
+
+Stream* Ext2FileSystem::openStream(const char* path, int oflag)
+{
+    // the file system is read-only
+    if (device == nullptr || (oflag & (O_WRONLY | O_CREAT | O_TRUNC | O_APPEND)) != 0)
+    {
+        return nullptr;
+    }
+
+    uint32_t number = lookup(path);
+    Inode inode;
+    if (number == 0 || !getInode(number, inode) || (inode.mode & MODE_TYPE_MASK) != MODE_REGULAR)
+    {
+        return nullptr;
+    }
+
+    for (Ext2FileStream& stream : streams)
+    {
+        if (!stream.isOpen())
+        {
+            stream.open(this, number, inode.size);
+            return &stream;
+        }
+    }
+
+    return nullptr;
+}
+
+size_t Ext2FileSystem::getDirEntries(size_t index, dirent* entries, size_t maxEntries)
+{
+    if (device == nullptr || maxEntries == 0)
+    {
+        return 0;
+    }
+
+    // continue from where the last call stopped instead of reading the
+    // directory from the start again
+    size_t entryIdx = 0;
+    uint32_t offset = 0;
+    if (index > 0 && index == dirPosition.index)
+    {
+        entryIdx = dirPosition.index;
+        offset = dirPosition.offset;
+    }
+
+    size_t numEntries = 0;
+    forEachEntry(ROOT_INODE, offset, [&](uint32_t number, const char* entryName, size_t nameLength, uint32_t nextOffset) {
+        offset = nextOffset;
+
+        // skip the current and parent directory entries
+        if ( (nameLength == 1 && entryName[0] == '.') ||
+             (nameLength == 2 && entryName[0] == '.' && entryName[1] == '.') )
+        {
+            return false;
+        }
+
+        // a name that doesn't fit would be cut off, and could then match
+        // another file
+        if (nameLength > NAME_MAX)
+        {
+            klog.logWarning(LOG_TAG, "Skipping directory entry {} with a name longer than {} characters", number, NAME_MAX);
+            return false;
+        }
+
+        if (entryIdx++ < index)
+        {
+            return false;
+        }
+
+        dirent& entry = entries[numEntries++];
+        entry.d_ino = number;
+        memcpy(entry.d_name, entryName, nameLength);
+        entry.d_name[nameLength] = '\0';
+
+        // stop once the buffer is full
+        return numEntries == maxEntries;
+    });
+
+    dirPosition = {index + numEntries, offset};
+
+    return numEntries;
+}
+
+size_t Ext2FileSystem::readPages(uint32_t number, size_t pageIdx, const uintptr_t* frames, size_t numPages)
+{
+    Inode inode;
+    if (device == nullptr || !getInode(number, inode))
+    {
+        return 0;
+    }
+
+    uint32_t blocksPerPage = PAGE_SIZE / blockSize;
+    uint32_t numFileBlocks = (inode.size + blockSize - 1) / blockSize;
+
+    size_t numRead = 0;
+    while (numRead < numPages)
+    {
+        uint32_t fileBlock = (pageIdx + numRead) * blocksPerPage;
+        uint32_t maxBlocks = (numPages - numRead) * blocksPerPage;
+
+        // blocks past the end of the file read as zeros
+        BlockRun run = {fileBlock, 0, maxBlocks};
+        if (fileBlock < numFileBlocks && !getBlockRun(number, inode, fileBlock, maxBlocks, run))
+        {
+            break;
+        }
+
+        size_t runPages = run.numBlocks / blocksPerPage;
+        if (runPages == 0)
+        {
+            // the page's blocks are not contiguous
+            if (!readPageByBlock(inode, pageIdx + numRead, frames[numRead]))
+            {
+                break;
+            }
+
+            ++numRead;
+            continue;
+        }
+
+        bool ok = false;
+        if (run.diskBlock == 0)
+        {
+            ok = zeroPages(frames + numRead, runPages);
+        }
+        else
+        {
+            ok = device->read(run.diskBlock * sectorsPerBlock, runPages * blocksPerPage * sectorsPerBlock, frames + numRead);
+        }
+
+        if (!ok)
+        {
+            break;
+        }
+
+        numRead += runPages;
+    }
+
+    return numRead;
+}
+
+bool Ext2FileSystem::readBlock(uint32_t block, size_t offset, void* buff, size_t size)
+{
+    uintptr_t frame = 0;
+    const uint8_t* data = mapBlock(block, frame);
+    if (data == nullptr)
+    {
+        return false;
+    }
+
+    memcpy(buff, data + offset, size);
+    releaseBlock(data, frame);
+
+    return true;
+}
+
+const uint8_t* Ext2FileSystem::mapBlock(uint32_t block, uintptr_t& frame)
+{
+    frame = pageFrameMgr->allocPageFrame();
+    if (frame == 0)
+    {
+        klog.logWarning(LOG_TAG, "Could not allocate a page frame");
+        return nullptr;
+    }
+
+    uint8_t* data = nullptr;
+    if (device->read(block * sectorsPerBlock, sectorsPerBlock, &frame))
+    {
+        data = processMgr.mapTempPage(frame);
+    }
+
+    if (data == nullptr)
+    {
+        pageFrameMgr->freePageFrame(frame);
+    }
+
+    return data;
+}
+
+void Ext2FileSystem::releaseBlock(const uint8_t* data, uintptr_t frame)
+{
+    processMgr.unmapTempPage(const_cast<uint8_t*>(data));
+    pageFrameMgr->freePageFrame(frame);
+}
+
+bool Ext2FileSystem::getInode(uint32_t number, Inode& inode)
+{
+    if (number == 0 || number > numInodes)
+    {
+        return false;
+    }
+
+    for (CachedInode& entry : inodeCache)
+    {
+        if (entry.number == number)
+        {
+            entry.lastUse = ++useCounter;
+            inode = entry.inode;
+            return true;
+        }
+    }
+
+    size_t group = (number - 1) / inodesPerGroup;
+    if (group >= numGroups)
+    {
+        return false;
+    }
+
+    size_t offset = ((number - 1) % inodesPerGroup) * inodeSize;
+    uint32_t block = groups[group].inodeTable + offset / blockSize;
+
+    uint8_t raw[GOOD_OLD_INODE_SIZE];
+    if (!readBlock(block, offset % blockSize, raw, sizeof(raw)))
+    {
+        return false;
+    }
+
+    memcpy(&inode.mode, raw + INODE_MODE, sizeof(inode.mode));
+    memcpy(&inode.size, raw + INODE_SIZE, sizeof(inode.size));
+    memcpy(inode.blocks, raw + INODE_BLOCKS, sizeof(inode.blocks));
+
+    // replace the least recently used entry (the cache may have changed
+    // while the block was read)
+    CachedInode* victim = &inodeCache[0];
+    for (CachedInode& entry : inodeCache)
+    {
+        if (entry.number == number)
+        {
+            return true;
+        }
+
+        if (entry.number == 0 || entry.lastUse < victim->lastUse)
+        {
+            victim = &entry;
+        }
+    }
+
+    victim->number = number;
+    victim->lastUse = ++useCounter;
+    victim->inode = inode;
+    victim->lastRun.numBlocks = 0;
+
+    return true;
+}
+
+bool Ext2FileSystem::getIndirectPointer(uint32_t block, uint32_t idx, uint32_t& pointer)
+{
+    for (CachedIndirectBlock& entry : indirectCache)
+    {
+        if (entry.block == block)
+        {
+            entry.lastUse = ++useCounter;
+            pointer = entry.pointers[idx];
+            return true;
+        }
+    }
+
+    uintptr_t frame = 0;
+    const uint8_t* data = mapBlock(block, frame);
+    if (data == nullptr)
+    {
+        return false;
+    }
+
+    pointer = reinterpret_cast<const uint32_t*>(data)[idx];
+
+    // replace the least recently used entry unless another process cached
+    // the block while it was read
+    CachedIndirectBlock* victim = &indirectCache[0];
+    for (CachedIndirectBlock& entry : indirectCache)
+    {
+        if (entry.block == block)
+        {
+            victim = nullptr;
+            break;
+        }
+
+        if (entry.block == 0 || entry.lastUse < victim->lastUse)
+        {
+            victim = &entry;
+        }
+    }
+
+    if (victim != nullptr)
+    {
+        victim->block = block;
+        victim->lastUse = ++useCounter;
+        memcpy(victim->pointers, data, blockSize);
+    }
+
+    releaseBlock(data, frame);
+
+    return true;
+}
+
+bool Ext2FileSystem::getBlockRun(uint32_t number, const Inode& inode, uint32_t fileBlock, uint32_t maxBlocks, BlockRun& run)
+{
+    // use the inode's last run if the block is in it
+    for (const CachedInode& entry : inodeCache)
+    {
+        const BlockRun& lastRun = entry.lastRun;
+        if ( entry.number == number && lastRun.numBlocks > 0 &&
+             fileBlock >= lastRun.fileBlock && fileBlock - lastRun.fileBlock < lastRun.numBlocks )
+        {
+            uint32_t offset = fileBlock - lastRun.fileBlock;
+            run.fileBlock = fileBlock;
+            run.diskBlock = (lastRun.diskBlock == 0) ? 0 : lastRun.diskBlock + offset;
+            run.numBlocks = lastRun.numBlocks - offset;
+            if (run.numBlocks > maxBlocks)
+            {
+                run.numBlocks = maxBlocks;
+            }
+
+            return true;
+        }
+    }
+
+    uint32_t numFileBlocks = (inode.size + blockSize - 1) / blockSize;
+
+    uint32_t diskBlock = 0;
+    if (!getDiskBlock(inode, fileBlock, diskBlock))
+    {
+        return false;
+    }
+
+    // extend the run while the next file block is in the next disk block
+    run = {fileBlock, diskBlock, 1};
+    while (run.numBlocks < maxBlocks && fileBlock + run.numBlocks < numFileBlocks)
+    {
+        uint32_t nextDiskBlock = 0;
+        if (!getDiskBlock(inode, fileBlock + run.numBlocks, nextDiskBlock))
+        {
+            break;
+        }
+
+        uint32_t expected = (run.diskBlock == 0) ? 0 : run.diskBlock + run.numBlocks;
+        if (nextDiskBlock != expected)
+        {
+            break;
+        }
+
+        ++run.numBlocks;
+    }
+
+    for (CachedInode& entry : inodeCache)
+    {
+        if (entry.number == number)
+        {
+            entry.lastRun = run;
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool Ext2FileSystem::getDiskBlock(const Inode& inode, uint32_t fileBlock, uint32_t& diskBlock)
+{
+    const uint32_t pointersPerBlock = blockSize / sizeof(uint32_t);
+
+    if (fileBlock < NUM_DIRECT_BLOCKS)
+    {
+        diskBlock = inode.blocks[fileBlock];
+        return true;
+    }
+
+    // follow the indirect blocks, stopping at a hole
+    uint32_t idx = fileBlock - NUM_DIRECT_BLOCKS;
+    uint32_t block = 0;
+    int numLevels = 0;
+    if (idx < pointersPerBlock)
+    {
+        block = inode.blocks[NUM_DIRECT_BLOCKS];
+        numLevels = 1;
+    }
+    else if ((idx -= pointersPerBlock) < pointersPerBlock * pointersPerBlock)
+    {
+        block = inode.blocks[NUM_DIRECT_BLOCKS + 1];
+        numLevels = 2;
+    }
+    else
+    {
+        idx -= pointersPerBlock * pointersPerBlock;
+        block = inode.blocks[NUM_DIRECT_BLOCKS + 2];
+        numLevels = 3;
+    }
+
+    for (int level = numLevels - 1; level >= 0 && block != 0; --level)
+    {
+        uint32_t divisor = 1;
+        for (int i = 0; i < level; ++i)
+        {
+            divisor *= pointersPerBlock;
+        }
+
+        if (!getIndirectPointer(block, (idx / divisor) % pointersPerBlock, block))
+        {
+            return false;
+        }
+    }
+
+    diskBlock = block;
+    return true;
+}
+
+template<typename Visitor>
+bool Ext2FileSystem::forEachEntry(uint32_t dirNumber, uint32_t startOffset, Visitor visitor)
+{
+    Inode dir;
+    if (!getInode(dirNumber, dir) || (dir.mode & MODE_TYPE_MASK) != MODE_DIRECTORY)
+    {
+        return false;
+    }
+
+    uint32_t numBlocks = (dir.size + blockSize - 1) / blockSize;
+    for (uint32_t fileBlock = startOffset / blockSize; fileBlock < numBlocks; ++fileBlock)
+    {
+        uint32_t diskBlock = 0;
+        if (!getDiskBlock(dir, fileBlock, diskBlock))
+        {
+            return false;
+        }
+
+        if (diskBlock == 0)
+        {
+            continue;
+        }
+
+        uintptr_t frame = 0;
+        const uint8_t* data = mapBlock(diskBlock, frame);
+        if (data == nullptr)
+        {
+            return false;
+        }
+
+        // entries don't cross blocks, so only the first block visited can
+        // start in the middle
+        bool found = false;
+        size_t offset = (fileBlock == startOffset / blockSize) ? startOffset % blockSize : 0;
+        while (!found && offset + sizeof(DirEntry) <= blockSize)
+        {
+            const DirEntry* entry = reinterpret_cast<const DirEntry*>(data + offset);
+            if (entry->recordSize < sizeof(DirEntry) || entry->recordSize > blockSize - offset ||
+                entry->nameLength > entry->recordSize - sizeof(DirEntry))
+            {
+                klog.logError(LOG_TAG, "Invalid directory entry in block {}", diskBlock);
+                break;
+            }
+
+            offset += entry->recordSize;
+
+            if (entry->inode != 0)
+            {
+                uint32_t nextOffset = fileBlock * blockSize + offset;
+                found = visitor(entry->inode, reinterpret_cast<const char*>(entry + 1), entry->nameLength, nextOffset);
+            }
+        }
+
+        releaseBlock(data, frame);
+
+        if (found)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t Ext2FileSystem::findInDirectory(uint32_t dirNumber, const char* name, size_t nameLength)
+{
+    uint32_t number = 0;
+    forEachEntry(dirNumber, 0, [&](uint32_t entryNumber, const char* entryName, size_t entryNameLength, uint32_t) {
+        if (entryNameLength == nameLength && memcmp(entryName, name, nameLength) == 0)
+        {
+            number = entryNumber;
+            return true;
+        }
+
+        return false;
+    });
+
+    return number;
+}
+
+uint32_t Ext2FileSystem::lookup(const char* path)
+{
+    uint32_t number = ROOT_INODE;
+    while (*path != '\0' && number != 0)
+    {
+        // skip separators
+        if (*path == '/')
+        {
+            ++path;
+            continue;
+        }
+
+        size_t length = 0;
+        while (path[length] != '\0' && path[length] != '/')
+        {
+            ++length;
+        }
+
+        number = findInDirectory(number, path, length);
+        path += length;
+    }
+
+    return number;
+}
+
+bool Ext2FileSystem::readPageByBlock(const Inode& inode, size_t pageIdx, uintptr_t frame)
+{
+    uint8_t* page = processMgr.mapTempPage(frame);
+    if (page == nullptr)
+    {
+        return false;
+    }
+
+    uint32_t blocksPerPage = PAGE_SIZE / blockSize;
+    uint32_t numFileBlocks = (inode.size + blockSize - 1) / blockSize;
+
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < blocksPerPage; ++i)
+    {
+        uint32_t fileBlock = pageIdx * blocksPerPage + i;
+        uint32_t diskBlock = 0;
+        if (fileBlock < numFileBlocks)
+        {
+            ok = getDiskBlock(inode, fileBlock, diskBlock);
+        }
+
+        if (ok && diskBlock == 0)
+        {
+            memset(page + i * blockSize, 0, blockSize);
+        }
+        else if (ok)
+        {
+            ok = readBlock(diskBlock, 0, page + i * blockSize, blockSize);
+        }
+    }
+
+    processMgr.unmapTempPage(page);
+
+    return ok;
+}
+
+bool Ext2FileSystem::zeroPages(const uintptr_t* frames, size_t numPages)
+{
+    for (size_t i = 0; i < numPages; ++i)
+    {
+        uint8_t* page = processMgr.mapTempPage(frames[i]);
+        if (page == nullptr)
+        {
+            return false;
+        }
+
+        memset(page, 0, PAGE_SIZE);
+        processMgr.unmapTempPage(page);
+    }
+
+    return true;
+}
+
+// create Ext2FileSystem instance
+Ext2FileSystem ext2FileSystem;
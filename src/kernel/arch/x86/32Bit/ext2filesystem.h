@@ -0,0 +1,254 @@
+#ifndef EXT2_FILE_SYSTEM_H_
+#define EXT2_FILE_SYSTEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ext2filestream.h"
+#include "filesystem.h"
+
+class BlockDevice;
+class PageFrameMgr;
+
+/**
+ * @brief A read-only ext2 file system on a block device.
+ * @details Group descriptors are read when the file system is mounted.
+ * Inodes and indirect blocks are cached, and so is the last run of
+ * contiguous blocks found in each cached inode's block map. File data is
+ * read through the page cache, which reads a run of pages with one call to
+ * readPages(); the pages are read from the device with one request per run
+ * of contiguous blocks.
+ *
+ * Only the root directory can be listed, because directory streams are
+ * only opened at mount points. Listing it continues from where the last
+ * getDirEntries() call stopped, so reading the directory in a loop only
+ * reads each directory block once. Names longer than NAME_MAX can't be
+ * returned in a dirent, so those entries are skipped.
+ *
+ * The caches are only changed while interrupts are disabled and never
+ * across a device request (which may block), so processes that block on
+ * the device don't see them change under them.
+ */
+class Ext2FileSystem : public FileSystem
+{
+public:
+    /// The tag used in the kernel log
+    static const char* LOG_TAG;
+
+    constexpr static uint16_t MAGIC = 0xEF53;
+
+    /// the inode number of the root directory
+    constexpr static uint32_t ROOT_INODE = 2;
+
+    Ext2FileSystem();
+
+    void setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr);
+
+    /**
+     * @brief Mount the file system on a block device.
+     * @return true if the device holds a supported ext2 file system; false,
+     * otherwise
+     */
+    bool mount(BlockDevice* blockDevice);
+
+    Stream* openStream(const char* path, int oflag) override;
+
+    bool unlink(const char*) override
+    {
+        return false;
+    }
+
+    size_t getDirEntries(size_t index, dirent* entries, size_t maxEntries) override;
+
+    size_t readPages(uint32_t inode, size_t pageIdx, const uintptr_t* frames, size_t numPages) override;
+
+private:
+    friend class Ext2FileSystemTestClass;
+
+    constexpr static size_t MAX_BLOCK_SIZE = 4096;
+    constexpr static size_t MAX_NUM_GROUPS = 128;
+    constexpr static size_t NUM_CACHED_INODES = 32;
+    constexpr static size_t NUM_CACHED_INDIRECT_BLOCKS = 8;
+    constexpr static size_t MAX_NUM_STREAMS = 16;
+
+    /// number of block pointers in an inode
+    constexpr static size_t NUM_BLOCK_POINTERS = 15;
+
+    /// number of direct block pointers in an inode
+    constexpr static size_t NUM_DIRECT_BLOCKS = 12;
+
+    struct GroupDescriptor
+    {
+        uint32_t blockBitmap;
+        uint32_t inodeBitmap;
+        uint32_t inodeTable;
+        uint16_t numFreeBlocks;
+        uint16_t numFreeInodes;
+        uint16_t numDirs;
+        uint16_t pad;
+        uint8_t reserved[12];
+    };
+
+    /**
+     * @brief The fields of an on-disk inode that are used.
+     */
+    struct Inode
+    {
+        uint16_t mode;
+        uint32_t size;
+        uint32_t blocks[NUM_BLOCK_POINTERS];
+    };
+
+    /**
+     * @brief A run of file blocks stored in contiguous disk blocks (or a
+     * run of holes if the disk block is 0).
+     */
+    struct BlockRun
+    {
+        uint32_t fileBlock;
+        uint32_t diskBlock;
+        uint32_t numBlocks;
+    };
+
+    struct CachedInode
+    {
+        /// the inode number (0 if the entry is unused)
+        uint32_t number;
+
+        uint32_t lastUse;
+
+        Inode inode;
+
+        /// the last run found in the inode's block map
+        BlockRun lastRun;
+    };
+
+    /**
+     * @brief Where listing the root directory stopped.
+     */
+    struct DirPosition
+    {
+        /// the index of the next entry to return
+        size_t index;
+
+        /// the offset of the entry after the last one returned in the
+        /// directory's data
+        uint32_t offset;
+    };
+
+    struct CachedIndirectBlock
+    {
+        /// the block number (0 if the entry is unused)
+        uint32_t block;
+
+        uint32_t lastUse;
+
+        uint32_t pointers[MAX_BLOCK_SIZE / sizeof(uint32_t)];
+    };
+
+    BlockDevice* device;
+    PageFrameMgr* pageFrameMgr;
+
+    uint32_t blockSize;
+    uint32_t sectorsPerBlock;
+    uint32_t inodeSize;
+    uint32_t inodesPerGroup;
+    uint32_t numInodes;
+
+    GroupDescriptor groups[MAX_NUM_GROUPS];
+    size_t numGroups;
+
+    CachedInode inodeCache[NUM_CACHED_INODES];
+    CachedIndirectBlock indirectCache[NUM_CACHED_INDIRECT_BLOCKS];
+
+    /// incremented each time a cache entry is used
+    uint32_t useCounter;
+
+    DirPosition dirPosition;
+
+    Ext2FileStream streams[MAX_NUM_STREAMS];
+
+    /**
+     * @brief Read part of a block.
+     * @param block The block number.
+     * @param offset The offset in the block.
+     * @param [out] buff The buffer to read into.
+     * @param size The number of bytes to read.
+     */
+    bool readBlock(uint32_t block, size_t offset, void* buff, size_t size);
+
+    /**
+     * @brief Read a block into a page frame and map it.
+     * @param [out] frame The page frame, which must be released with
+     * releaseBlock().
+     * @return The mapped block, or nullptr if it could not be read.
+     */
+    const uint8_t* mapBlock(uint32_t block, uintptr_t& frame);
+
+    void releaseBlock(const uint8_t* data, uintptr_t frame);
+
+    /**
+     * @brief Get an inode from the cache, reading it if it's not cached.
+     */
+    bool getInode(uint32_t number, Inode& inode);
+
+    /**
+     * @brief Get a block pointer from an indirect block.
+     */
+    bool getIndirectPointer(uint32_t block, uint32_t idx, uint32_t& pointer);
+
+    /**
+     * @brief Find the run of contiguous disk blocks that starts at a file
+     * block.
+     * @param number The inode number.
+     * @param inode The inode.
+     * @param fileBlock The file block.
+     * @param maxBlocks The maximum length of the run.
+     * @param [out] run The run.
+     */
+    bool getBlockRun(uint32_t number, const Inode& inode, uint32_t fileBlock, uint32_t maxBlocks, BlockRun& run);
+
+    /**
+     * @brief Get the disk block a file block is stored in (0 for a hole).
+     */
+    bool getDiskBlock(const Inode& inode, uint32_t fileBlock, uint32_t& diskBlock);
+
+    /**
+     * @brief Call a function for each entry in a directory until it returns
+     * true.
+     * @param dirNumber The directory's inode number.
+     * @param startOffset The offset of the first entry to visit in the
+     * directory's data.
+     * @param visitor Called with the entry's inode number, name, name
+     * length, and the offset of the next entry.
+     * @return true if the visitor returned true; false, otherwise
+     */
+    template<typename Visitor>
+    bool forEachEntry(uint32_t dirNumber, uint32_t startOffset, Visitor visitor);
+
+    /**
+     * @brief Find a file in a directory.
+     * @return The file's inode number, or 0 if it wasn't found.
+     */
+    uint32_t findInDirectory(uint32_t dirNumber, const char* name, size_t nameLength);
+
+    /**
+     * @brief Find a file's inode number from its path.
+     * @return The inode number, or 0 if the file wasn't found.
+     */
+    uint32_t lookup(const char* path);
+
+    /**
+     * @brief Fill a page of a file whose blocks are not contiguous on disk
+     * one block at a time.
+     */
+    bool readPageByBlock(const Inode& inode, size_t pageIdx, uintptr_t frame);
+
+    /**
+     * @brief Fill page frames with zeros.
+     */
+    bool zeroPages(const uintptr_t* frames, size_t numPages);
+};
+
+extern Ext2FileSystem ext2FileSystem;
+
+#endif // EXT2_FILE_SYSTEM_H_
@@ -0,0 +1,381 @@
+#include <dirent.h>
+#include <string.h>
+#include "blockdevice.h"
+#include "ext2filesystem.h"
+#include "processmgr.h"
+#include "unittests.h"
+
+namespace
+{
+
+constexpr uint32_t BLOCK_SIZE = 1024;
+constexpr uint32_t NUM_BLOCKS = 64;
+constexpr uint32_t POINTERS_PER_BLOCK = BLOCK_SIZE / sizeof(uint32_t);
+
+// the blocks of the test file: file blocks 0-14 are in disk blocks 20-34,
+// partly through the indirect block, followed by a block elsewhere and
+// holes, and file block 268 is reached through the double indirect block
+constexpr uint32_t FIRST_DISK_BLOCK = 20;
+constexpr uint32_t NUM_CONTIGUOUS_BLOCKS = 15;
+constexpr uint32_t INDIRECT_BLOCK = 40;
+constexpr uint32_t DOUBLE_INDIRECT_BLOCK = 41;
+constexpr uint32_t DOUBLE_INDIRECT_LEAF_BLOCK = 42;
+constexpr uint32_t SCATTERED_DISK_BLOCK = 50;
+constexpr uint32_t DOUBLE_INDIRECT_DISK_BLOCK = 55;
+
+// the root directory's two blocks
+constexpr uint32_t FIRST_DIR_BLOCK = 60;
+
+constexpr uint32_t SCATTERED_FILE_BLOCK = NUM_CONTIGUOUS_BLOCKS;
+constexpr uint32_t FIRST_DOUBLE_INDIRECT_FILE_BLOCK = 12 + POINTERS_PER_BLOCK;
+constexpr uint32_t NUM_FILE_BLOCKS = FIRST_DOUBLE_INDIRECT_FILE_BLOCK + 2;
+
+/**
+ * @brief A block device that reads from an image in memory and counts its
+ * requests.
+ */
+class TestBlockDevice : public BlockDevice
+{
+public:
+    uint8_t image[NUM_BLOCKS * BLOCK_SIZE];
+
+    size_t numRequests = 0;
+
+    void setPointer(uint32_t block, uint32_t idx, uint32_t pointer)
+    {
+        memcpy(image + block * BLOCK_SIZE + idx * sizeof(uint32_t), &pointer, sizeof(pointer));
+    }
+
+    /**
+     * @brief Add a directory entry.
+     * @return The offset of the next entry in the block.
+     */
+    size_t addDirEntry(uint32_t block, size_t offset, uint32_t inode, const char* name, bool isLast)
+    {
+        size_t nameLength = strlen(name);
+        size_t recordSize = isLast ? BLOCK_SIZE - offset : (8 + nameLength + 3) & ~3u;
+
+        uint8_t* entry = image + block * BLOCK_SIZE + offset;
+        memcpy(entry, &inode, sizeof(inode));
+        entry[4] = recordSize & 0xFF;
+        entry[5] = recordSize >> 8;
+        entry[6] = static_cast<uint8_t>(nameLength);
+        entry[7] = 0;
+        memcpy(entry + 8, name, nameLength);
+
+        return offset + recordSize;
+    }
+
+    uint32_t getNumSectors() const override
+    {
+        return sizeof(image) / SECTOR_SIZE;
+    }
+
+    bool transfer(Request& request) override
+    {
+        ++numRequests;
+
+        if (request.type != Request::eRead || request.sector + request.numSectors > getNumSectors())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < request.numSectors; ++i)
+        {
+            uint8_t* page = processMgr.mapTempPage(request.frames[i / SECTORS_PER_PAGE]);
+            if (page == nullptr)
+            {
+                return false;
+            }
+
+            memcpy(page + (i % SECTORS_PER_PAGE) * SECTOR_SIZE, image + (request.sector + i) * SECTOR_SIZE, SECTOR_SIZE);
+            processMgr.unmapTempPage(page);
+        }
+
+        return true;
+    }
+};
+
+TestBlockDevice device;
+
+} // namespace
+
+/**
+ * @brief Maps the blocks of a file on the test device.
+ */
+class Ext2FileSystemTestClass::TestFileSystem
+{
+public:
+    static constexpr uint32_t FILE_INODE = 12;
+
+    TestFileSystem()
+    {
+        memset(device.image, 0, sizeof(device.image));
+
+        for (uint32_t i = 0; i < Ext2FileSystem::NUM_DIRECT_BLOCKS; ++i)
+        {
+            inode.blocks[i] = FIRST_DISK_BLOCK + i;
+        }
+        inode.blocks[Ext2FileSystem::NUM_DIRECT_BLOCKS] = INDIRECT_BLOCK;
+        inode.blocks[Ext2FileSystem::NUM_DIRECT_BLOCKS + 1] = DOUBLE_INDIRECT_BLOCK;
+        inode.blocks[Ext2FileSystem::NUM_DIRECT_BLOCKS + 2] = 0;
+        inode.mode = 0x8000;
+        inode.size = NUM_FILE_BLOCKS * BLOCK_SIZE;
+
+        uint32_t numIndirect = NUM_CONTIGUOUS_BLOCKS - Ext2FileSystem::NUM_DIRECT_BLOCKS;
+        for (uint32_t i = 0; i < numIndirect; ++i)
+        {
+            device.setPointer(INDIRECT_BLOCK, i, FIRST_DISK_BLOCK + Ext2FileSystem::NUM_DIRECT_BLOCKS + i);
+        }
+        device.setPointer(INDIRECT_BLOCK, numIndirect, SCATTERED_DISK_BLOCK);
+        device.setPointer(DOUBLE_INDIRECT_BLOCK, 0, DOUBLE_INDIRECT_LEAF_BLOCK);
+        device.setPointer(DOUBLE_INDIRECT_LEAF_BLOCK, 0, DOUBLE_INDIRECT_DISK_BLOCK);
+
+        // the file system is set up as if it was mounted, with the file's
+        // inode cached
+        fileSystem.pageFrameMgr = ext2FileSystem.pageFrameMgr;
+        fileSystem.device = &device;
+        fileSystem.blockSize = BLOCK_SIZE;
+        fileSystem.sectorsPerBlock = BLOCK_SIZE / BlockDevice::SECTOR_SIZE;
+        fileSystem.numInodes = 32;
+
+        for (Ext2FileSystem::CachedInode& entry : fileSystem.inodeCache)
+        {
+            entry.number = 0;
+        }
+
+        clearIndirectCache();
+
+        Ext2FileSystem::CachedInode& entry = fileSystem.inodeCache[0];
+        entry.number = FILE_INODE;
+        entry.lastUse = ++fileSystem.useCounter;
+        entry.inode = inode;
+        entry.lastRun.numBlocks = 0;
+
+        fileSystem.dirPosition = {0, 0};
+
+        device.numRequests = 0;
+    }
+
+    /**
+     * @brief Add a root directory with the entries a to d, and one with a
+     * name that is too long between b and c.
+     */
+    void addRootDirectory()
+    {
+        size_t offset = device.addDirEntry(FIRST_DIR_BLOCK, 0, Ext2FileSystem::ROOT_INODE, ".", false);
+        offset = device.addDirEntry(FIRST_DIR_BLOCK, offset, Ext2FileSystem::ROOT_INODE, "..", false);
+        offset = device.addDirEntry(FIRST_DIR_BLOCK, offset, 20, "a", false);
+        offset = device.addDirEntry(FIRST_DIR_BLOCK, offset, 21, "b", false);
+        device.addDirEntry(FIRST_DIR_BLOCK, offset, 22, "a_name_that_is_longer_than_NAME_MAX", true);
+
+        offset = device.addDirEntry(FIRST_DIR_BLOCK + 1, 0, 23, "c", false);
+        device.addDirEntry(FIRST_DIR_BLOCK + 1, offset, 24, "d", true);
+
+        Ext2FileSystem::CachedInode& entry = fileSystem.inodeCache[1];
+        entry.number = Ext2FileSystem::ROOT_INODE;
+        entry.lastUse = ++fileSystem.useCounter;
+        memset(&entry.inode, 0, sizeof(entry.inode));
+        entry.inode.mode = 0x4000;
+        entry.inode.size = 2 * BLOCK_SIZE;
+        entry.inode.blocks[0] = FIRST_DIR_BLOCK;
+        entry.inode.blocks[1] = FIRST_DIR_BLOCK + 1;
+        entry.lastRun.numBlocks = 0;
+    }
+
+    size_t getDirEntries(size_t index, dirent* entries, size_t maxEntries)
+    {
+        return fileSystem.getDirEntries(index, entries, maxEntries);
+    }
+
+    void clearIndirectCache()
+    {
+        for (Ext2FileSystem::CachedIndirectBlock& entry : fileSystem.indirectCache)
+        {
+            entry.block = 0;
+        }
+    }
+
+    static size_t getNumRequests()
+    {
+        return device.numRequests;
+    }
+
+    bool getDiskBlock(uint32_t fileBlock, uint32_t& diskBlock)
+    {
+        return fileSystem.getDiskBlock(inode, fileBlock, diskBlock);
+    }
+
+    bool getBlockRun(uint32_t fileBlock, uint32_t maxBlocks, uint32_t& diskBlock, uint32_t& numBlocks)
+    {
+        Ext2FileSystem::BlockRun run = {0, 0, 0};
+        if (!fileSystem.getBlockRun(FILE_INODE, inode, fileBlock, maxBlocks, run))
+        {
+            return false;
+        }
+
+        diskBlock = run.diskBlock;
+        numBlocks = run.numBlocks;
+
+        return run.fileBlock == fileBlock;
+    }
+
+private:
+    static Ext2FileSystem fileSystem;
+
+    Ext2FileSystem::Inode inode;
+};
+
+Ext2FileSystem Ext2FileSystemTestClass::TestFileSystem::fileSystem;
+
+Ext2FileSystemTestClass::Ext2FileSystemTestClass() :
+    TestClass("Ext2FileSystem")
+{
+}
+
+void Ext2FileSystemTestClass::runTests()
+{
+    runTest("DirectBlocks", []()
+    {
+        TestFileSystem fileSystem;
+
+        uint32_t diskBlock = 0;
+        ASSERT_TRUE(fileSystem.getDiskBlock(0, diskBlock));
+        ASSERT_EQ(diskBlock, FIRST_DISK_BLOCK);
+        ASSERT_TRUE(fileSystem.getDiskBlock(11, diskBlock));
+        ASSERT_EQ(diskBlock, FIRST_DISK_BLOCK + 11);
+
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 0u);
+    });
+
+    runTest("IndirectBlocks", []()
+    {
+        TestFileSystem fileSystem;
+
+        uint32_t diskBlock = 0;
+        ASSERT_TRUE(fileSystem.getDiskBlock(12, diskBlock));
+        ASSERT_EQ(diskBlock, FIRST_DISK_BLOCK + 12);
+        ASSERT_TRUE(fileSystem.getDiskBlock(SCATTERED_FILE_BLOCK, diskBlock));
+        ASSERT_EQ(diskBlock, SCATTERED_DISK_BLOCK);
+        ASSERT_TRUE(fileSystem.getDiskBlock(SCATTERED_FILE_BLOCK + 1, diskBlock));
+        ASSERT_EQ(diskBlock, 0u);
+
+        // the indirect block is read once, and then cached
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 1u);
+    });
+
+    runTest("DoubleIndirectBlocks", []()
+    {
+        TestFileSystem fileSystem;
+
+        uint32_t diskBlock = 0;
+        ASSERT_TRUE(fileSystem.getDiskBlock(FIRST_DOUBLE_INDIRECT_FILE_BLOCK, diskBlock));
+        ASSERT_EQ(diskBlock, DOUBLE_INDIRECT_DISK_BLOCK);
+        ASSERT_TRUE(fileSystem.getDiskBlock(FIRST_DOUBLE_INDIRECT_FILE_BLOCK + 1, diskBlock));
+        ASSERT_EQ(diskBlock, 0u);
+
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 2u);
+    });
+
+    runTest("BlockRun", []()
+    {
+        TestFileSystem fileSystem;
+
+        // the run continues from the direct blocks into the indirect block,
+        // and ends at the block that is elsewhere
+        uint32_t diskBlock = 0;
+        uint32_t numBlocks = 0;
+        ASSERT_TRUE(fileSystem.getBlockRun(0, 64, diskBlock, numBlocks));
+        ASSERT_EQ(diskBlock, FIRST_DISK_BLOCK);
+        ASSERT_EQ(numBlocks, NUM_CONTIGUOUS_BLOCKS);
+
+        ASSERT_TRUE(fileSystem.getBlockRun(0, 4, diskBlock, numBlocks));
+        ASSERT_EQ(diskBlock, FIRST_DISK_BLOCK);
+        ASSERT_EQ(numBlocks, 4u);
+
+        ASSERT_TRUE(fileSystem.getBlockRun(SCATTERED_FILE_BLOCK, 64, diskBlock, numBlocks));
+        ASSERT_EQ(diskBlock, SCATTERED_DISK_BLOCK);
+        ASSERT_EQ(numBlocks, 1u);
+    });
+
+    runTest("HoleRun", []()
+    {
+        TestFileSystem fileSystem;
+
+        uint32_t diskBlock = 0;
+        uint32_t numBlocks = 0;
+        ASSERT_TRUE(fileSystem.getBlockRun(SCATTERED_FILE_BLOCK + 1, 8, diskBlock, numBlocks));
+        ASSERT_EQ(diskBlock, 0u);
+        ASSERT_EQ(numBlocks, 8u);
+    });
+
+    runTest("RunCache", []()
+    {
+        TestFileSystem fileSystem;
+
+        uint32_t diskBlock = 0;
+        uint32_t numBlocks = 0;
+        ASSERT_TRUE(fileSystem.getBlockRun(0, 64, diskBlock, numBlocks));
+
+        // a block in the last run is found without walking the block map,
+        // which would read the indirect block again
+        fileSystem.clearIndirectCache();
+        size_t numRequests = TestFileSystem::getNumRequests();
+
+        ASSERT_TRUE(fileSystem.getBlockRun(13, 64, diskBlock, numBlocks));
+        ASSERT_EQ(diskBlock, FIRST_DISK_BLOCK + 13);
+        ASSERT_EQ(numBlocks, NUM_CONTIGUOUS_BLOCKS - 13);
+        ASSERT_EQ(TestFileSystem::getNumRequests(), numRequests);
+    });
+
+    runTest("DirEntries", []()
+    {
+        TestFileSystem fileSystem;
+        fileSystem.addRootDirectory();
+
+        // the current and parent directories and the long name are skipped
+        dirent entries[8];
+        ASSERT_EQ(fileSystem.getDirEntries(0, entries, 8), 4u);
+        ASSERT_CSTR_EQ(entries[0].d_name, "a");
+        ASSERT_EQ(entries[0].d_ino, 20u);
+        ASSERT_CSTR_EQ(entries[1].d_name, "b");
+        ASSERT_CSTR_EQ(entries[2].d_name, "c");
+        ASSERT_CSTR_EQ(entries[3].d_name, "d");
+        ASSERT_EQ(entries[3].d_ino, 24u);
+
+        ASSERT_EQ(fileSystem.getDirEntries(4, entries, 8), 0u);
+    });
+
+    runTest("DirEntriesResume", []()
+    {
+        TestFileSystem fileSystem;
+        fileSystem.addRootDirectory();
+
+        // listing the directory one entry at a time continues from where
+        // the last call stopped, so each call only reads the blocks it needs
+        dirent entry;
+        ASSERT_EQ(fileSystem.getDirEntries(0, &entry, 1), 1u);
+        ASSERT_CSTR_EQ(entry.d_name, "a");
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 1u);
+
+        ASSERT_EQ(fileSystem.getDirEntries(1, &entry, 1), 1u);
+        ASSERT_CSTR_EQ(entry.d_name, "b");
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 2u);
+
+        ASSERT_EQ(fileSystem.getDirEntries(2, &entry, 1), 1u);
+        ASSERT_CSTR_EQ(entry.d_name, "c");
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 4u);
+
+        ASSERT_EQ(fileSystem.getDirEntries(3, &entry, 1), 1u);
+        ASSERT_CSTR_EQ(entry.d_name, "d");
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 5u);
+
+        ASSERT_EQ(fileSystem.getDirEntries(4, &entry, 1), 0u);
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 5u);
+
+        // going back reads the directory from the start
+        ASSERT_EQ(fileSystem.getDirEntries(1, &entry, 1), 1u);
+        ASSERT_CSTR_EQ(entry.d_name, "b");
+        ASSERT_EQ(TestFileSystem::getNumRequests(), 6u);
+    });
+}
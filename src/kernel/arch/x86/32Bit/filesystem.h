@@ -1,12 +1,83 @@
 #ifndef FILE_SYSTEM_H_
 #define FILE_SYSTEM_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 class Stream;
+struct dirent;
 
 class FileSystem
 {
 public:
-    virtual Stream* openStream(const char* path) = 0;
+    /// maximum size of a file name, including the null terminator
+    constexpr static size_t MAX_NAME_SIZE = 32;
+
+    /**
+     * @brief Open a stream to a file.
+     * @param path The file's path relative to where the file system is mounted.
+     * @param oflag The flags the file is opened with (e.g. O_RDONLY, O_CREAT).
+     * @return The stream, or nullptr if the file could not be opened.
+     */
+    virtual Stream* openStream(const char* path, int oflag) = 0;
+
+    /**
+     * @brief Remove a file.
+     * @param path The file's path relative to where the file system is mounted.
+     * @return true if the file was removed; false, otherwise
+     */
+    virtual bool unlink(const char* path) = 0;
+
+    /**
+     * @brief Read entries from the file system's root directory.
+     * @param index The index of the first entry to read.
+     * @param [out] entries The entries.
+     * @param maxEntries The maximum number of entries to read.
+     * @return The number of entries read (0 at the end of the directory).
+     */
+    virtual size_t getDirEntries(size_t index, dirent* entries, size_t maxEntries) = 0;
+
+    /**
+     * @brief Get the page frame that already holds a page of a file.
+     * @details File systems whose files are stored in memory implement this,
+     * so the page cache can use their pages in place instead of copying them.
+     * The page frame isn't freed, even if the file is truncated or removed,
+     * until it is released with releaseResidentPage().
+     * @param inode The file's inode number.
+     * @param pageIdx The index of the page in the file.
+     * @param [out] physicalAddr The physical address of the page.
+     * @param [out] virtualAddr The page's kernel virtual address if it is
+     * always mapped; 0, otherwise.
+     * @return true if the page is in memory; false, otherwise
+     */
+    virtual bool getResidentPage(uint32_t /*inode*/, size_t /*pageIdx*/, uintptr_t& /*physicalAddr*/, uintptr_t& /*virtualAddr*/)
+    {
+        return false;
+    }
+
+    /**
+     * @brief Release a page returned by getResidentPage().
+     * @param inode The file's inode number.
+     * @param physicalAddr The physical address of the page.
+     */
+    virtual void releaseResidentPage(uint32_t /*inode*/, uintptr_t /*physicalAddr*/)
+    {
+        // nothing to do
+    }
+
+    /**
+     * @brief Read consecutive pages of a file into page frames.
+     * @details The page cache calls this when pages are not in memory.
+     * @param inode The file's inode number.
+     * @param pageIdx The index of the first page in the file.
+     * @param frames The physical addresses of the page frames to fill.
+     * @param numPages The number of pages to read.
+     * @return The number of pages read.
+     */
+    virtual size_t readPages(uint32_t /*inode*/, size_t /*pageIdx*/, const uintptr_t* /*frames*/, size_t /*numPages*/)
+    {
+        return 0;
+    }
 };
 
 #endif // FILE_SYSTEM_H_
@@ -0,0 +1,22 @@
+#ifndef FONT_H_
+#define FONT_H_
+
+#include <stdint.h>
+
+constexpr unsigned int FONT_WIDTH = 8;
+constexpr unsigned int FONT_HEIGHT = 16;
+
+/// the first character in the font
+constexpr char FONT_FIRST_CHAR = ' ';
+
+/// the number of glyphs in the font (the printable ASCII characters)
+constexpr unsigned int FONT_NUM_GLYPHS = 95;
+
+/**
+ * @brief An 8x16 font for the printable ASCII characters.
+ * @details Each byte is a row of a glyph, and the most significant bit is
+ * the leftmost pixel.
+ */
+extern const uint8_t FONT_GLYPHS[FONT_NUM_GLYPHS][FONT_HEIGHT];
+
+#endif // FONT_H_
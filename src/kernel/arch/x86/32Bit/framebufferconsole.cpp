@@ -0,0 +1,335 @@
+#include <string.h>
+
+#include "framebufferconsole.h"
+#include "kernellogger.h"
+#include "multiboot.h"
+#include "system.h"
+#include "utils.h"
+
+const char* FramebufferConsole::LOG_TAG = "FramebufferConsole";
+
+uint16_t FramebufferConsole::shadow[MAX_HEIGHT * MAX_WIDTH];
+
+alignas(PAGE_SIZE) uint32_t FramebufferConsole::pageTable[PAGE_TABLE_NUM_ENTRIES];
+
+FramebufferConsole::Glyph FramebufferConsole::glyphCache[NUM_GLYPH_CACHE_SLOTS][FONT_NUM_GLYPHS];
+
+FramebufferConsole::FramebufferConsole() :
+    TextConsole(shadow, 0, 0)
+{
+    for (int i = 0; i < NUM_GLYPH_CACHE_SLOTS; ++i)
+    {
+        slotAttribs[i] = 0;
+        slotLastUse[i] = 0;
+    }
+
+    useCount = 0;
+    frameBuffer = nullptr;
+    pitch = 0;
+    screenRows = 0;
+    memRows = 0;
+    origin = 0;
+    canPan = false;
+    cursorDrawn = false;
+    cursorDrawnX = 0;
+    cursorDrawnY = 0;
+}
+
+bool FramebufferConsole::init(const multiboot_info* mbootInfo)
+{
+    if ( (mbootInfo->flags & MULTIBOOT_INFO_FRAMEBUFFER_INFO) == 0 ||
+         mbootInfo->framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_RGB ||
+         mbootInfo->framebuffer_bpp != 32 )
+    {
+        return false;
+    }
+
+    uint64_t physicalAddr = mbootInfo->framebuffer_addr;
+    uint32_t width = mbootInfo->framebuffer_width;
+    uint32_t height = mbootInfo->framebuffer_height;
+    pitch = mbootInfo->framebuffer_pitch;
+
+    // the framebuffer is mapped in one page table
+    constexpr uint32_t MAX_MAPPING_SIZE = PAGE_TABLE_NUM_ENTRIES * PAGE_SIZE;
+
+    if ( (physicalAddr >> 32) != 0 || (physicalAddr & PAGE_SIZE_MASK) != 0 ||
+         pitch == 0 || height > MAX_MAPPING_SIZE / pitch )
+    {
+        klog.logError(LOG_TAG, "Can't map {}x{} framebuffer at {x0>8}", width, height, static_cast<uint32_t>(physicalAddr));
+        return false;
+    }
+
+    unsigned int numColumns = width / FONT_WIDTH;
+    if (numColumns > MAX_WIDTH)
+    {
+        numColumns = MAX_WIDTH;
+    }
+
+    unsigned int numLines = height / FONT_HEIGHT;
+    if (numLines > MAX_HEIGHT)
+    {
+        numLines = MAX_HEIGHT;
+    }
+
+    if (numColumns == 0 || numLines == 0)
+    {
+        return false;
+    }
+
+    screenRows = numLines * FONT_HEIGHT;
+    memRows = height;
+
+    // use the video memory below the screen to scroll if the display start
+    // can be moved
+    canPan = hasVbeDispi(width, height, mbootInfo->framebuffer_bpp);
+    if (canPan)
+    {
+        unsigned int virtHeight = readVbeDispi(VBE_DISPI_INDEX_VIRT_HEIGHT);
+        unsigned int maxRows = MAX_MAPPING_SIZE / pitch;
+        memRows = (virtHeight < maxRows) ? virtHeight : maxRows;
+        if (memRows < height)
+        {
+            memRows = height;
+        }
+
+        canPan = (memRows > height);
+    }
+
+    // map the video memory in the page directory entry after the kernel's
+    // page table, which processes share with the kernel
+    int pageDirIdx = (KERNEL_VIRTUAL_BASE >> 22) + 1;
+    uint32_t virtualAddr = pageDirIdx << 22;
+    uint32_t numPages = align(memRows * pitch, PAGE_SIZE) / PAGE_SIZE;
+    for (uint32_t i = 0; i < numPages; ++i)
+    {
+        mapPage(pageTable, virtualAddr + i * PAGE_SIZE, static_cast<uint32_t>(physicalAddr) + i * PAGE_SIZE);
+    }
+
+    uint32_t pageTablePhysicalAddr = reinterpret_cast<uint32_t>(pageTable) - KERNEL_VIRTUAL_BASE;
+    mapPageTable(getKernelPageDirStart(), pageTablePhysicalAddr, pageDirIdx);
+
+    frameBuffer = reinterpret_cast<uint8_t*>(virtualAddr);
+
+    // EGA colors in attribute order
+    palette[ 0] = getPixel(mbootInfo, 0x00, 0x00, 0x00);
+    palette[ 1] = getPixel(mbootInfo, 0x00, 0x00, 0xAA);
+    palette[ 2] = getPixel(mbootInfo, 0x00, 0xAA, 0x00);
+    palette[ 3] = getPixel(mbootInfo, 0x00, 0xAA, 0xAA);
+    palette[ 4] = getPixel(mbootInfo, 0xAA, 0x00, 0x00);
+    palette[ 5] = getPixel(mbootInfo, 0xAA, 0x00, 0xAA);
+    palette[ 6] = getPixel(mbootInfo, 0xAA, 0x55, 0x00);
+    palette[ 7] = getPixel(mbootInfo, 0xAA, 0xAA, 0xAA);
+    palette[ 8] = getPixel(mbootInfo, 0x55, 0x55, 0x55);
+    palette[ 9] = getPixel(mbootInfo, 0x55, 0x55, 0xFF);
+    palette[10] = getPixel(mbootInfo, 0x55, 0xFF, 0x55);
+    palette[11] = getPixel(mbootInfo, 0x55, 0xFF, 0xFF);
+    palette[12] = getPixel(mbootInfo, 0xFF, 0x55, 0x55);
+    palette[13] = getPixel(mbootInfo, 0xFF, 0x55, 0xFF);
+    palette[14] = getPixel(mbootInfo, 0xFF, 0xFF, 0x55);
+    palette[15] = getPixel(mbootInfo, 0xFF, 0xFF, 0xFF);
+
+    // clear the rows the console doesn't draw in
+    memset(frameBuffer, 0, memRows * pitch);
+
+    origin = 0;
+    if (canPan)
+    {
+        updateDisplayStart();
+    }
+
+    setSize(numColumns, numLines);
+    flush();
+
+    klog.logInfo(LOG_TAG, "{}x{} framebuffer at {x0>8}: {} columns, {} lines, {} video memory rows",
+                 width, height, static_cast<uint32_t>(physicalAddr), numColumns, numLines, memRows);
+
+    return true;
+}
+
+bool FramebufferConsole::scrollScreen(unsigned int numLines)
+{
+    unsigned int numRows = numLines * FONT_HEIGHT;
+
+    // move the lines that are still on the screen with the display start
+    if (canPan && numLines < getHeight() && origin + numRows + screenRows <= memRows)
+    {
+        origin += numRows;
+        updateDisplayStart();
+
+        // the cursor moved up with the lines
+        if (cursorDrawn && cursorDrawnY >= numLines)
+        {
+            cursorDrawnY -= numLines;
+        }
+        else
+        {
+            cursorDrawn = false;
+        }
+
+        return true;
+    }
+
+    // when the bottom of video memory is reached, start over at the top
+    // and redraw the whole screen
+    if (origin != 0)
+    {
+        origin = 0;
+        updateDisplayStart();
+    }
+
+    cursorDrawn = false;
+
+    return false;
+}
+
+void FramebufferConsole::drawLine(unsigned int y, const uint16_t* line)
+{
+    for (unsigned int x = 0; x < getWidth(); ++x)
+    {
+        drawCell(x, y, line[x]);
+    }
+
+    if (cursorDrawn && cursorDrawnY == y)
+    {
+        cursorDrawn = false;
+    }
+}
+
+void FramebufferConsole::updateCursor()
+{
+    unsigned int x = getCursorX();
+    unsigned int y = getCursorY();
+
+    // erase the cursor where it was
+    if (cursorDrawn && (cursorDrawnX != x || cursorDrawnY != y))
+    {
+        drawCell(cursorDrawnX, cursorDrawnY, getShadowLine(cursorDrawnY)[cursorDrawnX]);
+        cursorDrawn = false;
+    }
+
+    if (!cursorDrawn)
+    {
+        uint16_t cell = getShadowLine(y)[x];
+        uint32_t color = palette[(cell >> 8) & 0x0F];
+
+        for (unsigned int row = FONT_HEIGHT - CURSOR_HEIGHT; row < FONT_HEIGHT; ++row)
+        {
+            uint32_t* dst = getPixelRow(y * FONT_HEIGHT + row) + x * FONT_WIDTH;
+            for (unsigned int i = 0; i < FONT_WIDTH; ++i)
+            {
+                dst[i] = color;
+            }
+        }
+
+        cursorDrawn = true;
+        cursorDrawnX = x;
+        cursorDrawnY = y;
+    }
+}
+
+bool FramebufferConsole::hasVbeDispi(uint32_t width, uint32_t height, uint8_t bpp) const
+{
+    uint16_t id = readVbeDispi(VBE_DISPI_INDEX_ID);
+    if (id < VBE_DISPI_ID_MIN || id > VBE_DISPI_ID_MAX)
+    {
+        return false;
+    }
+
+    // make sure the adapter is showing the boot loader's mode
+    return (readVbeDispi(VBE_DISPI_INDEX_ENABLE) & VBE_DISPI_ENABLED) != 0 &&
+           readVbeDispi(VBE_DISPI_INDEX_XRES) == width &&
+           readVbeDispi(VBE_DISPI_INDEX_YRES) == height &&
+           readVbeDispi(VBE_DISPI_INDEX_BPP) == bpp &&
+           pitch == width * sizeof(uint32_t);
+}
+
+uint16_t FramebufferConsole::readVbeDispi(uint16_t index) const
+{
+    outw(VBE_DISPI_INDEX_REG, index);
+    return inw(VBE_DISPI_DATA_REG);
+}
+
+void FramebufferConsole::writeVbeDispi(uint16_t index, uint16_t value)
+{
+    outw(VBE_DISPI_INDEX_REG, index);
+    outw(VBE_DISPI_DATA_REG, value);
+}
+
+void FramebufferConsole::updateDisplayStart()
+{
+    writeVbeDispi(VBE_DISPI_INDEX_Y_OFFSET, static_cast<uint16_t>(origin));
+}
+
+uint32_t FramebufferConsole::getPixel(const multiboot_info* mbootInfo, uint8_t red, uint8_t green, uint8_t blue)
+{
+    uint32_t pixel = 0;
+    pixel |= (uint32_t{red} >> (8 - mbootInfo->framebuffer_red_mask_size)) << mbootInfo->framebuffer_red_field_position;
+    pixel |= (uint32_t{green} >> (8 - mbootInfo->framebuffer_green_mask_size)) << mbootInfo->framebuffer_green_field_position;
+    pixel |= (uint32_t{blue} >> (8 - mbootInfo->framebuffer_blue_mask_size)) << mbootInfo->framebuffer_blue_field_position;
+    return pixel;
+}
+
+const FramebufferConsole::Glyph* FramebufferConsole::getGlyphs(uint8_t attrib)
+{
+    int slot = 0;
+    for (int i = 0; i < NUM_GLYPH_CACHE_SLOTS; ++i)
+    {
+        if (slotLastUse[i] != 0 && slotAttribs[i] == attrib)
+        {
+            slotLastUse[i] = ++useCount;
+            return glyphCache[i];
+        }
+
+        if (slotLastUse[i] < slotLastUse[slot])
+        {
+            slot = i;
+        }
+    }
+
+    // render the glyphs in the least recently used slot
+    uint32_t foreground = palette[attrib & 0x0F];
+    uint32_t background = palette[attrib >> 4];
+    for (unsigned int g = 0; g < FONT_NUM_GLYPHS; ++g)
+    {
+        for (unsigned int row = 0; row < FONT_HEIGHT; ++row)
+        {
+            uint8_t bits = FONT_GLYPHS[g][row];
+            for (unsigned int col = 0; col < FONT_WIDTH; ++col)
+            {
+                glyphCache[slot][g][row][col] = ( (bits & (0x80 >> col)) != 0 ) ? foreground : background;
+            }
+        }
+    }
+
+    slotAttribs[slot] = attrib;
+    slotLastUse[slot] = ++useCount;
+
+    return glyphCache[slot];
+}
+
+uint32_t* FramebufferConsole::getPixelRow(unsigned int row) const
+{
+    return reinterpret_cast<uint32_t*>(frameBuffer + (origin + row) * pitch);
+}
+
+void FramebufferConsole::drawCell(unsigned int x, unsigned int y, uint16_t cell)
+{
+    uint8_t ch = static_cast<uint8_t>(cell);
+    if (ch < FONT_FIRST_CHAR || ch >= FONT_FIRST_CHAR + FONT_NUM_GLYPHS)
+    {
+        ch = '?';
+    }
+
+    const Glyph& glyph = getGlyphs(static_cast<uint8_t>(cell >> 8))[ch - FONT_FIRST_CHAR];
+
+    // copy the glyph a row of 32-bit pixels at a time
+    for (unsigned int row = 0; row < FONT_HEIGHT; ++row)
+    {
+        uint32_t* dst = getPixelRow(y * FONT_HEIGHT + row) + x * FONT_WIDTH;
+        const uint32_t* src = glyph[row];
+        for (unsigned int i = 0; i < FONT_WIDTH; ++i)
+        {
+            dst[i] = src[i];
+        }
+    }
+}
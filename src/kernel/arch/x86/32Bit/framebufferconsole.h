@@ -0,0 +1,150 @@
+#ifndef FRAMEBUFFER_CONSOLE_H_
+#define FRAMEBUFFER_CONSOLE_H_
+
+#include "font.h"
+#include "paging.h"
+#include "textconsole.h"
+
+struct multiboot_info;
+
+/**
+ * @brief A text console drawn in the linear framebuffer the boot loader
+ * set up.
+ * @details Glyphs are rendered in advance for the color pairs in use, so
+ * drawing a character is a copy of 32-bit pixel rows. If the display
+ * adapter supports it (Bochs/QEMU VBE), the screen is scrolled by moving
+ * the display start down in video memory, like VgaDriver does in text mode.
+ */
+class FramebufferConsole : public TextConsole
+{
+public:
+    FramebufferConsole();
+
+    /**
+     * @brief Set up the console in the boot loader's framebuffer.
+     * @return true if the framebuffer can be used; false, otherwise
+     */
+    bool init(const multiboot_info* mbootInfo);
+
+protected:
+    /**
+     * @brief Move the display start down in video memory.
+     */
+    bool scrollScreen(unsigned int numLines) override;
+
+    /**
+     * @brief Draw a line's glyphs in the framebuffer.
+     */
+    void drawLine(unsigned int y, const uint16_t* line) override;
+
+    /**
+     * @brief Draw the cursor as an underline at the cursor position.
+     */
+    void updateCursor() override;
+
+private:
+    static const char* LOG_TAG;
+
+    /// the maximum number of columns on the screen
+    static constexpr unsigned int MAX_WIDTH = 160;
+
+    /// the number of color pairs with rendered glyphs
+    static constexpr int NUM_GLYPH_CACHE_SLOTS = 4;
+
+    /// the cursor's height in pixels
+    static constexpr unsigned int CURSOR_HEIGHT = 2;
+
+    /// Bochs VBE extensions (also in QEMU and VirtualBox)
+    static constexpr uint16_t VBE_DISPI_INDEX_REG = 0x01CE;
+    static constexpr uint16_t VBE_DISPI_DATA_REG  = 0x01CF;
+    static constexpr uint16_t VBE_DISPI_INDEX_ID          = 0;
+    static constexpr uint16_t VBE_DISPI_INDEX_XRES        = 1;
+    static constexpr uint16_t VBE_DISPI_INDEX_YRES        = 2;
+    static constexpr uint16_t VBE_DISPI_INDEX_BPP         = 3;
+    static constexpr uint16_t VBE_DISPI_INDEX_ENABLE      = 4;
+    static constexpr uint16_t VBE_DISPI_INDEX_VIRT_HEIGHT = 7;
+    static constexpr uint16_t VBE_DISPI_INDEX_Y_OFFSET    = 9;
+    static constexpr uint16_t VBE_DISPI_ID_MIN            = 0xB0C1; // first version with a virtual screen
+    static constexpr uint16_t VBE_DISPI_ID_MAX            = 0xB0CF;
+    static constexpr uint16_t VBE_DISPI_ENABLED           = 0x01;
+
+    /// a glyph's pixels
+    using Glyph = uint32_t[FONT_HEIGHT][FONT_WIDTH];
+
+    static uint16_t shadow[MAX_HEIGHT * MAX_WIDTH];
+
+    /// page table that maps the framebuffer after the kernel's page table
+    static uint32_t pageTable[PAGE_TABLE_NUM_ENTRIES];
+
+    /// glyphs rendered in the colors of a pair
+    static Glyph glyphCache[NUM_GLYPH_CACHE_SLOTS][FONT_NUM_GLYPHS];
+
+    /// attribute whose colors a cache slot's glyphs are rendered in
+    uint8_t slotAttribs[NUM_GLYPH_CACHE_SLOTS];
+
+    /// when a cache slot was last used (0 if the slot is empty)
+    uint32_t slotLastUse[NUM_GLYPH_CACHE_SLOTS];
+
+    uint32_t useCount;
+
+    /// pixel values of the 16 colors
+    uint32_t palette[16];
+
+    /// the mapped video memory
+    uint8_t* frameBuffer;
+
+    /// bytes per pixel row
+    uint32_t pitch;
+
+    /// number of visible pixel rows
+    unsigned int screenRows;
+
+    /// number of pixel rows in the mapped video memory
+    unsigned int memRows;
+
+    /// pixel row in video memory of the top of the screen
+    unsigned int origin;
+
+    /// whether the display start can be moved
+    bool canPan;
+
+    /// whether the cursor is drawn and where it is drawn
+    bool cursorDrawn;
+    unsigned int cursorDrawnX;
+    unsigned int cursorDrawnY;
+
+    /**
+     * @brief Check if the display adapter has Bochs VBE extensions and is
+     * showing the framebuffer.
+     */
+    bool hasVbeDispi(uint32_t width, uint32_t height, uint8_t bpp) const;
+
+    uint16_t readVbeDispi(uint16_t index) const;
+
+    void writeVbeDispi(uint16_t index, uint16_t value);
+
+    /**
+     * @brief Set the display start to the origin.
+     */
+    void updateDisplayStart();
+
+    /**
+     * @brief Convert an RGB color to a pixel value.
+     */
+    static uint32_t getPixel(const multiboot_info* mbootInfo, uint8_t red, uint8_t green, uint8_t blue);
+
+    /**
+     * @brief Get the glyphs for an attribute's colors, and render them if
+     * they are not in the cache.
+     */
+    const Glyph* getGlyphs(uint8_t attrib);
+
+    /**
+     * @brief Get a pixel row of the screen in video memory.
+     */
+    uint32_t* getPixelRow(unsigned int row) const;
+
+    void drawCell(unsigned int x, unsigned int y, uint16_t cell);
+};
+
+#endif // FRAMEBUFFER_CONSOLE_H_
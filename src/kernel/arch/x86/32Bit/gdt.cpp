@@ -1,3 +1,4 @@
+#include "cpu.h"
 #include "gdt.h"
 #include "string.h"
 
@@ -9,14 +10,9 @@ void loadGdt(uint32_t gdtAddr);
 extern "C"
 void loadTss(uint16_t tssIndex);
 
-constexpr int NUM_GDT_ENTRIES = 6;
-struct GdtEntry gdtEntries[NUM_GDT_ENTRIES];
-GdtPtr gdtPtr;
-TssEntry tssEntry;
-
-static void gdtSetGate(int32_t idx, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran)
+static void gdtSetGate(Gdt* gdt, int32_t idx, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran)
 {
-    GdtEntry* entry = gdtEntries + idx;
+    GdtEntry* entry = gdt->entries + idx;
 
     entry->baseLow     = base & 0xFFFF;
     entry->baseMiddle  = (base >> 16) & 0xFF;
@@ -29,37 +25,40 @@ static void gdtSetGate(int32_t idx, uint32_t base, uint32_t limit, uint8_t acces
     entry->access      = access;
 }
 
-static void setTss(int32_t idx, uint16_t ss0)
+static void setTss(Gdt* gdt, int32_t idx, uint16_t ss0)
 {
     // initialize TSS to 0
-    memset(&tssEntry, 0, sizeof(TssEntry));
+    memset(&gdt->tss, 0, sizeof(TssEntry));
 
     // set stack segment
-    tssEntry.ss0 = ss0;
+    gdt->tss.ss0 = ss0;
 
     // compute base and limit
-    uint32_t base = reinterpret_cast<uint32_t>(&tssEntry);
+    uint32_t base = reinterpret_cast<uint32_t>(&gdt->tss);
     uint32_t limit = base + sizeof(TssEntry);
 
     // add TSS to the GDT
-    gdtSetGate(idx, base, limit, 0xE9, 0x00);
+    gdtSetGate(gdt, idx, base, limit, 0xE9, 0x00);
 }
 
-void initGdt()
+void initGdt(Gdt* gdt, uint32_t perCpuDataAddr, uint32_t perCpuDataSize)
 {
     // set up the GDT pointer and limit
-    gdtPtr.limit = (sizeof(GdtEntry) * NUM_GDT_ENTRIES) - 1;
-    gdtPtr.base = reinterpret_cast<uint32_t>(&gdtEntries);
+    gdt->ptr.limit = (sizeof(GdtEntry) * NUM_GDT_ENTRIES) - 1;
+    gdt->ptr.base = reinterpret_cast<uint32_t>(&gdt->entries);
+
+    gdtSetGate(gdt, 0, 0, 0, 0, 0);                // null segment
+    gdtSetGate(gdt, 1, 0, 0xFFFFFFFF, 0x9A, 0xCF); // kernel code segment
+    gdtSetGate(gdt, 2, 0, 0xFFFFFFFF, 0x92, 0xCF); // kernel data segment
+    gdtSetGate(gdt, 3, 0, 0xFFFFFFFF, 0xFA, 0xCF); // user mode code segment
+    gdtSetGate(gdt, 4, 0, 0xFFFFFFFF, 0xF2, 0xCF); // user mode data segment
+    setTss(gdt, 5, 0x10);                          // TSS
 
-    gdtSetGate(0, 0, 0, 0, 0);                // null segment
-    gdtSetGate(1, 0, 0xFFFFFFFF, 0x9A, 0xCF); // kernel code segment
-    gdtSetGate(2, 0, 0xFFFFFFFF, 0x92, 0xCF); // kernel data segment
-    gdtSetGate(3, 0, 0xFFFFFFFF, 0xFA, 0xCF); // user mode code segment
-    gdtSetGate(4, 0, 0xFFFFFFFF, 0xF2, 0xCF); // user mode data segment
-    setTss(5, 0x10);                          // TSS
+    // per-CPU data segment (byte granularity)
+    gdtSetGate(gdt, 6, perCpuDataAddr, perCpuDataSize - 1, 0x92, 0x40);
 
     // load the new GDT
-    loadGdt(reinterpret_cast<uint32_t>(&gdtPtr));
+    loadGdt(reinterpret_cast<uint32_t>(&gdt->ptr));
 
     // load the TSS
     loadTss(0x28);
@@ -67,5 +66,5 @@ void initGdt()
 
 void setKernelStack(uint32_t stackAddr)
 {
-    tssEntry.esp0 = stackAddr;
+    Cpu::getCurrent()->gdt.tss.esp0 = stackAddr;
 }
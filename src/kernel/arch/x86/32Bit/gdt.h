@@ -8,6 +8,13 @@ extern "C"
 {
 #endif
 
+/// the number of entries in each processor's GDT
+#define NUM_GDT_ENTRIES 7
+
+/// the selector of the segment that holds the processor's per-CPU data; it
+/// is loaded in GS while the processor is in the kernel
+#define PER_CPU_SEGMENT_SELECTOR 0x30
+
 /**
  * @brief Contains the value of one GDT entry
  */
@@ -73,12 +80,29 @@ struct GdtPtr
 } __attribute__((packed));
 
 /**
- * @brief Initialize the Global Descriptor Table
+ * @brief A processor's GDT and TSS
+ * @details Each processor has its own, since the TSS holds the kernel stack
+ * that the processor switches to and the per-CPU segment points to the
+ * processor's own data.
+ */
+struct Gdt
+{
+    struct GdtEntry entries[NUM_GDT_ENTRIES];
+    struct GdtPtr ptr;
+    struct TssEntry tss;
+};
+
+/**
+ * @brief Initialize a Global Descriptor Table and load it on the calling
+ * processor, along with its TSS and per-CPU segment.
+ * @param gdt The processor's GDT.
+ * @param perCpuDataAddr The address of the processor's per-CPU data.
+ * @param perCpuDataSize The size of the processor's per-CPU data in bytes.
  */
-void initGdt();
+void initGdt(struct Gdt* gdt, uint32_t perCpuDataAddr, uint32_t perCpuDataSize);
 
 /**
- * @brief Set the kernel stack in the TSS.
+ * @brief Set the kernel stack in the calling processor's TSS.
  */
 void setKernelStack(uint32_t stackAddr);
 
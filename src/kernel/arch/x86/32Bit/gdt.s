@@ -1,6 +1,7 @@
 ; Set up the segment registers:
 ; Kernel code descriptor offset: 8 B
 ; Kernel data descriptor offset: 16 B
+; Per-CPU data descriptor offset: 48 B
 ; To set CS, we have to do a far jump. A far jump includes
 ; a segment as well as an offset
 global loadGdt
@@ -12,8 +13,9 @@ loadGdt:
 	mov ds, ax			; load all data segment selectors
 	mov es, ax
 	mov fs, ax
-	mov gs, ax
 	mov ss, ax
+	mov ax, 48			; 48 is the offset to the per-CPU data segment
+	mov gs, ax
 	jmp 8:.codeSegment	; 8 is the offset to the code segment
 .codeSegment:
 	ret
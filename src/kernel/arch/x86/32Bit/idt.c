@@ -58,6 +58,12 @@ void initIdt()
     idtFlush((uint32_t)&idtPtr);
 }
 
+void loadIdt()
+{
+    // all processors share the IDT
+    idtFlush((uint32_t)&idtPtr);
+}
+
 void idtSetGate(uint8_t idx, uint32_t base, uint16_t sel, uint8_t flags)
 {
     struct IdtEntry* entry = idtEntries + idx;
@@ -32,6 +32,11 @@ struct IdtPtr
 
 void initIdt();
 
+/**
+ * @brief Load the IDT set up by initIdt() on the calling processor.
+ */
+void loadIdt();
+
 void idtSetGate(uint8_t idx, uint32_t base, uint16_t sel, uint8_t flags);
 
 #ifdef __cplusplus
@@ -0,0 +1,160 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include "initrdfilesystem.h"
+#include "kernellogger.h"
+#include "multiboot.h"
+#include "paging.h"
+#include "system.h"
+
+namespace
+{
+
+const char* LOG_TAG = "Initrd";
+
+} // namespace
+
+InitrdFileSystem::InitrdFileSystem(const multiboot_mod_list* module) :
+    archiveStart(0),
+    directory(nullptr),
+    numFiles(0)
+{
+    if (module == nullptr)
+    {
+        return;
+    }
+
+    size_t archiveSize = module->mod_end - module->mod_start;
+    if (archiveSize < sizeof(Header))
+    {
+        klog.logError(LOG_TAG, "Archive is too small");
+        return;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(module->mod_start + KERNEL_VIRTUAL_BASE);
+    if (header->magic != MAGIC || header->version != VERSION)
+    {
+        klog.logError(LOG_TAG, "Invalid archive header");
+        return;
+    }
+
+    // check that the directory and every file are in the archive, so they
+    // don't need to be checked again when they're opened
+    const DirEntry* entries = reinterpret_cast<const DirEntry*>(header + 1);
+    if (header->numFiles > (archiveSize - sizeof(Header)) / sizeof(DirEntry))
+    {
+        klog.logError(LOG_TAG, "Directory is larger than the archive");
+        return;
+    }
+
+    for (size_t i = 0; i < header->numFiles; ++i)
+    {
+        const DirEntry& entry = entries[i];
+        if ( entry.name[MAX_NAME_SIZE - 1] != '\0' ||
+             (entry.offset & PAGE_SIZE_MASK) != 0 ||
+             entry.offset > archiveSize ||
+             entry.size > archiveSize - entry.offset )
+        {
+            klog.logError(LOG_TAG, "Invalid directory entry {}", i);
+            return;
+        }
+    }
+
+    archiveStart = module->mod_start;
+    directory = entries;
+    numFiles = header->numFiles;
+
+    klog.logInfo(LOG_TAG, "Found {} files", numFiles);
+}
+
+bool InitrdFileSystem::isValid() const
+{
+    return directory != nullptr;
+}
+
+Stream* InitrdFileSystem::openStream(const char* path, int oflag)
+{
+    // the archive is read-only
+    if ( (oflag & (O_WRONLY | O_CREAT | O_TRUNC | O_APPEND)) != 0 )
+    {
+        return nullptr;
+    }
+
+    const DirEntry* entry = findFile(path);
+    if (entry == nullptr)
+    {
+        return nullptr;
+    }
+
+    // find a stream
+    MBootModuleStream* stream = nullptr;
+    for (size_t i = 0; i < MAX_NUM_STREAMS && stream == nullptr; ++i)
+    {
+        if (!streams[i].isOpen())
+        {
+            stream = &streams[i];
+        }
+    }
+
+    // the directory entry's index is the file's inode number
+    if (stream != nullptr)
+    {
+        stream->open(this, entry - directory, archiveStart + entry->offset, entry->size);
+    }
+
+    return stream;
+}
+
+bool InitrdFileSystem::getResidentPage(uint32_t inode, size_t pageIdx, uintptr_t& physicalAddr, uintptr_t& virtualAddr)
+{
+    if (inode >= numFiles)
+    {
+        return false;
+    }
+
+    // the archive is mapped in the kernel's address space
+    physicalAddr = archiveStart + directory[inode].offset + pageIdx * PAGE_SIZE;
+    virtualAddr = physicalAddr + KERNEL_VIRTUAL_BASE;
+
+    return true;
+}
+
+size_t InitrdFileSystem::getDirEntries(size_t index, dirent* entries, size_t maxEntries)
+{
+    size_t numEntries = 0;
+    for (size_t i = index; i < numFiles && numEntries < maxEntries; ++i)
+    {
+        dirent& entry = entries[numEntries++];
+        entry.d_ino = i;
+        strncpy(entry.d_name, directory[i].name, NAME_MAX);
+        entry.d_name[NAME_MAX] = '\0';
+    }
+
+    return numEntries;
+}
+
+const InitrdFileSystem::DirEntry* InitrdFileSystem::findFile(const char* name) const
+{
+    size_t low = 0;
+    size_t high = numFiles;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        int cmp = strcmp(name, directory[mid].name);
+        if (cmp == 0)
+        {
+            return &directory[mid];
+        }
+        else if (cmp < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+
+    return nullptr;
+}
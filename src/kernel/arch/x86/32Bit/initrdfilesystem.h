@@ -0,0 +1,83 @@
+#ifndef INITRD_FILE_SYSTEM_H_
+#define INITRD_FILE_SYSTEM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "filesystem.h"
+#include "mbootmodulestream.h"
+
+struct multiboot_mod_list;
+
+/**
+ * @brief A read-only file system stored in an archive loaded as a multiboot
+ * module.
+ * @details The archive is created by tools/create-initrd.py. It starts with
+ * a header and a directory sorted by name, and each file's data starts on a
+ * page boundary, so files can be mapped without copying.
+ */
+class InitrdFileSystem : public FileSystem
+{
+public:
+    /// "INRD" in little-endian
+    constexpr static uint32_t MAGIC = 0x4452'4E49;
+    constexpr static uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t numFiles;
+        uint32_t reserved;
+    };
+
+    struct DirEntry
+    {
+        char name[MAX_NAME_SIZE];
+
+        /// offset of the file's data from the start of the archive
+        uint32_t offset;
+
+        /// size of the file's data in bytes
+        uint32_t size;
+    };
+
+    /**
+     * @brief Constructor
+     * @param module The module that holds the archive (may be nullptr).
+     */
+    InitrdFileSystem(const multiboot_mod_list* module);
+
+    /**
+     * @brief Whether the module holds a valid archive.
+     */
+    bool isValid() const;
+
+protected:
+    Stream* openStream(const char* path, int oflag) override;
+
+    bool unlink(const char*) override
+    {
+        return false;
+    }
+
+    size_t getDirEntries(size_t index, dirent* entries, size_t maxEntries) override;
+
+    bool getResidentPage(uint32_t inode, size_t pageIdx, uintptr_t& physicalAddr, uintptr_t& virtualAddr) override;
+
+private:
+    /// physical address of the start of the archive
+    uintptr_t archiveStart;
+
+    const DirEntry* directory;
+    size_t numFiles;
+
+    static constexpr size_t MAX_NUM_STREAMS = 16;
+    MBootModuleStream streams[MAX_NUM_STREAMS];
+
+    /**
+     * @brief Find a file's directory entry with a binary search.
+     */
+    const DirEntry* findFile(const char* name) const;
+};
+
+#endif // INITRD_FILE_SYSTEM_H_
@@ -0,0 +1,104 @@
+#include <fcntl.h>
+#include <string.h>
+#include "initrdfilesystem.h"
+#include "multiboot.h"
+#include "stream.h"
+#include "system.h"
+#include "unittests.h"
+
+namespace
+{
+
+constexpr size_t NUM_FILES = 7;
+
+/// sorted by name, like the archives that tools/create-initrd.py creates
+const char* const FILE_NAMES[NUM_FILES] = {"bin", "cat", "echo", "init", "ls", "sh", "snake"};
+
+struct Archive
+{
+    InitrdFileSystem::Header header;
+    InitrdFileSystem::DirEntry entries[NUM_FILES];
+};
+
+// the archive is in the kernel image, so its physical address is known
+Archive archive;
+
+/**
+ * @brief Create an archive where each file's size is its index plus 1, so
+ * a test can tell which file was found.
+ */
+multiboot_mod_list createArchive()
+{
+    memset(&archive, 0, sizeof(archive));
+    archive.header.magic = InitrdFileSystem::MAGIC;
+    archive.header.version = InitrdFileSystem::VERSION;
+    archive.header.numFiles = NUM_FILES;
+
+    for (size_t i = 0; i < NUM_FILES; ++i)
+    {
+        strcpy(archive.entries[i].name, FILE_NAMES[i]);
+        archive.entries[i].offset = 0;
+        archive.entries[i].size = i + 1;
+    }
+
+    multiboot_mod_list module = {};
+    module.mod_start = reinterpret_cast<uintptr_t>(&archive) - KERNEL_VIRTUAL_BASE;
+    module.mod_end = module.mod_start + sizeof(archive);
+
+    return module;
+}
+
+} // namespace
+
+InitrdFileSystemTestClass::InitrdFileSystemTestClass() :
+    TestClass("InitrdFileSystem")
+{
+}
+
+void InitrdFileSystemTestClass::runTests()
+{
+    runTest("FindFile", []()
+    {
+        multiboot_mod_list module = createArchive();
+        InitrdFileSystem initrd(&module);
+        ASSERT_TRUE(initrd.isValid());
+
+        FileSystem& fileSystem = initrd;
+        for (size_t i = 0; i < NUM_FILES; ++i)
+        {
+            Stream* stream = fileSystem.openStream(FILE_NAMES[i], O_RDONLY);
+            ASSERT_TRUE(stream != nullptr, FILE_NAMES[i]);
+
+            off_t size = stream->size();
+            stream->close();
+            ASSERT_EQ(size, static_cast<off_t>(i + 1), FILE_NAMES[i]);
+        }
+    });
+
+    runTest("MissingFile", []()
+    {
+        multiboot_mod_list module = createArchive();
+        InitrdFileSystem initrd(&module);
+        ASSERT_TRUE(initrd.isValid());
+
+        // before the first name, between names, a prefix, and after the last
+        // name
+        FileSystem& fileSystem = initrd;
+        const char* names[] = {"", "a", "d", "sn", "snakes", "z"};
+        for (const char* name : names)
+        {
+            Stream* stream = fileSystem.openStream(name, O_RDONLY);
+            ASSERT_TRUE(stream == nullptr, name);
+        }
+    });
+
+    runTest("ReadOnly", []()
+    {
+        multiboot_mod_list module = createArchive();
+        InitrdFileSystem initrd(&module);
+
+        FileSystem& fileSystem = initrd;
+        ASSERT_TRUE(fileSystem.openStream("init", O_WRONLY) == nullptr);
+        ASSERT_TRUE(fileSystem.openStream("init", O_RDONLY | O_CREAT) == nullptr);
+    });
+}
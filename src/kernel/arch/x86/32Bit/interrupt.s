@@ -46,25 +46,29 @@ isrCommonStub:
 
 	mov ax, ds			; mov ds to lower 16-bits of eax
 	push eax			; save the data segment descriptor
+	mov ax, gs
+	push eax			; save the GS segment descriptor
 
 	mov ax, 16			; load the kernel data segment descriptor
 	mov ds, ax
 	mov es, ax
 	mov fs, ax
+	mov ax, 48			; load the per-CPU data segment descriptor
 	mov gs, ax
 
-	mov eax, esp		; push the stack pointer
+	lea eax, [esp + 4]	; push the stack pointer (the registers start at ds)
 	push eax
 
 	call isrHandler		; call the C interrupt handler
 
 	pop eax				; pop the stack pointer
 
+	pop eax				; reload the original GS segment descriptor
+	mov gs, ax
 	pop eax				; reload the original data segment descriptor
 	mov ds, ax
 	mov es, ax
 	mov fs, ax
-	mov gs, ax
 
 	popa				; pop edi, esi, ebp, esp, ebx, edx, ecx, eax
 	add esp, 8			; cleans up the pushed error code and interrupt number
@@ -82,31 +86,41 @@ irqCommonStub:
 
 	mov ax, ds			; mov ds to lower 16-bits of eax
 	push eax			; save the data segment descriptor
+	mov ax, gs
+	push eax			; save the GS segment descriptor
 
 	mov ax, 16			; load the kernel data segment descriptor
 	mov ds, ax
 	mov es, ax
 	mov fs, ax
+	mov ax, 48			; load the per-CPU data segment descriptor
 	mov gs, ax
 
-	mov eax, esp		; push stack pointer as arg
+	lea eax, [esp + 4]	; push stack pointer as arg (the registers start at ds)
 	push eax
 
 	call irqHandler
 
 	pop eax				; pop stack pointer
 
+	pop eax				; reload the original GS segment descriptor
+	mov gs, ax
 	pop eax				; reload the original data segment descriptor
 	mov ds, ax
 	mov es, ax
 	mov fs, ax
-	mov gs, ax
 
 	popa				; pop edi, esi, ebp, esp, ebx, edx, ecx, eax
 	add esp, 8			; cleans up the pushed error code and interrupt number
 	iret				; pops 5 things at once: CS, EIP, EFLAGS, SS, and ESP
 						; (these are pushed automatically by the processor)
 
+; The local APIC's spurious interrupt handler. Spurious interrupts are
+; not in service, so they must not be acknowledged.
+global irqSpurious
+irqSpurious:
+	iret
+
 ; system call interrupt handler
 extern systemCallHandler
 global isr128
@@ -115,11 +129,14 @@ isr128:
 
 	mov dx, ds			; mov ds to lower 16-bits of edx
 	push edx			; save the data segment descriptor
+	mov dx, gs
+	push edx			; save the GS segment descriptor
 
 	mov dx, 16			; load the kernel data segment descriptor
 	mov ds, dx
 	mov es, dx
 	mov fs, dx
+	mov dx, 48			; load the per-CPU data segment descriptor
 	mov gs, dx
 
 	; push function arguments
@@ -136,11 +153,12 @@ isr128:
 	; clean up pushed function arguments
 	add esp, 12
 
+	pop edx				; reload the original GS segment descriptor
+	mov gs, dx
 	pop edx				; reload the original data segment descriptor
 	mov ds, dx
 	mov es, dx
 	mov fs, dx
-	mov gs, dx
 
 	iret				; pops 5 things at once: CS, EIP, EFLAGS, SS, and ESP
 						; (these are pushed automatically by the processor)
@@ -196,3 +214,16 @@ IRQ 12, 44
 IRQ 13, 45
 IRQ 14, 46
 IRQ 15, 47
+
+; define local APIC interrupts
+IRQ 16, 48
+
+; define message signaled interrupts
+IRQ 17, 49
+IRQ 18, 50
+IRQ 19, 51
+IRQ 20, 52
+
+; define the reschedule and TLB shootdown inter-processor interrupts
+IRQ 21, 53
+IRQ 22, 54
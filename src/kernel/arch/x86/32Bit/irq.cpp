@@ -1,17 +1,19 @@
+#include "apic.h"
+#include "cpu.h"
 #include "idt.h"
 #include "irq.h"
+#include "kernellock.h"
 #include "system.h"
-
-const int IRQ_START_NUM = 32;
-const int NUM_IRQ_FUNCTIONS = 16;
+#include "tasklet.h"
 
 /**
  * @brief Array of function pointers for IRQ handlers
  */
-irqHandlerPtr irqFunctions[16] =
+irqHandlerPtr irqFunctions[NUM_IRQ_HANDLERS] =
 {
     nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
     nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
 };
 
 namespace
@@ -34,6 +36,15 @@ void remapIrq()
     outb(0xA1, 0x0);
 }
 
+/**
+ * @brief Mask every IRQ in the PIC
+ */
+void disablePic()
+{
+    outb(0x21, 0xFF);
+    outb(0xA1, 0xFF);
+}
+
 }
 
 void initIrq()
@@ -56,20 +67,51 @@ void initIrq()
     idtSetGate(IRQ_START_NUM + 13, (uint32_t)irq13, 0x08, 0x8E);
     idtSetGate(IRQ_START_NUM + 14, (uint32_t)irq14, 0x08, 0x8E);
     idtSetGate(IRQ_START_NUM + 15, (uint32_t)irq15, 0x08, 0x8E);
+    idtSetGate(IRQ_START_NUM + IRQ_APIC_TIMER, (uint32_t)irq16, 0x08, 0x8E);
+    idtSetGate(IRQ_START_NUM + IRQ_MSI_START + 0, (uint32_t)irq17, 0x08, 0x8E);
+    idtSetGate(IRQ_START_NUM + IRQ_MSI_START + 1, (uint32_t)irq18, 0x08, 0x8E);
+    idtSetGate(IRQ_START_NUM + IRQ_MSI_START + 2, (uint32_t)irq19, 0x08, 0x8E);
+    idtSetGate(IRQ_START_NUM + IRQ_MSI_START + 3, (uint32_t)irq20, 0x08, 0x8E);
+    idtSetGate(IRQ_START_NUM + IRQ_RESCHEDULE, (uint32_t)irq21, 0x08, 0x8E);
+    idtSetGate(IRQ_START_NUM + IRQ_TLB_SHOOTDOWN, (uint32_t)irq22, 0x08, 0x8E);
+    idtSetGate(Apic::SPURIOUS_VECTOR, (uint32_t)irqSpurious, 0x08, 0x8E);
+
+    // the I/O APIC delivers the IRQs on the same vectors, and they are
+    // acknowledged with one write to the local APIC instead of port I/O
+    if (Apic::init(IRQ_START_NUM))
+    {
+        disablePic();
+    }
 }
 
 void registerIrqHandler(uint8_t irq, irqHandlerPtr handler)
 {
     irqFunctions[irq] = handler;
+
+    if (Apic::isEnabled())
+    {
+        Apic::setIrqMasked(irq, false);
+    }
 }
 
 void unregisterIrqHandler(uint8_t irq)
 {
+    if (Apic::isEnabled())
+    {
+        Apic::setIrqMasked(irq, true);
+    }
+
     irqFunctions[irq] = nullptr;
 }
 
-void sendPicEoi(const registers* regs)
+void sendEoi(const registers* regs)
 {
+    if (Apic::isEnabled())
+    {
+        Apic::sendEoi();
+        return;
+    }
+
     // if the IDT entry is greater than or equal to IRQ8,
     // send an EOI to the slave interrupt controller
     if (regs->intNo >= IRQ_START_NUM + 8)
@@ -81,12 +123,40 @@ void sendPicEoi(const registers* regs)
     outb(0x20, 0x20);
 }
 
+bool isInIrqHandler()
+{
+    if (Apic::isEnabled())
+    {
+        return Apic::isInService();
+    }
+
+    // read the master PIC's in-service register (IRQs on the slave PIC are
+    // also in service on the master's cascade IRQ), then switch back to
+    // reading the interrupt request register
+    outb(0x20, 0x0B);
+    uint8_t inService = inb(0x20);
+    outb(0x20, 0x0A);
+
+    return inService != 0;
+}
+
 /**
  * @brief Called from assembly to handle IRQ
  */
 extern "C"
 void irqHandler(const struct registers* regs)
 {
+    // the processor that sent the shootdown holds the kernel lock and waits
+    // for this one
+    if (regs->intNo == IRQ_START_NUM + IRQ_TLB_SHOOTDOWN)
+    {
+        Cpu::handleShootdown();
+        sendEoi(regs);
+        return;
+    }
+
+    bool locked = KernelLock::enter();
+
     // function pointer
     irqHandlerPtr handler = irqFunctions[regs->intNo - IRQ_START_NUM];
 
@@ -96,5 +166,10 @@ void irqHandler(const struct registers* regs)
         handler(regs);
     }
 
-    sendPicEoi(regs);
+    sendEoi(regs);
+
+    // run the work the handler deferred now that other IRQs can be delivered
+    Tasklet::runScheduled();
+
+    KernelLock::leave(locked);
 }
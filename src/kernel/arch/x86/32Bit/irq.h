@@ -25,6 +25,30 @@
 #define IRQ_COM2       IRQ3
 #define IRQ_COM1       IRQ4
 
+/// the local APIC timer, which comes from the processor's local APIC rather
+/// than the PIC or I/O APIC
+#define IRQ_APIC_TIMER 16
+
+/// the IRQs for message signaled interrupts (MSI) from PCI functions,
+/// which are sent straight to the local APIC
+#define IRQ_MSI_START 17
+#define NUM_MSI_IRQS   4
+
+/// the inter-processor interrupt that wakes an idle processor when it has
+/// processes to run
+#define IRQ_RESCHEDULE 21
+
+/// the inter-processor interrupt that makes a processor invalidate a page
+/// in its TLB (it is handled without the kernel lock, which the sender
+/// holds)
+#define IRQ_TLB_SHOOTDOWN 22
+
+/// the number of IRQs that handlers can be registered for
+#define NUM_IRQ_HANDLERS 23
+
+/// the interrupt vector of IRQ 0
+#define IRQ_START_NUM 32
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -46,25 +70,47 @@ extern void irq12();
 extern void irq13();
 extern void irq14();
 extern void irq15();
+extern void irq16();
+extern void irq17();
+extern void irq18();
+extern void irq19();
+extern void irq20();
+extern void irq21();
+extern void irq22();
+extern void irqSpurious();
 
 typedef void (*irqHandlerPtr)(const registers*);
 
+/**
+ * @brief Set up IRQ delivery. IRQs are delivered by the I/O APIC if there
+ * is one; otherwise, by the PIC.
+ */
 void initIrq();
 
 /**
- * @brief Register a handler for an IRQ.
+ * @brief Register a handler for an IRQ, and unmask the IRQ if it is
+ * delivered by the I/O APIC.
  */
 void registerIrqHandler(uint8_t irq, irqHandlerPtr handler);
 
 /**
- * @brief Unregister a handler for an IRQ.
+ * @brief Unregister a handler for an IRQ, and mask the IRQ if it is
+ * delivered by the I/O APIC.
  */
 void unregisterIrqHandler(uint8_t irq);
 
 /**
- * @brief Send End Of Interrupt (EOI) command to PIC.
+ * @brief Send End Of Interrupt (EOI) command to the local APIC or the PIC.
+ */
+void sendEoi(const registers* regs);
+
+/**
+ * @brief Whether an IRQ handler is running (i.e. an IRQ has not been
+ * acknowledged yet). Code that may be called from an IRQ handler must not
+ * sleep if this is true, because the interrupt it waits for can't be
+ * delivered.
  */
-void sendPicEoi(const registers* regs);
+bool isInIrqHandler();
 
 #ifdef __cplusplus
 } // extern "C"
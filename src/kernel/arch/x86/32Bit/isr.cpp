@@ -1,6 +1,7 @@
 #include <stdio.h>
 
 #include "isr.h"
+#include "kernellock.h"
 #include "system.h"
 
 namespace
@@ -101,6 +102,8 @@ void unregisterIsrHandler(uint8_t isr)
 extern "C"
 void isrHandler(const struct registers* regs)
 {
+    bool locked = KernelLock::enter();
+
     isrHandlerPtr handler = nullptr;
     if (regs->intNo < ISR_FUNCTIONS_SIZE)
     {
@@ -131,4 +134,5 @@ void isrHandler(const struct registers* regs)
         PANIC(errorMsg);
     }
 
+    KernelLock::leave(locked);
 }
@@ -0,0 +1,53 @@
+#include "cpu.h"
+#include "kernellock.h"
+
+volatile uint32_t KernelLock::locked = 0;
+volatile uint32_t KernelLock::owner = KernelLock::NO_OWNER;
+
+void KernelLock::acquire()
+{
+    while (__atomic_exchange_n(&locked, 1, __ATOMIC_ACQUIRE) != 0)
+    {
+        // wait without writing, so the cache line isn't bounced between
+        // the waiting processors; interrupts are disabled, so TLB
+        // shootdowns from the processor that holds the lock are handled
+        // here
+        while (locked != 0)
+        {
+            Cpu::handleShootdown();
+            asm volatile ("pause");
+        }
+    }
+
+    owner = Cpu::getCurrent()->index;
+}
+
+void KernelLock::release()
+{
+    owner = NO_OWNER;
+    __atomic_store_n(&locked, 0, __ATOMIC_RELEASE);
+}
+
+bool KernelLock::enter()
+{
+    if (isHeld())
+    {
+        return false;
+    }
+
+    acquire();
+    return true;
+}
+
+void KernelLock::leave(bool acquired)
+{
+    if (acquired)
+    {
+        release();
+    }
+}
+
+bool KernelLock::isHeld()
+{
+    return owner == Cpu::getCurrent()->index;
+}
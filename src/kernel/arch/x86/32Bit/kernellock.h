@@ -0,0 +1,59 @@
+#ifndef KERNEL_LOCK_H_
+#define KERNEL_LOCK_H_
+
+#include <stdint.h>
+
+/**
+ * @brief The lock that lets one processor at a time run kernel code.
+ * @details The kernel was written for one processor, where disabling
+ * interrupts is enough to keep kernel data consistent, so with several
+ * processors only user code runs in parallel. A processor holds the lock
+ * whenever it is in the kernel: interrupts and system calls from user mode
+ * acquire it, and it is released when they return to user mode and while
+ * the processor idles. Ownership belongs to the processor, not to the code
+ * that acquired it, so a process that was switched out in the kernel can
+ * resume on another processor and release the lock there.
+ */
+class KernelLock
+{
+public:
+    /**
+     * @brief Spin until the calling processor holds the lock. Interrupts
+     * should be disabled.
+     */
+    static void acquire();
+
+    /**
+     * @brief Release the lock held by the calling processor.
+     */
+    static void release();
+
+    /**
+     * @brief Acquire the lock when entering the kernel, unless the calling
+     * processor already holds it (i.e. it was interrupted in the kernel).
+     * @return Whether the lock was acquired; pass this to leave().
+     */
+    static bool enter();
+
+    /**
+     * @brief Release the lock when leaving the kernel if enter() acquired
+     * it.
+     */
+    static void leave(bool acquired);
+
+    /**
+     * @brief Whether the calling processor holds the lock.
+     */
+    static bool isHeld();
+
+private:
+    /// the owner when no processor holds the lock
+    static constexpr uint32_t NO_OWNER = 0xFFFF'FFFF;
+
+    static volatile uint32_t locked;
+
+    /// the index of the processor that holds the lock
+    static volatile uint32_t owner;
+};
+
+#endif // KERNEL_LOCK_H_
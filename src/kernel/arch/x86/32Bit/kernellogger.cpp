@@ -19,6 +19,15 @@ void KernelLogger::flush(const char* buff, size_t len)
     {
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buff);
         stream->write(ptr, len, /*block=*/ true);
+    }
+}
+
+void KernelLogger::flushStream()
+{
+    Logger::flush();
+
+    if (stream != nullptr)
+    {
         stream->flush();
     }
 }
@@ -41,7 +41,9 @@ public:
     static constexpr ELevel LOG_LEVEL = eInfo;
 
     /// Messages at this level and above will be flushed immediately after they are logged.
-    static constexpr ELevel FLUSH_LEVEL = eInfo;
+    /// Flushing waits for the device to send every queued byte, so it is
+    /// only done on the panic path (see flushStream()).
+    static constexpr ELevel FLUSH_LEVEL = eOff;
 
     /**
      * @brief Construct a new KernelLogger object.
@@ -54,6 +56,11 @@ public:
      */
     void setStream(Stream* streamPtr);
 
+    /**
+     * @brief Wait until the stream has sent all logged messages.
+     */
+    void flushStream();
+
     template<typename... Ts>
     void logTrace(const char* tag, const char* format, Ts... ts)
     {
@@ -106,10 +113,12 @@ private:
             log(format, ts...);
             write('\n');
 
+            // pass the message to the stream, which sends it in the background
+            Logger::flush();
+
             if constexpr (level >= FLUSH_LEVEL)
             {
-                // flush the buffer
-                Logger::flush();
+                flushStream();
             }
         }
     }
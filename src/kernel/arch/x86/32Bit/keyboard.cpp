@@ -1,9 +1,10 @@
 #include <ctype.h>
+#include <errno.h>
 
 #include "keyboard.h"
 #include "os.h"
-#include "processmgr.h"
 #include "system.h"
+#include "waitqueue.h"
 
 #define CONTROL_KEYS_START 0x0100
 
@@ -125,6 +126,13 @@ uint16_t Keyboard::keyQueue[KEY_QUEUE_SIZE];
 unsigned int Keyboard::keyQHead = 0;
 unsigned int Keyboard::keyQTail = 0;
 
+WaitQueue Keyboard::waitQueue;
+
+Stream::InputHandler Keyboard::inputHandler = nullptr;
+void* Keyboard::inputHandlerData = nullptr;
+
+Tasklet Keyboard::bottomHalf(runBottomHalf, nullptr);
+
 void Keyboard::init()
 {
     registerIrqHandler(IRQ_KEYBOARD, interruptHandler);
@@ -148,12 +156,12 @@ void Keyboard::interruptHandler(const registers* /*regs*/)
             ++scanCodeQTail;
         }
     }
+
+    bottomHalf.schedule();
 }
 
 bool Keyboard::getKey(uint16_t& key)
 {
-    processQueue();
-
     // if the queue is empty return false
     if (keyQHead == keyQTail)
     {
@@ -239,6 +247,16 @@ bool Keyboard::getChar(char& ch)
     return found;
 }
 
+void Keyboard::runBottomHalf(void* /*data*/)
+{
+    processQueue();
+
+    if (inputHandler == nullptr || inputHandler(inputHandlerData))
+    {
+        waitQueue.wakeAll();
+    }
+}
+
 void Keyboard::processQueue()
 {
     while (scanCodeQHead != scanCodeQTail)
@@ -270,23 +288,32 @@ void Keyboard::processQueue()
 ssize_t Keyboard::read(uint8_t* buff, size_t nbyte)
 {
     size_t idx = 0;
-    while (idx < nbyte)
+    char ch = '\0';
+    while (idx < nbyte && getChar(ch))
     {
-        char ch = '\0';
-        bool found = getChar(ch);
-        while (!found)
-        {
-            processMgr.yieldCurrentProcess();
-            found = getChar(ch);
-        }
-
         reinterpret_cast<char*>(buff)[idx] = ch;
         ++idx;
     }
 
+    if (idx == 0 && nbyte > 0)
+    {
+        return -EAGAIN;
+    }
+
     return static_cast<ssize_t>(idx);
 }
 
+WaitQueue* Keyboard::getWaitQueue()
+{
+    return &waitQueue;
+}
+
+void Keyboard::setInputHandler(InputHandler handler, void* data)
+{
+    inputHandler = handler;
+    inputHandlerData = data;
+}
+
 void Keyboard::keyRelease(uint16_t key)
 {
     if (key >= CONTROL_KEYS_START)
@@ -3,6 +3,7 @@
 
 #include "irq.h"
 #include "stream.h"
+#include "tasklet.h"
 
 namespace os
 {
@@ -19,7 +20,8 @@ public:
     static void init();
 
     /**
-     * @brief The keyboard interrupt handler.
+     * @brief The keyboard interrupt handler. It only queues the scan code;
+     * the scan codes are translated to keys in a tasklet.
      */
     static void interruptHandler(const registers* regs);
 
@@ -33,8 +35,6 @@ public:
      */
     static bool getChar(char& ch);
 
-    static void processQueue();
-
     bool canRead() const override
     {
         return true;
@@ -47,6 +47,10 @@ public:
 
     ssize_t read(uint8_t* buff, size_t nbyte) override;
 
+    WaitQueue* getWaitQueue() override;
+
+    void setInputHandler(InputHandler handler, void* data) override;
+
     ssize_t write(const uint8_t*, size_t) override
     {
         return -1;
@@ -81,6 +85,20 @@ private:
     static unsigned int keyQHead;
     static unsigned int keyQTail;
 
+    // processes waiting for a key
+    static WaitQueue waitQueue;
+
+    // processes keys as they arrive (see setInputHandler())
+    static InputHandler inputHandler;
+    static void* inputHandlerData;
+
+    // translates queued scan codes to keys
+    static Tasklet bottomHalf;
+
+    static void runBottomHalf(void* data);
+
+    static void processQueue();
+
     static void keyRelease(uint16_t key);
 
     static void keyPress(uint16_t key);
@@ -0,0 +1,51 @@
+#include "apic.h"
+#include "lapictimer.h"
+#include "pitclockevent.h"
+
+bool LapicTimer::init(irqHandlerPtr eventHandler)
+{
+    if (!Apic::isEnabled())
+    {
+        return false;
+    }
+
+    // count down from the maximum, without interrupting, while the PIT
+    // counts a known time
+    Apic::startTimer(MAX_COUNT, IRQ_START_NUM + IRQ_APIC_TIMER, /*masked=*/ true);
+    PitClockEvent::wait(CALIBRATION_PIT_COUNT);
+    uint32_t numCounts = MAX_COUNT - Apic::getTimerCount();
+    Apic::stopTimer();
+
+    frequency = static_cast<uint64_t>(numCounts) * PIT_FREQUENCY / CALIBRATION_PIT_COUNT;
+    if (frequency == 0)
+    {
+        return false;
+    }
+
+    minDelay = (NS_PER_SEC + frequency - 1) / frequency;
+    maxDelay = MAX_COUNT * NS_PER_SEC / frequency;
+
+    registerIrqHandler(IRQ_APIC_TIMER, eventHandler);
+
+    return true;
+}
+
+void LapicTimer::setNextEvent(uint64_t delayNs)
+{
+    uint64_t count = delayNs * frequency / NS_PER_SEC;
+    if (count == 0)
+    {
+        count = 1;
+    }
+    else if (count > MAX_COUNT)
+    {
+        count = MAX_COUNT;
+    }
+
+    Apic::startTimer(static_cast<uint32_t>(count), IRQ_START_NUM + IRQ_APIC_TIMER);
+}
+
+void LapicTimer::stop()
+{
+    Apic::stopTimer();
+}
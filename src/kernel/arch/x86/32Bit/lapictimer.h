@@ -0,0 +1,45 @@
+#ifndef LAPIC_TIMER_H_
+#define LAPIC_TIMER_H_
+
+#include "clockevent.h"
+
+/**
+ * @brief The local APIC timer in one-shot mode. Its rate is measured
+ * against the PIT when it is set up.
+ */
+class LapicTimer : public ClockEvent
+{
+public:
+    /**
+     * @brief Measure the timer's rate and register the handler.
+     * @return false if the local APIC is not in use
+     */
+    bool init(irqHandlerPtr eventHandler) override;
+
+    void setNextEvent(uint64_t delayNs) override;
+
+    void stop() override;
+
+    const char* getName() const override
+    {
+        return "local APIC timer";
+    }
+
+    /**
+     * @brief Get the timer's rate in counts per second.
+     */
+    uint64_t getFrequency() const
+    {
+        return frequency;
+    }
+
+private:
+    /// PIT cycles to measure the rate for (10 ms)
+    static constexpr uint16_t CALIBRATION_PIT_COUNT = 11'932;
+
+    static constexpr uint32_t MAX_COUNT = 0xFFFF'FFFF;
+
+    uint64_t frequency = 0;
+};
+
+#endif // LAPIC_TIMER_H_
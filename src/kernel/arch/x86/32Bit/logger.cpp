@@ -291,7 +291,13 @@ void Logger::flush()
 {
     if (buffSize > 0)
     {
-        flush(buff, buffSize);
+        // writing the buffer may sleep, and another process may log in the
+        // meantime, so it's copied and emptied first
+        char msg[MAX_BUFF_SIZE];
+        size_t len = buffSize;
+        memcpy(msg, buff, len);
         buffSize = 0;
+
+        flush(msg, len);
     }
 }
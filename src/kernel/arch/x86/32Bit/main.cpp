@@ -2,22 +2,35 @@
 
 #include "multiboot.h"
 
-#include "gdt.h"
+#include "apic.h"
+#include "atadriver.h"
+#include "blockdevice.h"
+#include "clock.h"
+#include "cpu.h"
+#include "ext2filesystem.h"
+#include "framebufferconsole.h"
 #include "idt.h"
+#include "initrdfilesystem.h"
 #include "irq.h"
 #include "kernellogger.h"
+#include "kernellock.h"
 #include "keyboard.h"
 #include "mbootmodulefilesystem.h"
+#include "pagecache.h"
 #include "pageframemgr.h"
 #include "paging.h"
+#include "pci.h"
 #include "processmgr.h"
 #include "rootfilesystem.h"
 #include "serialportdriver.h"
 #include "streamtable.h"
 #include "system.h"
 #include "timer.h"
+#include "tmpfilesystem.h"
+#include "tty.h"
 #include "userlogger.h"
 #include "vgadriver.h"
+#include "virtioblockdevice.h"
 
 /**
  * @brief 32-bit x86 kernel main
@@ -25,12 +38,22 @@
 extern "C"
 void kernelMain(const uint32_t MULTIBOOT_MAGIC_NUM, const multiboot_info* mbootInfo)
 {
-    initGdt();
+    Cpu::init();
+
+    // the boot processor is in the kernel until it runs the first process,
+    // so the other processors wait to run processes until then
+    KernelLock::acquire();
+
     initIdt();
     initIrq();
     configPaging();
 
-    os::Timer::init(20);
+    // the scheduler and the timer wheel keep time with the clock
+    if (!Clock::init())
+    {
+        PANIC("The CPU has no time stamp counter.");
+    }
+    os::Timer::init();
 
     os::Keyboard::init();
 
@@ -40,17 +63,42 @@ void kernelMain(const uint32_t MULTIBOOT_MAGIC_NUM, const multiboot_info* mbootI
     // create stream drivers
     os::Keyboard keyboardDriver;
     VgaDriver vgaDriver;
+    FramebufferConsole framebufferConsole;
     SerialPortDriver serial1(SerialPortDriver::COM1_PORT, 115'200);
     SerialPortDriver serial2(SerialPortDriver::COM2_PORT, 115'200);
 
-    streamTable.addStream(&keyboardDriver);
-    streamTable.addStream(&vgaDriver);
-    streamTable.addStream(&serial1);
+    klog.setStream(&serial2);
+
+    klog.logInfo("Initialization", "IRQs are delivered by the {}", Apic::isEnabled() ? "I/O APIC" : "PIC");
+    klog.logInfo("Initialization", "Time slices are timed by the {}", os::Timer::getClockEvent()->getName());
+    klog.logInfo("Initialization", "TSC runs at {} kHz{}", static_cast<uint32_t>(Clock::getTscFrequency() / 1000),
+                 Clock::isTscInvariant() ? "" : " (not invariant)");
+
+    // the other processors run processes once the boot processor releases
+    // the kernel lock
+    unsigned int numCpus = Cpu::startApplicationProcessors();
+    klog.logInfo("Initialization", "{} processor{} running", numCpus, (numCpus == 1) ? " is" : "s are");
+
+    // draw the console in the framebuffer if the boot loader set up a
+    // graphics mode; otherwise, use VGA text mode
+    TextConsole* console = &framebufferConsole;
+    if (MULTIBOOT_MAGIC_NUM != MULTIBOOT_BOOTLOADER_MAGIC || !framebufferConsole.init(mbootInfo))
+    {
+        vgaDriver.init();
+        console = &vgaDriver;
+    }
+
+    // processes read and write the keyboard and console, and the first
+    // serial port, through terminals
+    Tty consoleTty(&keyboardDriver, console);
+    Tty serialTty(&serial1, &serial1);
+
+    streamTable.addStream(&consoleTty);
+    streamTable.addStream(&serialTty);
     streamTable.addStream(&serial2);
 
-    ulog.addStream(&vgaDriver);
+    ulog.addStream(console);
     ulog.addStream(&serial1);
-    klog.setStream(&serial2);
 
     // ensure we were booted by a Multiboot-compliant boot loader
     if (MULTIBOOT_MAGIC_NUM != MULTIBOOT_BOOTLOADER_MAGIC)
@@ -65,12 +113,46 @@ void kernelMain(const uint32_t MULTIBOOT_MAGIC_NUM, const multiboot_info* mbootI
 
     PageFrameMgr pageFrameMgr(mbootInfo);
 
+    // evict cached file pages when page frames run out
+    pageCache.setPageFrameMgr(&pageFrameMgr);
+    pageFrameMgr.setReclaimHandler([](size_t numPages) { return pageCache.reclaim(numPages); });
+
+    // find disks
+    pciBus.scan();
+    ataDriver.init(&pageFrameMgr);
+    virtioBlockDriver.init(&pageFrameMgr);
+
     // init file systems
     MBootModuleFileSystem mbootModuleFileSystem(mbootInfo);
-    rootFileSystem.addFileSystem(&mbootModuleFileSystem);
+    InitrdFileSystem initrdFileSystem(mbootModuleFileSystem.findModule("initrd"));
+
+    // programs are in the initrd if there is one; otherwise, each program
+    // is its own module
+    if (initrdFileSystem.isValid())
+    {
+        rootFileSystem.addFileSystem("", &initrdFileSystem);
+        rootFileSystem.addFileSystem("modules", &mbootModuleFileSystem);
+    }
+    else
+    {
+        rootFileSystem.addFileSystem("", &mbootModuleFileSystem);
+    }
+
+    tmpFileSystem.setPageFrameMgr(&pageFrameMgr);
+    rootFileSystem.addFileSystem("tmp", &tmpFileSystem);
+
+    // mount the first disk with an ext2 file system
+    ext2FileSystem.setPageFrameMgr(&pageFrameMgr);
+    for (size_t i = 0; i < blockDeviceTable.getNumDevices(); ++i)
+    {
+        if (ext2FileSystem.mount(blockDeviceTable.getDevice(i)))
+        {
+            rootFileSystem.addFileSystem("disk", &ext2FileSystem);
+            break;
+        }
+    }
 
     processMgr.setPageFrameMgr(&pageFrameMgr);
-    processMgr.setMultibootInfo(mbootInfo);
 
     processMgr.mainloop();
 }
@@ -1,6 +1,9 @@
+#include <dirent.h>
+#include <fcntl.h>
 #include <string.h>
 #include "mbootmodulefilesystem.h"
 #include "multiboot.h"
+#include "paging.h"
 #include "streamtable.h"
 #include "system.h"
 
@@ -10,27 +13,32 @@ MBootModuleFileSystem::MBootModuleFileSystem(const multiboot_info* mbootInfo) :
 {
 }
 
-Stream* MBootModuleFileSystem::openStream(const char* path)
+const multiboot_mod_list* MBootModuleFileSystem::findModule(const char* name) const
 {
     // search for a module with a matching name
-    const multiboot_mod_list* module = nullptr;
-    uintptr_t addr = moduleStartAddr;
+    const multiboot_mod_list* modules = reinterpret_cast<const multiboot_mod_list*>(moduleStartAddr);
     for (size_t i = 0; i < numModules; ++i)
     {
-        // get module info struct
-        const multiboot_mod_list* modulePtr = reinterpret_cast<const multiboot_mod_list*>(addr);
-
-        // check if name matches
-        const char* modName = reinterpret_cast<const char*>(modulePtr->cmdline + KERNEL_VIRTUAL_BASE);
-        if (strcmp(path, modName) == 0)
+        const char* modName = reinterpret_cast<const char*>(modules[i].cmdline + KERNEL_VIRTUAL_BASE);
+        if (strcmp(name, modName) == 0)
         {
-            module = modulePtr;
-            break;
+            return &modules[i];
         }
+    }
+
+    return nullptr;
+}
 
-        addr += sizeof(multiboot_mod_list);
+Stream* MBootModuleFileSystem::openStream(const char* path, int oflag)
+{
+    // modules are read-only
+    if ( (oflag & (O_WRONLY | O_CREAT | O_TRUNC | O_APPEND)) != 0 )
+    {
+        return nullptr;
     }
 
+    const multiboot_mod_list* module = findModule(path);
+
     // find a stream
     MBootModuleStream* stream = nullptr;
     if (module != nullptr)
@@ -44,11 +52,46 @@ Stream* MBootModuleFileSystem::openStream(const char* path)
         }
     }
 
-    // set the stream's module
+    // the module's index is its inode number
     if (stream != nullptr)
     {
-        stream->setModule(module);
+        const multiboot_mod_list* modules = reinterpret_cast<const multiboot_mod_list*>(moduleStartAddr);
+        stream->open(this, module - modules, module->mod_start, module->mod_end - module->mod_start);
     }
 
     return stream;
 }
+
+bool MBootModuleFileSystem::getResidentPage(uint32_t inode, size_t pageIdx, uintptr_t& physicalAddr, uintptr_t& virtualAddr)
+{
+    if (inode >= numModules)
+    {
+        return false;
+    }
+
+    // modules are mapped in the kernel's address space
+    const multiboot_mod_list* modules = reinterpret_cast<const multiboot_mod_list*>(moduleStartAddr);
+    physicalAddr = modules[inode].mod_start + pageIdx * PAGE_SIZE;
+    virtualAddr = physicalAddr + KERNEL_VIRTUAL_BASE;
+
+    return true;
+}
+
+size_t MBootModuleFileSystem::getDirEntries(size_t index, dirent* entries, size_t maxEntries)
+{
+    const multiboot_mod_list* modules = reinterpret_cast<const multiboot_mod_list*>(moduleStartAddr);
+
+    size_t numEntries = 0;
+    for (size_t i = index; i < numModules && numEntries < maxEntries; ++i)
+    {
+        const char* modName = reinterpret_cast<const char*>(modules[i].cmdline + KERNEL_VIRTUAL_BASE);
+
+        // the module's index is its inode number
+        dirent& entry = entries[numEntries++];
+        entry.d_ino = i;
+        strncpy(entry.d_name, modName, NAME_MAX);
+        entry.d_name[NAME_MAX] = '\0';
+    }
+
+    return numEntries;
+}
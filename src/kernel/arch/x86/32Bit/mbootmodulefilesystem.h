@@ -7,14 +7,30 @@
 #include "mbootmodulestream.h"
 
 struct multiboot_info;
+struct multiboot_mod_list;
 
 class MBootModuleFileSystem : public FileSystem
 {
 public:
     MBootModuleFileSystem(const multiboot_info* mbootInfo);
 
+    /**
+     * @brief Find the module with the given name.
+     * @return The module, or nullptr if there is no module with the name.
+     */
+    const multiboot_mod_list* findModule(const char* name) const;
+
 protected:
-    Stream* openStream(const char* path) override;
+    Stream* openStream(const char* path, int oflag) override;
+
+    bool unlink(const char*) override
+    {
+        return false;
+    }
+
+    size_t getDirEntries(size_t index, dirent* entries, size_t maxEntries) override;
+
+    bool getResidentPage(uint32_t inode, size_t pageIdx, uintptr_t& physicalAddr, uintptr_t& virtualAddr) override;
 
 private:
     uintptr_t moduleStartAddr;
@@ -1,39 +1,131 @@
-#include <string.h>
 #include "mbootmodulestream.h"
-#include "multiboot.h"
-#include "system.h"
+#include "paging.h"
 
 MBootModuleStream::MBootModuleStream()
 {
-    setModule(nullptr);
+    close();
 }
 
-void MBootModuleStream::setModule(const multiboot_mod_list* modulePtr)
+void MBootModuleStream::open(FileSystem* fileSystemPtr, uint32_t inodeNum, uintptr_t physicalAddr, size_t size)
 {
-    module = modulePtr;
-    position = (module == nullptr) ? 0 : module->mod_start + KERNEL_VIRTUAL_BASE;
+    fileSystem = fileSystemPtr;
+    inode = inodeNum;
+    dataStart = physicalAddr;
+    dataSize = size;
+    position = 0;
+    readAhead.reset();
 }
 
 ssize_t MBootModuleStream::read(uint8_t* buff, size_t nbyte)
 {
-    size_t moduleEnd = module->mod_end + KERNEL_VIRTUAL_BASE;
-    if (position + nbyte >= moduleEnd)
+    ssize_t rv = readAt(buff, nbyte, static_cast<off_t>(position));
+    if (rv > 0)
     {
-        nbyte = moduleEnd - position;
+        position += rv;
     }
 
-    memcpy(buff, reinterpret_cast<const void*>(position), nbyte);
-    position += nbyte;
+    return rv;
+}
+
+ssize_t MBootModuleStream::readAt(uint8_t* buff, size_t nbyte, off_t offset)
+{
+    if (offset < 0)
+    {
+        return -1;
+    }
+
+    return pageCache.read(fileSystem, inode, dataSize, static_cast<size_t>(offset), buff, nbyte, readAhead);
+}
+
+ssize_t MBootModuleStream::send(Stream* outStream, size_t nbyte)
+{
+    ssize_t rv = sendAt(outStream, nbyte, static_cast<off_t>(position));
+    if (rv > 0)
+    {
+        position += rv;
+    }
+
+    return rv;
+}
+
+ssize_t MBootModuleStream::sendAt(Stream* outStream, size_t nbyte, off_t offset)
+{
+    if (offset < 0)
+    {
+        return -1;
+    }
+
+    return pageCache.send(fileSystem, inode, dataSize, static_cast<size_t>(offset), outStream, nbyte, readAhead);
+}
+
+bool MBootModuleStream::getPhysicalMemory(uintptr_t& physicalAddr, size_t& size) const
+{
+    // GRUB loads modules on a page boundary, so the module's pages can be
+    // mapped directly
+    if (!isOpen() || (dataStart & PAGE_SIZE_MASK) != 0)
+    {
+        return false;
+    }
+
+    physicalAddr = dataStart;
+    size = dataSize;
+
+    return true;
+}
+
+off_t MBootModuleStream::seek(off_t offset, int whence)
+{
+    if (!isOpen())
+    {
+        return -1;
+    }
+
+    off_t base = 0;
+    switch (whence)
+    {
+        case SEEK_SET:
+            base = 0;
+            break;
+
+        case SEEK_CUR:
+            base = static_cast<off_t>(position);
+            break;
+
+        case SEEK_END:
+            base = size();
+            break;
+
+        default:
+            return -1;
+    }
+
+    off_t newPosition = base + offset;
+    if (newPosition < 0)
+    {
+        return -1;
+    }
+
+    position = static_cast<size_t>(newPosition);
+
+    return newPosition;
+}
+
+off_t MBootModuleStream::size() const
+{
+    if (!isOpen())
+    {
+        return -1;
+    }
 
-    return static_cast<ssize_t>(nbyte);
+    return static_cast<off_t>(dataSize);
 }
 
 void MBootModuleStream::close()
 {
-    setModule(nullptr);
+    open(nullptr, 0, 0, 0);
 }
 
 bool MBootModuleStream::isOpen() const
 {
-    return module != nullptr;
+    return dataStart != 0;
 }
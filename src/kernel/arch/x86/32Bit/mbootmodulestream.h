@@ -1,16 +1,24 @@
 #ifndef MBOOT_MODULE_STREAM_H_
 #define MBOOT_MODULE_STREAM_H_
 
+#include "pagecache.h"
 #include "stream.h"
 
-struct multiboot_mod_list;
+class FileSystem;
 
 class MBootModuleStream : public Stream
 {
 public:
     MBootModuleStream();
 
-    void setModule(const multiboot_mod_list* modulePtr);
+    /**
+     * @brief Open the stream to a file stored in a module.
+     * @param fileSystemPtr The file system the file is in.
+     * @param inodeNum The file's inode number in the file system.
+     * @param physicalAddr The physical address of the file's data.
+     * @param size The size of the file's data in bytes.
+     */
+    void open(FileSystem* fileSystemPtr, uint32_t inodeNum, uintptr_t physicalAddr, size_t size);
 
     bool canRead() const override
     {
@@ -24,11 +32,23 @@ public:
 
     ssize_t read(uint8_t* buff, size_t nbyte) override;
 
+    ssize_t readAt(uint8_t* buff, size_t nbyte, off_t offset) override;
+
     ssize_t write(const uint8_t*, size_t) override
     {
         return -1;
     }
 
+    ssize_t send(Stream* outStream, size_t nbyte) override;
+
+    ssize_t sendAt(Stream* outStream, size_t nbyte, off_t offset) override;
+
+    bool getPhysicalMemory(uintptr_t& physicalAddr, size_t& size) const override;
+
+    off_t seek(off_t offset, int whence) override;
+
+    off_t size() const override;
+
     void flush() override
     {
     }
@@ -38,8 +58,19 @@ public:
     bool isOpen() const;
 
 private:
-    const multiboot_mod_list* module;
+    FileSystem* fileSystem;
+    uint32_t inode;
+
+    /// physical address of the start of the data (0 if the stream is closed)
+    uintptr_t dataStart;
+
+    /// size of the data in bytes
+    size_t dataSize;
+
+    /// offset from the start of the data
     size_t position;
+
+    PageCache::ReadAhead readAhead;
 };
 
 #endif // MBOOT_MODULE_STREAM_H_
@@ -0,0 +1,494 @@
+/**
+ * @brief Page cache
+ */
+
+#include <string.h>
+#include "filesystem.h"
+#include "kernellogger.h"
+#include "pagecache.h"
+#include "pageframemgr.h"
+#include "paging.h"
+#include "processmgr.h"
+#include "stream.h"
+#include "utils.h"
+
+const char* PageCache::LOG_TAG = "PageCache";
+
+void PageCache::ReadAhead::reset()
+{
+    nextPageIdx = 0;
+    numPages = 0;
+}
+
+PageCache::PageCache() :
+    freeEntry(0),
+    lruHead(-1),
+    lruTail(-1),
+    pageFrameMgr(nullptr)
+{
+    // chain all entries in the free list
+    for (int i = 0; i < MAX_NUM_PAGES; ++i)
+    {
+        entries[i].next = (i + 1 < MAX_NUM_PAGES) ? i + 1 : -1;
+        entries[i].pinCount = 0;
+        entries[i].isRemoved = false;
+    }
+
+    for (int& bucket : buckets)
+    {
+        bucket = -1;
+    }
+}
+
+void PageCache::setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr)
+{
+    pageFrameMgr = pageFrameMgrPtr;
+}
+
+ssize_t PageCache::read(FileSystem* fileSystem, uint32_t inode, size_t fileSize, size_t position,
+                        uint8_t* buff, size_t nbyte, ReadAhead& readAhead)
+{
+    return transfer(fileSystem, inode, fileSize, position, buff, nullptr, nbyte, readAhead);
+}
+
+ssize_t PageCache::send(FileSystem* fileSystem, uint32_t inode, size_t fileSize, size_t position,
+                        Stream* outStream, size_t nbyte, ReadAhead& readAhead)
+{
+    return transfer(fileSystem, inode, fileSize, position, nullptr, outStream, nbyte, readAhead);
+}
+
+ssize_t PageCache::transfer(FileSystem* fileSystem, uint32_t inode, size_t fileSize, size_t position,
+                            uint8_t* buff, Stream* outStream, size_t nbyte, ReadAhead& readAhead)
+{
+    if (position >= fileSize || nbyte == 0)
+    {
+        return 0;
+    }
+
+    if (nbyte > fileSize - position)
+    {
+        nbyte = fileSize - position;
+    }
+
+    size_t firstPageIdx = position / PAGE_SIZE;
+    size_t lastPageIdx = (position + nbyte - 1) / PAGE_SIZE;
+    size_t numFilePages = align(fileSize, PAGE_SIZE) / PAGE_SIZE;
+
+    // grow the read-ahead window while the file is read sequentially
+    if (firstPageIdx == readAhead.nextPageIdx || firstPageIdx + 1 == readAhead.nextPageIdx)
+    {
+        readAhead.numPages = (readAhead.numPages == 0) ? 1 : readAhead.numPages * 2;
+        if (readAhead.numPages > MAX_READ_AHEAD_PAGES)
+        {
+            readAhead.numPages = MAX_READ_AHEAD_PAGES;
+        }
+    }
+    else
+    {
+        readAhead.numPages = 0;
+    }
+
+    readAhead.nextPageIdx = lastPageIdx + 1;
+
+    // copy the data one page at a time
+    size_t numRead = 0;
+    ssize_t error = 0;
+    while (numRead < nbyte)
+    {
+        size_t pageIdx = (position + numRead) / PAGE_SIZE;
+        size_t offset = (position + numRead) & PAGE_SIZE_MASK;
+        size_t num = PAGE_SIZE - offset;
+        if (num > nbyte - numRead)
+        {
+            num = nbyte - numRead;
+        }
+
+        // read the rest of the request and the read-ahead window together
+        size_t readAheadPages = (lastPageIdx - pageIdx) + readAhead.numPages;
+
+        // the page stays pinned while the stream write blocks
+        bool isTemp = false;
+        int entryIdx = -1;
+        uintptr_t residentAddr = 0;
+        uint8_t* page = getPage(fileSystem, inode, pageIdx, numFilePages, readAheadPages, isTemp, entryIdx, residentAddr);
+        if (page == nullptr)
+        {
+            error = -1;
+            break;
+        }
+
+        ssize_t numCopied = static_cast<ssize_t>(num);
+        if (buff != nullptr)
+        {
+            memcpy(buff + numRead, page + offset, num);
+        }
+        else
+        {
+            numCopied = outStream->write(page + offset, num, true);
+        }
+
+        if (isTemp)
+        {
+            processMgr.unmapTempPage(page);
+        }
+        unpin(fileSystem, inode, entryIdx, residentAddr);
+
+        if (numCopied <= 0)
+        {
+            error = numCopied;
+            break;
+        }
+
+        numRead += numCopied;
+        if (static_cast<size_t>(numCopied) < num)
+        {
+            break;
+        }
+    }
+
+    // an error is only reported if nothing was transferred
+    return (numRead == 0) ? error : static_cast<ssize_t>(numRead);
+}
+
+void PageCache::invalidate(const FileSystem* fileSystem, uint32_t inode)
+{
+    int idx = lruHead;
+    while (idx != -1)
+    {
+        int next = entries[idx].lruNext;
+        if (entries[idx].fileSystem == fileSystem && entries[idx].inode == inode)
+        {
+            remove(idx);
+        }
+
+        idx = next;
+    }
+}
+
+size_t PageCache::reclaim(size_t numPages)
+{
+    size_t numFreed = 0;
+    while (numFreed < numPages)
+    {
+        int idx = findEvictable();
+        if (idx == -1)
+        {
+            break;
+        }
+
+        remove(idx);
+        ++numFreed;
+    }
+
+    return numFreed;
+}
+
+uint8_t* PageCache::getPage(FileSystem* fileSystem, uint32_t inode, size_t pageIdx, size_t numFilePages,
+                            size_t readAheadPages, bool& isTemp, int& entryIdx, uintptr_t& residentAddr)
+{
+    entryIdx = -1;
+    residentAddr = 0;
+
+    // use pages that are already in memory in place
+    uintptr_t physicalAddr = 0;
+    uintptr_t virtualAddr = 0;
+    if (fileSystem->getResidentPage(inode, pageIdx, physicalAddr, virtualAddr))
+    {
+        if (virtualAddr != 0)
+        {
+            isTemp = false;
+            residentAddr = physicalAddr;
+            return reinterpret_cast<uint8_t*>(virtualAddr);
+        }
+
+        uint8_t* page = processMgr.mapTempPage(physicalAddr);
+        if (page == nullptr)
+        {
+            fileSystem->releaseResidentPage(inode, physicalAddr);
+            return nullptr;
+        }
+
+        isTemp = true;
+        residentAddr = physicalAddr;
+        return page;
+    }
+
+    int idx = find(fileSystem, inode, pageIdx);
+    if (idx < 0)
+    {
+        size_t numPages = 1 + readAheadPages;
+        if (numPages > MAX_READ_AHEAD_PAGES)
+        {
+            numPages = MAX_READ_AHEAD_PAGES;
+        }
+        if (numPages > numFilePages - pageIdx)
+        {
+            numPages = numFilePages - pageIdx;
+        }
+
+        idx = fill(fileSystem, inode, pageIdx, numPages);
+        if (idx < 0)
+        {
+            return nullptr;
+        }
+    }
+
+    uint8_t* page = processMgr.mapTempPage(entries[idx].physicalAddr);
+    if (page == nullptr)
+    {
+        return nullptr;
+    }
+
+    touch(idx);
+    ++entries[idx].pinCount;
+
+    isTemp = true;
+    entryIdx = idx;
+    return page;
+}
+
+void PageCache::unpin(FileSystem* fileSystem, uint32_t inode, int idx, uintptr_t residentAddr)
+{
+    if (idx < 0)
+    {
+        fileSystem->releaseResidentPage(inode, residentAddr);
+        return;
+    }
+
+    Entry& entry = entries[idx];
+    --entry.pinCount;
+
+    if (entry.pinCount == 0 && entry.isRemoved)
+    {
+        release(idx);
+    }
+}
+
+int PageCache::fill(FileSystem* fileSystem, uint32_t inode, size_t pageIdx, size_t numPages)
+{
+    // allocate frames for a run of pages that are not cached, so the file
+    // system can read them with one request
+    uintptr_t frames[MAX_READ_AHEAD_PAGES];
+    size_t numFrames = 0;
+    while (numFrames < numPages)
+    {
+        if (numFrames > 0 && find(fileSystem, inode, pageIdx + numFrames) >= 0)
+        {
+            break;
+        }
+
+        uintptr_t frame = allocFrame();
+        if (frame == 0)
+        {
+            break;
+        }
+
+        frames[numFrames++] = frame;
+    }
+
+    if (numFrames == 0)
+    {
+        klog.logWarning(LOG_TAG, "Could not allocate a page frame");
+        return -1;
+    }
+
+    size_t numRead = fileSystem->readPages(inode, pageIdx, frames, numFrames);
+
+    int idx = -1;
+    for (size_t i = 0; i < numFrames; ++i)
+    {
+        if (i < numRead)
+        {
+            insert(fileSystem, inode, pageIdx + i, frames[i]);
+        }
+        else
+        {
+            pageFrameMgr->freePageFrame(frames[i]);
+        }
+    }
+
+    if (numRead > 0)
+    {
+        idx = find(fileSystem, inode, pageIdx);
+    }
+
+    return idx;
+}
+
+int PageCache::find(const FileSystem* fileSystem, uint32_t inode, size_t pageIdx) const
+{
+    int idx = buckets[hash(fileSystem, inode, pageIdx)];
+    while (idx != -1)
+    {
+        const Entry& entry = entries[idx];
+        if (entry.fileSystem == fileSystem && entry.inode == inode && entry.pageIdx == pageIdx)
+        {
+            return idx;
+        }
+
+        idx = entry.next;
+    }
+
+    return -1;
+}
+
+void PageCache::insert(const FileSystem* fileSystem, uint32_t inode, size_t pageIdx, uintptr_t physicalAddr)
+{
+    if (find(fileSystem, inode, pageIdx) >= 0)
+    {
+        pageFrameMgr->freePageFrame(physicalAddr);
+        return;
+    }
+
+    // evict the least recently used page if the cache is full; the page
+    // isn't cached if every page is in use
+    if (freeEntry == -1)
+    {
+        int evictIdx = findEvictable();
+        if (evictIdx == -1)
+        {
+            pageFrameMgr->freePageFrame(physicalAddr);
+            return;
+        }
+
+        remove(evictIdx);
+    }
+
+    int idx = freeEntry;
+    Entry& entry = entries[idx];
+    freeEntry = entry.next;
+
+    entry.fileSystem = fileSystem;
+    entry.inode = inode;
+    entry.pageIdx = pageIdx;
+    entry.physicalAddr = physicalAddr;
+    entry.pinCount = 0;
+    entry.isRemoved = false;
+
+    int bucket = hash(fileSystem, inode, pageIdx);
+    entry.next = buckets[bucket];
+    buckets[bucket] = idx;
+
+    lruPushFront(idx);
+}
+
+void PageCache::remove(int idx)
+{
+    Entry& entry = entries[idx];
+
+    // unlink from the hash bucket
+    int* link = &buckets[hash(entry.fileSystem, entry.inode, entry.pageIdx)];
+    while (*link != idx)
+    {
+        link = &entries[*link].next;
+    }
+    *link = entry.next;
+
+    lruUnlink(idx);
+
+    // the page is still being read, so it is freed when it is unpinned
+    if (entry.pinCount > 0)
+    {
+        entry.isRemoved = true;
+        return;
+    }
+
+    release(idx);
+}
+
+void PageCache::release(int idx)
+{
+    Entry& entry = entries[idx];
+
+    pageFrameMgr->freePageFrame(entry.physicalAddr);
+
+    entry.fileSystem = nullptr;
+    entry.isRemoved = false;
+    entry.next = freeEntry;
+    freeEntry = idx;
+}
+
+int PageCache::findEvictable() const
+{
+    int idx = lruTail;
+    while (idx != -1 && entries[idx].pinCount > 0)
+    {
+        idx = entries[idx].lruPrev;
+    }
+
+    return idx;
+}
+
+uintptr_t PageCache::allocFrame()
+{
+    if (pageFrameMgr == nullptr)
+    {
+        return 0;
+    }
+
+    // the page frame manager evicts cached pages if it runs out of frames
+    return pageFrameMgr->allocPageFrame();
+}
+
+void PageCache::touch(int idx)
+{
+    if (lruHead != idx)
+    {
+        lruUnlink(idx);
+        lruPushFront(idx);
+    }
+}
+
+void PageCache::lruUnlink(int idx)
+{
+    Entry& entry = entries[idx];
+
+    if (entry.lruPrev != -1)
+    {
+        entries[entry.lruPrev].lruNext = entry.lruNext;
+    }
+    else
+    {
+        lruHead = entry.lruNext;
+    }
+
+    if (entry.lruNext != -1)
+    {
+        entries[entry.lruNext].lruPrev = entry.lruPrev;
+    }
+    else
+    {
+        lruTail = entry.lruPrev;
+    }
+}
+
+void PageCache::lruPushFront(int idx)
+{
+    Entry& entry = entries[idx];
+
+    entry.lruPrev = -1;
+    entry.lruNext = lruHead;
+
+    if (lruHead != -1)
+    {
+        entries[lruHead].lruPrev = idx;
+    }
+    else
+    {
+        lruTail = idx;
+    }
+
+    lruHead = idx;
+}
+
+int PageCache::hash(const FileSystem* fileSystem, uint32_t inode, size_t pageIdx)
+{
+    uint32_t h = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fileSystem) >> 4);
+    h = h * 31 + inode;
+    h = h * 31 + static_cast<uint32_t>(pageIdx);
+
+    return static_cast<int>(h % NUM_BUCKETS);
+}
+
+// create PageCache instance
+PageCache pageCache;
@@ -0,0 +1,201 @@
+/**
+ * @brief Page cache
+ */
+
+#ifndef PAGE_CACHE_H_
+#define PAGE_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+class FileSystem;
+class PageFrameMgr;
+class Stream;
+
+/**
+ * @brief Caches pages of files in memory.
+ * @details File streams read through the cache. Pages of files that are
+ * already in memory (see FileSystem::getResidentPage()) are used in place.
+ * Other pages are read from the file system into page frames, which are
+ * reused in least recently used order when the cache is full or page
+ * frames run out. A page is pinned while it is being copied or written to
+ * a stream, which may block, so it can't be evicted and reused meanwhile;
+ * file systems pin their resident pages until they are released.
+ */
+class PageCache
+{
+public:
+    /**
+     * @brief A stream's read-ahead state.
+     * @details The read-ahead window doubles while a stream is read
+     * sequentially and shrinks back when it seeks.
+     */
+    struct ReadAhead
+    {
+        /// the page after the last page read
+        size_t nextPageIdx;
+
+        /// number of pages to read ahead
+        size_t numPages;
+
+        void reset();
+    };
+
+    /// The tag used in the kernel log
+    static const char* LOG_TAG;
+
+    PageCache();
+
+    void setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr);
+
+    /**
+     * @brief Read from a file.
+     * @param fileSystem The file system the file is in.
+     * @param inode The file's inode number.
+     * @param fileSize The size of the file in bytes.
+     * @param position The offset to read from.
+     * @param buff The buffer to read into.
+     * @param nbyte The number of bytes to read.
+     * @param readAhead The read-ahead state of the stream reading the file.
+     * @return The number of bytes read, or a number less than 0 if an error occurred.
+     */
+    ssize_t read(FileSystem* fileSystem, uint32_t inode, size_t fileSize, size_t position,
+                 uint8_t* buff, size_t nbyte, ReadAhead& readAhead);
+
+    /**
+     * @brief Write part of a file to a stream straight from the cached pages.
+     * @param outStream The stream to write to.
+     * @see read()
+     * @return The number of bytes written, or a number less than 0 if an error occurred.
+     */
+    ssize_t send(FileSystem* fileSystem, uint32_t inode, size_t fileSize, size_t position,
+                 Stream* outStream, size_t nbyte, ReadAhead& readAhead);
+
+    /**
+     * @brief Remove a file's pages from the cache.
+     * @details File systems call this when a file's data changes.
+     */
+    void invalidate(const FileSystem* fileSystem, uint32_t inode);
+
+    /**
+     * @brief Free the least recently used pages.
+     * @param numPages The number of pages to free.
+     * @return The number of pages freed.
+     */
+    size_t reclaim(size_t numPages);
+
+private:
+    constexpr static int MAX_NUM_PAGES = 256;
+    constexpr static int NUM_BUCKETS = 64;
+    constexpr static size_t MAX_READ_AHEAD_PAGES = 32;
+
+    struct Entry
+    {
+        const FileSystem* fileSystem;
+        uint32_t inode;
+        size_t pageIdx;
+        uintptr_t physicalAddr;
+
+        /// the number of users of the page; pinned pages are not evicted
+        int pinCount;
+
+        /// whether the entry was removed while it was pinned; it is freed
+        /// when it is unpinned
+        bool isRemoved;
+
+        /// next entry in the hash bucket or free list
+        int next;
+
+        /// previous and next entries in the LRU list
+        int lruPrev;
+        int lruNext;
+    };
+
+    Entry entries[MAX_NUM_PAGES];
+
+    /// first entry in each hash bucket
+    int buckets[NUM_BUCKETS];
+
+    /// first unused entry
+    int freeEntry;
+
+    /// most and least recently used entries
+    int lruHead;
+    int lruTail;
+
+    PageFrameMgr* pageFrameMgr;
+
+    /**
+     * @brief Copy part of a file to a buffer or write it to a stream.
+     * @param buff The buffer to copy to, or nullptr to write to outStream.
+     * @param outStream The stream to write to if buff is nullptr.
+     */
+    ssize_t transfer(FileSystem* fileSystem, uint32_t inode, size_t fileSize, size_t position,
+                     uint8_t* buff, Stream* outStream, size_t nbyte, ReadAhead& readAhead);
+
+    /**
+     * @brief Get a mapping of one of a file's pages, reading it if needed.
+     * @param [out] isTemp Whether the page was temporarily mapped.
+     * @param [out] entryIdx The pinned entry of a cached page, or -1 if
+     * the page is resident in the file system.
+     * @param [out] residentAddr The physical address of a page that is
+     * resident in the file system, which is pinned by the file system; 0,
+     * otherwise.
+     * @return The page's virtual address, or nullptr on an error.
+     */
+    uint8_t* getPage(FileSystem* fileSystem, uint32_t inode, size_t pageIdx, size_t numFilePages,
+                     size_t readAheadPages, bool& isTemp, int& entryIdx, uintptr_t& residentAddr);
+
+    /**
+     * @brief Release a page pinned by getPage().
+     */
+    void unpin(FileSystem* fileSystem, uint32_t inode, int idx, uintptr_t residentAddr);
+
+    /**
+     * @brief Read a run of pages that are not in the cache.
+     * @return The index of the first page's entry, or -1 if it could not be read.
+     */
+    int fill(FileSystem* fileSystem, uint32_t inode, size_t pageIdx, size_t numPages);
+
+    int find(const FileSystem* fileSystem, uint32_t inode, size_t pageIdx) const;
+
+    void insert(const FileSystem* fileSystem, uint32_t inode, size_t pageIdx, uintptr_t physicalAddr);
+
+    /**
+     * @brief Remove an entry from the cache. A pinned entry's frame is
+     * freed once it is unpinned.
+     */
+    void remove(int idx);
+
+    /**
+     * @brief Free an entry's page frame and return it to the free list.
+     */
+    void release(int idx);
+
+    /**
+     * @brief Get the least recently used entry that isn't pinned.
+     * @return The entry's index, or -1 if every entry is pinned.
+     */
+    int findEvictable() const;
+
+    /**
+     * @brief Allocate a page frame, evicting pages if needed.
+     */
+    uintptr_t allocFrame();
+
+    /**
+     * @brief Mark an entry as the most recently used.
+     */
+    void touch(int idx);
+
+    void lruUnlink(int idx);
+
+    void lruPushFront(int idx);
+
+    static int hash(const FileSystem* fileSystem, uint32_t inode, size_t pageIdx);
+};
+
+extern PageCache pageCache;
+
+#endif // PAGE_CACHE_H_
@@ -11,7 +11,8 @@
 
 typedef unsigned int uint;
 
-PageFrameMgr::PageFrameMgr(const multiboot_info* mbootInfo)
+PageFrameMgr::PageFrameMgr(const multiboot_info* mbootInfo) :
+    reclaimHandler(nullptr)
 {
     constexpr unsigned int MAX_MEM_BLOCKS = 32;
     MemBlock memBlocks[MAX_MEM_BLOCKS];
@@ -275,6 +276,37 @@ unsigned int PageFrameMgr::getIsAllocSize(const PageFrameBlock& pfBlock) const
 }
 
 uintptr_t PageFrameMgr::allocPageFrame()
+{
+    uintptr_t addr = findFreePageFrame();
+
+    // try to get a page frame back from whoever is holding on to them
+    if (addr == 0 && reclaimHandler != nullptr && reclaimHandler(1) > 0)
+    {
+        addr = findFreePageFrame();
+    }
+
+    return addr;
+}
+
+uintptr_t PageFrameMgr::allocContiguousPageFrames(size_t numPages)
+{
+    uintptr_t addr = findFreePageFrames(numPages);
+
+    // reclaimed page frames may not be contiguous, but it's worth a try
+    if (addr == 0 && reclaimHandler != nullptr && reclaimHandler(numPages) > 0)
+    {
+        addr = findFreePageFrames(numPages);
+    }
+
+    return addr;
+}
+
+void PageFrameMgr::setReclaimHandler(size_t (*handler)(size_t numPages))
+{
+    reclaimHandler = handler;
+}
+
+uintptr_t PageFrameMgr::findFreePageFrame()
 {
     for (unsigned int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
     {
@@ -303,6 +335,50 @@ uintptr_t PageFrameMgr::allocPageFrame()
     return 0;
 }
 
+uintptr_t PageFrameMgr::findFreePageFrames(size_t numPages)
+{
+    constexpr uint BITS_PER_FIELD = sizeof(uint32_t) * 8;
+
+    if (numPages == 0)
+    {
+        return 0;
+    }
+
+    for (unsigned int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+    {
+        const uint32_t* isAlloc = blocks[blockIdx].isAlloc;
+
+        uint runStart = 0;
+        size_t runLength = 0;
+        for (uint pageIdx = 0; pageIdx < blocks[blockIdx].numPages; ++pageIdx)
+        {
+            if ( (isAlloc[pageIdx / BITS_PER_FIELD] & (1u << (pageIdx % BITS_PER_FIELD))) != 0 )
+            {
+                runLength = 0;
+                continue;
+            }
+
+            if (runLength == 0)
+            {
+                runStart = pageIdx;
+            }
+
+            if (++runLength == numPages)
+            {
+                // mark the run allocated
+                for (uint i = runStart; i <= pageIdx; ++i)
+                {
+                    blocks[blockIdx].isAlloc[i / BITS_PER_FIELD] |= 1u << (i % BITS_PER_FIELD);
+                }
+
+                return blocks[blockIdx].startAddr + runStart * PAGE_SIZE;
+            }
+        }
+    }
+
+    return 0;
+}
+
 void PageFrameMgr::freePageFrame(uintptr_t addr)
 {
     unsigned int blockIdx = 0;
@@ -26,11 +26,28 @@ public:
      */
     uintptr_t allocPageFrame();
 
+    /**
+     * @brief Allocate physically contiguous page frames (e.g. for a device
+     * that accesses memory with DMA)
+     * @param numPages the number of page frames
+     * @return the physical address of the first page frame or zero if no
+     * memory could be allocated
+     */
+    uintptr_t allocContiguousPageFrames(size_t numPages);
+
     /**
      * @brief Free a page frame
      */
     void freePageFrame(uintptr_t addr);
 
+    /**
+     * @brief Set a function that frees page frames when none are free
+     * (e.g. by evicting cached pages).
+     * @details The function is given the number of page frames needed and
+     * returns the number it freed.
+     */
+    void setReclaimHandler(size_t (*handler)(size_t numPages));
+
     // ------ Debugging ------
 
     bool isPageFrameAlloc(uintptr_t addr) const;
@@ -64,6 +81,19 @@ private:
     PageFrameBlock* blocks;
     unsigned int numBlocks;
 
+    /// frees page frames when none are free
+    size_t (*reclaimHandler)(size_t numPages);
+
+    /**
+     * @brief Find a free page frame and mark it allocated.
+     */
+    uintptr_t findFreePageFrame();
+
+    /**
+     * @brief Find a run of free page frames and mark them allocated.
+     */
+    uintptr_t findFreePageFrames(size_t numPages);
+
     void initMemBlocks(const multiboot_info* mbootInfo, MemBlock* memBlocks, unsigned int memBlocksSize, unsigned int& numMemBlocks);
 
     /**
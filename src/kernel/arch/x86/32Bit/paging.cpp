@@ -1,5 +1,6 @@
 #include <stdio.h>
 
+#include "cpu.h"
 #include "kernellogger.h"
 #include "multiboot.h"
 #include "paging.h"
@@ -72,7 +73,7 @@ void mapPageTable(uint32_t* pageDir, uint32_t pageTableAddr, int pageDirIdx, boo
     pageDir[pageDirIdx] = pageDirEntry;
 }
 
-void mapPage(uint32_t* pageTable, uint32_t virtualAddr, uint32_t physicalAddr, bool user)
+void mapPage(uint32_t* pageTable, uint32_t virtualAddr, uint32_t physicalAddr, bool user, bool writable)
 {
     // calculate the page table index
     int pageTableIdx = (virtualAddr >> 12) & PAGE_TABLE_INDEX_MASK;
@@ -88,6 +89,10 @@ void mapPage(uint32_t* pageTable, uint32_t virtualAddr, uint32_t physicalAddr, b
     {
         pageTableEntry |= PAGE_TABLE_USER; // set user privilege
     }
+    if (!writable)
+    {
+        pageTableEntry &= ~PAGE_TABLE_READ_WRITE; // clear read/write bit
+    }
     pageTable[pageTableIdx] = pageTableEntry;
 }
 
@@ -115,6 +120,34 @@ bool mapPage(int pageDirIdx, uint32_t* pageTable, uint32_t& virtualAddr, uint32_
     return false;
 }
 
+bool mapPages(int pageDirIdx, uint32_t* pageTable, uint32_t& virtualAddr, uint32_t physicalAddr, size_t numPages)
+{
+    size_t runLength = 0;
+    for (int idx = 0; idx < PAGE_TABLE_NUM_ENTRIES; ++idx)
+    {
+        if ( (pageTable[idx] & PAGE_TABLE_PRESENT) != 0 )
+        {
+            runLength = 0;
+            continue;
+        }
+
+        if (++runLength == numPages)
+        {
+            int startIdx = idx - static_cast<int>(numPages) + 1;
+            virtualAddr = (pageDirIdx << 22) | (startIdx << 12);
+
+            for (size_t i = 0; i < numPages; ++i)
+            {
+                mapPage(pageTable, virtualAddr + i * PAGE_SIZE, physicalAddr + i * PAGE_SIZE);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void unmapPage(uint32_t* pageTable, uint32_t virtualAddr)
 {
     // calculate the page table index
@@ -123,8 +156,9 @@ void unmapPage(uint32_t* pageTable, uint32_t virtualAddr)
     // clear the page table entry
     pageTable[pageTableIdx] = 0;
 
-    // invalidate page in TLB
-    invalidatePage(virtualAddr);
+    // invalidate page in TLB, including the other processors' TLBs if they
+    // use the same page table
+    Cpu::invalidatePage(virtualAddr);
 }
 
 void mapModules(const multiboot_info* mbootInfo)
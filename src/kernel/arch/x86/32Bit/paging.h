@@ -1,6 +1,7 @@
 #ifndef PAGING_H_
 #define PAGING_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "isr.h"
@@ -78,6 +79,12 @@ bool isPagingEnabled();
  */
 void setPageDirectory(uint32_t pageDirAddr);
 
+/**
+ * @brief Gets the page directory.
+ * @return the physical address of the current page directory
+ */
+uint32_t getPageDirectory();
+
 /**
  * @brief Invalidate TLB for the given address.
  */
@@ -97,7 +104,7 @@ void mapPageTable(uint32_t* pageDir, uint32_t pageTable, int pageDirIdx, bool us
 /**
  * @brief Map a page in a page table.
  */
-void mapPage(uint32_t* pageTable, uint32_t virtualAddr, uint32_t physicalAddr, bool user = false);
+void mapPage(uint32_t* pageTable, uint32_t virtualAddr, uint32_t physicalAddr, bool user = false, bool writable = true);
 
 /**
  * @brief Map a page in the first available page table entry and return the virtual address.
@@ -105,7 +112,14 @@ void mapPage(uint32_t* pageTable, uint32_t virtualAddr, uint32_t physicalAddr, b
 bool mapPage(int pageDirIdx, uint32_t* pageTable, uint32_t& virtualAddr, uint32_t physicalAddr, bool user = false);
 
 /**
- * @brief Unmap a page from a page table.
+ * @brief Map physically contiguous pages in the first run of available page
+ * table entries and return the virtual address of the first page.
+ */
+bool mapPages(int pageDirIdx, uint32_t* pageTable, uint32_t& virtualAddr, uint32_t physicalAddr, size_t numPages);
+
+/**
+ * @brief Unmap a page from a page table in the active page directory, and
+ * invalidate it in the TLBs of all processors that use the page directory.
  */
 void unmapPage(uint32_t* pageTable, uint32_t virtualAddr);
 
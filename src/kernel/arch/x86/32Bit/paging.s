@@ -152,6 +152,15 @@ setPageDirectory:
 
 	ret
 
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; gets the page directory
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+global getPageDirectory
+getPageDirectory:
+	mov eax, cr3
+
+	ret
+
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ; invalidate TLB for given address
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -0,0 +1,452 @@
+/**
+ * @brief PCI bus
+ */
+
+#include "apic.h"
+#include "kernellogger.h"
+#include "pci.h"
+#include "system.h"
+
+namespace
+{
+
+constexpr static uint16_t CONFIG_ADDRESS_PORT = 0xCF8;
+constexpr static uint16_t CONFIG_DATA_PORT = 0xCFC;
+
+constexpr static uint32_t CONFIG_ENABLE = 0x8000'0000;
+
+constexpr static uint8_t HEADER_TYPE_MULTI_FUNCTION = 0x80;
+constexpr static uint8_t HEADER_TYPE_MASK = 0x7F;
+constexpr static uint8_t HEADER_TYPE_GENERAL = 0x00;
+constexpr static uint8_t HEADER_TYPE_BRIDGE = 0x01;
+
+/// the number of BARs in a PCI-to-PCI bridge's header
+constexpr static int NUM_BRIDGE_BARS = 2;
+
+constexpr static uint32_t BAR_IO_SPACE = 0x1;
+constexpr static uint32_t BAR_IO_MASK = 0xFFFF'FFFC;
+constexpr static uint32_t BAR_MEMORY_MASK = 0xFFFF'FFF0;
+constexpr static uint32_t BAR_TYPE_MASK = 0x6;
+constexpr static uint32_t BAR_TYPE_64_BIT = 0x4;
+
+/// capability lists are in the device-specific part of configuration space
+constexpr static uint8_t MIN_CAPABILITY_OFFSET = 0x40;
+
+/// bounds the walk of a capability list, in case it has a loop
+constexpr static int MAX_NUM_CAPABILITIES = 48;
+
+/**
+ * @brief Select a 32-bit configuration register.
+ */
+void selectConfig(const PciBus::Address& address, uint8_t offset)
+{
+    uint32_t configAddr = CONFIG_ENABLE
+                          | (static_cast<uint32_t>(address.bus) << 16)
+                          | (static_cast<uint32_t>(address.device) << 11)
+                          | (static_cast<uint32_t>(address.function) << 8)
+                          | (offset & 0xFC);
+
+    outl(CONFIG_ADDRESS_PORT, configAddr);
+}
+
+/**
+ * @brief Get a byte from a copy of configuration space.
+ */
+uint8_t getConfig8(const uint32_t* config, uint8_t offset)
+{
+    return (config[offset / 4] >> ((offset & 3) * 8)) & 0xFF;
+}
+
+/**
+ * @brief Get a key that sorts addresses by bus, device, then function.
+ */
+uint32_t getSortKey(const PciBus::Address& address)
+{
+    return (static_cast<uint32_t>(address.bus) << 16) | (static_cast<uint32_t>(address.device) << 8) | address.function;
+}
+
+} // namespace
+
+const char* PciBus::LOG_TAG = "PCI";
+
+uint32_t PciBus::readConfig32(const Address& address, uint8_t offset) const
+{
+    selectConfig(address, offset);
+    return inl(CONFIG_DATA_PORT);
+}
+
+uint16_t PciBus::readConfig16(const Address& address, uint8_t offset) const
+{
+    return (readConfig32(address, offset) >> ((offset & 2) * 8)) & 0xFFFF;
+}
+
+uint8_t PciBus::readConfig8(const Address& address, uint8_t offset) const
+{
+    return (readConfig32(address, offset) >> ((offset & 3) * 8)) & 0xFF;
+}
+
+void PciBus::writeConfig32(const Address& address, uint8_t offset, uint32_t value) const
+{
+    selectConfig(address, offset);
+    outl(CONFIG_DATA_PORT, value);
+}
+
+void PciBus::writeConfig16(const Address& address, uint8_t offset, uint16_t value) const
+{
+    selectConfig(address, offset);
+    outw(CONFIG_DATA_PORT + (offset & 2), value);
+}
+
+void PciBus::scan()
+{
+    numFunctions = 0;
+
+    // a multi-function host bridge means there are several host
+    // controllers, and function n is the controller for bus n
+    Address hostBridge = {0, 0, 0};
+    if ((readConfig8(hostBridge, CONFIG_HEADER_TYPE) & HEADER_TYPE_MULTI_FUNCTION) == 0)
+    {
+        scanBus(0);
+    }
+    else
+    {
+        for (uint8_t function = 0; function < MAX_NUM_FUNCTIONS; ++function)
+        {
+            hostBridge.function = function;
+            if (readConfig16(hostBridge, CONFIG_VENDOR_ID) != 0xFFFF)
+            {
+                scanBus(function);
+            }
+        }
+    }
+
+    // bridges are followed as they are found, so the buses behind them
+    // are out of order
+    for (size_t i = 1; i < numFunctions; ++i)
+    {
+        Function function = functions[i];
+        size_t j = i;
+        while (j > 0 && getSortKey(functions[j - 1].address) > getSortKey(function.address))
+        {
+            functions[j] = functions[j - 1];
+            --j;
+        }
+        functions[j] = function;
+    }
+
+    for (size_t i = 0; i < numFunctions; ++i)
+    {
+        const Function& function = functions[i];
+        klog.logInfo(LOG_TAG, "{}:{}.{} {x0>4}:{x0>4} class {x0>2}:{x0>2}{}",
+                     function.address.bus, function.address.device, function.address.function,
+                     function.getVendorId(), function.getDeviceId(), function.getClass(), function.getSubclass(),
+                     (function.msiOffset != 0) ? " MSI" : "");
+    }
+
+    for (size_t i = 0; i < numFunctions; ++i)
+    {
+        for (size_t j = 0; j < numDrivers; ++j)
+        {
+            probe(functions[i], drivers[j]);
+        }
+    }
+}
+
+size_t PciBus::getNumFunctions() const
+{
+    return numFunctions;
+}
+
+const PciBus::Function& PciBus::getFunction(size_t idx) const
+{
+    return functions[idx];
+}
+
+bool PciBus::registerDriver(PciDriver* driver)
+{
+    if (numDrivers >= MAX_NUM_DRIVERS)
+    {
+        return false;
+    }
+
+    drivers[numDrivers++] = driver;
+
+    for (size_t i = 0; i < numFunctions; ++i)
+    {
+        probe(functions[i], driver);
+    }
+
+    return true;
+}
+
+uint32_t PciBus::getBar(const Address& address, int barIdx) const
+{
+    return readConfig32(address, CONFIG_BAR0 + barIdx * 4);
+}
+
+bool PciBus::findByClass(uint8_t classCode, uint8_t subclass, Address& address) const
+{
+    // the class code and subclass are the upper 16 bits of the register
+    // at offset 0x08
+    uint32_t value = (static_cast<uint32_t>(classCode) << 24) | (static_cast<uint32_t>(subclass) << 16);
+    return find(0x08, 0xFFFF'0000, value, address);
+}
+
+bool PciBus::findById(uint16_t vendorId, uint16_t deviceId, Address& address) const
+{
+    uint32_t value = (static_cast<uint32_t>(deviceId) << 16) | vendorId;
+    return find(CONFIG_VENDOR_ID, 0xFFFF'FFFF, value, address);
+}
+
+void PciBus::enable(const Address& address, uint16_t commandBits) const
+{
+    uint16_t command = readConfig16(address, CONFIG_COMMAND);
+    writeConfig16(address, CONFIG_COMMAND, command | commandBits);
+}
+
+bool PciBus::enableMsi(const Function& function, uint8_t& irq)
+{
+    if (function.msiOffset == 0 || !Apic::isEnabled() || nextMsiIrq >= IRQ_MSI_START + NUM_MSI_IRQS)
+    {
+        return false;
+    }
+
+    irq = nextMsiIrq++;
+    uint8_t vector = IRQ_START_NUM + irq;
+
+    // the message is a write to this processor's local APIC; the data is
+    // the vector (fixed delivery, edge triggered)
+    const Address& address = function.address;
+    uint8_t capability = function.msiOffset;
+    uint16_t control = readConfig16(address, capability + MSI_CONTROL);
+    writeConfig32(address, capability + MSI_ADDRESS, MSI_ADDRESS_BASE | (static_cast<uint32_t>(Apic::getLocalApicId()) << 12));
+    if ((control & MSI_CONTROL_64_BIT) != 0)
+    {
+        writeConfig32(address, capability + MSI_ADDRESS + 4, 0);
+        writeConfig16(address, capability + MSI_DATA_64, vector);
+    }
+    else
+    {
+        writeConfig16(address, capability + MSI_DATA_32, vector);
+    }
+
+    // use a single message
+    control = (control & ~MSI_CONTROL_MULTIPLE_ENABLE) | MSI_CONTROL_ENABLE;
+    writeConfig16(address, capability + MSI_CONTROL, control);
+
+    enable(address, COMMAND_INTX_DISABLE);
+
+    return true;
+}
+
+void PciBus::scanBus(uint8_t bus)
+{
+    for (uint8_t device = 0; device < MAX_NUM_DEVICES; ++device)
+    {
+        // no function 0 means no device
+        Address address = {bus, device, 0};
+        if (readConfig16(address, CONFIG_VENDOR_ID) == 0xFFFF)
+        {
+            continue;
+        }
+
+        addFunction(address);
+
+        // only multi-function devices have functions other than 0
+        if ((readConfig8(address, CONFIG_HEADER_TYPE) & HEADER_TYPE_MULTI_FUNCTION) == 0)
+        {
+            continue;
+        }
+
+        for (address.function = 1; address.function < MAX_NUM_FUNCTIONS; ++address.function)
+        {
+            if (readConfig16(address, CONFIG_VENDOR_ID) != 0xFFFF)
+            {
+                addFunction(address);
+            }
+        }
+    }
+}
+
+void PciBus::addFunction(const Address& address)
+{
+    if (numFunctions >= MAX_NUM_CACHED_FUNCTIONS)
+    {
+        klog.logWarning(LOG_TAG, "Too many functions; ignoring {}:{}.{}", address.bus, address.device, address.function);
+        return;
+    }
+
+    // the capability list is walked in a copy of configuration space
+    uint32_t config[CONFIG_SPACE_SIZE / 4];
+    for (size_t i = 0; i < CONFIG_SPACE_SIZE / 4; ++i)
+    {
+        config[i] = readConfig32(address, i * 4);
+    }
+
+    Function& function = functions[numFunctions++];
+    function.address = address;
+    for (uint8_t i = 0; i < CONFIG_HEADER_SIZE / 4; ++i)
+    {
+        function.header[i] = config[i];
+    }
+    function.msiOffset = findCapability(config, CAPABILITY_MSI);
+    function.driver = nullptr;
+
+    sizeBars(function);
+
+    // follow bridges to the buses behind them
+    uint8_t headerType = function.getConfig8(CONFIG_HEADER_TYPE) & HEADER_TYPE_MASK;
+    if (headerType == HEADER_TYPE_BRIDGE)
+    {
+        uint8_t secondaryBus = function.getConfig8(CONFIG_SECONDARY_BUS);
+        if (secondaryBus > address.bus)
+        {
+            scanBus(secondaryBus);
+        }
+    }
+}
+
+void PciBus::sizeBars(Function& function) const
+{
+    for (int i = 0; i < NUM_BARS; ++i)
+    {
+        function.barSizes[i] = 0;
+    }
+
+    uint8_t headerType = function.getConfig8(CONFIG_HEADER_TYPE) & HEADER_TYPE_MASK;
+    int numBars = (headerType == HEADER_TYPE_GENERAL) ? NUM_BARS : (headerType == HEADER_TYPE_BRIDGE) ? NUM_BRIDGE_BARS : 0;
+    if (numBars == 0)
+    {
+        return;
+    }
+
+    // turn decoding off while the BARs hold all ones, so the function
+    // doesn't respond at a bogus address, and don't let anything use the
+    // device in the meantime
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    const Address& address = function.address;
+    uint16_t command = readConfig16(address, CONFIG_COMMAND);
+    writeConfig16(address, CONFIG_COMMAND, command & ~(COMMAND_IO_SPACE | COMMAND_MEMORY_SPACE));
+
+    for (int i = 0; i < numBars; ++i)
+    {
+        uint8_t offset = CONFIG_BAR0 + i * 4;
+        uint32_t bar = function.getBar(i);
+
+        // the writable bits give the size
+        writeConfig32(address, offset, 0xFFFF'FFFF);
+        uint32_t sizeMask = readConfig32(address, offset);
+        writeConfig32(address, offset, bar);
+
+        if ((bar & BAR_IO_SPACE) != 0)
+        {
+            // the upper 16 bits of I/O BARs may be hardwired to 0
+            sizeMask &= BAR_IO_MASK;
+            if (sizeMask != 0)
+            {
+                function.barSizes[i] = ~(sizeMask | 0xFFFF'0000) + 1;
+            }
+        }
+        else if ((bar & BAR_TYPE_MASK) == BAR_TYPE_64_BIT && i + 1 < numBars)
+        {
+            // the next BAR is the upper half of the address
+            uint8_t upperOffset = offset + 4;
+            uint32_t upperBar = function.getBar(i + 1);
+            writeConfig32(address, upperOffset, 0xFFFF'FFFF);
+            uint32_t upperSizeMask = readConfig32(address, upperOffset);
+            writeConfig32(address, upperOffset, upperBar);
+
+            uint64_t sizeMask64 = (static_cast<uint64_t>(upperSizeMask) << 32) | (sizeMask & BAR_MEMORY_MASK);
+            if (sizeMask64 != 0)
+            {
+                function.barSizes[i] = ~sizeMask64 + 1;
+            }
+            ++i;
+        }
+        else
+        {
+            sizeMask &= BAR_MEMORY_MASK;
+            if (sizeMask != 0)
+            {
+                function.barSizes[i] = static_cast<uint32_t>(~sizeMask + 1);
+            }
+        }
+    }
+
+    writeConfig16(address, CONFIG_COMMAND, command);
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+}
+
+uint8_t PciBus::findCapability(const uint32_t* config, uint8_t capabilityId)
+{
+    // the status register's capabilities bit is in its low byte
+    if ((getConfig8(config, CONFIG_STATUS) & STATUS_CAPABILITIES) == 0)
+    {
+        return 0;
+    }
+
+    uint8_t offset = getConfig8(config, CONFIG_CAPABILITIES) & 0xFC;
+    for (int i = 0; i < MAX_NUM_CAPABILITIES && offset >= MIN_CAPABILITY_OFFSET; ++i)
+    {
+        if (getConfig8(config, offset) == capabilityId)
+        {
+            return offset;
+        }
+
+        // the next pointer follows the ID
+        offset = getConfig8(config, offset + 1) & 0xFC;
+    }
+
+    return 0;
+}
+
+void PciBus::probe(Function& function, PciDriver* driver)
+{
+    if (function.driver != nullptr)
+    {
+        return;
+    }
+
+    size_t numIds = 0;
+    const PciDriver::DeviceId* ids = driver->getDeviceIds(numIds);
+    for (size_t i = 0; i < numIds; ++i)
+    {
+        bool vendorMatches = (ids[i].vendorId == ANY_ID || ids[i].vendorId == function.getVendorId());
+        bool deviceMatches = (ids[i].deviceId == ANY_ID || ids[i].deviceId == function.getDeviceId());
+        if (vendorMatches && deviceMatches)
+        {
+            if (driver->probe(function))
+            {
+                function.driver = driver;
+                klog.logInfo(LOG_TAG, "{}:{}.{} is driven by {}", function.address.bus, function.address.device,
+                             function.address.function, driver->getName());
+            }
+            return;
+        }
+    }
+}
+
+bool PciBus::find(uint8_t offset, uint32_t mask, uint32_t value, Address& address) const
+{
+    uint32_t startKey = getSortKey(address);
+    for (size_t i = 0; i < numFunctions; ++i)
+    {
+        const Function& function = functions[i];
+        if (getSortKey(function.address) >= startKey && (function.header[offset / 4] & mask) == value)
+        {
+            address = function.address;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// create PciBus instance
+PciBus pciBus;
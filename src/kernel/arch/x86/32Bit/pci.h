@@ -0,0 +1,327 @@
+/**
+ * @brief PCI bus
+ */
+
+#ifndef PCI_H_
+#define PCI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "irq.h"
+
+class PciDriver;
+
+/**
+ * @brief Accesses PCI configuration space with configuration mechanism #1.
+ * @details scan() enumerates the functions on the bus once and caches
+ * their configuration headers, so drivers can find their devices without
+ * configuration space accesses. Drivers registered with registerDriver()
+ * are given the functions that match their IDs.
+ */
+class PciBus
+{
+public:
+    /// The tag used in the kernel log
+    static const char* LOG_TAG;
+
+    constexpr static unsigned int MAX_NUM_BUSES = 256;
+    constexpr static uint8_t MAX_NUM_DEVICES = 32;
+    constexpr static uint8_t MAX_NUM_FUNCTIONS = 8;
+
+    /// maximum number of functions scan() caches
+    constexpr static size_t MAX_NUM_CACHED_FUNCTIONS = 64;
+
+    /// maximum number of registered drivers
+    constexpr static size_t MAX_NUM_DRIVERS = 8;
+
+    /// the number of BARs in a general device's header
+    constexpr static int NUM_BARS = 6;
+
+    /// matches any vendor or device ID
+    constexpr static uint16_t ANY_ID = 0xFFFF;
+
+    // configuration space offsets
+    constexpr static uint8_t CONFIG_VENDOR_ID = 0x00;
+    constexpr static uint8_t CONFIG_DEVICE_ID = 0x02;
+    constexpr static uint8_t CONFIG_COMMAND = 0x04;
+    constexpr static uint8_t CONFIG_STATUS = 0x06;
+    constexpr static uint8_t CONFIG_PROG_IF = 0x09;
+    constexpr static uint8_t CONFIG_SUBCLASS = 0x0A;
+    constexpr static uint8_t CONFIG_CLASS = 0x0B;
+    constexpr static uint8_t CONFIG_HEADER_TYPE = 0x0E;
+    constexpr static uint8_t CONFIG_BAR0 = 0x10;
+    constexpr static uint8_t CONFIG_SECONDARY_BUS = 0x19;
+    constexpr static uint8_t CONFIG_CAPABILITIES = 0x34;
+    constexpr static uint8_t CONFIG_INTERRUPT_LINE = 0x3C;
+
+    /// the size of the standard configuration header
+    constexpr static uint8_t CONFIG_HEADER_SIZE = 0x40;
+
+    /// the size of the configuration space
+    constexpr static size_t CONFIG_SPACE_SIZE = 0x100;
+
+    // command register bits
+    constexpr static uint16_t COMMAND_IO_SPACE = 0x0001;
+    constexpr static uint16_t COMMAND_MEMORY_SPACE = 0x0002;
+    constexpr static uint16_t COMMAND_BUS_MASTER = 0x0004;
+    constexpr static uint16_t COMMAND_INTX_DISABLE = 0x0400;
+
+    // status register bits
+    constexpr static uint16_t STATUS_CAPABILITIES = 0x0010;
+
+    /**
+     * @brief The location of a function on the bus.
+     */
+    struct Address
+    {
+        uint8_t bus;
+        uint8_t device;
+        uint8_t function;
+    };
+
+    /**
+     * @brief A function found by scan().
+     */
+    struct Function
+    {
+        Address address;
+
+        /// a copy of the configuration header
+        uint32_t header[CONFIG_HEADER_SIZE / 4];
+
+        /// the size of the region each BAR decodes, or 0 if the BAR is not
+        /// used (or is the upper half of a 64-bit BAR)
+        uint64_t barSizes[NUM_BARS];
+
+        /// the offset of the MSI capability, or 0 if there is none
+        uint8_t msiOffset;
+
+        /// the driver that claimed the function, or nullptr
+        PciDriver* driver;
+
+        uint8_t getConfig8(uint8_t offset) const
+        {
+            return (header[offset / 4] >> ((offset & 3) * 8)) & 0xFF;
+        }
+
+        uint16_t getConfig16(uint8_t offset) const
+        {
+            return (header[offset / 4] >> ((offset & 2) * 8)) & 0xFFFF;
+        }
+
+        uint16_t getVendorId() const
+        {
+            return getConfig16(CONFIG_VENDOR_ID);
+        }
+
+        uint16_t getDeviceId() const
+        {
+            return getConfig16(CONFIG_DEVICE_ID);
+        }
+
+        uint8_t getClass() const
+        {
+            return getConfig8(CONFIG_CLASS);
+        }
+
+        uint8_t getSubclass() const
+        {
+            return getConfig8(CONFIG_SUBCLASS);
+        }
+
+        uint8_t getInterruptLine() const
+        {
+            return getConfig8(CONFIG_INTERRUPT_LINE);
+        }
+
+        /**
+         * @brief Get a base address register's value when the bus was
+         * scanned.
+         * @param barIdx The index of the BAR (0-5).
+         */
+        uint32_t getBar(int barIdx) const
+        {
+            return header[CONFIG_BAR0 / 4 + barIdx];
+        }
+    };
+
+    uint32_t readConfig32(const Address& address, uint8_t offset) const;
+
+    uint16_t readConfig16(const Address& address, uint8_t offset) const;
+
+    uint8_t readConfig8(const Address& address, uint8_t offset) const;
+
+    void writeConfig32(const Address& address, uint8_t offset, uint32_t value) const;
+
+    void writeConfig16(const Address& address, uint8_t offset, uint16_t value) const;
+
+    /**
+     * @brief Enumerate the functions on the bus, following PCI-to-PCI
+     * bridges, and cache their configuration headers and BAR sizes. The
+     * registered drivers are given the functions that match their IDs.
+     */
+    void scan();
+
+    size_t getNumFunctions() const;
+
+    /**
+     * @brief Get a function found by scan(). Functions are sorted by their
+     * addresses.
+     */
+    const Function& getFunction(size_t idx) const;
+
+    /**
+     * @brief Register a driver, and give it the functions that have already
+     * been found that match its IDs and have no driver yet.
+     * @return false if too many drivers are registered
+     */
+    bool registerDriver(PciDriver* driver);
+
+    /**
+     * @brief Get a base address register.
+     * @param address The function's address.
+     * @param barIdx The index of the BAR (0-5).
+     * @return The BAR's value.
+     */
+    uint32_t getBar(const Address& address, int barIdx) const;
+
+    /**
+     * @brief Find a function found by scan() by its class code.
+     * @param classCode The class code.
+     * @param subclass The subclass.
+     * @param [in,out] address The address to start searching at (zero
+     * to search from the start); set to the function's address if one is
+     * found. Increment the function number to find the next one.
+     * @return true if a function was found; false, otherwise
+     */
+    bool findByClass(uint8_t classCode, uint8_t subclass, Address& address) const;
+
+    /**
+     * @brief Find a function found by scan() by its vendor and device IDs.
+     * @see findByClass()
+     */
+    bool findById(uint16_t vendorId, uint16_t deviceId, Address& address) const;
+
+    /**
+     * @brief Enable a function's I/O or memory decoding and bus mastering.
+     */
+    void enable(const Address& address, uint16_t commandBits) const;
+
+    /**
+     * @brief Deliver a function's interrupt as a message signaled interrupt
+     * (MSI) to this processor's local APIC, instead of its shared INTx
+     * line.
+     * @details The function's INTx interrupt is disabled. The IRQ is
+     * allocated from IRQ_MSI_START; register its handler with
+     * registerIrqHandler().
+     * @param function The function.
+     * @param [out] irq The IRQ the function's interrupt is delivered on.
+     * @return false if the function has no MSI capability, the local APIC is
+     * not in use, or no IRQs are left
+     */
+    bool enableMsi(const Function& function, uint8_t& irq);
+
+private:
+    friend class PciBusTestClass;
+
+    // MSI capability
+    constexpr static uint8_t CAPABILITY_MSI = 0x05;
+    constexpr static uint8_t MSI_CONTROL = 0x02;
+    constexpr static uint8_t MSI_ADDRESS = 0x04;
+    constexpr static uint8_t MSI_DATA_32 = 0x08;
+    constexpr static uint8_t MSI_DATA_64 = 0x0C;
+    constexpr static uint16_t MSI_CONTROL_ENABLE = 0x0001;
+    constexpr static uint16_t MSI_CONTROL_MULTIPLE_ENABLE = 0x0070;
+    constexpr static uint16_t MSI_CONTROL_64_BIT = 0x0080;
+
+    /// the local APIC's address range in MSI address registers
+    constexpr static uint32_t MSI_ADDRESS_BASE = 0xFEE0'0000;
+
+    Function functions[MAX_NUM_CACHED_FUNCTIONS];
+
+    size_t numFunctions = 0;
+
+    PciDriver* drivers[MAX_NUM_DRIVERS];
+
+    size_t numDrivers = 0;
+
+    /// the next IRQ to allocate to an MSI
+    uint8_t nextMsiIrq = IRQ_MSI_START;
+
+    /**
+     * @brief Scan the devices on a bus.
+     */
+    void scanBus(uint8_t bus);
+
+    /**
+     * @brief Cache a function, and scan the bus behind it if it is a
+     * bridge.
+     */
+    void addFunction(const Address& address);
+
+    /**
+     * @brief Measure the size of each BAR by writing all ones and reading
+     * back which bits are writable.
+     */
+    void sizeBars(Function& function) const;
+
+    /**
+     * @brief Find a capability in the capability list of a copy of a
+     * function's configuration space.
+     * @param config The configuration space (CONFIG_SPACE_SIZE bytes).
+     * @return The capability's offset, or 0 if the function doesn't have it.
+     */
+    static uint8_t findCapability(const uint32_t* config, uint8_t capabilityId);
+
+    /**
+     * @brief Give a function to a driver if the function has no driver yet
+     * and matches one of the driver's IDs.
+     */
+    void probe(Function& function, PciDriver* driver);
+
+    /**
+     * @brief Find the first cached function at or after the given address
+     * that matches the given configuration header fields.
+     * @param offset The offset of a 32-bit configuration register.
+     * @param mask The bits of the register to compare.
+     * @param value The expected value of the bits.
+     */
+    bool find(uint8_t offset, uint32_t mask, uint32_t value, Address& address) const;
+};
+
+/**
+ * @brief A driver for PCI functions, registered with
+ * PciBus::registerDriver().
+ */
+class PciDriver
+{
+public:
+    /**
+     * @brief The IDs of functions that a driver handles. PciBus::ANY_ID
+     * matches any ID.
+     */
+    struct DeviceId
+    {
+        uint16_t vendorId;
+        uint16_t deviceId;
+    };
+
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief Get the IDs of the functions that the driver handles.
+     * @param [out] numIds The number of IDs.
+     */
+    virtual const DeviceId* getDeviceIds(size_t& numIds) const = 0;
+
+    /**
+     * @brief Set up a function that matches one of the driver's IDs.
+     * @return true if the driver handles the function; false, otherwise
+     */
+    virtual bool probe(const PciBus::Function& function) = 0;
+};
+
+extern PciBus pciBus;
+
+#endif // PCI_H_
@@ -0,0 +1,120 @@
+#include <string.h>
+#include "pci.h"
+#include "unittests.h"
+
+/**
+ * @brief A copy of a function's configuration space with a capability
+ * list.
+ */
+class PciBusTestClass::TestConfig
+{
+public:
+    TestConfig()
+    {
+        memset(config, 0, sizeof(config));
+    }
+
+    void setByte(uint8_t offset, uint8_t value)
+    {
+        uint32_t shift = (offset & 3) * 8;
+        config[offset / 4] = (config[offset / 4] & ~(0xFFu << shift)) | (static_cast<uint32_t>(value) << shift);
+    }
+
+    /**
+     * @brief Set the capabilities bit and the pointer to the first
+     * capability.
+     */
+    void setFirst(uint8_t offset)
+    {
+        setByte(PciBus::CONFIG_STATUS, PciBus::STATUS_CAPABILITIES);
+        setByte(PciBus::CONFIG_CAPABILITIES, offset);
+    }
+
+    void setCapability(uint8_t offset, uint8_t id, uint8_t next)
+    {
+        setByte(offset, id);
+        setByte(offset + 1, next);
+    }
+
+    uint8_t find(uint8_t capabilityId) const
+    {
+        return PciBus::findCapability(config, capabilityId);
+    }
+
+    static uint8_t getMsiId()
+    {
+        return PciBus::CAPABILITY_MSI;
+    }
+
+private:
+    uint32_t config[PciBus::CONFIG_SPACE_SIZE / 4];
+};
+
+PciBusTestClass::PciBusTestClass() :
+    TestClass("PciBus")
+{
+}
+
+void PciBusTestClass::runTests()
+{
+    runTest("NoCapabilities", []()
+    {
+        TestConfig config;
+
+        // the capabilities pointer is ignored without the status bit
+        config.setByte(PciBus::CONFIG_CAPABILITIES, 0x40);
+        config.setCapability(0x40, TestConfig::getMsiId(), 0);
+
+        ASSERT_EQ(config.find(TestConfig::getMsiId()), 0);
+    });
+
+    runTest("FindCapability", []()
+    {
+        TestConfig config;
+        config.setFirst(0x40);
+        config.setCapability(0x40, 0x01, 0x60);
+        config.setCapability(0x60, 0x11, 0x50);
+        config.setCapability(0x50, TestConfig::getMsiId(), 0);
+
+        ASSERT_EQ(config.find(0x01), 0x40);
+        ASSERT_EQ(config.find(0x11), 0x60);
+        ASSERT_EQ(config.find(TestConfig::getMsiId()), 0x50);
+        ASSERT_EQ(config.find(0x10), 0);
+    });
+
+    runTest("ReservedPointerBits", []()
+    {
+        TestConfig config;
+
+        // the low two bits of the pointers are reserved
+        config.setFirst(0x43);
+        config.setCapability(0x40, 0x01, 0x52);
+        config.setCapability(0x50, TestConfig::getMsiId(), 0);
+
+        ASSERT_EQ(config.find(TestConfig::getMsiId()), 0x50);
+    });
+
+    runTest("PointerInHeader", []()
+    {
+        TestConfig config;
+
+        // capabilities can't be in the standard header, so the walk stops
+        config.setFirst(0x40);
+        config.setCapability(0x40, 0x01, 0x08);
+        config.setCapability(0x08, TestConfig::getMsiId(), 0);
+
+        ASSERT_EQ(config.find(TestConfig::getMsiId()), 0);
+    });
+
+    runTest("Loop", []()
+    {
+        TestConfig config;
+
+        // a list with a loop doesn't hang the walk
+        config.setFirst(0x40);
+        config.setCapability(0x40, 0x01, 0x50);
+        config.setCapability(0x50, 0x09, 0x40);
+
+        ASSERT_EQ(config.find(TestConfig::getMsiId()), 0);
+    });
+}
@@ -0,0 +1,56 @@
+#include "pitclockevent.h"
+#include "system.h"
+
+bool PitClockEvent::init(irqHandlerPtr eventHandler)
+{
+    minDelay = (NS_PER_SEC + PIT_FREQUENCY - 1) / PIT_FREQUENCY;
+    maxDelay = MAX_COUNT * NS_PER_SEC / PIT_FREQUENCY;
+
+    stop();
+    registerIrqHandler(IRQ_TIMER, eventHandler);
+
+    return true;
+}
+
+void PitClockEvent::setNextEvent(uint64_t delayNs)
+{
+    uint64_t count = delayNs * PIT_FREQUENCY / NS_PER_SEC;
+    if (count == 0)
+    {
+        count = 1;
+    }
+    else if (count > MAX_COUNT)
+    {
+        count = MAX_COUNT;
+    }
+
+    // the count starts when its high byte is written
+    outb(COMMAND, CHANNEL0_ONE_SHOT);
+    outb(CHANNEL0_DATA, count & 0xFF);
+    outb(CHANNEL0_DATA, (count >> 8) & 0xFF);
+}
+
+void PitClockEvent::stop()
+{
+    // setting the mode stops the count until a new count is written
+    outb(COMMAND, CHANNEL0_ONE_SHOT);
+}
+
+void PitClockEvent::wait(uint16_t count)
+{
+    // turn the speaker off, and hold channel 2 while its count is loaded
+    uint8_t speaker = inb(SPEAKER_PORT) & ~(SPEAKER_DATA | SPEAKER_GATE2);
+    outb(SPEAKER_PORT, speaker);
+
+    outb(COMMAND, CHANNEL2_ONE_SHOT);
+    outb(CHANNEL2_DATA, count & 0xFF);
+    outb(CHANNEL2_DATA, count >> 8);
+
+    // the output goes high when the count reaches zero
+    outb(SPEAKER_PORT, speaker | SPEAKER_GATE2);
+    while ( (inb(SPEAKER_PORT) & SPEAKER_OUT2) == 0 )
+    {
+    }
+
+    outb(SPEAKER_PORT, speaker);
+}
@@ -0,0 +1,52 @@
+#ifndef PIT_CLOCK_EVENT_H_
+#define PIT_CLOCK_EVENT_H_
+
+#include "clockevent.h"
+
+#define PIT_FREQUENCY 1'193'180
+
+/**
+ * @brief Channel 0 of the Programmable Interval Timer in one-shot mode
+ * (mode 0, interrupt on terminal count).
+ */
+class PitClockEvent : public ClockEvent
+{
+public:
+    bool init(irqHandlerPtr eventHandler) override;
+
+    void setNextEvent(uint64_t delayNs) override;
+
+    void stop() override;
+
+    const char* getName() const override
+    {
+        return "PIT";
+    }
+
+    /**
+     * @brief Busy wait for a number of PIT clock cycles with channel 2,
+     * which does not interrupt (e.g. to measure another timer's rate).
+     */
+    static void wait(uint16_t count);
+
+private:
+    static constexpr uint16_t CHANNEL0_DATA = 0x40;
+    static constexpr uint16_t CHANNEL2_DATA = 0x42;
+    static constexpr uint16_t COMMAND       = 0x43;
+
+    /// channel 2's gate and output bits are in the PC speaker port
+    static constexpr uint16_t SPEAKER_PORT = 0x61;
+    static constexpr uint8_t SPEAKER_GATE2 = 0x01;
+    static constexpr uint8_t SPEAKER_DATA  = 0x02;
+    static constexpr uint8_t SPEAKER_OUT2  = 0x20;
+
+    /// channel 0, low byte then high byte, mode 0
+    static constexpr uint8_t CHANNEL0_ONE_SHOT = 0x30;
+
+    /// channel 2, low byte then high byte, mode 0
+    static constexpr uint8_t CHANNEL2_ONE_SHOT = 0xB0;
+
+    static constexpr uint32_t MAX_COUNT = 0xFFFF;
+};
+
+#endif // PIT_CLOCK_EVENT_H_
@@ -1,27 +1,68 @@
+#include "apic.h"
+#include "clock.h"
+#include "cpu.h"
+#include "fcntl.h"
 #include "gdt.h"
 #include "irq.h"
+#include "kernellock.h"
 #include "kernellogger.h"
-#include "multiboot.h"
 #include "pageframemgr.h"
 #include "processmgr.h"
+#include "rootfilesystem.h"
+#include "stream.h"
 #include "streamtable.h"
 #include "string.h"
 #include "system.h"
+#include "tasklet.h"
+#include "timer.h"
 #include "userlogger.h"
 #include "utils.h"
 
 const uintptr_t ProcessMgr::ProcessInfo::KERNEL_STACK_PAGE = KERNEL_VIRTUAL_BASE - PAGE_SIZE;
 const uintptr_t ProcessMgr::ProcessInfo::USER_STACK_PAGE = ProcessMgr::ProcessInfo::KERNEL_STACK_PAGE - PAGE_SIZE;
 
-// put the ProcessInfo pointer at the base of the kernel stack
-ProcessMgr::ProcessInfo** ProcessMgr::ProcessInfo::PROCESS_INFO = reinterpret_cast<ProcessMgr::ProcessInfo**>(ProcessMgr::ProcessInfo::KERNEL_STACK_PAGE + PAGE_SIZE - 4);
-
-// the kernel stack starts right after the ProcessInfo pointer
-const uintptr_t ProcessMgr::ProcessInfo::KERNEL_STACK_START = reinterpret_cast<uintptr_t>(ProcessMgr::ProcessInfo::PROCESS_INFO) - sizeof(ProcessMgr::ProcessInfo::PROCESS_INFO);
+// the current process is found through the per-CPU data, so the whole
+// kernel stack page is the stack
+const uintptr_t ProcessMgr::ProcessInfo::KERNEL_STACK_START = ProcessMgr::ProcessInfo::KERNEL_STACK_PAGE + PAGE_SIZE;
 
 ProcessMgr::ProcessInfo* ProcessMgr::ProcessInfo::initProcess = nullptr;
 
-ProcessMgr::ProcessInfo::ProcessInfo()
+namespace
+{
+
+/**
+ * @brief Wake a process when its sleep or timed wait ends.
+ */
+void wakeProcess(void* data)
+{
+    processMgr.unblockProcess(static_cast<ProcessMgr::ProcessInfo*>(data));
+}
+
+/**
+ * @brief Mark a process to be terminated when its alarm goes off, and wake
+ * it if it is sleeping.
+ */
+void expireAlarm(void* data)
+{
+    ProcessMgr::ProcessInfo* procInfo = static_cast<ProcessMgr::ProcessInfo*>(data);
+    procInfo->alarmExpired = true;
+    procInfo->sleepTimer.cancel();
+    processMgr.unblockProcess(procInfo);
+}
+
+/**
+ * @brief Handle the interrupt another processor sends to give an idle
+ * processor a process. Waking the processor is all it needs to do.
+ */
+void handleRescheduleInterrupt(const registers*)
+{
+}
+
+} // namespace
+
+ProcessMgr::ProcessInfo::ProcessInfo() :
+    sleepTimer(wakeProcess, this),
+    alarmTimer(expireAlarm, this)
 {
     reset();
 }
@@ -37,7 +78,13 @@ void ProcessMgr::ProcessInfo::reset()
     lowerPageTable = {0, 0, PageFrameInfo::eOther};
     upperPageTable = {0, 0, PageFrameInfo::eOther};
     numPages = 0;
+    numMappings = 0;
     status = eTerminated;
+    sleepTimer.cancel();
+    alarmTimer.cancel();
+    alarmExpired = false;
+    cpuIdx = 0;
+    lastRunNs = 0;
 
     for (int i = 0; i < MAX_NUM_STREAM_INDICES; ++i)
     {
@@ -64,6 +111,9 @@ void ProcessMgr::ProcessInfo::exit()
 
     childProcesses.clear();
 
+    sleepTimer.cancel();
+    alarmTimer.cancel();
+
     // close any open file descriptors
     for (int i = 0; i < MAX_NUM_STREAM_INDICES; ++i)
     {
@@ -116,6 +166,11 @@ ProcessMgr::ProcessInfo::EStatus ProcessMgr::ProcessInfo::getStatus() const
     return status;
 }
 
+void ProcessMgr::ProcessInfo::setStatus(EStatus newStatus)
+{
+    status = newStatus;
+}
+
 int ProcessMgr::ProcessInfo::addStreamIndex(int masterStreamIdx)
 {
     for (int i = 0; i < MAX_NUM_STREAM_INDICES; ++i)
@@ -212,14 +267,71 @@ int ProcessMgr::ProcessInfo::duplicateStreamIndex(int procStreamIdx, int dupProc
     return dupProcStreamIdx;
 }
 
+bool ProcessMgr::ProcessInfo::addMapping(const MemoryMapping& mapping)
+{
+    if (numMappings >= MAX_NUM_MAPPINGS)
+    {
+        return false;
+    }
+
+    mappings[numMappings++] = mapping;
+    return true;
+}
+
+bool ProcessMgr::ProcessInfo::removeMapping(uintptr_t virtualAddr, size_t numPages, MemoryMapping& mapping)
+{
+    for (int i = 0; i < numMappings; ++i)
+    {
+        if (mappings[i].virtualAddr == virtualAddr && mappings[i].numPages == numPages)
+        {
+            mapping = mappings[i];
+            mappings[i] = mappings[numMappings - 1];
+            --numMappings;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+ProcessMgr::ProcessInfo::MemoryMapping ProcessMgr::ProcessInfo::getMapping(int i) const
+{
+    return mappings[i];
+}
+
+int ProcessMgr::ProcessInfo::getNumMappings() const
+{
+    return numMappings;
+}
+
+void ProcessMgr::ProcessInfo::clearMappings()
+{
+    numMappings = 0;
+}
+
+void ProcessMgr::ProcessInfo::copyMappings(ProcessInfo* procInfo)
+{
+    // the mapped pages are shared, so we only need to copy the bookkeeping
+    // (the page table entries are copied with the page tables)
+    memcpy(mappings, procInfo->mappings, procInfo->numMappings * sizeof(MemoryMapping));
+    numMappings = procInfo->numMappings;
+}
+
 const char* ProcessMgr::LOG_TAG = "Processes";
 
 ProcessMgr::ProcessMgr() :
-    currentProcIdx(0),
-    intSwitchEnabled(false),
-    pageFrameMgr(nullptr),
-    mbootInfo(nullptr)
+    pageFrameMgr(nullptr)
 {
+    for (RunQueue& queue : runQueues)
+    {
+        queue.currentIdx = 0;
+        queue.runningProc = nullptr;
+        queue.intSwitchEnabled = false;
+        queue.procAction = EAction::eNone;
+        queue.actionProc = nullptr;
+        queue.isIdle = false;
+        queue.nextBalanceNs = 0;
+    }
 }
 
 void ProcessMgr::setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr)
@@ -227,39 +339,45 @@ void ProcessMgr::setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr)
     pageFrameMgr = pageFrameMgrPtr;
 }
 
-void ProcessMgr::setMultibootInfo(const multiboot_info* multibootInfo)
-{
-    mbootInfo = multibootInfo;
-}
-
 void ProcessMgr::mainloop()
 {
     klog.logInfo(LOG_TAG, "Starting mainloop");
 
-    ProcessInfo* proc = nullptr;
+    registerIrqHandler(IRQ_RESCHEDULE, handleRescheduleInterrupt);
 
-    const multiboot_mod_list* initModule = nullptr;
-    bool found = findModule("init", initModule);
-    if (!found)
+    // kick off init process
+    bool ok = createProcess("init", 0, 0, 0);
+    if (!ok)
     {
-        PANIC("Could not find init program.");
+        PANIC("Could not start init program.");
     }
+    ProcessInfo::initProcess = getCurrentProcessInfo();
 
-    // kick off init process
-    createProcess(initModule, 0, 1, 1);
-    proc = ProcessInfo::initProcess = runningProcs[currentProcIdx];
+    loop(ProcessInfo::initProcess);
+}
+
+void ProcessMgr::apMainloop()
+{
+    KernelLock::acquire();
+
+    loop(nullptr);
+}
 
+void ProcessMgr::loop(ProcessInfo* proc)
+{
     while (true)
     {
         // switch to kernel's page directory
         uintptr_t kernelPageDirPhyAddr = reinterpret_cast<uintptr_t>(getKernelPageDirStart()) - KERNEL_VIRTUAL_BASE;
-        setPageDirectory(kernelPageDirPhyAddr);
+        Cpu::switchPageDirectory(kernelPageDirPhyAddr);
 
         // enable interrupts
         setInt();
 
         // process actions
-        switch (procAction)
+        RunQueue& queue = getRunQueue();
+        ProcessInfo* actionProc = queue.actionProc;
+        switch (queue.procAction)
         {
         case EAction::eNone:
             // do nothing
@@ -281,36 +399,78 @@ void ProcessMgr::mainloop()
         }
 
         case EAction::eYield:
-            proc = getNextScheduledProcess();
+            proc = nullptr;
             break;
 
         case EAction::eExit:
-            runningProcs.remove(actionProc);
+        {
+            clearInt();
+            RunQueue& procQueue = runQueues[actionProc->cpuIdx];
+            procQueue.lock.acquire();
+            procQueue.procs.remove(actionProc);
+            procQueue.lock.release();
+
             actionProc->exit();
-            proc = getNextScheduledProcess();
+            setInt();
+            proc = nullptr;
             break;
         }
 
-        // reset action
-        procAction = EAction::eNone;
-
-        if (proc != nullptr)
+        case EAction::eBlock:
         {
-            // switch to process
-            switchToProcessFromKernel(proc);
+            // an interrupt may have already unblocked the process
+            RunQueue& procQueue = runQueues[actionProc->cpuIdx];
+            procQueue.lock.acquire();
+            if (actionProc->getStatus() == ProcessInfo::eBlocked)
+            {
+                procQueue.procs.remove(actionProc);
+            }
+            procQueue.lock.release();
+
+            proc = nullptr;
+            break;
         }
-        else
+        }
+
+        // reset action
+        queue.procAction = EAction::eNone;
+
+        // a forked process's parent continues; otherwise, the process that
+        // came back to the kernel can be moved to other processors now that
+        // its action is done
+        if (proc == nullptr)
         {
-            // halt if there are no more processes
-            asm volatile ("hlt");
+            clearInt();
+
+            queue.lock.acquire();
+            if (queue.runningProc != nullptr)
+            {
+                queue.runningProc->lastRunNs = Clock::getNs();
+                queue.runningProc = nullptr;
+            }
+            queue.lock.release();
+
+            proc = waitForProcess();
         }
+
+        // switch to process
+        os::Timer::startTimeSlice();
+        switchToProcessFromKernel(proc);
     }
 }
 
-void ProcessMgr::createProcess(const multiboot_mod_list* module, int stdinStreamIdx, int stdoutStreamIdx, int stderrStreamIdx)
+bool ProcessMgr::createProcess(const char* path, int stdinStreamIdx, int stdoutStreamIdx, int stderrStreamIdx)
 {
     bool ok = true;
 
+    // open the executable
+    size_t exeSize = 0;
+    int exeStreamIdx = openExecutable(path, exeSize);
+    if (exeStreamIdx < 0)
+    {
+        return false;
+    }
+
     // find an entry in the process info table
     ProcessInfo* newProcInfo = nullptr;
     ok = getNewProcInfo(newProcInfo);
@@ -332,12 +492,14 @@ void ProcessMgr::createProcess(const multiboot_mod_list* module, int stdinStream
         unmapPages(newProcInfo, getKernelPageTableStart());
 
         // switch to process's page directory
-        setPageDirectory(newProcInfo->pageDir.physicalAddr);
+        Cpu::switchPageDirectory(newProcInfo->pageDir.physicalAddr);
 
         // copy the program and set up the stack
-        ok = setUpProgram(module, newProcInfo);
+        ok = setUpProgram(exeStreamIdx, exeSize, newProcInfo);
     }
 
+    rootFileSystem.close(exeStreamIdx);
+
     if (ok)
     {
         // add stream for stdin, stdout, and stderr
@@ -345,28 +507,37 @@ void ProcessMgr::createProcess(const multiboot_mod_list* module, int stdinStream
         newProcInfo->addStreamIndex(stdoutStreamIdx);
         newProcInfo->addStreamIndex(stderrStreamIdx);
 
-        /// @todo temp hardcode
-        newProcInfo->addStreamIndex(2);
+        /// @todo temp hardcode (the serial port terminal)
+        newProcInfo->addStreamIndex(1);
 
         // allocate a process ID and start the process
         newProcInfo->start(getNewId());
 
-        // set the ProcessInfo pointer
-        *ProcessInfo::PROCESS_INFO = newProcInfo;
+        // the processor runs the process
+        clearInt();
+        Cpu::getCurrent()->process = newProcInfo;
 
-        // add process to list of running processes
-        runningProcs.add(newProcInfo);
+        // add process to the processor's run queue; it is the running
+        // process first, so no other processor takes it
+        RunQueue& queue = getRunQueue();
+        queue.lock.acquire();
+        queue.runningProc = newProcInfo;
+        queue.lock.release();
+        enqueueProcess(newProcInfo, Cpu::getCurrent()->index);
 
         // set the kernel stack for the process
         setKernelStack(ProcessInfo::KERNEL_STACK_START);
 
         // allow process switching once interrupts are enabled again
         // in the process
-        clearInt();
-        intSwitchEnabled = true;
-
-        // switch to user mode and run process
-        switchToUserMode(ProcessInfo::USER_STACK_PAGE + PAGE_SIZE - 4, &kernelStack);
+        queue.intSwitchEnabled = true;
+        os::Timer::startTimeSlice();
+
+        // switch to user mode and run process; the process enters the
+        // kernel again through an interrupt or system call, which takes the
+        // lock
+        KernelLock::release();
+        switchToUserMode(ProcessInfo::USER_STACK_PAGE + PAGE_SIZE - 4, &Cpu::getCurrent()->kernelStack);
     }
     else
     {
@@ -375,10 +546,12 @@ void ProcessMgr::createProcess(const multiboot_mod_list* module, int stdinStream
 
         // switch back to kernel's page directory
         uintptr_t kernelPageDirPhyAddr = reinterpret_cast<uintptr_t>(getKernelPageDirStart()) - KERNEL_VIRTUAL_BASE;
-        setPageDirectory(kernelPageDirPhyAddr);
+        Cpu::switchPageDirectory(kernelPageDirPhyAddr);
 
         cleanUpProcess(newProcInfo);
     }
+
+    return ok;
 }
 
 pid_t ProcessMgr::forkCurrentProcess()
@@ -396,15 +569,13 @@ bool ProcessMgr::switchCurrentProcessExecutable(const char* path, const char* co
     ProcessInfo* procInfo = getCurrentProcessInfo();
     uintptr_t* lowerPageTable = reinterpret_cast<uintptr_t*>(procInfo->lowerPageTable.virtualAddr);
 
-    // find module
-    const multiboot_mod_list* module = nullptr;
-    ok = findModule(path, module);
+    // open the executable
+    size_t exeSize = 0;
+    int exeStreamIdx = openExecutable(path, exeSize);
+    ok = exeStreamIdx >= 0;
 
     if (ok)
     {
-        // get size of new executable
-        size_t exeSize = module->mod_end - module->mod_start;
-
         // get current allocated memory size for code
         int numCodePages = procInfo->getNumPagesOfType(ProcessInfo::PageFrameInfo::eCode);
         size_t allocMem = numCodePages * PAGE_SIZE;
@@ -428,6 +599,7 @@ bool ProcessMgr::switchCurrentProcessExecutable(const char* path, const char* co
             if (phyAddr == 0)
             {
                 logError("Could not allocate page frame");
+                rootFileSystem.close(exeStreamIdx);
                 return false;
             }
 
@@ -440,15 +612,28 @@ bool ProcessMgr::switchCurrentProcessExecutable(const char* path, const char* co
 
         /// @todo if we have more memory than we need, dealloc pages
 
+        // the new executable does not inherit memory mappings
+        unmapProcessMappings(procInfo);
+
         // copy args
         uintptr_t stackStart = copyArgs(argv, ProcessInfo::USER_STACK_PAGE + PAGE_SIZE - 4);
 
         // copy new executable
-        memcpy(reinterpret_cast<void*>(ProcessInfo::CODE_VIRTUAL_START),
-               reinterpret_cast<const void*>(module->mod_start + KERNEL_VIRTUAL_BASE),
-               exeSize);
+        bool readOk = readExecutable(exeStreamIdx, exeSize);
+        rootFileSystem.close(exeStreamIdx);
+
+        // the old executable has been overwritten, so the process can't
+        // continue
+        if (!readOk)
+        {
+            logError("Could not read executable");
+            exitCurrentProcess(1);
+        }
 
-        // switch to user mode
+        // switch to user mode (the system call doesn't return, so it
+        // doesn't release the kernel lock)
+        clearInt();
+        KernelLock::release();
         uintptr_t temp;
         switchToUserMode(stackStart, &temp);
     }
@@ -461,6 +646,52 @@ void ProcessMgr::yieldCurrentProcess()
     executeAction(EAction::eYield, getCurrentProcessInfo());
 }
 
+void ProcessMgr::blockCurrentProcess()
+{
+    ProcessInfo* currentProc = getCurrentProcessInfo();
+    currentProc->setStatus(ProcessInfo::eBlocked);
+
+    executeAction(EAction::eBlock, currentProc);
+}
+
+void ProcessMgr::unblockProcess(ProcessInfo* procInfo)
+{
+    // a blocked process isn't moved to other processors, so its run queue
+    // doesn't change
+    RunQueue& queue = runQueues[procInfo->cpuIdx];
+    queue.lock.acquire();
+
+    bool wasBlocked = procInfo->getStatus() == ProcessInfo::eBlocked;
+    if (wasBlocked)
+    {
+        procInfo->setStatus(ProcessInfo::eRunning);
+    }
+
+    // the process may not have been removed from the run queue yet
+    bool isQueued = queue.procs.contains(procInfo);
+
+    queue.lock.release();
+
+    if (!wasBlocked || isQueued)
+    {
+        return;
+    }
+
+    // the process's cache is most likely still on the processor it last
+    // ran on; if that processor is busy, an idle one can steal the process
+    enqueueProcess(procInfo, procInfo->cpuIdx);
+    if (!queue.isIdle)
+    {
+        wakeIdleProcessor();
+    }
+}
+
+bool ProcessMgr::isInProcess() const
+{
+    uintptr_t stack = reinterpret_cast<uintptr_t>(getStackPointer());
+    return stack >= ProcessInfo::KERNEL_STACK_PAGE && stack < ProcessInfo::KERNEL_STACK_PAGE + PAGE_SIZE;
+}
+
 void ProcessMgr::exitCurrentProcess(int exitCode)
 {
     ProcessInfo* currentProc = getCurrentProcessInfo();
@@ -477,66 +708,239 @@ void ProcessMgr::cleanUpCurrentProcessChild(ProcessInfo* childProc)
     cleanUpProcess(childProc);
 }
 
-void ProcessMgr::processTimerInterrupt(const registers* regs)
+void ProcessMgr::sleepCurrentProcess(uint64_t deadlineNs)
+{
+    ProcessInfo* currentProc = getCurrentProcessInfo();
+
+    currentProc->sleepTimer.start(deadlineNs);
+    while (currentProc->sleepTimer.isPending() && !currentProc->alarmExpired)
+    {
+        blockCurrentProcess();
+        clearInt();
+    }
+
+    currentProc->sleepTimer.cancel();
+}
+
+uint64_t ProcessMgr::setCurrentProcessAlarm(uint64_t deadlineNs)
+{
+    ProcessInfo* currentProc = getCurrentProcessInfo();
+
+    uint64_t remaining = 0;
+    if (currentProc->alarmTimer.isPending())
+    {
+        uint64_t now = Clock::getNs();
+        uint64_t deadline = currentProc->alarmTimer.getDeadline();
+
+        // an alarm that is due but hasn't gone off yet is still pending
+        remaining = (deadline > now) ? deadline - now : 1;
+    }
+
+    if (deadlineNs == 0)
+    {
+        currentProc->alarmTimer.cancel();
+    }
+    else
+    {
+        currentProc->alarmTimer.start(deadlineNs);
+    }
+
+    return remaining;
+}
+
+void ProcessMgr::checkCurrentProcessAlarm()
+{
+    // there are no signals, so the alarm always terminates the process
+    // (the default action for SIGALRM)
+    if (getCurrentProcessInfo()->alarmExpired)
+    {
+        exitCurrentProcess(ALARM_EXIT_CODE);
+    }
+}
+
+void ProcessMgr::processTimerInterrupt(const registers* regs, bool timeSliceEnded)
 {
-    if (intSwitchEnabled)
+    if (!getRunQueue().intSwitchEnabled)
+    {
+        return;
+    }
+
+    // a tasklet that was interrupted must finish before another process
+    // runs, so check again shortly
+    if (Tasklet::isRunning())
+    {
+        if (timeSliceEnded)
+        {
+            os::Timer::startTimeSlice(TASKLET_RETRY_NS);
+        }
+        return;
+    }
+
+    // a process that was interrupted in user mode can be terminated right
+    // away; code in the kernel is left to return from its system call,
+    // where the alarm is checked
+    bool inUserMode = (regs->cs & 0x3) == 0x3;
+    if (inUserMode && getCurrentProcessInfo()->alarmExpired)
     {
-        sendPicEoi(regs);
+        sendEoi(regs);
+        checkCurrentProcessAlarm();
+    }
+
+    if (timeSliceEnded)
+    {
+        sendEoi(regs);
 
         yieldCurrentProcess();
+
+        // the alarm may have gone off while other processes ran
+        if (inUserMode)
+        {
+            checkCurrentProcessAlarm();
+        }
     }
 }
 
-ProcessMgr::ProcessInfo* ProcessMgr::getCurrentProcessInfo()
+uintptr_t ProcessMgr::mapCurrentProcessMemory(uintptr_t physicalAddr, size_t numPages)
 {
-    return *ProcessInfo::PROCESS_INFO;
+    ProcessInfo* procInfo = getCurrentProcessInfo();
+    uintptr_t* lowerPageTable = reinterpret_cast<uintptr_t*>(procInfo->lowerPageTable.virtualAddr);
+
+    if (numPages == 0 || (physicalAddr & PAGE_SIZE_MASK) != 0)
+    {
+        return 0;
+    }
+
+    // find a range of unmapped pages in the mapping region that is big enough
+    constexpr size_t START_IDX = (ProcessInfo::MAPPING_VIRTUAL_START >> 12) & PAGE_TABLE_INDEX_MASK;
+    constexpr size_t END_IDX = START_IDX + ((ProcessInfo::MAPPING_VIRTUAL_END - ProcessInfo::MAPPING_VIRTUAL_START) >> 12);
+    size_t runStartIdx = START_IDX;
+    size_t runSize = 0;
+    for (size_t idx = START_IDX; idx < END_IDX && runSize < numPages; ++idx)
+    {
+        if ( (lowerPageTable[idx] & PAGE_TABLE_PRESENT) == 0 )
+        {
+            ++runSize;
+        }
+        else
+        {
+            runStartIdx = idx + 1;
+            runSize = 0;
+        }
+    }
+
+    if (runSize < numPages)
+    {
+        klog.logWarning(LOG_TAG, "Not enough address space to map {} pages", numPages);
+        return 0;
+    }
+
+    uintptr_t virtualAddr = runStartIdx << 12;
+    if (!procInfo->addMapping({virtualAddr, numPages}))
+    {
+        klog.logWarning(LOG_TAG, "The maximum number of memory mappings has already been created");
+        return 0;
+    }
+
+    // map the pages as read-only user pages
+    for (size_t i = 0; i < numPages; ++i)
+    {
+        uintptr_t pageVirAddr = virtualAddr + i * PAGE_SIZE;
+        mapPage(lowerPageTable, pageVirAddr, physicalAddr + i * PAGE_SIZE, true, false);
+        invalidatePage(pageVirAddr);
+    }
+
+    return virtualAddr;
+}
+
+bool ProcessMgr::unmapCurrentProcessMemory(uintptr_t virtualAddr, size_t numPages)
+{
+    ProcessInfo* procInfo = getCurrentProcessInfo();
+    uintptr_t* lowerPageTable = reinterpret_cast<uintptr_t*>(procInfo->lowerPageTable.virtualAddr);
+
+    ProcessInfo::MemoryMapping mapping;
+    bool found = procInfo->removeMapping(virtualAddr, numPages, mapping);
+    if (found)
+    {
+        for (size_t i = 0; i < mapping.numPages; ++i)
+        {
+            unmapPage(lowerPageTable, mapping.virtualAddr + i * PAGE_SIZE);
+        }
+    }
+
+    return found;
 }
 
-uint32_t ProcessMgr::getNumModules() const
+ProcessMgr::ProcessInfo* ProcessMgr::getCurrentProcessInfo()
 {
-    return mbootInfo->mods_count;
+    return Cpu::getCurrent()->process;
 }
 
-bool ProcessMgr::getModuleName(uint32_t index, char* name) const
+uint32_t* ProcessMgr::getActiveKernelPageTable()
 {
-    if (index >= mbootInfo->mods_count)
+    uintptr_t kernelPageDirPhyAddr = reinterpret_cast<uintptr_t>(getKernelPageDirStart()) - KERNEL_VIRTUAL_BASE;
+    if (getPageDirectory() == kernelPageDirPhyAddr)
     {
-        name[0] = '\0';
-        return false;
+        return getKernelPageTableStart();
     }
 
-    const multiboot_mod_list* moduleList = reinterpret_cast<const multiboot_mod_list*>(mbootInfo->mods_addr + KERNEL_VIRTUAL_BASE);
+    return reinterpret_cast<uint32_t*>(getCurrentProcessInfo()->kernelPageTable.virtualAddr);
+}
 
-    const char* modName = reinterpret_cast<const char*>(moduleList[index].cmdline + KERNEL_VIRTUAL_BASE);
-    strcpy(name, modName);
+uint8_t* ProcessMgr::mapTempPage(uintptr_t physicalAddr)
+{
+    uint32_t virtualAddr = 0;
+    if (!mapPage((KERNEL_VIRTUAL_BASE >> 22), getActiveKernelPageTable(), virtualAddr, physicalAddr))
+    {
+        logError("Could not map a temporary page.");
+        return nullptr;
+    }
 
-    return true;
+    return reinterpret_cast<uint8_t*>(virtualAddr);
 }
 
-bool ProcessMgr::findModule(const char* name, const multiboot_mod_list*& module)
+void ProcessMgr::unmapTempPage(uint8_t* page)
 {
-    bool found = false;
-    uint32_t addr = mbootInfo->mods_addr + KERNEL_VIRTUAL_BASE;
-    uint32_t count = mbootInfo->mods_count;
+    unmapPage(getActiveKernelPageTable(), reinterpret_cast<uintptr_t>(page));
+}
+
+int ProcessMgr::openExecutable(const char* path, size_t& exeSize)
+{
+    int streamIdx = rootFileSystem.open(path, O_RDONLY);
+    if (streamIdx < 0)
+    {
+        return -1;
+    }
 
-    for (uint32_t i = 0; i < count; ++i)
+    off_t size = streamTable.getStream(streamIdx)->size();
+    if (size <= 0)
     {
-        // get module info struct
-        const multiboot_mod_list* modulePtr = reinterpret_cast<const multiboot_mod_list*>(addr);
+        rootFileSystem.close(streamIdx);
+        return -1;
+    }
+
+    exeSize = static_cast<size_t>(size);
 
-        // check if name matches
-        const char* modName = reinterpret_cast<const char*>(modulePtr->cmdline + KERNEL_VIRTUAL_BASE);
-        if (strcmp(name, modName) == 0)
+    return streamIdx;
+}
+
+bool ProcessMgr::readExecutable(int streamIdx, size_t exeSize)
+{
+    Stream* stream = streamTable.getStream(streamIdx);
+
+    size_t numRead = 0;
+    while (numRead < exeSize)
+    {
+        uint8_t* dst = reinterpret_cast<uint8_t*>(ProcessInfo::CODE_VIRTUAL_START + numRead);
+        ssize_t rv = stream->read(dst, exeSize - numRead);
+        if (rv <= 0)
         {
-            module = modulePtr;
-            found = true;
             break;
         }
 
-        addr += sizeof(multiboot_mod_list);
+        numRead += rv;
     }
 
-    return found;
+    return numRead == exeSize;
 }
 
 ProcessMgr::ProcessInfo* ProcessMgr::forkProcess(ProcessInfo* procInfo)
@@ -568,6 +972,9 @@ ProcessMgr::ProcessInfo* ProcessMgr::forkProcess(ProcessInfo* procInfo)
 
         // copy process's streams
         newProcInfo->copyStreamIndices(procInfo);
+
+        // copy process's memory mappings
+        newProcInfo->copyMappings(procInfo);
     }
 
     // unmap process pages from kernel page table
@@ -587,14 +994,12 @@ ProcessMgr::ProcessInfo* ProcessMgr::forkProcess(ProcessInfo* procInfo)
         // add new process to parent's children list
         procInfo->childProcesses.add(newProcInfo);
 
-        // switch to process's page directory
-        setPageDirectory(newProcInfo->pageDir.physicalAddr);
-
-        // set the ProcessInfo pointer
-        *ProcessInfo::PROCESS_INFO = newProcInfo;
-
-        // add process to list of running processes
-        runningProcs.add(newProcInfo);
+        // run the process on the processor with the least load, which is
+        // the parent's processor if it isn't busier than the others
+        // (interrupt handlers may unblock processes)
+        clearInt();
+        enqueueProcess(newProcInfo, findLeastLoadedProcessor(procInfo->cpuIdx));
+        setInt();
     }
     else
     {
@@ -609,7 +1014,7 @@ ProcessMgr::ProcessInfo* ProcessMgr::forkProcess(ProcessInfo* procInfo)
 
     // switch back to kernel's page directory
     uintptr_t kernelPageDirPhyAddr = reinterpret_cast<uintptr_t>(getKernelPageDirStart()) - KERNEL_VIRTUAL_BASE;
-    setPageDirectory(kernelPageDirPhyAddr);
+    Cpu::switchPageDirectory(kernelPageDirPhyAddr);
 
     return ok ? newProcInfo : nullptr;
 }
@@ -759,6 +1164,13 @@ void ProcessMgr::copyKernelPageTable(ProcessInfo* dstProc, uintptr_t* srcKernelP
     memset(pageDir, 0, PAGE_SIZE);
     int kernelIdx = KERNEL_VIRTUAL_BASE >> 22;
     mapPageTable(pageDir, dstProc->kernelPageTable.physicalAddr, kernelIdx);
+
+    // share the kernel's other page tables (e.g. the framebuffer's)
+    const uint32_t* kernelPageDir = getKernelPageDirStart();
+    for (int idx = kernelIdx + 1; idx < PAGE_DIR_NUM_ENTRIES; ++idx)
+    {
+        pageDir[idx] = kernelPageDir[idx];
+    }
 }
 
 void ProcessMgr::createProcessPageTables(ProcessInfo* newProcInfo)
@@ -799,14 +1211,14 @@ void ProcessMgr::copyProcessPageTables(ProcessInfo* dstProc, ProcessInfo* srcPro
     mapPageTable(dstPageDir, dstProc->upperPageTable.physicalAddr, upperIdx, true);
 }
 
-bool ProcessMgr::setUpProgram(const multiboot_mod_list* module, ProcessInfo* newProcInfo)
+bool ProcessMgr::setUpProgram(int exeStreamIdx, size_t exeSize, ProcessInfo* newProcInfo)
 {
     uintptr_t* lowerPageTable = reinterpret_cast<uintptr_t*>(newProcInfo->lowerPageTable.virtualAddr);
     uintptr_t* upperPageTable = reinterpret_cast<uintptr_t*>(newProcInfo->upperPageTable.virtualAddr);
 
     // allocate and map pages for code
     uintptr_t virAddr = ProcessInfo::CODE_VIRTUAL_START;
-    for (unsigned int ptr = module->mod_start; ptr < module->mod_end; ptr += PAGE_SIZE)
+    for (size_t offset = 0; offset < exeSize; offset += PAGE_SIZE)
     {
         uintptr_t phyAddr = pageFrameMgr->allocPageFrame();
         if (phyAddr == 0)
@@ -822,10 +1234,11 @@ bool ProcessMgr::setUpProgram(const multiboot_mod_list* module, ProcessInfo* new
     }
 
     // copy process's code
-    size_t codeSize = module->mod_end - module->mod_start;
-    memcpy(reinterpret_cast<void*>(ProcessInfo::CODE_VIRTUAL_START),
-           reinterpret_cast<const void*>(module->mod_start + KERNEL_VIRTUAL_BASE),
-           codeSize);
+    if (!readExecutable(exeStreamIdx, exeSize))
+    {
+        logError("Could not read executable.");
+        return false;
+    }
 
     // allocate and map a page for the kernel stack
     uintptr_t kernelStackPhyAddr = pageFrameMgr->allocPageFrame();
@@ -850,6 +1263,22 @@ bool ProcessMgr::setUpProgram(const multiboot_mod_list* module, ProcessInfo* new
     return true;
 }
 
+void ProcessMgr::unmapProcessMappings(ProcessInfo* procInfo)
+{
+    uintptr_t* lowerPageTable = reinterpret_cast<uintptr_t*>(procInfo->lowerPageTable.virtualAddr);
+
+    for (int i = 0; i < procInfo->getNumMappings(); ++i)
+    {
+        ProcessInfo::MemoryMapping mapping = procInfo->getMapping(i);
+        for (size_t j = 0; j < mapping.numPages; ++j)
+        {
+            unmapPage(lowerPageTable, mapping.virtualAddr + j * PAGE_SIZE);
+        }
+    }
+
+    procInfo->clearMappings();
+}
+
 bool ProcessMgr::copyProcessPages(ProcessInfo* dstProc, ProcessInfo* srcProc)
 {
     for (int i = 0; i < srcProc->getNumPages(); ++i)
@@ -945,23 +1374,277 @@ pid_t ProcessMgr::getNewId()
     return nextId++;
 }
 
-ProcessMgr::ProcessInfo* ProcessMgr::getNextScheduledProcess()
+ProcessMgr::RunQueue& ProcessMgr::getRunQueue()
+{
+    return runQueues[Cpu::getCurrent()->index];
+}
+
+void ProcessMgr::enqueueProcess(ProcessInfo* procInfo, unsigned int cpuIdx)
+{
+    RunQueue& queue = runQueues[cpuIdx];
+    queue.lock.acquire();
+
+    procInfo->cpuIdx = cpuIdx;
+    queue.procs.add(procInfo);
+
+    // the processor checks its run queue with the lock held before it
+    // halts, so it either finds the process or is interrupted
+    bool isIdle = queue.isIdle;
+
+    queue.lock.release();
+
+    if (isIdle && cpuIdx != Cpu::getCurrent()->index)
+    {
+        Apic::sendFixedIpi(Cpu::get(cpuIdx)->apicId, IRQ_START_NUM + IRQ_RESCHEDULE);
+    }
+}
+
+void ProcessMgr::wakeIdleProcessor()
 {
-    if (runningProcs.getSize() > 0)
+    unsigned int cpuIdx = Cpu::getCurrent()->index;
+    for (unsigned int i = 0; i < Cpu::getNumCpus(); ++i)
     {
-        currentProcIdx = (currentProcIdx >= runningProcs.getSize() - 1) ? 0 : currentProcIdx + 1;
-        return runningProcs[currentProcIdx];
+        if (i != cpuIdx && runQueues[i].isIdle)
+        {
+            Apic::sendFixedIpi(Cpu::get(i)->apicId, IRQ_START_NUM + IRQ_RESCHEDULE);
+            return;
+        }
+    }
+}
+
+size_t ProcessMgr::getLoad(unsigned int cpuIdx)
+{
+    RunQueue& queue = runQueues[cpuIdx];
+
+    queue.lock.acquire();
+    size_t load = countRunnable(queue);
+    queue.lock.release();
+
+    return load;
+}
+
+size_t ProcessMgr::getNumWaiting(unsigned int cpuIdx)
+{
+    RunQueue& queue = runQueues[cpuIdx];
+    queue.lock.acquire();
+
+    size_t numWaiting = countRunnable(queue);
+    if (numWaiting > 0 && queue.runningProc != nullptr && queue.runningProc->getStatus() == ProcessInfo::eRunning)
+    {
+        --numWaiting;
+    }
+
+    queue.lock.release();
+
+    return numWaiting;
+}
+
+size_t ProcessMgr::countRunnable(const RunQueue& queue) const
+{
+    // blocked processes stay in the run queue until the processor's main
+    // loop removes them
+    size_t numRunnable = 0;
+    for (size_t i = 0; i < queue.procs.getSize(); ++i)
+    {
+        if (queue.procs[i]->getStatus() == ProcessInfo::eRunning)
+        {
+            ++numRunnable;
+        }
+    }
+
+    return numRunnable;
+}
+
+unsigned int ProcessMgr::findLeastLoadedProcessor(unsigned int preferredIdx)
+{
+    unsigned int leastIdx = preferredIdx;
+    size_t leastLoad = getLoad(preferredIdx);
+    for (unsigned int i = 0; i < Cpu::getNumCpus(); ++i)
+    {
+        size_t load = getLoad(i);
+        if (load < leastLoad)
+        {
+            leastIdx = i;
+            leastLoad = load;
+        }
+    }
+
+    return leastIdx;
+}
+
+unsigned int ProcessMgr::findBusiestProcessor()
+{
+    unsigned int cpuIdx = Cpu::getCurrent()->index;
+    unsigned int busiestIdx = cpuIdx;
+    size_t mostWaiting = 0;
+    for (unsigned int i = 0; i < Cpu::getNumCpus(); ++i)
+    {
+        size_t numWaiting = getNumWaiting(i);
+        if (i != cpuIdx && numWaiting > mostWaiting)
+        {
+            busiestIdx = i;
+            mostWaiting = numWaiting;
+        }
+    }
+
+    return busiestIdx;
+}
+
+size_t ProcessMgr::pullProcesses(unsigned int srcIdx, size_t maxNumProcs, uint64_t minIdleNs)
+{
+    RunQueue& srcQueue = runQueues[srcIdx];
+    unsigned int cpuIdx = Cpu::getCurrent()->index;
+    RunQueue& dstQueue = runQueues[cpuIdx];
+    uint64_t now = Clock::getNs();
+
+    // lock the queues in the order of their indices, so two processors
+    // pulling from each other don't deadlock
+    RunQueue& firstQueue = (srcIdx < cpuIdx) ? srcQueue : dstQueue;
+    RunQueue& secondQueue = (srcIdx < cpuIdx) ? dstQueue : srcQueue;
+    firstQueue.lock.acquire();
+    secondQueue.lock.acquire();
+
+    size_t numMoved = 0;
+    while (numMoved < maxNumProcs)
+    {
+        // the process that ran least recently has the coldest cache
+        ProcessInfo* coldestProc = nullptr;
+        for (size_t i = 0; i < srcQueue.procs.getSize(); ++i)
+        {
+            ProcessInfo* proc = srcQueue.procs[i];
+            bool canMove = proc != srcQueue.runningProc && proc->getStatus() == ProcessInfo::eRunning &&
+                           proc->lastRunNs + minIdleNs <= now;
+            if (canMove && (coldestProc == nullptr || proc->lastRunNs < coldestProc->lastRunNs))
+            {
+                coldestProc = proc;
+            }
+        }
+
+        if (coldestProc == nullptr)
+        {
+            break;
+        }
+
+        srcQueue.procs.remove(coldestProc);
+        coldestProc->cpuIdx = cpuIdx;
+        dstQueue.procs.add(coldestProc);
+        ++numMoved;
+    }
+
+    secondQueue.lock.release();
+    firstQueue.lock.release();
+
+    return numMoved;
+}
+
+void ProcessMgr::balanceLoad()
+{
+    RunQueue& queue = getRunQueue();
+    unsigned int cpuIdx = Cpu::getCurrent()->index;
+    uint64_t now = Clock::getNs();
+
+    size_t load = getLoad(cpuIdx);
+    if (load > 0 && now < queue.nextBalanceNs)
+    {
+        return;
+    }
+    queue.nextBalanceNs = now + BALANCE_INTERVAL_NS;
+
+    unsigned int busiestIdx = findBusiestProcessor();
+    if (busiestIdx == cpuIdx)
+    {
+        return;
+    }
+
+    if (load == 0)
+    {
+        // a processor with nothing to run steals half of the busiest
+        // processor's waiting processes, hot or not
+        size_t numWaiting = getNumWaiting(busiestIdx);
+        pullProcesses(busiestIdx, (numWaiting + 1) / 2, 0);
     }
     else
     {
-        return nullptr;
+        // even out the load, but leave processes whose cache is still hot
+        // on the processor they ran on
+        size_t busiestLoad = getLoad(busiestIdx);
+        if (busiestLoad >= load + 2)
+        {
+            pullProcesses(busiestIdx, (busiestLoad - load) / 2, CACHE_HOT_NS);
+        }
     }
 }
 
+ProcessMgr::ProcessInfo* ProcessMgr::getNextScheduledProcess()
+{
+    balanceLoad();
+
+    RunQueue& queue = getRunQueue();
+    queue.lock.acquire();
+
+    ProcessInfo* proc = nullptr;
+    size_t load = 0;
+    if (queue.procs.getSize() > 0)
+    {
+        queue.currentIdx = (queue.currentIdx >= queue.procs.getSize() - 1) ? 0 : queue.currentIdx + 1;
+        proc = queue.procs[queue.currentIdx];
+        load = countRunnable(queue);
+    }
+
+    // the process is the running process before the lock is released, so
+    // no other processor takes it
+    queue.runningProc = proc;
+    queue.isIdle = (proc == nullptr);
+
+    queue.lock.release();
+
+    // let an idle processor steal the processes left waiting here
+    if (load > 1)
+    {
+        wakeIdleProcessor();
+    }
+
+    return proc;
+}
+
+ProcessMgr::ProcessInfo* ProcessMgr::waitForProcess()
+{
+    // scheduling doesn't need the kernel lock, so the other processors can
+    // run kernel code meanwhile
+    KernelLock::release();
+
+    ProcessInfo* proc = getNextScheduledProcess();
+    if (proc == nullptr)
+    {
+        // nothing runs until an interrupt unblocks a process, so the timer
+        // doesn't need to interrupt (the timer needs the kernel lock)
+        KernelLock::acquire();
+        os::Timer::stopTimeSlice();
+        KernelLock::release();
+
+        // a processor that looked for an idle processor before this one was
+        // marked idle didn't interrupt it, so look for processes to steal
+        // again before halting
+        proc = getNextScheduledProcess();
+        while (proc == nullptr)
+        {
+            // sti only takes effect after hlt, so an interrupt can't be
+            // missed between them
+            asm volatile ("sti; hlt; cli");
+            proc = getNextScheduledProcess();
+        }
+    }
+
+    KernelLock::acquire();
+
+    return proc;
+}
+
 void ProcessMgr::executeAction(EAction action, ProcessInfo* process)
 {
-    procAction = action;
-    actionProc = process;
+    RunQueue& queue = getRunQueue();
+    queue.procAction = action;
+    queue.actionProc = process;
 
     // switch to kernel
     switchToKernelFromProcess();
@@ -970,25 +1653,29 @@ void ProcessMgr::executeAction(EAction action, ProcessInfo* process)
 void ProcessMgr::switchToKernelFromProcess()
 {
     // don't try to switch processes while we're in the kernel
-    intSwitchEnabled = false;
+    getRunQueue().intSwitchEnabled = false;
 
     // switch to kernel
-    switchToProcessStack(kernelStack, &getCurrentProcessInfo()->stack);
+    Cpu* cpu = Cpu::getCurrent();
+    switchToProcessStack(cpu->kernelStack, &cpu->process->stack);
 
-    // we're back from the kernel, enable process switching again
-    intSwitchEnabled = true;
+    // we're back from the kernel, possibly on another processor, so enable
+    // process switching again on the processor we're on now
+    getRunQueue().intSwitchEnabled = true;
 }
 
 void ProcessMgr::switchToProcessFromKernel(ProcessInfo* procInfo)
 {
     // switch to process's page directory
-    setPageDirectory(procInfo->pageDir.physicalAddr);
+    Cpu::switchPageDirectory(procInfo->pageDir.physicalAddr);
 
     // set the kernel stack for the process
     setKernelStack(ProcessInfo::KERNEL_STACK_START);
 
     // switch to process
-    switchToProcessStack(procInfo->stack, &kernelStack);
+    Cpu* cpu = Cpu::getCurrent();
+    cpu->process = procInfo;
+    switchToProcessStack(procInfo->stack, &cpu->kernelStack);
 }
 
 void ProcessMgr::cleanUpProcess(ProcessInfo* procInfo)
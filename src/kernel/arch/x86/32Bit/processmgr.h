@@ -8,10 +8,12 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include "acpi.h"
 #include "paging.h"
 #include "set.hpp"
+#include "spinlock.h"
+#include "timerwheel.h"
 
-struct multiboot_mod_list;
 class PageFrameMgr;
 
 /**
@@ -30,6 +32,13 @@ public:
         constexpr static int MAX_NUM_PAGES = 8;
         constexpr static size_t MAX_NUM_CHILDREN = 32;
         constexpr static int MAX_NUM_STREAM_INDICES = 8;
+        constexpr static int MAX_NUM_MAPPINGS = 4;
+
+        /// virtual address of the start of the memory mapping region
+        constexpr static uintptr_t MAPPING_VIRTUAL_START = 0x0020'0000;
+
+        /// virtual address of the end of the memory mapping region
+        constexpr static uintptr_t MAPPING_VIRTUAL_END = 0x0040'0000;
 
         /// virtual address of the kernel stack page
         static const uintptr_t KERNEL_STACK_PAGE;
@@ -37,9 +46,6 @@ public:
         /// virtual address of the user stack page
         static const uintptr_t USER_STACK_PAGE;
 
-        /// the ProcessInfo instance for the current process
-        static ProcessInfo** PROCESS_INFO;
-
         /// the start address of the kernel stack page
         static const uintptr_t KERNEL_STACK_START;
 
@@ -52,6 +58,9 @@ public:
 
             /// The process has been terminated.
             eTerminated,
+
+            /// The process is waiting for an event.
+            eBlocked,
         };
 
         struct PageFrameInfo
@@ -68,6 +77,16 @@ public:
             } type;
         };
 
+        /**
+         * @brief Memory that is mapped into the process's address space but
+         * not owned by the process (e.g. a file mapped with mmap).
+         */
+        struct MemoryMapping
+        {
+            uintptr_t virtualAddr;
+            size_t numPages;
+        };
+
         /// Process's parent process.
         ProcessInfo* parentProcess;
 
@@ -97,6 +116,8 @@ public:
 
         EStatus getStatus() const;
 
+        void setStatus(EStatus newStatus);
+
         int addStreamIndex(int masterStreamIdx);
 
         void removeStreamIndex(int procStreamIdx);
@@ -109,6 +130,18 @@ public:
 
         int duplicateStreamIndex(int procStreamIdx, int dupProcStreamIdx);
 
+        bool addMapping(const MemoryMapping& mapping);
+
+        bool removeMapping(uintptr_t virtualAddr, size_t numPages, MemoryMapping& mapping);
+
+        MemoryMapping getMapping(int i) const;
+
+        int getNumMappings() const;
+
+        void clearMappings();
+
+        void copyMappings(ProcessInfo* procInfo);
+
         PageFrameInfo pageDir;
 
         PageFrameInfo kernelPageTable;
@@ -126,6 +159,24 @@ public:
             pid_t pid;
         } actionResult;
 
+        /// wakes the process from a sleep or a timed wait
+        SoftTimer sleepTimer;
+
+        /// terminates the process (alarm())
+        SoftTimer alarmTimer;
+
+        /// whether the alarm went off; the process is terminated at the
+        /// next safe point
+        bool alarmExpired;
+
+        /// the index of the processor whose run queue the process is in,
+        /// which is the processor it last ran on once it has run
+        unsigned int cpuIdx;
+
+        /// when the process last stopped running on the Clock; its cache
+        /// is assumed to be cold on other processors after a while
+        uint64_t lastRunNs;
+
     private:
         /// Unique ID for the process.
         pid_t id;
@@ -138,8 +189,13 @@ public:
         /// to the kernel's stream table.
         int streamIndices[MAX_NUM_STREAM_INDICES];
 
+        /// Memory mapped into the process's address space.
+        MemoryMapping mappings[MAX_NUM_MAPPINGS];
+
         int numPages;
 
+        int numMappings;
+
         EStatus status;
     };
 
@@ -153,12 +209,19 @@ public:
 
     void setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr);
 
-    void setMultibootInfo(const multiboot_info* multibootInfo);
-
+    /**
+     * @brief Start the init process and run processes on the boot
+     * processor.
+     */
     void mainloop();
 
+    /**
+     * @brief Run processes on an application processor once it has started.
+     */
+    void apMainloop();
+
     /// @todo make this private
-    void createProcess(const multiboot_mod_list* module, int stdinStreamIdx, int stdoutStreamIdx, int stderrStreamIdx);
+    bool createProcess(const char* path, int stdinStreamIdx, int stdoutStreamIdx, int stderrStreamIdx);
 
     pid_t forkCurrentProcess();
 
@@ -169,31 +232,126 @@ public:
 
     void yieldCurrentProcess();
 
+    /**
+     * @brief Block the current process until unblockProcess() is called.
+     * @details Interrupts must be disabled when calling this, so an
+     * interrupt cannot unblock the process before it is blocked.
+     */
+    void blockCurrentProcess();
+
+    /**
+     * @brief Make a blocked process runnable again on the processor it last
+     * ran on. Safe to call from an interrupt handler.
+     */
+    void unblockProcess(ProcessInfo* procInfo);
+
+    /**
+     * @brief Whether the caller is running on a process's kernel stack (as
+     * opposed to the kernel's boot stack).
+     */
+    bool isInProcess() const;
+
     void exitCurrentProcess(int exitCode);
 
     void cleanUpCurrentProcessChild(ProcessInfo* childProc);
 
-    void processTimerInterrupt(const registers* regs);
+    /**
+     * @brief Block the current process until the Clock reaches a deadline.
+     * @details Interrupts must be disabled when calling this. The sleep ends
+     * early if the process's alarm goes off.
+     * @param deadlineNs The deadline on the Clock in nanoseconds.
+     */
+    void sleepCurrentProcess(uint64_t deadlineNs);
+
+    /**
+     * @brief Set or cancel the current process's alarm. The process is
+     * terminated when the alarm goes off.
+     * @param deadlineNs The deadline on the Clock in nanoseconds, or 0 to
+     * cancel the alarm.
+     * @return The time that was left on the previous alarm in nanoseconds,
+     * or 0 if no alarm was set.
+     */
+    uint64_t setCurrentProcessAlarm(uint64_t deadlineNs);
+
+    /**
+     * @brief Terminate the current process if its alarm went off.
+     * @details Called where the process can safely be terminated: when it
+     * returns from a system call or is interrupted in user mode.
+     */
+    void checkCurrentProcessAlarm();
+
+    /**
+     * @brief Map physical memory read-only into the current process's
+     * address space.
+     * @param physicalAddr The physical address of the memory (must be page
+     * aligned).
+     * @param numPages The number of pages to map.
+     * @return The virtual address of the mapping or 0 if the memory could
+     * not be mapped.
+     */
+    uintptr_t mapCurrentProcessMemory(uintptr_t physicalAddr, size_t numPages);
+
+    /**
+     * @brief Unmap memory that was mapped with mapCurrentProcessMemory().
+     * @details Mappings can't be split, so the range must be a whole
+     * mapping.
+     * @param virtualAddr The virtual address of the start of the mapping.
+     * @param numPages The number of pages in the mapping.
+     * @return true if the memory was unmapped; false, otherwise
+     */
+    bool unmapCurrentProcessMemory(uintptr_t virtualAddr, size_t numPages);
+
+    /**
+     * @brief Handle a timer interrupt.
+     * @param regs The interrupted code's registers.
+     * @param timeSliceEnded Whether the current process's time slice ended.
+     */
+    void processTimerInterrupt(const registers* regs, bool timeSliceEnded);
 
     /**
      * @brief Get the ProcessInfo for calling process.
      */
     ProcessInfo* getCurrentProcessInfo();
 
-    uint32_t getNumModules() const;
+    /**
+     * @brief Get the kernel page table used by the current page directory.
+     * @details Each process has its own copy of the kernel page table, so
+     * temporary kernel mappings must be made in this table to be visible.
+     */
+    uint32_t* getActiveKernelPageTable();
 
-    bool getModuleName(uint32_t index, char* name) const;
+    /**
+     * @brief Temporarily map a page frame in the active kernel page table.
+     * @return The virtual address of the page, or nullptr if the page could
+     * not be mapped.
+     */
+    uint8_t* mapTempPage(uintptr_t physicalAddr);
+
+    /**
+     * @brief Unmap a page mapped with mapTempPage().
+     */
+    void unmapTempPage(uint8_t* page);
 
 private:
     constexpr static int MAX_NUM_PROCESSES = 32;
-    ProcessInfo processes[MAX_NUM_PROCESSES];
 
-    Set<ProcessInfo*, MAX_NUM_PROCESSES> runningProcs;
+    /// how often a processor checks whether it should pull processes from
+    /// a busier processor
+    constexpr static uint64_t BALANCE_INTERVAL_NS = 10'000'000;
+
+    /// how long after a process ran its cache is assumed to be hot; load
+    /// balancing only moves processes that haven't run for this long
+    constexpr static uint64_t CACHE_HOT_NS = 500'000;
 
-    size_t currentProcIdx;
+    /// how long to wait before trying to switch processes again when the
+    /// time slice ended during a tasklet
+    constexpr static uint64_t TASKLET_RETRY_NS = 1'000'000;
 
-    /// whether interrupt process switching is enabled
-    bool intSwitchEnabled;
+    /// the exit code of a process terminated by its alarm (shells report
+    /// 128 plus the signal number for SIGALRM)
+    constexpr static int ALARM_EXIT_CODE = 128 + 14;
+
+    ProcessInfo processes[MAX_NUM_PROCESSES];
 
     enum class EAction
     {
@@ -208,27 +366,69 @@ private:
 
         /// exit a process
         eExit,
+
+        /// block a process
+        eBlock,
     };
 
-    /// the page frame manager
-    PageFrameMgr* pageFrameMgr;
+    /**
+     * @brief A processor's scheduling state.
+     * @details The processors schedule without the kernel lock, so procs,
+     * currentIdx, runningProc, and isIdle are protected by the queue's own
+     * lock. Two queues are locked in the order of their processors'
+     * indices. The rest is only used by the queue's processor.
+     */
+    struct RunQueue
+    {
+        SpinLock lock;
+
+        /// the runnable processes, including the one running
+        Set<ProcessInfo*, MAX_NUM_PROCESSES> procs;
+
+        size_t currentIdx;
 
-    /// the multiboot info
-    const multiboot_info* mbootInfo;
+        /// the process the processor is running, or nullptr while the
+        /// processor is in the main loop (processes are only moved to
+        /// other processors while they don't run)
+        ProcessInfo* runningProc;
 
-    /// the kernel stack before switching to a process
-    uintptr_t kernelStack;
+        /// whether interrupt process switching is enabled
+        bool intSwitchEnabled;
 
-    /// an action to perform on a process
-    EAction procAction;
+        /// an action to perform on a process
+        EAction procAction;
+
+        /// the process to perform the action on
+        ProcessInfo* actionProc;
+
+        /// whether the processor has nothing to run and waits for an
+        /// interrupt (this is read without the lock to find an idle
+        /// processor)
+        volatile bool isIdle;
+
+        /// when the processor next balances its load on the Clock
+        uint64_t nextBalanceNs;
+    };
 
-    /// the process to perform the action on
-    ProcessInfo* actionProc;
+    /// the processors' run queues
+    RunQueue runQueues[MadtInfo::MAX_NUM_CPUS];
+
+    /// the page frame manager
+    PageFrameMgr* pageFrameMgr;
+
+    /**
+     * @brief Open an executable file.
+     * @param path The executable's path.
+     * @param [out] exeSize The size of the executable in bytes.
+     * @return The executable's index in the stream table, or -1 if it could
+     * not be opened.
+     */
+    int openExecutable(const char* path, size_t& exeSize);
 
     /**
-     * @brief Find the multiboot module with the given name.
+     * @brief Read an executable into the current process's code pages.
      */
-    bool findModule(const char* name, const multiboot_mod_list*& module);
+    bool readExecutable(int streamIdx, size_t exeSize);
 
     /**
      * @brief Fork the given process.
@@ -278,7 +478,12 @@ private:
      * @brief Set up the program for the process by copying the
      * code and setting up the stack.
      */
-    bool setUpProgram(const multiboot_mod_list* module, ProcessInfo* newProcInfo);
+    bool setUpProgram(int exeStreamIdx, size_t exeSize, ProcessInfo* newProcInfo);
+
+    /**
+     * @brief Unmap all memory mappings from a process.
+     */
+    void unmapProcessMappings(ProcessInfo* procInfo);
 
     /**
      * @brief Copy code and stack pages from one process to another.
@@ -291,10 +496,97 @@ private:
     pid_t getNewId();
 
     /**
-     * @brief Get the next scheduled process.
+     * @brief Run processes on the calling processor.
+     * @param proc The process to run first, or nullptr.
+     */
+    void loop(ProcessInfo* proc);
+
+    /**
+     * @brief Get the calling processor's run queue.
+     */
+    RunQueue& getRunQueue();
+
+    /**
+     * @brief Add a process to a processor's run queue, and interrupt the
+     * processor if it is idle. No run queue lock may be held.
+     */
+    void enqueueProcess(ProcessInfo* procInfo, unsigned int cpuIdx);
+
+    /**
+     * @brief Interrupt an idle processor, so it steals processes from the
+     * busiest processor. Another processor may become idle meanwhile, so
+     * this is only a hint.
+     */
+    void wakeIdleProcessor();
+
+    /**
+     * @brief Get the number of runnable processes in a processor's run
+     * queue, including the one it is running.
+     */
+    size_t getLoad(unsigned int cpuIdx);
+
+    /**
+     * @brief Get the number of processes in a processor's run queue that
+     * are waiting to run (i.e. that could be moved to another processor).
+     */
+    size_t getNumWaiting(unsigned int cpuIdx);
+
+    /**
+     * @brief Count the runnable processes in a run queue. The queue must be
+     * locked.
+     */
+    size_t countRunnable(const RunQueue& queue) const;
+
+    /**
+     * @brief Get the processor with the lowest load, preferring the given
+     * processor when there is a tie. The loads may have changed by the
+     * time this returns.
+     */
+    unsigned int findLeastLoadedProcessor(unsigned int preferredIdx);
+
+    /**
+     * @brief Get the other processor with the most waiting processes.
+     * @return The processor's index, or the calling processor's index if no
+     * other processor has waiting processes.
+     */
+    unsigned int findBusiestProcessor();
+
+    /**
+     * @brief Move waiting processes from another processor's run queue to
+     * the calling processor's, the ones that ran least recently first.
+     * Both queues are locked while the processes are moved.
+     * @param srcIdx The processor to take processes from.
+     * @param maxNumProcs The maximum number of processes to move.
+     * @param minIdleNs Only processes that haven't run for this long are
+     * moved.
+     * @return The number of processes moved.
+     */
+    size_t pullProcesses(unsigned int srcIdx, size_t maxNumProcs, uint64_t minIdleNs);
+
+    /**
+     * @brief Balance the calling processor's load: steal half of the
+     * busiest processor's waiting processes if the processor has nothing to
+     * run, and periodically pull cache-cold processes from a processor with
+     * more load.
+     */
+    void balanceLoad();
+
+    /**
+     * @brief Get the next scheduled process on the calling processor, and
+     * make it the running process. This doesn't need the kernel lock.
+     * @return The process, or nullptr if there is nothing to run, in which
+     * case the processor is marked idle, so the next process enqueued for
+     * it sends it an interrupt.
      */
     ProcessInfo* getNextScheduledProcess();
 
+    /**
+     * @brief Wait with the kernel lock released until the calling processor
+     * has a process to run.
+     * @return The process, which is the running process.
+     */
+    ProcessInfo* waitForProcess();
+
     /**
      * @brief Execute an action.
      */
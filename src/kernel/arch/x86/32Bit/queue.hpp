@@ -11,10 +11,15 @@
  * long as one thread only calls enqueue() and the other thread only calls
  * dequeue(). It is NOT thread-safe if each thread makes calls to both
  * enqueue() and dequeue().
+ * @details The queue is a ring buffer whose size is a power of two. The
+ * head and tail are free-running counters that are masked to index the
+ * array, so each one is only written by one side.
  */
 template<typename T, size_t MAX_SIZE>
 class Queue
 {
+    static_assert(MAX_SIZE > 0 && (MAX_SIZE & (MAX_SIZE - 1)) == 0, "Queue size must be a power of two");
+
 public:
     Queue();
 
@@ -35,10 +40,24 @@ public:
     void print();
 
 private:
+    static constexpr size_t INDEX_MASK = MAX_SIZE - 1;
+
     T array[MAX_SIZE];
-    size_t head;
-    size_t tail;
-    size_t size;
+
+    /// number of items dequeued
+    volatile size_t head;
+
+    /// number of items enqueued
+    volatile size_t tail;
+
+    /**
+     * @brief Keep the compiler from moving array accesses past an update to
+     * the head or tail.
+     */
+    static void publish()
+    {
+        asm volatile ("" : : : "memory");
+    }
 };
 
 template<typename T, size_t MAX_SIZE>
@@ -46,25 +65,24 @@ Queue<T, MAX_SIZE>::Queue()
 {
     head = 0;
     tail = 0;
-    size = 0;
 }
 
 template<typename T, size_t MAX_SIZE>
 size_t Queue<T, MAX_SIZE>::getSize() const
 {
-    return size;
+    return tail - head;
 }
 
 template<typename T, size_t MAX_SIZE>
 bool Queue<T, MAX_SIZE>::isEmpty() const
 {
-    return size == 0;
+    return tail == head;
 }
 
 template<typename T, size_t MAX_SIZE>
 bool Queue<T, MAX_SIZE>::isFull() const
 {
-    return size == MAX_SIZE;
+    return tail - head == MAX_SIZE;
 }
 
 template<typename T, size_t MAX_SIZE>
@@ -75,13 +93,9 @@ bool Queue<T, MAX_SIZE>::enqueue(T item)
         return false;
     }
 
-    array[tail] = item;
+    array[tail & INDEX_MASK] = item;
+    publish();
     ++tail;
-    if (tail >= MAX_SIZE)
-    {
-        tail = 0;
-    }
-    ++size;
 
     return true;
 }
@@ -90,23 +104,22 @@ template<typename T, size_t MAX_SIZE>
 size_t Queue<T, MAX_SIZE>::enqueue(const T* buff, size_t buffSize)
 {
     size_t numToEnqueue = buffSize;
-    size_t sizeAvailable = MAX_SIZE - size;
+    size_t sizeAvailable = MAX_SIZE - getSize();
     if (numToEnqueue > sizeAvailable)
     {
         numToEnqueue = sizeAvailable;
     }
 
+    size_t idx = tail;
     for (size_t i = 0; i < numToEnqueue; ++i)
     {
-        array[tail] = buff[i];
-        ++tail;
-        if (tail >= MAX_SIZE)
-        {
-            tail = 0;
-        }
+        array[idx & INDEX_MASK] = buff[i];
+        ++idx;
     }
 
-    size += numToEnqueue;
+    // publish the items after they have been copied
+    publish();
+    tail = idx;
 
     return numToEnqueue;
 }
@@ -119,13 +132,9 @@ bool Queue<T, MAX_SIZE>::dequeue(T& item)
         return false;
     }
 
-    item = array[head];
+    item = array[head & INDEX_MASK];
+    publish();
     ++head;
-    if (head >= MAX_SIZE)
-    {
-        head = 0;
-    }
-    --size;
 
     return true;
 }
@@ -134,22 +143,22 @@ template<typename T, size_t MAX_SIZE>
 size_t Queue<T, MAX_SIZE>::dequeue(T* buff, size_t buffSize)
 {
     size_t numToDequeue = buffSize;
+    size_t size = getSize();
     if (numToDequeue > size)
     {
         numToDequeue = size;
     }
 
+    size_t idx = head;
     for (size_t i = 0; i < numToDequeue; ++i)
     {
-        buff[i] = array[head];
-        ++head;
-        if (head >= MAX_SIZE)
-        {
-            head = 0;
-        }
+        buff[i] = array[idx & INDEX_MASK];
+        ++idx;
     }
 
-    size -= numToDequeue;
+    // free the items after they have been copied
+    publish();
+    head = idx;
 
     return numToDequeue;
 }
@@ -157,22 +166,15 @@ size_t Queue<T, MAX_SIZE>::dequeue(T* buff, size_t buffSize)
 template<typename T, size_t MAX_SIZE>
 void Queue<T, MAX_SIZE>::print()
 {
-    if (size == 0)
+    if (isEmpty())
     {
         ulog.log("<empty>\n");
     }
     else
     {
-        size_t idx = head;
-        for (size_t i = 0; i < size; ++i)
+        for (size_t idx = head; idx != tail; ++idx)
         {
-            ulog.log("{} ", array[idx]);
-
-            ++idx;
-            if (idx >= MAX_SIZE)
-            {
-                idx = 0;
-            }
+            ulog.log("{} ", array[idx & INDEX_MASK]);
         }
         ulog.log("\n");
     }
@@ -1,26 +1,46 @@
+#include <fcntl.h>
 #include <string.h>
 #include "filesystem.h"
 #include "rootfilesystem.h"
 #include "stream.h"
 #include "streamtable.h"
 
+namespace
+{
+
+/**
+ * @brief Skip the leading slashes in a path.
+ */
+const char* skipSlashes(const char* path)
+{
+    while (*path == '/')
+    {
+        ++path;
+    }
+
+    return path;
+}
+
+} // namespace
+
 RootFileSystem::RootFileSystem()
 {
     numFileSystems = 0;
-    memset(fileSystems, 0, sizeof(fileSystems));
+    memset(mountPoints, 0, sizeof(mountPoints));
 }
 
-void RootFileSystem::addFileSystem(FileSystem* fileSystem)
+void RootFileSystem::addFileSystem(const char* mountPath, FileSystem* fileSystem)
 {
     if (numFileSystems < MAX_NUM_FILE_SYSTEMS)
     {
-        fileSystems[numFileSystems++] = fileSystem;
+        mountPath = skipSlashes(mountPath);
+        mountPoints[numFileSystems++] = {mountPath, strlen(mountPath), fileSystem};
     }
 }
 
-int RootFileSystem::open(const char* path)
+int RootFileSystem::open(const char* path, int oflag)
 {
-    Stream* stream = openStream(path);
+    Stream* stream = openStream(path, oflag);
 
     // open the stream
     int streamIdx = -1;
@@ -43,25 +63,90 @@ void RootFileSystem::close(int streamIdx)
     streamTable.removeStreamReference(streamIdx);
 }
 
-Stream* RootFileSystem::openStream(const char* path)
+bool RootFileSystem::unlink(const char* path)
+{
+    const char* relativePath = nullptr;
+    FileSystem* fileSystem = findFileSystem(path, relativePath);
+    if (fileSystem == nullptr)
+    {
+        return false;
+    }
+
+    return fileSystem->unlink(relativePath);
+}
+
+size_t RootFileSystem::getDirEntries(const char* dirPath, size_t index, dirent* entries, size_t maxEntries)
+{
+    const char* relativePath = nullptr;
+    FileSystem* fileSystem = findFileSystem(dirPath, relativePath);
+    if (fileSystem == nullptr || *relativePath != '\0')
+    {
+        return 0;
+    }
+
+    return fileSystem->getDirEntries(index, entries, maxEntries);
+}
+
+Stream* RootFileSystem::openStream(const char* path, int oflag)
 {
-    Stream* stream = nullptr;
+    const char* relativePath = nullptr;
+    FileSystem* fileSystem = findFileSystem(path, relativePath);
+    if (fileSystem == nullptr)
+    {
+        return nullptr;
+    }
 
-    /// @todo looping through the file systems trying to open the file in
-    /// each one is not a good long-term solution
-    for (FileSystem* fileSystem : fileSystems)
+    // the path is the directory the file system is mounted at
+    if (*relativePath == '\0')
     {
-        if (fileSystem != nullptr)
+        if ( (oflag & (O_WRONLY | O_CREAT | O_TRUNC | O_APPEND)) != 0 )
+        {
+            return nullptr;
+        }
+
+        for (DirectoryStream& dirStream : dirStreams)
         {
-            stream = fileSystem->openStream(path);
-            if (stream != nullptr)
+            if (!dirStream.isOpen())
             {
-                break;
+                dirStream.open(fileSystem);
+                return &dirStream;
             }
         }
+
+        return nullptr;
     }
 
-    return stream;
+    return fileSystem->openStream(relativePath, oflag);
+}
+
+FileSystem* RootFileSystem::findFileSystem(const char* path, const char*& relativePath)
+{
+    path = skipSlashes(path);
+
+    const MountPoint* match = nullptr;
+    for (size_t i = 0; i < numFileSystems; ++i)
+    {
+        const MountPoint& mountPoint = mountPoints[i];
+
+        // the path must be in the mount directory, not just start with its name
+        size_t len = mountPoint.pathLength;
+        bool inMountDir = len == 0 ||
+                          (strncmp(path, mountPoint.path, len) == 0 && (path[len] == '\0' || path[len] == '/'));
+
+        if (inMountDir && (match == nullptr || len > match->pathLength))
+        {
+            match = &mountPoint;
+        }
+    }
+
+    if (match == nullptr)
+    {
+        return nullptr;
+    }
+
+    relativePath = skipSlashes(path + match->pathLength);
+
+    return match->fileSystem;
 }
 
 // init root file system
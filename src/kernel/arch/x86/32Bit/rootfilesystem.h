@@ -3,26 +3,71 @@
 
 #include <stddef.h>
 
+#include "directorystream.h"
+
 class FileSystem;
 class Stream;
+struct dirent;
 
 class RootFileSystem
 {
 public:
     RootFileSystem();
 
-    void addFileSystem(FileSystem* fileSystem);
+    /**
+     * @brief Mount a file system.
+     * @param mountPath The directory the file system is mounted at. An empty
+     * path mounts the file system at the root.
+     * @param fileSystem The file system.
+     */
+    void addFileSystem(const char* mountPath, FileSystem* fileSystem);
 
-    int open(const char* path);
+    int open(const char* path, int oflag);
 
     void close(int streamIdx);
 
+    bool unlink(const char* path);
+
+    /**
+     * @brief Read entries from a directory.
+     * @details Only the directories file systems are mounted at can be
+     * listed. The same directories can be opened to list them with a
+     * DirectoryStream.
+     * @param dirPath The directory's path.
+     * @param index The index of the first entry to read.
+     * @param [out] entries The entries.
+     * @param maxEntries The maximum number of entries to read.
+     * @return The number of entries read (0 at the end of the directory).
+     */
+    size_t getDirEntries(const char* dirPath, size_t index, dirent* entries, size_t maxEntries);
+
 private:
+    struct MountPoint
+    {
+        const char* path;
+        size_t pathLength;
+        FileSystem* fileSystem;
+    };
+
     static constexpr size_t MAX_NUM_FILE_SYSTEMS = 4;
-    FileSystem* fileSystems[MAX_NUM_FILE_SYSTEMS];
+    MountPoint mountPoints[MAX_NUM_FILE_SYSTEMS];
     size_t numFileSystems;
 
-    Stream* openStream(const char* path);
+    static constexpr size_t MAX_NUM_DIR_STREAMS = 8;
+    DirectoryStream dirStreams[MAX_NUM_DIR_STREAMS];
+
+    Stream* openStream(const char* path, int oflag);
+
+    /**
+     * @brief Find the file system a path is in.
+     * @details The file system mounted at the longest matching directory is
+     * used.
+     * @param path The absolute path.
+     * @param [out] relativePath The path relative to the file system's mount
+     * path.
+     * @return The file system, or nullptr if no file system matched.
+     */
+    FileSystem* findFileSystem(const char* path, const char*& relativePath);
 };
 
 extern RootFileSystem rootFileSystem;
@@ -1,11 +1,14 @@
+#include <errno.h>
+
 #include "irq.h"
 #include "serialportdriver.h"
 #include "system.h"
 
 SerialPortDriver* SerialPortDriver::instances[] = {nullptr, nullptr, nullptr, nullptr};
 unsigned int SerialPortDriver::numInstances = 0;
+Tasklet SerialPortDriver::bottomHalf(runBottomHalf, nullptr);
 
-SerialPortDriver::SerialPortDriver(uint16_t portAddr, unsigned int baudRate)
+SerialPortDriver::SerialPortDriver(uint16_t portAddr, unsigned int baudRate, RxTrigger rxTrigger)
 {
     init();
     if (numInstances >= MAX_NUM_INSTANCES)
@@ -16,6 +19,10 @@ SerialPortDriver::SerialPortDriver(uint16_t portAddr, unsigned int baudRate)
 
     // save port
     port = portAddr;
+    intEnable = IER_RECEIVE_AVAIL;
+    intMasked = false;
+    inputHandler = nullptr;
+    inputHandlerData = nullptr;
 
     // calculate baud divisor
     unsigned int baudDivisor = 1;
@@ -42,9 +49,14 @@ SerialPortDriver::SerialPortDriver(uint16_t portAddr, unsigned int baudRate)
     outb(port + DLL, baudDivisorLo); // set baud divisor low byte
     outb(port + DLH, baudDivisorHi); // set baud divisor high byte
     outb(port + LCR, 0x03); // 8 bits, no parity, 1 stop bit
-    outb(port + FCR, 0x87); // enable FIFOs, clear them, 8-byte trigger threshold
+    outb(port + FCR, FIFO_ENABLE_AND_CLEAR | static_cast<uint8_t>(rxTrigger)); // enable FIFOs, clear them, set trigger threshold
     outb(port + MCR, 0x0b); // enable IRQs, set RTS/DTR
-    outb(port + IER, 0x03); // enable interrupts
+
+    // UARTs older than the 16550A don't have (working) FIFOs, so they can
+    // only be sent one byte at a time
+    txBurstSize = ( (inb(port + IIR) & FIFOS_ENABLED) == FIFOS_ENABLED ) ? FIFO_SIZE : 1;
+
+    outb(port + IER, intEnable); // enable interrupts
 }
 
 SerialPortDriver::~SerialPortDriver()
@@ -65,10 +77,24 @@ ssize_t SerialPortDriver::read(uint8_t* buff, size_t nbyte)
 {
     size_t num = inQ.dequeue(buff, nbyte);
 
-    if ( num == 0 && (inb(port + LSR) & 1) != 0 )
+    // bytes below the receive FIFO's trigger level may not have caused an
+    // interrupt yet
+    if (num == 0 && nbyte > 0)
+    {
+        bool intEnabled = isIntEnabled();
+        clearInt();
+        receive();
+        if (intEnabled)
+        {
+            setInt();
+        }
+
+        num = inQ.dequeue(buff, nbyte);
+    }
+
+    if (num == 0 && nbyte > 0)
     {
-        buff[0] = inb(port + RBR);
-        num = 1;
+        return -EAGAIN;
     }
 
     return static_cast<ssize_t>(num);
@@ -78,33 +104,52 @@ ssize_t SerialPortDriver::write(const uint8_t* buff, size_t nbyte)
 {
     size_t num = outQ.enqueue(buff, nbyte);
 
-    // if the output reg is empty, write a byte
+    // if the transmitter is idle, start it; otherwise, the bottom half sends
+    // the queued bytes when the transmit empty interrupt occurs
+    bool intEnabled = isIntEnabled();
+    clearInt();
     if ( (inb(port + LSR) & EMPTY_TRANS_HOLD_REG) != 0 )
     {
-        uint8_t value = 0;
-        bool avail = outQ.dequeue(value);
-        if (avail)
-        {
-            outb(port + THR, value);
-        }
+        transmit();
+    }
+    if (intEnabled)
+    {
+        setInt();
+    }
+
+    if (num == 0 && nbyte > 0)
+    {
+        return -EAGAIN;
     }
 
     return static_cast<ssize_t>(num);
 }
 
+WaitQueue* SerialPortDriver::getWaitQueue()
+{
+    return &waitQueue;
+}
+
+void SerialPortDriver::setInputHandler(InputHandler handler, void* data)
+{
+    inputHandler = handler;
+    inputHandlerData = data;
+}
+
 void SerialPortDriver::flush()
 {
     while (outQ.getSize() > 0)
     {
-        // if the output reg is empty, write a byte
-        if ( (inb(port + LSR) & EMPTY_TRANS_HOLD_REG) != 0 )
+        // if the transmit FIFO is empty, refill it
+        bool intEnabled = isIntEnabled();
+        clearInt();
+        if ( (inb(port + LSR) & EMPTY_TRANS_HOLD_REG) != 0 && transmit() )
         {
-            uint8_t value = 0;
-            bool avail = outQ.dequeue(value);
-            if (avail)
-            {
-                outb(port + THR, value);
-            }
+            waitQueue.wakeAll();
+        }
+        if (intEnabled)
+        {
+            setInt();
         }
     }
 }
@@ -127,30 +172,108 @@ void SerialPortDriver::interruptHandler(const registers* /*regs*/)
     for (unsigned int i = 0; i < numInstances; ++i)
     {
         SerialPortDriver* instance = instances[i];
-        instance->processInterrupt();
+        if (!instance->intMasked)
+        {
+            instance->intMasked = true;
+            outb(instance->port + IER, 0);
+        }
+    }
+
+    bottomHalf.schedule();
+}
+
+void SerialPortDriver::runBottomHalf(void* /*data*/)
+{
+    for (unsigned int i = 0; i < numInstances; ++i)
+    {
+        SerialPortDriver* instance = instances[i];
+        if (instance->intMasked)
+        {
+            instance->processInterrupt();
+        }
     }
 }
 
 void SerialPortDriver::processInterrupt()
 {
-    uint8_t iirVal = inb(port + IIR);
-    uint8_t intType = iirVal & INT_TYPE_MASK;
+    // read() only receives during a system call or from the input handler
+    // below, so the receive FIFO can be drained with interrupts enabled
+    bool received = receive();
+    bool wake = false;
+
+    clearInt();
 
-    if ( (iirVal & NO_PENDING_INT) == 0 )
+    if ( (inb(port + LSR) & EMPTY_TRANS_HOLD_REG) != 0 )
     {
-        if (intType == INT_RECEIVE_AVAIL || intType == INT_TIME_OUT_PENDING)
+        if (transmit())
         {
-            uint8_t value = inb(port + RBR);
-            inQ.enqueue(value);
+            wake = true;
         }
-        else if (intType == INT_TRANS_EMPTY)
+        else
         {
-            uint8_t value = 0;
-            bool avail = outQ.dequeue(value);
-            if (avail)
-            {
-                outb(port + THR, value);
-            }
+            // nothing left to send
+            intEnable &= ~IER_TRANS_EMPTY;
         }
     }
+
+    // the UART requests the IRQ again if more data arrived in the meantime
+    intMasked = false;
+    outb(port + IER, intEnable);
+
+    setInt();
+
+    // readers are woken for received data unless the input handler has
+    // nothing for them yet
+    if (received && (inputHandler == nullptr || inputHandler(inputHandlerData)))
+    {
+        wake = true;
+    }
+
+    if (wake)
+    {
+        waitQueue.wakeAll();
+    }
+}
+
+void SerialPortDriver::setIntEnable(uint8_t value)
+{
+    intEnable = value;
+
+    // the bottom half enables them when it's done
+    if (!intMasked)
+    {
+        outb(port + IER, intEnable);
+    }
+}
+
+bool SerialPortDriver::receive()
+{
+    bool received = false;
+
+    // drain the receive FIFO; if inQ is full, the bytes are dropped
+    while ( (inb(port + LSR) & DATA_READY) != 0 )
+    {
+        uint8_t value = inb(port + RBR);
+        inQ.enqueue(value);
+        received = true;
+    }
+
+    return received;
+}
+
+bool SerialPortDriver::transmit()
+{
+    uint8_t buff[FIFO_SIZE];
+    size_t num = outQ.dequeue(buff, txBurstSize);
+    for (size_t i = 0; i < num; ++i)
+    {
+        outb(port + THR, buff[i]);
+    }
+
+    if (num > 0 && (intEnable & IER_TRANS_EMPTY) == 0)
+    {
+        setIntEnable(intEnable | IER_TRANS_EMPTY);
+    }
+
+    return num > 0;
 }
@@ -6,6 +6,8 @@
 
 #include "queue.hpp"
 #include "stream.h"
+#include "tasklet.h"
+#include "waitqueue.h"
 
 struct registers;
 
@@ -69,6 +71,28 @@ public:
     /// Data can be transmitted
     static constexpr uint8_t EMPTY_TRANS_HOLD_REG = 0x20;
 
+    /// FIFO control register bits to enable the FIFOs and clear them
+    static constexpr uint8_t FIFO_ENABLE_AND_CLEAR = 0x07;
+
+    /// Interrupt identification register bits set when the FIFOs are enabled
+    static constexpr uint8_t FIFOS_ENABLED = 0xC0;
+
+    /// Size of the 16550's transmit and receive FIFOs
+    static constexpr unsigned int FIFO_SIZE = 16;
+
+    /**
+     * @brief The number of bytes in the receive FIFO that trigger a
+     * received data available interrupt. The values are the FIFO control
+     * register's trigger level bits.
+     */
+    enum class RxTrigger : uint8_t
+    {
+        e1Byte   = 0x00,
+        e4Bytes  = 0x40,
+        e8Bytes  = 0x80,
+        e14Bytes = 0xC0,
+    };
+
     /// Interrupt identification register interrupt type mask
     static constexpr uint8_t INT_TYPE_MASK = 0xE;
 
@@ -90,10 +114,25 @@ public:
     /// No interrupt is pending
     static constexpr uint8_t NO_PENDING_INT = 0x01;
 
+    /// Interrupt enable register bit for received data available interrupts
+    static constexpr uint8_t IER_RECEIVE_AVAIL = 0x01;
+
+    /// Interrupt enable register bit for transmitter holding register empty
+    /// interrupts
+    static constexpr uint8_t IER_TRANS_EMPTY = 0x02;
+
     /// UART clock rate
     static constexpr unsigned int CLOCK_RATE = 115'200;
 
-    SerialPortDriver(uint16_t portAddr, unsigned int baudRate);
+    /**
+     * @brief Constructor
+     * @param portAddr The UART's port address (e.g. COM1_PORT).
+     * @param baudRate The baud rate.
+     * @param rxTrigger The receive FIFO level that triggers an interrupt.
+     * Higher levels cause fewer interrupts. Bytes below the level are
+     * still received after the UART's character time-out.
+     */
+    SerialPortDriver(uint16_t portAddr, unsigned int baudRate, RxTrigger rxTrigger = RxTrigger::e8Bytes);
 
     ~SerialPortDriver();
 
@@ -111,6 +150,10 @@ public:
 
     ssize_t write(const uint8_t* buff, size_t nbyte) override;
 
+    WaitQueue* getWaitQueue() override;
+
+    void setInputHandler(InputHandler handler, void* data) override;
+
     void flush() override;
 
     void close() override
@@ -123,15 +166,71 @@ private:
     static SerialPortDriver* instances[MAX_NUM_INSTANCES];
     static unsigned int numInstances;
 
+    static constexpr size_t QUEUE_SIZE = 1024;
+
+    /// moves data between the UARTs and the queues
+    static Tasklet bottomHalf;
+
     uint16_t port;
-    Queue<uint8_t, 64> inQ;
-    Queue<uint8_t, 64> outQ;
+
+    /// The interrupts the UART should have enabled. The transmit empty
+    /// interrupt is only enabled while bytes are being sent, because
+    /// enabling it when the transmitter is idle raises it right away.
+    uint8_t intEnable;
+
+    /// whether the UART's interrupts are disabled until the bottom half runs
+    bool intMasked;
+
+    /// the number of bytes that can be written to THR when it is empty (1
+    /// if the UART does not have FIFOs)
+    unsigned int txBurstSize;
+
+    Queue<uint8_t, QUEUE_SIZE> inQ;
+    Queue<uint8_t, QUEUE_SIZE> outQ;
+
+    /// processes waiting for received data or for room in outQ
+    WaitQueue waitQueue;
+
+    /// processes received data as it arrives (see setInputHandler())
+    InputHandler inputHandler;
+    void* inputHandlerData;
 
     static void init();
 
+    /**
+     * @brief The top half. It disables the UARTs' interrupts, so they stop
+     * requesting the IRQ, and schedules the bottom half.
+     */
     static void interruptHandler(const registers* regs);
 
+    static void runBottomHalf(void* data);
+
+    /**
+     * @brief Receive and transmit data, and enable the UART's interrupts
+     * again.
+     */
     void processInterrupt();
+
+    /**
+     * @brief Set the interrupts the UART should have enabled. Interrupts must
+     * be disabled.
+     */
+    void setIntEnable(uint8_t value);
+
+    /**
+     * @brief Move bytes from the receive FIFO to inQ.
+     * @return true if any bytes were received.
+     */
+    bool receive();
+
+    /**
+     * @brief Move up to txBurstSize bytes from outQ to the transmit FIFO,
+     * and enable the transmit empty interrupt if any bytes were sent.
+     * @details The transmit FIFO must be empty. Interrupts must be disabled,
+     * so this doesn't race with the bottom half for outQ.
+     * @return true if any bytes were transmitted.
+     */
+    bool transmit();
 };
 
 #endif // SERIAL_PORT_DRIVER_H_
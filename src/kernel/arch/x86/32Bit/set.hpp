@@ -17,6 +17,8 @@ public:
 
     void clear();
 
+    bool contains(T item) const;
+
     T operator [](size_t idx) const;
 
 private:
@@ -62,6 +64,20 @@ void Set<T, MAX_SIZE>::clear()
     size = 0;
 }
 
+template<typename T, size_t MAX_SIZE>
+bool Set<T, MAX_SIZE>::contains(T item) const
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (array[i] == item)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 template<typename T, size_t MAX_SIZE>
 T Set<T, MAX_SIZE>::operator [](size_t idx) const
 {
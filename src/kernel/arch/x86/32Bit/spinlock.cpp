@@ -0,0 +1,33 @@
+#include "cpu.h"
+#include "spinlock.h"
+#include "system.h"
+
+void SpinLock::acquire()
+{
+    bool wasIntEnabled = isIntEnabled();
+    clearInt();
+
+    while (__atomic_exchange_n(&locked, 1, __ATOMIC_ACQUIRE) != 0)
+    {
+        // interrupts are disabled, so TLB shootdowns from the processor
+        // that holds the kernel lock are handled here
+        while (locked != 0)
+        {
+            Cpu::handleShootdown();
+            asm volatile ("pause");
+        }
+    }
+
+    intEnabled = wasIntEnabled;
+}
+
+void SpinLock::release()
+{
+    bool wasIntEnabled = intEnabled;
+    __atomic_store_n(&locked, 0, __ATOMIC_RELEASE);
+
+    if (wasIntEnabled)
+    {
+        setInt();
+    }
+}
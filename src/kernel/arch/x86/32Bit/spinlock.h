@@ -0,0 +1,36 @@
+#ifndef SPIN_LOCK_H_
+#define SPIN_LOCK_H_
+
+#include <stdint.h>
+
+/**
+ * @brief A lock that protects data shared by processors outside of the
+ * kernel lock (e.g. the run queues).
+ * @details Interrupts are disabled while the lock is held, since an
+ * interrupt handler on the same processor may try to acquire it. Code that
+ * holds a spin lock must not wait for the kernel lock.
+ */
+class SpinLock
+{
+public:
+    /**
+     * @brief Disable interrupts, and spin until the calling processor holds
+     * the lock.
+     */
+    void acquire();
+
+    /**
+     * @brief Release the lock, and enable interrupts again if they were
+     * enabled when it was acquired. Locks must be released in the reverse
+     * order they were acquired.
+     */
+    void release();
+
+private:
+    volatile uint32_t locked = 0;
+
+    /// whether interrupts were enabled when the holder acquired the lock
+    bool intEnabled = false;
+};
+
+#endif // SPIN_LOCK_H_
@@ -1,26 +1,186 @@
+#include <errno.h>
+
+#include "irq.h"
+#include "processmgr.h"
 #include "stream.h"
+#include "system.h"
+#include "tasklet.h"
+#include "waitqueue.h"
 
 ssize_t Stream::write(const uint8_t* buff, size_t nbyte, bool block)
 {
-    ssize_t rv = -1;
+    if (!block)
+    {
+        return write(buff, nbyte);
+    }
 
-    if (block)
+    // a process waits for room on the stream's wait queue; otherwise (e.g.
+    // in an interrupt handler, a tasklet, or the scheduler), writes are
+    // retried until they succeed
+    WaitQueue* waitQueue = nullptr;
+    if (processMgr.isInProcess() && !isInIrqHandler() && !Tasklet::isRunning() && !isPanicking())
     {
-        rv = write(buff, nbyte);
-        /// @todo Need to check if size_t can be cast to ssize_t
-        while (rv >= 0 && rv < static_cast<ssize_t>(nbyte))
-        {
-            /// @todo if this is being called from a process, we should probably yield here
+        waitQueue = getWaitQueue();
+    }
 
-            buff += rv;
-            nbyte -= rv;
-            rv = write(buff, nbyte);
+    // interrupts must be disabled between a failed write and waiting, so
+    // the wake up can't be missed
+    bool intEnabled = isIntEnabled();
+    if (waitQueue != nullptr)
+    {
+        clearInt();
+    }
+
+    size_t numWritten = 0;
+    ssize_t rv = 0;
+    while (numWritten < nbyte)
+    {
+        rv = write(buff + numWritten, nbyte - numWritten);
+        if (rv == -EAGAIN)
+        {
+            if (waitQueue != nullptr)
+            {
+                waitQueue->wait();
+            }
         }
+        else if (rv <= 0)
+        {
+            break;
+        }
+        else
+        {
+            numWritten += rv;
+        }
+    }
+
+    if (waitQueue != nullptr && intEnabled)
+    {
+        setInt();
     }
-    else
+
+    if (numWritten > 0 || nbyte == 0)
     {
-        rv = write(buff, nbyte);
+        return static_cast<ssize_t>(numWritten);
     }
 
     return rv;
 }
+
+ssize_t Stream::send(Stream* outStream, size_t nbyte)
+{
+    constexpr size_t BUFF_SIZE = 256;
+    uint8_t buff[BUFF_SIZE];
+
+    size_t numSent = 0;
+    ssize_t error = 0;
+    while (numSent < nbyte)
+    {
+        size_t num = (nbyte - numSent < BUFF_SIZE) ? nbyte - numSent : BUFF_SIZE;
+        ssize_t numRead = read(buff, num);
+        if (numRead <= 0)
+        {
+            error = numRead;
+            break;
+        }
+
+        ssize_t numWritten = outStream->write(buff, numRead, true);
+        if (numWritten < 0)
+        {
+            error = numWritten;
+            break;
+        }
+
+        numSent += numWritten;
+        if (numWritten < numRead)
+        {
+            break;
+        }
+    }
+
+    // an error is only reported if nothing was sent, and the end of the
+    // stream is 0
+    return (numSent == 0) ? error : static_cast<ssize_t>(numSent);
+}
+
+ssize_t Stream::sendAt(Stream* outStream, size_t nbyte, off_t offset)
+{
+    constexpr size_t BUFF_SIZE = 256;
+    uint8_t buff[BUFF_SIZE];
+
+    size_t numSent = 0;
+    ssize_t error = 0;
+    while (numSent < nbyte)
+    {
+        size_t num = (nbyte - numSent < BUFF_SIZE) ? nbyte - numSent : BUFF_SIZE;
+        ssize_t numRead = readAt(buff, num, offset + static_cast<off_t>(numSent));
+        if (numRead <= 0)
+        {
+            error = numRead;
+            break;
+        }
+
+        ssize_t numWritten = outStream->write(buff, numRead, true);
+        if (numWritten < 0)
+        {
+            error = numWritten;
+            break;
+        }
+
+        numSent += numWritten;
+        if (numWritten < numRead)
+        {
+            break;
+        }
+    }
+
+    return (numSent == 0) ? error : static_cast<ssize_t>(numSent);
+}
+
+ssize_t Stream::readAt(uint8_t* /*buff*/, size_t /*nbyte*/, off_t /*offset*/)
+{
+    return -ESPIPE;
+}
+
+WaitQueue* Stream::getWaitQueue()
+{
+    return nullptr;
+}
+
+uint64_t Stream::getReadTimeout() const
+{
+    return 0;
+}
+
+void Stream::setInputHandler(InputHandler /*handler*/, void* /*data*/)
+{
+}
+
+ssize_t Stream::getDirEntries(dirent* /*entries*/, size_t /*maxEntries*/)
+{
+    return -1;
+}
+
+bool Stream::getPhysicalMemory(uintptr_t& /*physicalAddr*/, size_t& /*size*/) const
+{
+    return false;
+}
+
+off_t Stream::seek(off_t /*offset*/, int /*whence*/)
+{
+    return -ESPIPE;
+}
+
+off_t Stream::size() const
+{
+    return -1;
+}
+
+int Stream::getTerminalAttributes(termios* /*attributes*/) const
+{
+    return -ENOTTY;
+}
+
+int Stream::setTerminalAttributes(int /*optionalActions*/, const termios* /*attributes*/)
+{
+    return -ENOTTY;
+}
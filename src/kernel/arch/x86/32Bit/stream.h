@@ -4,12 +4,22 @@
 #include <stdint.h>
 #include <unistd.h>
 
+class WaitQueue;
+struct dirent;
+struct termios;
+
 /**
  * @brief An abstract base class for reading and/or writing data.
  */
 class Stream
 {
 public:
+    /**
+     * @brief A function a device's bottom half calls when input arrives.
+     * @return Whether processes waiting to read should be woken.
+     */
+    using InputHandler = bool (*)(void* data);
+
     /**
      * @brief Whether this stream supports reading.
      * @return true if the stream supports reading.
@@ -26,12 +36,29 @@ public:
 
     /**
      * @brief Read from the stream.
+     * @details This is a non-blocking call. Devices return what is
+     * available, or -EAGAIN if no data is available yet.
+     * @param buff The buffer to read into.
+     * @param nbyte The size of the buffer in bytes.
+     * @return The number of bytes read (0 at the end of a file), or a number less than 0 if an error occurred.
      */
     virtual ssize_t read(uint8_t* buff, size_t nbyte) = 0;
 
+    /**
+     * @brief Read from a position in the stream without changing the
+     * stream's position.
+     * @details The default implementation is for streams that can't seek.
+     * @param buff The buffer to read into.
+     * @param nbyte The size of the buffer in bytes.
+     * @param offset The offset from the start of the stream to read from.
+     * @return The number of bytes read (0 at the end of a file), or a number less than 0 if an error occurred (-ESPIPE if the stream can't seek).
+     */
+    virtual ssize_t readAt(uint8_t* buff, size_t nbyte, off_t offset);
+
     /**
      * @brief Write to the stream.
-     * @details This is a non-blocking call.
+     * @details This is a non-blocking call. Devices write what fits in
+     * their buffers, or return -EAGAIN if nothing fits.
      * @param buff The data to write.
      * @param nbyte The number of bytes in the buffer.
      * @return The number of bytes written if successful, or a number less than 0 if an error occurred.
@@ -42,11 +69,123 @@ public:
      * @brief Write to the stream.
      * @param buff The data to write.
      * @param nbyte The number of bytes in the buffer.
-     * @param block Whether to block until all data has been written.
+     * @param block Whether to block until all data has been written. A
+     * process sleeps on the stream's wait queue while the stream is full.
      * @return The number of bytes written if successful, or a number less than 0 if an error occurred.
      */
     ssize_t write(const uint8_t* buff, size_t nbyte, bool block);
 
+    /**
+     * @brief Get the queue to wait on after read() or write() returned
+     * -EAGAIN.
+     * @details The queue is woken when the stream may have become readable
+     * or writable. The default implementation is for streams that never
+     * return -EAGAIN.
+     * @return The wait queue, or nullptr if the stream does not have one.
+     */
+    virtual WaitQueue* getWaitQueue();
+
+    /**
+     * @brief Get how long a blocking read waits for data before it returns
+     * no data.
+     * @details The default implementation is for streams that wait
+     * indefinitely.
+     * @return The timeout in nanoseconds, or 0 to wait indefinitely.
+     */
+    virtual uint64_t getReadTimeout() const;
+
+    /**
+     * @brief Pass input to a handler as it arrives (e.g. a terminal's line
+     * discipline), and only wake readers when the handler says so.
+     * @details The default implementation is for streams without a bottom
+     * half, whose input is only read in read().
+     * @param handler The handler, or nullptr to wake readers for all input.
+     * @param data The data to pass to the handler.
+     */
+    virtual void setInputHandler(InputHandler handler, void* data);
+
+    /**
+     * @brief Read from this stream and write the data to another stream.
+     * @details The default implementation copies the data through a small
+     * buffer. Streams whose data is in the page cache write it to the other
+     * stream straight from the cached pages.
+     * @param outStream The stream to write to.
+     * @param nbyte The number of bytes to send.
+     * @return The number of bytes sent, 0 at the end of the stream, or a number less than 0 if an error occurred before anything was sent (-EAGAIN if no data is available yet).
+     */
+    virtual ssize_t send(Stream* outStream, size_t nbyte);
+
+    /**
+     * @brief Send data from a position in this stream to another stream
+     * without changing this stream's position.
+     * @details The default implementation copies the data read with
+     * readAt() through a small buffer.
+     * @param outStream The stream to write to.
+     * @param nbyte The number of bytes to send.
+     * @param offset The offset from the start of this stream to send from.
+     * @return The number of bytes sent, 0 at the end of the stream, or a number less than 0 if an error occurred before anything was sent (-ESPIPE if the stream can't seek).
+     */
+    virtual ssize_t sendAt(Stream* outStream, size_t nbyte, off_t offset);
+
+    /**
+     * @brief Read entries from a directory, starting after the last entry
+     * read.
+     * @details The default implementation is for streams that are not
+     * directories.
+     * @param [out] entries The entries.
+     * @param maxEntries The maximum number of entries to read.
+     * @return The number of entries read (0 at the end of the directory), or a number less than 0 if the stream is not a directory.
+     */
+    virtual ssize_t getDirEntries(dirent* entries, size_t maxEntries);
+
+    /**
+     * @brief Get the physical memory that holds the stream's data.
+     * @details This is only supported by streams whose data is stored
+     * contiguously in memory and starts on a page boundary. The default
+     * implementation does not support it.
+     * @param [out] physicalAddr The physical address of the start of the data.
+     * @param [out] size The size of the data in bytes.
+     * @return true if the stream's data is in memory.
+     * @return false if the stream does not support this.
+     */
+    virtual bool getPhysicalMemory(uintptr_t& physicalAddr, size_t& size) const;
+
+    /**
+     * @brief Set the position the next read or write will start at.
+     * @details The default implementation does not support seeking.
+     * @param offset The offset relative to the position given by whence.
+     * @param whence SEEK_SET, SEEK_CUR, or SEEK_END.
+     * @return The new position from the start of the stream, or a number less than 0 if an error occurred (-ESPIPE if the stream can't seek).
+     */
+    virtual off_t seek(off_t offset, int whence);
+
+    /**
+     * @brief Get the size of the stream's data.
+     * @details The default implementation is for streams without a fixed
+     * size (e.g. devices).
+     * @return The size in bytes, or a number less than 0 if the stream does not have a size.
+     */
+    virtual off_t size() const;
+
+    /**
+     * @brief Get the stream's terminal attributes.
+     * @details The default implementation is for streams that are not
+     * terminals.
+     * @param [out] attributes The terminal attributes.
+     * @return 0 if successful, or a number less than 0 if the stream is not a terminal.
+     */
+    virtual int getTerminalAttributes(termios* attributes) const;
+
+    /**
+     * @brief Set the stream's terminal attributes.
+     * @details The default implementation is for streams that are not
+     * terminals.
+     * @param optionalActions TCSANOW, TCSADRAIN, or TCSAFLUSH.
+     * @param attributes The new terminal attributes.
+     * @return 0 if successful, or a number less than 0 if an error occurred.
+     */
+    virtual int setTerminalAttributes(int optionalActions, const termios* attributes);
+
     /**
      * @brief Flush any internal stream buffers.
      */
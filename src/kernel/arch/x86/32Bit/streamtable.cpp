@@ -10,6 +10,9 @@ StreamTable::StreamTable()
 
     // init all stream ref counts to 0
     memset(streamsRefCounts, 0, sizeof(streamsRefCounts));
+
+    // init all stream status flags to 0
+    memset(streamsStatusFlags, 0, sizeof(streamsStatusFlags));
 }
 
 int StreamTable::addStream(Stream* stream)
@@ -20,6 +23,7 @@ int StreamTable::addStream(Stream* stream)
         {
             streams[i] = stream;
             ++streamsRefCounts[i];
+            streamsStatusFlags[i] = 0;
             return i;
         }
     }
@@ -61,5 +65,23 @@ Stream* StreamTable::getStream(int streamIdx) const
     return nullptr;
 }
 
+int StreamTable::getStatusFlags(int streamIdx) const
+{
+    if (streamIdx >= 0 && streamIdx < MAX_NUM_STREAMS)
+    {
+        return streamsStatusFlags[streamIdx];
+    }
+
+    return 0;
+}
+
+void StreamTable::setStatusFlags(int streamIdx, int flags)
+{
+    if (streamIdx >= 0 && streamIdx < MAX_NUM_STREAMS)
+    {
+        streamsStatusFlags[streamIdx] = flags;
+    }
+}
+
 // create StreamTable instance
 StreamTable streamTable;
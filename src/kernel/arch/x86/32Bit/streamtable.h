@@ -18,11 +18,21 @@ public:
 
     Stream* getStream(int streamIdx) const;
 
+    /**
+     * @brief Get the file status flags (e.g. O_NONBLOCK) of an open stream.
+     * @details The flags are shared by every file descriptor that refers
+     * to the stream.
+     */
+    int getStatusFlags(int streamIdx) const;
+
+    void setStatusFlags(int streamIdx, int flags);
+
 private:
     constexpr static int MAX_NUM_STREAMS = 16;
 
     Stream* streams[MAX_NUM_STREAMS];
     size_t streamsRefCounts[MAX_NUM_STREAMS];
+    int streamsStatusFlags[MAX_NUM_STREAMS];
 };
 
 extern StreamTable streamTable;
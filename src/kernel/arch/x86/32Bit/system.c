@@ -12,6 +12,66 @@ void outb(uint16_t port, uint8_t value)
     __asm volatile ("outb %1, %0" : : "dN" (port), "a" (value));
 }
 
+uint16_t inw(uint16_t port)
+{
+    uint16_t rv;
+    __asm volatile ("inw %1, %0" : "=a" (rv) : "dN" (port));
+    return rv;
+}
+
+void outw(uint16_t port, uint16_t value)
+{
+    __asm volatile ("outw %1, %0" : : "dN" (port), "a" (value));
+}
+
+uint32_t inl(uint16_t port)
+{
+    uint32_t rv;
+    __asm volatile ("inl %1, %0" : "=a" (rv) : "dN" (port));
+    return rv;
+}
+
+void outl(uint16_t port, uint32_t value)
+{
+    __asm volatile ("outl %1, %0" : : "dN" (port), "a" (value));
+}
+
+void insw(uint16_t port, void* buff, size_t count)
+{
+    __asm volatile ("rep insw" : "+D" (buff), "+c" (count) : "d" (port) : "memory");
+}
+
+void outsw(uint16_t port, const void* buff, size_t count)
+{
+    __asm volatile ("rep outsw" : "+S" (buff), "+c" (count) : "d" (port) : "memory");
+}
+
+void cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx)
+{
+    __asm volatile ("cpuid" : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx) : "a" (leaf), "c" (0));
+}
+
+uint64_t readMsr(uint32_t msr)
+{
+    uint32_t lo;
+    uint32_t hi;
+    __asm volatile ("rdmsr" : "=a" (lo), "=d" (hi) : "c" (msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+void writeMsr(uint32_t msr, uint64_t value)
+{
+    __asm volatile ("wrmsr" : : "c" (msr), "a" ((uint32_t)value), "d" ((uint32_t)(value >> 32)));
+}
+
+uint64_t readTsc()
+{
+    uint32_t lo;
+    uint32_t hi;
+    __asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
 void __cxa_pure_virtual()
 {
     while (1);
@@ -1,9 +1,20 @@
 #include "kernellogger.h"
+#include "system.h"
 #include "userlogger.h"
 
+namespace
+{
+
+bool panicking = false;
+
+} // namespace
+
 extern "C"
 void panic(const char* file, unsigned long line, const char* function, const char* message)
 {
+    clearInt();
+    panicking = true;
+
     klog.logError("Panic", "Kernel panic!!!");
     klog.logError("Panic", "{}, line {}", file, line);
     klog.logError("Panic", function);
@@ -15,7 +26,17 @@ void panic(const char* file, unsigned long line, const char* function, const cha
              "{}\x1b[0m\n",
              file, line, function, message);
 
+    // interrupts are disabled, so wait for the devices to send the messages
+    klog.flushStream();
+    ulog.flushStreams();
+
     /// @todo What should we do here? Maybe hang in debug
     /// mode and reboot in release mode.
     while (true);
 }
+
+extern "C"
+bool isPanicking()
+{
+    return panicking;
+}
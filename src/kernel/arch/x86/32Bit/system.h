@@ -1,6 +1,8 @@
 #ifndef SYSTEM_H_
 #define SYSTEM_H_
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -27,6 +29,45 @@ uint8_t inb(uint16_t port);
 
 void outb(uint16_t port, uint8_t value);
 
+uint16_t inw(uint16_t port);
+
+void outw(uint16_t port, uint16_t value);
+
+uint32_t inl(uint16_t port);
+
+void outl(uint16_t port, uint32_t value);
+
+/**
+ * @brief Read words from a port into a buffer.
+ */
+void insw(uint16_t port, void* buff, size_t count);
+
+/**
+ * @brief Write words from a buffer to a port.
+ */
+void outsw(uint16_t port, const void* buff, size_t count);
+
+/**
+ * @brief Execute the CPUID instruction.
+ * @param leaf The value of EAX (the information to get).
+ */
+void cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx);
+
+/**
+ * @brief Read a model-specific register.
+ */
+uint64_t readMsr(uint32_t msr);
+
+/**
+ * @brief Write a model-specific register.
+ */
+void writeMsr(uint32_t msr, uint64_t value);
+
+/**
+ * @brief Read the time stamp counter.
+ */
+uint64_t readTsc();
+
 /**
  * @brief Clear global interrupt flag.
  */
@@ -37,6 +78,11 @@ void clearInt();
  */
 void setInt();
 
+/**
+ * @brief Whether the global interrupt flag is set.
+ */
+bool isIntEnabled();
+
 const void* getStackPointer();
 
 const void* getStackStart();
@@ -76,6 +122,12 @@ void panic(const char* file, unsigned long line, const char* function, const cha
 
 #define PANIC(message) panic(__FILE__, __LINE__, __PRETTY_FUNCTION__, message)
 
+/**
+ * @brief Whether panic() has been called. Code on the panic path must not
+ * sleep or switch processes.
+ */
+bool isPanicking();
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
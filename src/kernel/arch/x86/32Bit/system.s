@@ -27,6 +27,14 @@ setInt:
 	sti
 	ret
 
+global isIntEnabled
+isIntEnabled:
+	pushf
+	pop eax
+	and eax, INTERRUPT_FLAG
+	shr eax, 9
+	ret
+
 ; get the stack pointer
 global getStackPointer
 getStackPointer:
@@ -1,17 +1,122 @@
+#include "clock.h"
+#include "dirent.h"
+#include "errno.h"
 #include "fcntl.h"
+#include "filesystem.h"
+#include "kernellock.h"
 #include "keyboard.h"
+#include "paging.h"
 #include "processmgr.h"
 #include "rootfilesystem.h"
+#include "stream.h"
 #include "streamtable.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
 #include "sys/wait.h"
 #include "system.h"
 #include "systemcalls.h"
+#include "termios.h"
+#include "time.h"
+#include "timerwheel.h"
 #include "unistd.h"
 #include "unittests.h"
+#include "utils.h"
+#include "waitqueue.h"
+
+namespace
+{
+
+/**
+ * @brief Look up the stream for one of the current process's file descriptors.
+ */
+Stream* getStream(int fildes)
+{
+    // convert the local stream index to the master stream table index
+    int masterStreamIdx = processMgr.getCurrentProcessInfo()->getStreamIndex(fildes);
+    if (masterStreamIdx < 0)
+    {
+        return nullptr;
+    }
+
+    // look up the stream in the master stream table
+    return streamTable.getStream(masterStreamIdx);
+}
+
+/**
+ * @brief Whether one of the current process's file descriptors is in
+ * non-blocking mode.
+ */
+bool isNonBlocking(int fildes)
+{
+    int masterStreamIdx = processMgr.getCurrentProcessInfo()->getStreamIndex(fildes);
+    return (streamTable.getStatusFlags(masterStreamIdx) & O_NONBLOCK) != 0;
+}
+
+/**
+ * @brief Block the current process until a stream that returned -EAGAIN may
+ * be ready again.
+ * @details System calls run with interrupts disabled, so the stream cannot
+ * become ready between the failed call and waiting.
+ * @param deadlineNs When to stop waiting on the Clock, or 0 to wait
+ * indefinitely.
+ * @return false if the deadline passed; true, otherwise
+ */
+bool waitForStream(Stream* stream, uint64_t deadlineNs = 0)
+{
+    WaitQueue* waitQueue = stream->getWaitQueue();
+    if (waitQueue == nullptr)
+    {
+        processMgr.yieldCurrentProcess();
+        return deadlineNs == 0 || Clock::getNs() < deadlineNs;
+    }
+
+    if (deadlineNs == 0)
+    {
+        waitQueue->wait();
+        return true;
+    }
+
+    return waitQueue->wait(deadlineNs);
+}
+
+/**
+ * @brief Return an error from mmap.
+ * @details Mappings are below the kernel, so addresses that are negative
+ * as numbers are error numbers.
+ */
+void* mmapError(int error)
+{
+    return reinterpret_cast<void*>(static_cast<intptr_t>(-error));
+}
+
+} // namespace
 
 namespace systemcall
 {
 
+unsigned int alarm(unsigned int seconds)
+{
+    uint64_t deadline = (seconds > 0) ? Clock::getNs() + seconds * Clock::NS_PER_SEC : 0;
+    uint64_t remaining = processMgr.setCurrentProcessAlarm(deadline);
+
+    // round up, so a pending alarm isn't reported as no alarm
+    return (remaining + Clock::NS_PER_SEC - 1) / Clock::NS_PER_SEC;
+}
+
+int clock_gettime(clockid_t clock_id, timespec* tp)
+{
+    if (clock_id != CLOCK_MONOTONIC || tp == nullptr)
+    {
+        return -EINVAL;
+    }
+
+    uint64_t ns = Clock::getNs();
+    tp->tv_sec = ns / Clock::NS_PER_SEC;
+    tp->tv_nsec = ns % Clock::NS_PER_SEC;
+
+    return 0;
+}
+
 int close(int fildes)
 {
     int rv = -1;
@@ -66,14 +171,90 @@ pid_t fork()
     return processMgr.forkCurrentProcess();
 }
 
-int getNumModules()
+int fcntl(int fildes, int cmd, int arg)
 {
-    return processMgr.getNumModules();
+    int masterStreamIdx = processMgr.getCurrentProcessInfo()->getStreamIndex(fildes);
+    if (masterStreamIdx < 0)
+    {
+        return -EBADF;
+    }
+
+    int flags = streamTable.getStatusFlags(masterStreamIdx);
+    switch (cmd)
+    {
+    case F_GETFL:
+        return flags;
+
+    case F_SETFL:
+        // only O_NONBLOCK can be changed after a file has been opened
+        flags = (flags & ~O_NONBLOCK) | (arg & O_NONBLOCK);
+        streamTable.setStatusFlags(masterStreamIdx, flags);
+        return 0;
+
+    default:
+        return -EINVAL;
+    }
 }
 
-void getModuleName(int index, char* name)
+int fstat(int fildes, struct stat* buf)
 {
-    processMgr.getModuleName(index, name);
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
+    {
+        return -EBADF;
+    }
+
+    if (buf == nullptr)
+    {
+        return -EINVAL;
+    }
+
+    // streams without a size are devices
+    off_t size = stream->size();
+    if (size >= 0)
+    {
+        buf->st_mode = S_IFREG;
+        buf->st_size = size;
+    }
+    else
+    {
+        buf->st_mode = S_IFCHR;
+        buf->st_size = 0;
+    }
+
+    if (stream->canRead())
+    {
+        buf->st_mode |= S_IRUSR;
+    }
+    if (stream->canWrite())
+    {
+        buf->st_mode |= S_IWUSR;
+    }
+
+    return 0;
+}
+
+ssize_t getdents(int fildes, dirent* buf, size_t nbyte)
+{
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
+    {
+        return -EBADF;
+    }
+
+    size_t maxEntries = nbyte / sizeof(dirent);
+    if (maxEntries == 0)
+    {
+        return -EINVAL;
+    }
+
+    ssize_t numEntries = stream->getDirEntries(buf, maxEntries);
+    if (numEntries < 0)
+    {
+        return -ENOTDIR;
+    }
+
+    return numEntries * sizeof(dirent);
 }
 
 pid_t getpid()
@@ -86,49 +267,195 @@ pid_t getppid()
     return processMgr.getCurrentProcessInfo()->parentProcess->getId();
 }
 
-int open(const char *path, int oflag)
+off_t lseek(int fildes, off_t offset, int whence)
 {
-    /// @todo Support other modes besides read-only
-    if (oflag != O_RDONLY)
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
     {
-        return -1;
+        return -EBADF;
+    }
+
+    off_t rv = stream->seek(offset, whence);
+    if (rv < 0 && rv != -ESPIPE)
+    {
+        rv = -EINVAL;
     }
 
-    int fd = -1;
-    int masterStreamIdx = rootFileSystem.open(path);
+    return rv;
+}
 
-    if (masterStreamIdx >= 0)
+void* mmap(void* /*addr*/, size_t len, int prot, int flags, int fildes, off_t off)
+{
+    // only read-only mappings are supported, and the address hint is ignored
+    if ( (prot & PROT_WRITE) != 0 )
     {
-        fd = processMgr.getCurrentProcessInfo()->addStreamIndex(masterStreamIdx);
+        return mmapError(EACCES);
+    }
 
-        // close the stream if there was an error
-        if (fd < 0)
-        {
-            rootFileSystem.close(masterStreamIdx);
-        }
+    if ( (flags & MAP_FIXED) != 0 || len == 0 || off < 0 || (off & PAGE_SIZE_MASK) != 0 )
+    {
+        return mmapError(EINVAL);
     }
 
-    return fd;
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
+    {
+        return mmapError(EBADF);
+    }
+
+    // the stream's data must already be in memory to be mapped
+    uintptr_t physicalAddr = 0;
+    size_t size = 0;
+    if (!stream->getPhysicalMemory(physicalAddr, size))
+    {
+        return mmapError(ENODEV);
+    }
+
+    // the whole range must be in the stream's pages
+    size_t offset = static_cast<size_t>(off);
+    size_t mappedSize = align(size, PAGE_SIZE);
+    if (offset >= mappedSize || len > mappedSize - offset)
+    {
+        return mmapError(ENXIO);
+    }
+
+    size_t numPages = align(len, PAGE_SIZE) / PAGE_SIZE;
+    uintptr_t virtualAddr = processMgr.mapCurrentProcessMemory(physicalAddr + offset, numPages);
+    if (virtualAddr == 0)
+    {
+        return mmapError(ENOMEM);
+    }
+
+    return reinterpret_cast<void*>(virtualAddr);
 }
 
-ssize_t read(int fildes, void* buf, size_t nbyte)
+int munmap(void* addr, size_t len)
 {
-    // convert the local stream index to the master stream table index
-    int masterStreamIdx = processMgr.getCurrentProcessInfo()->getStreamIndex(fildes);
+    uintptr_t virtualAddr = reinterpret_cast<uintptr_t>(addr);
+    if (len == 0 || (virtualAddr & PAGE_SIZE_MASK) != 0)
+    {
+        return -EINVAL;
+    }
+
+    // only whole mappings can be unmapped
+    size_t numPages = align(len, PAGE_SIZE) / PAGE_SIZE;
+    bool ok = processMgr.unmapCurrentProcessMemory(virtualAddr, numPages);
+    return ok ? 0 : -EINVAL;
+}
+
+int nanosleep(const timespec* rqtp, timespec* rmtp)
+{
+    if (rqtp == nullptr || rqtp->tv_sec < 0 || rqtp->tv_nsec < 0 || rqtp->tv_nsec >= static_cast<long>(Clock::NS_PER_SEC))
+    {
+        return -EINVAL;
+    }
+
+    // keep the deadline from overflowing
+    uint64_t now = Clock::getNs();
+    uint64_t maxSeconds = (TimerWheel::NO_EVENT - now) / Clock::NS_PER_SEC - 1;
+    uint64_t seconds = (static_cast<uint64_t>(rqtp->tv_sec) < maxSeconds) ? rqtp->tv_sec : maxSeconds;
+    uint64_t deadline = now + seconds * Clock::NS_PER_SEC + rqtp->tv_nsec;
+
+    processMgr.sleepCurrentProcess(deadline);
+
+    // the sleep only ends early if the process's alarm went off
+    if (rmtp != nullptr)
+    {
+        now = Clock::getNs();
+        uint64_t remaining = (deadline > now) ? deadline - now : 0;
+        rmtp->tv_sec = remaining / Clock::NS_PER_SEC;
+        rmtp->tv_nsec = remaining % Clock::NS_PER_SEC;
+    }
+
+    return 0;
+}
+
+int open(const char *path, int oflag)
+{
+    // the file must be opened for reading and/or writing
+    if ( (oflag & O_RDWR) == 0 )
+    {
+        return -EINVAL;
+    }
+
+    int masterStreamIdx = rootFileSystem.open(path, oflag);
     if (masterStreamIdx < 0)
     {
-        return -1;
+        return -ENOENT;
     }
 
-    // look up the stream in the master stream table
-    Stream* stream = streamTable.getStream(masterStreamIdx);
+    int fd = processMgr.getCurrentProcessInfo()->addStreamIndex(masterStreamIdx);
+
+    // close the stream if the process has no free descriptors
+    if (fd < 0)
+    {
+        rootFileSystem.close(masterStreamIdx);
+        return -EMFILE;
+    }
+
+    streamTable.setStatusFlags(masterStreamIdx, oflag & (O_ACCMODE | O_APPEND | O_NONBLOCK));
+
+    return fd;
+}
+
+ssize_t pread(int fildes, void* buf, size_t nbyte, off_t offset)
+{
+    Stream* stream = getStream(fildes);
     if (stream == nullptr)
     {
-        return -1;
+        return -EBADF;
+    }
+
+    if (offset < 0)
+    {
+        return -EINVAL;
+    }
+
+    // the read may block, so it doesn't move the stream's position, which
+    // is shared with other processes
+    ssize_t rv = stream->readAt(reinterpret_cast<uint8_t*>(buf), nbyte, offset);
+    if (rv < 0 && rv != -ESPIPE)
+    {
+        rv = -EIO;
     }
 
-    // read from the stream
+    return rv;
+}
+
+ssize_t read(int fildes, void* buf, size_t nbyte)
+{
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
+    {
+        return -EBADF;
+    }
+
+    // read from the stream, and in blocking mode, wait until at least one
+    // byte is available
+    bool block = !isNonBlocking(fildes);
     ssize_t rv = stream->read(reinterpret_cast<uint8_t*>(buf), nbyte);
+    if (block && rv == -EAGAIN)
+    {
+        // some streams stop waiting after a timeout, and the read returns
+        // no data
+        uint64_t timeout = stream->getReadTimeout();
+        uint64_t deadline = (timeout > 0) ? Clock::getNs() + timeout : 0;
+        while (rv == -EAGAIN)
+        {
+            if (!waitForStream(stream, deadline))
+            {
+                rv = 0;
+                break;
+            }
+
+            rv = stream->read(reinterpret_cast<uint8_t*>(buf), nbyte);
+        }
+    }
+
+    if (rv < 0 && rv != -EAGAIN)
+    {
+        rv = -EIO;
+    }
 
     return rv;
 }
@@ -158,6 +485,85 @@ int sched_yield()
     return 0;
 }
 
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    Stream* outStream = getStream(out_fd);
+    Stream* inStream = getStream(in_fd);
+    if (outStream == nullptr || inStream == nullptr)
+    {
+        return -EBADF;
+    }
+
+    ssize_t rv = 0;
+    if (offset == nullptr)
+    {
+        rv = inStream->send(outStream, count);
+    }
+    else
+    {
+        // send from the given offset and update the offset instead of the
+        // stream's position, which is shared with other processes (the
+        // send may block)
+        if (*offset < 0)
+        {
+            return -EINVAL;
+        }
+
+        rv = inStream->sendAt(outStream, count, *offset);
+        if (rv > 0)
+        {
+            *offset += rv;
+        }
+    }
+
+    // streams that fail without a specific error return -1, which is an I/O
+    // error; other errors, like -EAGAIN from a non-blocking stream, are
+    // passed on
+    if (rv == -1)
+    {
+        rv = -EIO;
+    }
+
+    return rv;
+}
+
+int tcgetattr(int fildes, termios* termios_p)
+{
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
+    {
+        return -EBADF;
+    }
+
+    if (termios_p == nullptr)
+    {
+        return -EINVAL;
+    }
+
+    return stream->getTerminalAttributes(termios_p);
+}
+
+int tcsetattr(int fildes, int optional_actions, const termios* termios_p)
+{
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
+    {
+        return -EBADF;
+    }
+
+    if (termios_p == nullptr)
+    {
+        return -EINVAL;
+    }
+
+    return stream->setTerminalAttributes(optional_actions, termios_p);
+}
+
+int unlink(const char* path)
+{
+    return rootFileSystem.unlink(path) ? 0 : -ENOENT;
+}
+
 pid_t waitpid(pid_t pid, int* stat_loc, int options)
 {
     if ( options & (WCONTINUED | WUNTRACED) )
@@ -225,29 +631,29 @@ pid_t waitpid(pid_t pid, int* stat_loc, int options)
 
 ssize_t write(int fildes, const void* buf, size_t nbyte)
 {
-    // convert the local stream index to the master stream table index
-    int masterStreamIdx = processMgr.getCurrentProcessInfo()->getStreamIndex(fildes);
-    if (masterStreamIdx < 0)
+    Stream* stream = getStream(fildes);
+    if (stream == nullptr)
     {
-        return -1;
+        return -EBADF;
     }
 
-    // look up the stream in the master stream table
-    Stream* stream = streamTable.getStream(masterStreamIdx);
-    if (stream == nullptr)
+    // write to the stream, and in blocking mode, wait for room until all
+    // the data has been written
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buf);
+    ssize_t rv = isNonBlocking(fildes) ? stream->write(data, nbyte) : stream->write(data, nbyte, true);
+
+    // a file system that is full reports it; other errors are I/O errors
+    if (rv < 0 && rv != -EAGAIN && rv != -ENOSPC)
     {
-        return -1;
+        rv = -EIO;
     }
 
-    // write to the stream
-    ssize_t rv = stream->write(reinterpret_cast<const uint8_t*>(buf), nbyte, true);
-
     return rv;
 }
 
 } // namespace systemcall
 
-constexpr uint32_t SYSTEM_CALLS_SIZE = 16;
+constexpr uint32_t SYSTEM_CALLS_SIZE = 30;
 const void* SYSTEM_CALLS[SYSTEM_CALLS_SIZE] = {
     reinterpret_cast<const void*>(systemcall::write),
     reinterpret_cast<const void*>(systemcall::getpid),
@@ -258,31 +664,51 @@ const void* SYSTEM_CALLS[SYSTEM_CALLS_SIZE] = {
     reinterpret_cast<const void*>(systemcall::getppid),
     reinterpret_cast<const void*>(systemcall::waitpid),
     reinterpret_cast<const void*>(systemcall::execv),
-    reinterpret_cast<const void*>(systemcall::getNumModules),
-    reinterpret_cast<const void*>(systemcall::getModuleName),
+    nullptr, // removed: getNumModules (use getdents); fails with ENOSYS
+    nullptr, // removed: getModuleName (use getdents); fails with ENOSYS
     reinterpret_cast<const void*>(systemcall::runKernelTests),
     reinterpret_cast<const void*>(systemcall::open),
     reinterpret_cast<const void*>(systemcall::close),
     reinterpret_cast<const void*>(systemcall::dup),
     reinterpret_cast<const void*>(systemcall::dup2),
+    reinterpret_cast<const void*>(systemcall::mmap),
+    reinterpret_cast<const void*>(systemcall::munmap),
+    reinterpret_cast<const void*>(systemcall::lseek),
+    reinterpret_cast<const void*>(systemcall::pread),
+    reinterpret_cast<const void*>(systemcall::fstat),
+    reinterpret_cast<const void*>(systemcall::unlink),
+    reinterpret_cast<const void*>(systemcall::sendfile),
+    reinterpret_cast<const void*>(systemcall::fcntl),
+    reinterpret_cast<const void*>(systemcall::getdents),
+    reinterpret_cast<const void*>(systemcall::tcgetattr),
+    reinterpret_cast<const void*>(systemcall::tcsetattr),
+    reinterpret_cast<const void*>(systemcall::clock_gettime),
+    reinterpret_cast<const void*>(systemcall::nanosleep),
+    reinterpret_cast<const void*>(systemcall::alarm),
 };
 
 extern "C"
 uint32_t systemCallHandler(uint32_t sysCallNum, uint32_t numArgs, const uint32_t* argPtr)
 {
+    bool locked = KernelLock::enter();
+
+    uint32_t rv = 0;
     if (sysCallNum >= SYSTEM_CALLS_SIZE || SYSTEM_CALLS[sysCallNum] == nullptr)
     {
-        /// @todo Temporarily calling PANIC. This needs to
-        /// be changed to something else like killing the
-        /// calling process.
-        PANIC("Unknown system call.");
-
-        return 0xbad'ca11;
+        // unknown and removed system calls fail in the caller instead of
+        // bringing down the kernel
+        rv = static_cast<uint32_t>(-ENOSYS);
     }
     else
     {
         const void* funcPtr = SYSTEM_CALLS[sysCallNum];
 
-        return execSystemCall(funcPtr, numArgs, argPtr);
+        rv = execSystemCall(funcPtr, numArgs, argPtr);
+
+        processMgr.checkCurrentProcessAlarm();
     }
+
+    KernelLock::leave(locked);
+
+    return rv;
 }
@@ -0,0 +1,69 @@
+#include "system.h"
+#include "tasklet.h"
+
+Tasklet* Tasklet::head = nullptr;
+Tasklet* Tasklet::tail = nullptr;
+bool Tasklet::running = false;
+
+void Tasklet::schedule()
+{
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    if (!scheduled)
+    {
+        scheduled = true;
+        next = nullptr;
+        if (tail == nullptr)
+        {
+            head = this;
+        }
+        else
+        {
+            tail->next = this;
+        }
+        tail = this;
+    }
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+}
+
+void Tasklet::runScheduled()
+{
+    // tasklets scheduled by an IRQ that arrives while a tasklet is running
+    // are run by the outer call
+    if (running)
+    {
+        return;
+    }
+
+    running = true;
+
+    while (head != nullptr)
+    {
+        Tasklet* tasklet = head;
+        head = tasklet->next;
+        if (head == nullptr)
+        {
+            tail = nullptr;
+        }
+
+        // the tasklet may be scheduled again while it runs
+        tasklet->next = nullptr;
+        tasklet->scheduled = false;
+
+        setInt();
+        tasklet->function(tasklet->data);
+        clearInt();
+    }
+
+    running = false;
+}
+
+bool Tasklet::isRunning()
+{
+    return running;
+}
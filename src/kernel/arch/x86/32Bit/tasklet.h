@@ -0,0 +1,63 @@
+#ifndef TASKLET_H_
+#define TASKLET_H_
+
+/**
+ * @brief Work deferred from an IRQ handler (a bottom half).
+ * @details An IRQ handler (the top half) only acknowledges its device,
+ * takes the raw data, and schedules a tasklet. Scheduled tasklets run when
+ * the outermost IRQ handler returns, after the EOI and with interrupts
+ * enabled, so the heavier processing doesn't delay other IRQs (e.g. the
+ * timer). Tasklets run one at a time, are not preempted by the scheduler,
+ * and must not sleep.
+ */
+class Tasklet
+{
+public:
+    using Function = void (*)(void* data);
+
+    /**
+     * @brief Constructor
+     * @param func The function to run.
+     * @param funcData The data to pass to the function.
+     */
+    constexpr Tasklet(Function func, void* funcData) :
+        function(func),
+        data(funcData),
+        next(nullptr),
+        scheduled(false)
+    {
+    }
+
+    /**
+     * @brief Schedule the tasklet to run. Scheduling a tasklet that has not
+     * run yet does nothing, so it runs once for several IRQs. Safe to call
+     * from an IRQ handler.
+     */
+    void schedule();
+
+    /**
+     * @brief Run the scheduled tasklets. Called with interrupts disabled at
+     * the end of an IRQ, and interrupts are disabled when this returns.
+     */
+    static void runScheduled();
+
+    /**
+     * @brief Whether a tasklet is running. Code that may be called from a
+     * tasklet must not sleep or switch processes if this is true.
+     */
+    static bool isRunning();
+
+private:
+    /// scheduled tasklets in the order they were scheduled
+    static Tasklet* head;
+    static Tasklet* tail;
+
+    static bool running;
+
+    Function function;
+    void* data;
+    Tasklet* next;
+    bool scheduled;
+};
+
+#endif // TASKLET_H_
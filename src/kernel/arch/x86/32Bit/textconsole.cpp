@@ -0,0 +1,595 @@
+#include <ctype.h>
+
+#include "textconsole.h"
+
+const TextConsole::EColor TextConsole::SGR_COLOR_TO_ENUM[] =
+{
+    EColor::eBlack,
+    EColor::eRed,
+    EColor::eGreen,
+    EColor::eBrown,
+    EColor::eBlue,
+    EColor::eMagenta,
+    EColor::eCyan,
+    EColor::eWhite
+};
+
+TextConsole::TextConsole(uint16_t* cells, unsigned int width, unsigned int height)
+{
+    shadow = cells;
+    shadowTop = 0;
+    this->width = 0;
+    this->height = 0;
+    dirtyLines = 0;
+    numScrolledLines = 0;
+    attrib = 0;
+    csrX = 0;
+    csrY = 0;
+    defaultBackground = EColor::eBlack;
+    defaultForeground = EColor::eWhite;
+    inEscSequence = false;
+    escSequenceChar = '\0';
+    csiState = eParameter;
+    parameterBytesSize = 0;
+    intermediateBytesSize = 0;
+
+    // sets attrib
+    setBackgroundColor(defaultBackground);
+    setForegroundColor(defaultForeground);
+
+    setSize(width, height);
+}
+
+TextConsole::EColor TextConsole::getForegroundColor() const
+{
+    uint16_t color = 0x0F00 & attrib;
+    color >>= 8;
+    return static_cast<EColor>(color);
+}
+
+void TextConsole::setForegroundColor(EColor color)
+{
+    uint16_t temp = static_cast<uint16_t>(color);
+    temp <<= 8;
+    attrib &= 0xF000; // clear all but background color
+    attrib |= temp; // set new foreground color
+}
+
+TextConsole::EColor TextConsole::getBackgroundColor() const
+{
+    uint16_t color = 0xF000 & attrib;
+    color >>= 12;
+    return static_cast<EColor>(color);
+}
+
+void TextConsole::setBackgroundColor(EColor color)
+{
+    uint16_t temp = static_cast<uint16_t>(color);
+    temp <<= 12;
+    attrib &= 0x0F00; // clear all but foreground color
+    attrib |= temp; // set new background color
+}
+
+unsigned int TextConsole::getCursorX() const
+{
+    return csrX;
+}
+
+void TextConsole::setCursorX(unsigned int x)
+{
+    csrX = x;
+
+    if (x >= width)
+    {
+        csrX = width - 1;
+    }
+}
+
+unsigned int TextConsole::getCursorY() const
+{
+    return csrY;
+}
+
+void TextConsole::setCursorY(unsigned int y)
+{
+    csrY = y;
+
+    if (y >= height)
+    {
+        csrY = height - 1;
+    }
+}
+
+ssize_t TextConsole::write(const uint8_t* buff, size_t nbyte)
+{
+    size_t i = 0;
+    for (; i < nbyte; ++i)
+    {
+        writeChar(buff[i]);
+    }
+
+    flush();
+
+    return static_cast<ssize_t>(i);
+}
+
+void TextConsole::flush()
+{
+    // lines that are still on the screen only have to be redrawn if the
+    // screen couldn't move them
+    if (numScrolledLines > 0)
+    {
+        if (!scrollScreen(numScrolledLines))
+        {
+            dirtyLines = getAllLinesDirty();
+        }
+
+        numScrolledLines = 0;
+    }
+
+    for (unsigned int y = 0; dirtyLines != 0; ++y, dirtyLines >>= 1)
+    {
+        if ( (dirtyLines & 1) != 0 )
+        {
+            drawLine(y, getShadowLine(y));
+        }
+    }
+
+    updateCursor();
+}
+
+unsigned int TextConsole::getWidth() const
+{
+    return width;
+}
+
+unsigned int TextConsole::getHeight() const
+{
+    return height;
+}
+
+void TextConsole::setSize(unsigned int newWidth, unsigned int newHeight)
+{
+    width = newWidth;
+    height = (newHeight < MAX_HEIGHT) ? newHeight : MAX_HEIGHT;
+    shadowTop = 0;
+    numScrolledLines = 0;
+    csrX = 0;
+    csrY = 0;
+
+    if (width > 0 && height > 0)
+    {
+        clear(0, 0, width - 1, height - 1);
+    }
+}
+
+uint16_t* TextConsole::getShadowLine(unsigned int y)
+{
+    return shadow + ((shadowTop + y) % height) * width;
+}
+
+void TextConsole::clear(unsigned int startX, unsigned int startY, unsigned int endX, unsigned int endY)
+{
+    for (unsigned int y = startY; y <= endY; ++y)
+    {
+        uint16_t* line = getShadowLine(y);
+        unsigned int lineStartX = (y == startY) ? startX : 0;
+        unsigned int lineEndX = (y == endY) ? endX : width - 1;
+        for (unsigned int x = lineStartX; x <= lineEndX; ++x)
+        {
+            line[x] = attrib | static_cast<uint16_t>(' ');
+        }
+
+        dirtyLines |= uint64_t{1} << y;
+    }
+}
+
+uint64_t TextConsole::getAllLinesDirty() const
+{
+    return (height < 64) ? (uint64_t{1} << height) - 1 : ~uint64_t{0};
+}
+
+void TextConsole::writeChar(char ch)
+{
+    if (inEscSequence)
+    {
+        parseEscSequence(ch);
+    }
+    else if (ch == ESCAPE)
+    {
+        inEscSequence = true;
+    }
+    else
+    {
+        outputChar(ch);
+        scroll();
+    }
+}
+
+void TextConsole::outputChar(char ch)
+{
+    if (ch == '\n')
+    {
+        ++csrY;
+        csrX = 0;
+    }
+    else if (ch == '\r')
+    {
+        csrX = 0;
+    }
+    else if (ch == '\t')
+    {
+        unsigned int spaces = TAB_SIZE - (csrX % TAB_SIZE);
+        csrX += spaces;
+        if (csrX >= width)
+        {
+            ++csrY;
+            csrX = 0;
+        }
+    }
+    else if (ch == '\b')
+    {
+        if (csrX > 0)
+        {
+            --csrX;
+        }
+    }
+    else
+    {
+        uint16_t val = attrib | static_cast<uint8_t>(ch);
+
+        getShadowLine(csrY)[csrX] = val;
+        dirtyLines |= uint64_t{1} << csrY;
+
+        ++csrX;
+        if (csrX >= width)
+        {
+            ++csrY;
+            csrX = 0;
+        }
+    }
+}
+
+void TextConsole::scroll()
+{
+    if (csrY >= height)
+    {
+        // the top line becomes the bottom line, and the screen is
+        // scrolled by flush()
+        shadowTop = (shadowTop + 1) % height;
+        dirtyLines >>= 1;
+        ++numScrolledLines;
+
+        // clear bottom line
+        clear(0, height - 1, width - 1, height - 1);
+
+        // reset cursor to the bottom left corner of the screen
+        csrX = 0;
+        csrY = height - 1;
+    }
+}
+
+void TextConsole::parseEscSequence(char ch)
+{
+    if (escSequenceChar == '\0')
+    {
+        escSequenceChar = ch;
+    }
+    else if (escSequenceChar == CSI)
+    {
+        parseCsi(ch);
+    }
+}
+
+void TextConsole::parseCsi(char ch)
+{
+    bool reset = false;
+
+    if (ch >= CSI_START_PARAMETER_BYTE && ch <= CSI_END_PARAMETER_BYTE)
+    {
+        if (csiState == eParameter)
+        {
+            if (parameterBytesSize < MAX_PARAMETER_BYTES_SIZE - 1)
+            {
+                parameterBytes[parameterBytesSize++] = ch;
+            }
+            else
+            {
+                // error: ran out of buffer space
+                reset = true;
+            }
+        }
+        else
+        {
+            // error: got a parameter character while not in parameter state
+            reset = true;
+        }
+    }
+    else if (ch >= CSI_START_INTERMEDIATE_BYTE && ch <= CSI_END_INTERMEDIATE_BYTE)
+    {
+        if (csiState == eParameter)
+        {
+            // go to next state
+            csiState = eIntermediate;
+        }
+
+        if (csiState == eIntermediate)
+        {
+            if (intermediateBytesSize < MAX_INTERMEDIATE_BYTES_SIZE - 1)
+            {
+                intermediateBytes[intermediateBytesSize++] = ch;
+            }
+            else
+            {
+                // error: ran out of buffer space
+                reset = true;
+            }
+        }
+        else
+        {
+            // error: got an intermidiate character while not in intermidiate state
+            reset = true;
+        }
+    }
+    else if (ch >= CSI_START_FINAL_BYTE && ch <= CSI_END_FINAL_BYTE)
+    {
+        parameterBytes[parameterBytesSize] = '\0';
+        intermediateBytes[intermediateBytesSize] = '\0';
+        finalByte = ch;
+
+        evalCsi();
+
+        // done with sequence, reset state
+        reset = true;
+    }
+
+    if (reset)
+    {
+        inEscSequence = false;
+        escSequenceChar = '\0';
+        csiState = eParameter;
+        parameterBytesSize = 0;
+        intermediateBytesSize = 0;
+    }
+}
+
+void TextConsole::evalCsi()
+{
+    const char* ptr = nullptr;
+    bool error = false;
+
+    if (finalByte == 'A')
+    {
+        unsigned int y = 0;
+        bool done = getNumParam(y, 1, error, ptr);
+        if (done && !error)
+        {
+            setCursorY(csrY - y);
+        }
+    }
+    else if (finalByte == 'B')
+    {
+        unsigned int y = 0;
+        bool done = getNumParam(y, 1, error, ptr);
+        if (done && !error)
+        {
+            setCursorY(csrY + y);
+        }
+    }
+    else if (finalByte == 'C')
+    {
+        unsigned int x = 0;
+        bool done = getNumParam(x, 1, error, ptr);
+        if (done && !error)
+        {
+            setCursorX(csrX + x);
+        }
+    }
+    else if (finalByte == 'D')
+    {
+        unsigned int x = 0;
+        bool done = getNumParam(x, 1, error, ptr);
+        if (done && !error)
+        {
+            setCursorX(csrX - x);
+        }
+    }
+    else if (finalByte == 'E')
+    {
+        unsigned int y = 0;
+        bool done = getNumParam(y, 1, error, ptr);
+        if (done && !error)
+        {
+            setCursorX(0);
+            setCursorY(csrY + y);
+        }
+    }
+    else if (finalByte == 'F')
+    {
+        unsigned int y = 0;
+        bool done = getNumParam(y, 1, error, ptr);
+        if (done && !error)
+        {
+            setCursorX(0);
+            setCursorY(csrY - y);
+        }
+    }
+    else if (finalByte == 'G')
+    {
+        unsigned int x = 0;
+        bool done = getNumParam(x, 1, error, ptr);
+        if (done && !error)
+        {
+            if (x > 0)
+            {
+                // convert the escape sequence's 1-based index
+                // to a 0-based index
+                --x;
+            }
+            setCursorX(x);
+        }
+    }
+    else if (finalByte == 'H')
+    {
+        unsigned int x = 1;
+        unsigned int y = 1;
+        bool done = getNumParam(x, 1, error, ptr);
+        if (!done && !error)
+        {
+            done = getNumParam(y, 1, error, ptr);
+        }
+
+        if (done && !error)
+        {
+            if (x > 0)
+            {
+                // convert the escape sequence's 1-based index
+                // to a 0-based index
+                --x;
+            }
+            if (y > 0)
+            {
+                // convert the escape sequence's 1-based index
+                // to a 0-based index
+                --y;
+            }
+
+            setCursorX(x);
+            setCursorY(y);
+        }
+    }
+    else if (finalByte == 'J')
+    {
+        unsigned int n = 0;
+        bool done = getNumParam(n, 0, error, ptr);
+        if (done && !error)
+        {
+            if (n == 0)
+            {
+                // clear from cursor to end of screen
+                clear(csrX, csrY, width - 1, height - 1);
+            }
+            else if (n == 1)
+            {
+                // clear from cursor to beginning of screen
+                clear(0, 0, csrX, csrY);
+            }
+            else if (n == 2 || n == 3)
+            {
+                // clear entire screen
+                clear(0, 0, width - 1, height - 1);
+
+                // Note: If n == 3, the scroll buffer should be cleared as well,
+                // but we don't have a scroll buffer right now.
+            }
+        }
+    }
+    else if (finalByte == 'm')
+    {
+        evalCsiSgr();
+    }
+}
+
+bool TextConsole::getNumParam(unsigned int& num, unsigned int def, bool& error, const char*& ptr)
+{
+    // (MAX_PARAM * 10) must fit in an unsigned int (32-bits) for
+    // the check below to work
+    constexpr unsigned int MAX_PARAM = 100'000'000;
+
+    // if this is the first time this function is called,
+    // start at the beginning of the paramter string
+    if (ptr == nullptr)
+    {
+        ptr = parameterBytes;
+    }
+
+    // if there is no number before the delimiter, use the
+    // default value
+    if (*ptr == ';' || *ptr == '\0')
+    {
+        num = def;
+        error = false;
+        // we're done if this is the end of the string
+        return (*ptr == '\0');
+    }
+
+    num = 0;
+    while (*ptr != '\0')
+    {
+        if (isdigit(*ptr))
+        {
+            num *= 10;
+            if (num > MAX_PARAM)
+            {
+                error = true;
+                return true;
+            }
+
+            num += *ptr - '0';
+        }
+        else if (*ptr == ';')
+        {
+            // increment the pointer for the next time this function is called
+            ++ptr;
+            error = false;
+            return false;
+        }
+        else // invalid character
+        {
+            num = 0;
+            error = true;
+            return true;
+        }
+
+        ++ptr;
+    }
+
+    error = false;
+    // when we get here, we're done parsing the string
+    return true;
+}
+
+void TextConsole::evalCsiSgr()
+{
+    const char* ptr = nullptr;
+    bool error = false;
+    unsigned int n = 0;
+    bool done = getNumParam(n, 0, error, ptr);
+    while (!error)
+    {
+        if (n == 0)
+        {
+            setBackgroundColor(defaultBackground);
+            setForegroundColor(defaultForeground);
+        }
+        else if (n >= 30 && n <= 37)
+        {
+            // set foreground color
+            unsigned int colorIdx = n - 30;
+            EColor color = SGR_COLOR_TO_ENUM[colorIdx];
+            setForegroundColor(color);
+        }
+        else if (n == 39)
+        {
+            setForegroundColor(defaultForeground);
+        }
+        else if (n >= 40 && n <= 47)
+        {
+            // set background color
+            unsigned int colorIdx = n - 40;
+            EColor color = SGR_COLOR_TO_ENUM[colorIdx];
+            setBackgroundColor(color);
+        }
+        else if (n == 49)
+        {
+            setBackgroundColor(defaultBackground);
+        }
+
+        if (done)
+        {
+            break;
+        }
+
+        done = getNumParam(n, 0, error, ptr);
+    }
+}
@@ -0,0 +1,207 @@
+#ifndef TEXT_CONSOLE_H_
+#define TEXT_CONSOLE_H_
+
+#include "stream.h"
+
+/**
+ * @brief A console that shows text in a grid of character cells.
+ * @details Text and escape sequences are drawn in a shadow buffer in RAM.
+ * Each cell is a character in the low byte and a VGA attribute (background
+ * color in the high nibble, foreground color in the low nibble) in the high
+ * byte. Derived classes draw the changed lines on the screen.
+ */
+class TextConsole : public Stream
+{
+public:
+    static constexpr unsigned int TAB_SIZE = 4;
+
+    enum class EColor
+    {
+        eBlack        =  0,
+        eBlue         =  1,
+        eGreen        =  2,
+        eCyan         =  3,
+        eRed          =  4,
+        eMagenta      =  5,
+        eBrown        =  6,
+        eLightGray    =  7,
+        eDarkGray     =  8,
+        eLightBlue    =  9,
+        eLightGreen   = 10,
+        eLightCyan    = 11,
+        eLightRed     = 12,
+        eLightMagenta = 13,
+        eLightBrown   = 14,
+        eWhite        = 15,
+    };
+
+    EColor getForegroundColor() const;
+
+    void setForegroundColor(EColor color);
+
+    EColor getBackgroundColor() const;
+
+    void setBackgroundColor(EColor color);
+
+    unsigned int getCursorX() const;
+
+    void setCursorX(unsigned int x);
+
+    unsigned int getCursorY() const;
+
+    void setCursorY(unsigned int y);
+
+    bool canRead() const override
+    {
+        return false;
+    }
+
+    bool canWrite() const override
+    {
+        return true;
+    }
+
+    ssize_t read(uint8_t*, size_t) override
+    {
+        return -1;
+    }
+
+    /**
+     * @brief Write to the screen.
+     * @details The text is drawn in the shadow buffer, and the changed lines
+     * are drawn on the screen once at the end by flush().
+     */
+    ssize_t write(const uint8_t* buff, size_t nbyte) override;
+
+    /**
+     * @brief Scroll the screen, draw the changed lines from the shadow
+     * buffer, and update the cursor.
+     */
+    void flush() override;
+
+    void close() override
+    {
+        // nothing to do
+    }
+
+protected:
+    /// the maximum number of lines on the screen
+    static constexpr unsigned int MAX_HEIGHT = 64;
+
+    /**
+     * @brief Constructor
+     * @param cells The shadow buffer. It must be big enough for width *
+     * height cells.
+     * @param width The number of columns on the screen.
+     * @param height The number of lines on the screen.
+     */
+    TextConsole(uint16_t* cells, unsigned int width, unsigned int height);
+
+    unsigned int getWidth() const;
+
+    unsigned int getHeight() const;
+
+    /**
+     * @brief Set the size of the screen and clear it.
+     */
+    void setSize(unsigned int newWidth, unsigned int newHeight);
+
+    /**
+     * @brief Get a screen line in the shadow buffer.
+     */
+    uint16_t* getShadowLine(unsigned int y);
+
+    /**
+     * @brief Move the contents of the screen up.
+     * @param numLines The number of lines to move the contents by.
+     * @return true if the contents were moved; false, if every line must be
+     * redrawn
+     */
+    virtual bool scrollScreen(unsigned int numLines) = 0;
+
+    /**
+     * @brief Draw a line from the shadow buffer on the screen.
+     */
+    virtual void drawLine(unsigned int y, const uint16_t* line) = 0;
+
+    /**
+     * @brief Show the cursor at the cursor position.
+     */
+    virtual void updateCursor() = 0;
+
+    void clear(unsigned int startX, unsigned int startY, unsigned int endX, unsigned int endY);
+
+private:
+    static constexpr char ESCAPE = '\x1B';
+    static constexpr char CSI    = '[';
+    static constexpr char CSI_START_PARAMETER_BYTE    = '\x30';
+    static constexpr char CSI_END_PARAMETER_BYTE      = '\x3F';
+    static constexpr char CSI_START_INTERMEDIATE_BYTE = '\x20';
+    static constexpr char CSI_END_INTERMEDIATE_BYTE   = '\x2F';
+    static constexpr char CSI_START_FINAL_BYTE        = '\x40';
+    static constexpr char CSI_END_FINAL_BYTE          = '\x7E';
+
+    static const EColor SGR_COLOR_TO_ENUM[8];
+
+    /// The screen's contents. Screen line y is stored in shadow line
+    /// (shadowTop + y) % height, so scrolling doesn't move any data.
+    uint16_t* shadow;
+    unsigned int shadowTop;
+
+    unsigned int width;
+    unsigned int height;
+
+    /// bit y is set if screen line y has changed since the last flush
+    uint64_t dirtyLines;
+
+    /// number of lines scrolled since the last flush
+    unsigned int numScrolledLines;
+
+    uint16_t attrib;
+    unsigned int csrX;
+    unsigned int csrY;
+    EColor defaultBackground;
+    EColor defaultForeground;
+    bool inEscSequence;
+    char escSequenceChar;
+    enum ECsiState
+    {
+        eParameter,
+        eIntermediate,
+        eFinal
+    } csiState;
+    static constexpr size_t MAX_PARAMETER_BYTES_SIZE = 32;
+    size_t parameterBytesSize;
+    char parameterBytes[MAX_PARAMETER_BYTES_SIZE];
+    static constexpr size_t MAX_INTERMEDIATE_BYTES_SIZE = 32;
+    size_t intermediateBytesSize;
+    char intermediateBytes[MAX_INTERMEDIATE_BYTES_SIZE];
+    char finalByte;
+
+    /**
+     * @brief Get the dirty line mask with a bit set for every line.
+     */
+    uint64_t getAllLinesDirty() const;
+
+    void writeChar(char ch);
+
+    void outputChar(char ch);
+
+    void scroll();
+
+    /**
+     * @brief Parse a character in an escape sequence.
+     * @param ch the character to parse.
+     */
+    void parseEscSequence(char ch);
+
+    void parseCsi(char ch);
+
+    void evalCsi();
+
+    bool getNumParam(unsigned int& num, unsigned int def, bool& error, const char*& ptr);
+
+    void evalCsiSgr();
+};
+
+#endif // TEXT_CONSOLE_H_
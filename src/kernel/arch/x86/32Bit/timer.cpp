@@ -1,40 +1,123 @@
+#include "clock.h"
+#include "cpu.h"
+#include "lapictimer.h"
+#include "pitclockevent.h"
 #include "processmgr.h"
-#include "timer.h"
 #include "system.h"
+#include "timer.h"
+#include "timerwheel.h"
+
+namespace
+{
+
+PitClockEvent pitClockEvent;
+LapicTimer lapicTimer;
+
+}
 
 namespace os
 {
 
-uint64_t Timer::ticks = 0;
+ClockEvent* Timer::clockEvent = nullptr;
 
-void Timer::init(unsigned int freq)
+void Timer::init()
 {
-    ticks = 0;
+    // the local APIC timer is programmed without port I/O
+    if (lapicTimer.init(interruptHandler))
+    {
+        clockEvent = &lapicTimer;
+    }
+    else
+    {
+        pitClockEvent.init(interruptHandler);
+        clockEvent = &pitClockEvent;
+    }
+}
 
-    // register interrupt
-    registerIrqHandler(IRQ_TIMER, interruptHandler);
+const ClockEvent* Timer::getClockEvent()
+{
+    return clockEvent;
+}
 
-    // the value we send to the PIT is the value to divide it's
-    // 1,193,180 Hz input clock by
-    uint16_t divisor = PIT_FREQUENCY / freq;
+void Timer::startTimeSlice(uint64_t length)
+{
+    bool intEnabled = isIntEnabled();
+    clearInt();
 
-    // set the command byte
-    outb(0x43, 0x36);
+    Cpu* cpu = Cpu::getCurrent();
+    cpu->timeSliceRunning = true;
+    cpu->timeSliceEnd = Clock::getNs() + length;
+    update();
 
-    // set the divisor
-    outb(0x40, divisor & 0xFF);
-    outb(0x40, divisor >> 8);
+    if (intEnabled)
+    {
+        setInt();
+    }
 }
 
-uint64_t Timer::getTicks()
+void Timer::stopTimeSlice()
 {
-    return ticks;
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    Cpu::getCurrent()->timeSliceRunning = false;
+    update();
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+}
+
+void Timer::update()
+{
+    // every processor is programmed for the timer wheel, and the first
+    // one interrupted runs it
+    const Cpu* cpu = Cpu::getCurrent();
+    uint64_t eventTime = TimerWheel::getNextEventTime();
+    if (cpu->timeSliceRunning && cpu->timeSliceEnd < eventTime)
+    {
+        eventTime = cpu->timeSliceEnd;
+    }
+
+    if (eventTime == TimerWheel::NO_EVENT)
+    {
+        clockEvent->stop();
+        return;
+    }
+
+    // an event later than the device can count is reached in several
+    // interrupts
+    uint64_t now = Clock::getNs();
+    uint64_t delay = (eventTime > now) ? eventTime - now : 0;
+    if (delay > clockEvent->getMaxDelay())
+    {
+        delay = clockEvent->getMaxDelay();
+    }
+    else if (delay < clockEvent->getMinDelay())
+    {
+        delay = clockEvent->getMinDelay();
+    }
+
+    clockEvent->setNextEvent(delay);
 }
 
 void Timer::interruptHandler(const registers* regs)
 {
-    ++ticks;
-    processMgr.processTimerInterrupt(regs);
+    uint64_t now = Clock::getNs();
+
+    TimerWheel::run(now);
+
+    Cpu* cpu = Cpu::getCurrent();
+    bool timeSliceEnded = cpu->timeSliceRunning && now >= cpu->timeSliceEnd;
+    if (timeSliceEnded)
+    {
+        cpu->timeSliceRunning = false;
+    }
+
+    update();
+
+    processMgr.processTimerInterrupt(regs, timeSliceEnded);
 }
 
 } // namespace os
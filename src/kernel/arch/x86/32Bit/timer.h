@@ -3,28 +3,58 @@
 
 #include <stdint.h>
 
+#include "clockevent.h"
 #include "irq.h"
 
-#define PIT_FREQUENCY 1'193'180
-
 namespace os
 {
 
+/**
+ * @brief Programs the clock event device for the scheduler and the timer
+ * wheel.
+ * @details There is no periodic tick. The device is programmed to interrupt
+ * when the running process's time slice ends or when the timer wheel is
+ * next due, whichever comes first, and it is stopped while neither is
+ * pending. Each processor has its own device (its local APIC timer) and
+ * times its own process's time slice.
+ */
 class Timer
 {
 public:
+    /// how long a process runs before another process is scheduled
+    static constexpr uint64_t TIME_SLICE_NS = 50'000'000;
+
     /**
-     * @brief Initialize the timer with the frequency at which to interrupt
-     * @param freq the timer frequency in Hz, this cannot be less than 19
+     * @brief Choose the clock event device: the local APIC timer if the
+     * local APIC is in use; otherwise, the PIT.
      */
-    static void init(unsigned int freq);
+    static void init();
 
-    static uint64_t getTicks();
+    static const ClockEvent* getClockEvent();
 
-    static void interruptHandler(const struct registers* regs);
+    /**
+     * @brief Interrupt the calling processor's process when its time slice
+     * ends.
+     * @param length The length of the time slice in nanoseconds.
+     */
+    static void startTimeSlice(uint64_t length = TIME_SLICE_NS);
+
+    /**
+     * @brief Cancel the time slice (e.g. when no process is running), so
+     * the timer only interrupts an idle processor for the timer wheel.
+     */
+    static void stopTimeSlice();
+
+    /**
+     * @brief Program the calling processor's clock event device for its
+     * next time slice end or timer wheel event. Interrupts must be disabled.
+     */
+    static void update();
 
 private:
-    static uint64_t ticks;
+    static ClockEvent* clockEvent;
+
+    static void interruptHandler(const registers* regs);
 };
 
 } // namespace os
@@ -0,0 +1,234 @@
+#include "clock.h"
+#include "system.h"
+#include "timer.h"
+#include "timerwheel.h"
+
+void SoftTimer::start(uint64_t deadlineNs)
+{
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    if (pending)
+    {
+        TimerWheel::remove(this);
+    }
+
+    deadline = deadlineNs;
+
+    TimerWheel::add(this);
+
+    // the deadline may be earlier than the clock event that is programmed
+    os::Timer::update();
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+}
+
+void SoftTimer::cancel()
+{
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    // the programmed clock event is left alone; if it was for this timer,
+    // the wheel finds nothing to do
+    if (pending)
+    {
+        TimerWheel::remove(this);
+    }
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+}
+
+SoftTimer* TimerWheel::slots[NUM_LEVELS][NUM_SLOTS] = {};
+uint64_t TimerWheel::occupiedSlots[NUM_LEVELS] = {};
+uint64_t TimerWheel::currentTick = 0;
+
+void TimerWheel::add(SoftTimer* timer)
+{
+    // round up, so the timer doesn't expire before its deadline
+    timer->expiryTick = (timer->deadline >> TICK_SHIFT) + ((timer->deadline & TICK_MASK) != 0 ? 1 : 0);
+
+    // the wheel isn't run while no slots are due, so it may be behind the
+    // clock; catching up only skips ticks where nothing happens, and it
+    // keeps the timer out of the higher levels
+    uint64_t nowTick = Clock::getNs() >> TICK_SHIFT;
+    if (nowTick > currentTick && getNextEventTick() > nowTick)
+    {
+        currentTick = nowTick;
+    }
+
+    insert(timer);
+}
+
+void TimerWheel::remove(SoftTimer* timer)
+{
+    if (timer->prev != nullptr)
+    {
+        timer->prev->next = timer->next;
+    }
+    else
+    {
+        slots[timer->level][timer->slot] = timer->next;
+        if (timer->next == nullptr)
+        {
+            occupiedSlots[timer->level] &= ~(1ULL << timer->slot);
+        }
+    }
+
+    if (timer->next != nullptr)
+    {
+        timer->next->prev = timer->prev;
+    }
+
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    timer->pending = false;
+}
+
+void TimerWheel::run(uint64_t nowNs)
+{
+    uint64_t nowTick = nowNs >> TICK_SHIFT;
+
+    // skip straight to each tick where a slot is due
+    uint64_t tick = getNextEventTick();
+    while (tick <= nowTick)
+    {
+        currentTick = tick;
+
+        // a level's slot is due every time the levels below wrap around
+        for (unsigned level = 1; level < NUM_LEVELS; ++level)
+        {
+            if ( (tick & ((1ULL << (SLOT_BITS * level)) - 1)) != 0 )
+            {
+                break;
+            }
+
+            cascade(level, (tick >> (SLOT_BITS * level)) & SLOT_MASK);
+        }
+
+        // take the expired timers out of the wheel before calling them,
+        // since they may be started again
+        unsigned slot = tick & SLOT_MASK;
+        SoftTimer* timer = slots[0][slot];
+        slots[0][slot] = nullptr;
+        occupiedSlots[0] &= ~(1ULL << slot);
+        currentTick = tick + 1;
+
+        while (timer != nullptr)
+        {
+            SoftTimer* nextTimer = timer->next;
+
+            timer->prev = nullptr;
+            timer->next = nullptr;
+            timer->pending = false;
+            timer->function(timer->data);
+
+            timer = nextTimer;
+        }
+
+        tick = getNextEventTick();
+    }
+
+    if (currentTick < nowTick)
+    {
+        currentTick = nowTick;
+    }
+}
+
+uint64_t TimerWheel::getNextEventTime()
+{
+    uint64_t tick = getNextEventTick();
+    if (tick == NO_EVENT)
+    {
+        return NO_EVENT;
+    }
+
+    return tick << TICK_SHIFT;
+}
+
+void TimerWheel::insert(SoftTimer* timer)
+{
+    uint64_t expiryTick = (timer->expiryTick > currentTick) ? timer->expiryTick : currentTick;
+    uint64_t delta = expiryTick - currentTick;
+
+    // timers beyond the wheel's range wait in the last level, and they
+    // are put in a lower level when their slot is cascaded
+    if (delta >= RANGE)
+    {
+        expiryTick = currentTick + RANGE - 1;
+        delta = RANGE - 1;
+    }
+
+    unsigned level = 0;
+    while ( delta >= (1ULL << (SLOT_BITS * (level + 1))) )
+    {
+        ++level;
+    }
+
+    unsigned slot = (expiryTick >> (SLOT_BITS * level)) & SLOT_MASK;
+
+    timer->level = level;
+    timer->slot = slot;
+    timer->prev = nullptr;
+    timer->next = slots[level][slot];
+    if (timer->next != nullptr)
+    {
+        timer->next->prev = timer;
+    }
+    slots[level][slot] = timer;
+    occupiedSlots[level] |= 1ULL << slot;
+    timer->pending = true;
+}
+
+void TimerWheel::cascade(unsigned level, unsigned slot)
+{
+    SoftTimer* timer = slots[level][slot];
+    slots[level][slot] = nullptr;
+    occupiedSlots[level] &= ~(1ULL << slot);
+
+    while (timer != nullptr)
+    {
+        SoftTimer* nextTimer = timer->next;
+        insert(timer);
+        timer = nextTimer;
+    }
+}
+
+uint64_t TimerWheel::getNextEventTick()
+{
+    uint64_t nextTick = NO_EVENT;
+
+    for (unsigned level = 0; level < NUM_LEVELS; ++level)
+    {
+        if (occupiedSlots[level] == 0)
+        {
+            continue;
+        }
+
+        // the first slot of this level that the wheel reaches; a higher
+        // level slot is due at the tick where it starts
+        unsigned shift = SLOT_BITS * level;
+        uint64_t start = (currentTick + (1ULL << shift) - 1) >> shift;
+        unsigned startSlot = start & SLOT_MASK;
+        unsigned slot = findSlot(occupiedSlots[level], startSlot);
+        uint64_t tick = (start + ((slot - startSlot) & SLOT_MASK)) << shift;
+
+        if (tick < nextTick)
+        {
+            nextTick = tick;
+        }
+    }
+
+    return nextTick;
+}
+
+unsigned TimerWheel::findSlot(uint64_t bitmap, unsigned start)
+{
+    uint64_t rotated = (start == 0) ? bitmap : (bitmap >> start) | (bitmap << (NUM_SLOTS - start));
+    return (start + __builtin_ctzll(rotated)) & SLOT_MASK;
+}
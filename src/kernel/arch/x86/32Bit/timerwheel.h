@@ -0,0 +1,173 @@
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+/**
+ * @brief A function that is called from the timer interrupt once the
+ * monotonic clock reaches a deadline.
+ * @details Pending timers are kept in the TimerWheel, so starting and
+ * canceling a timer takes constant time. The function runs with interrupts
+ * disabled and must not sleep.
+ */
+class SoftTimer
+{
+public:
+    using Function = void (*)(void* data);
+
+    /**
+     * @brief Constructor
+     * @param func The function to call when the timer expires.
+     * @param funcData The data to pass to the function.
+     */
+    constexpr SoftTimer(Function func, void* funcData) :
+        function(func),
+        data(funcData),
+        deadline(0),
+        expiryTick(0),
+        prev(nullptr),
+        next(nullptr),
+        level(0),
+        slot(0),
+        pending(false)
+    {
+    }
+
+    /**
+     * @brief Start the timer, replacing its deadline if it is already
+     * pending. Safe to call from an IRQ handler.
+     * @param deadlineNs The deadline on the Clock in nanoseconds. The timer
+     * expires right away if it has already passed.
+     */
+    void start(uint64_t deadlineNs);
+
+    /**
+     * @brief Stop the timer if it hasn't expired yet. Safe to call from an
+     * IRQ handler.
+     */
+    void cancel();
+
+    /**
+     * @brief Whether the timer has been started and hasn't expired or been
+     * canceled.
+     */
+    bool isPending() const
+    {
+        return pending;
+    }
+
+    uint64_t getDeadline() const
+    {
+        return deadline;
+    }
+
+private:
+    friend class TimerWheel;
+    friend class TimerWheelTestClass;
+
+    Function function;
+    void* data;
+
+    uint64_t deadline;
+
+    /// the wheel tick the timer expires at
+    uint64_t expiryTick;
+
+    /// the timers in the same wheel slot
+    SoftTimer* prev;
+    SoftTimer* next;
+
+    /// the wheel slot the timer is in
+    uint8_t level;
+    uint8_t slot;
+
+    bool pending;
+};
+
+/**
+ * @brief Hierarchical timer wheel
+ * @details Time is divided into ticks of 2^16 ns (about 65.5 us), which is
+ * the wheel's resolution. Each level has 64 slots, and a slot at level n
+ * spans 64^n ticks, so 5 levels cover about 19.5 hours; later timers wait
+ * in the last level. A timer is put in the lowest level whose range covers
+ * its deadline, and when the wheel reaches a higher level slot, its timers
+ * are moved down (cascaded) to the levels below. The wheel is only run when
+ * a slot is due, so it doesn't need a periodic tick.
+ */
+class TimerWheel
+{
+public:
+    /// returned when no timers are pending
+    static constexpr uint64_t NO_EVENT = 0xFFFF'FFFF'FFFF'FFFF;
+
+    /**
+     * @brief Add a timer. Interrupts must be disabled.
+     */
+    static void add(SoftTimer* timer);
+
+    /**
+     * @brief Remove a pending timer. Interrupts must be disabled.
+     */
+    static void remove(SoftTimer* timer);
+
+    /**
+     * @brief Cascade the slots that are due and call the functions of
+     * the timers that expired. Called from the timer interrupt.
+     * @param nowNs The current time on the Clock.
+     */
+    static void run(uint64_t nowNs);
+
+    /**
+     * @brief Get the time when the wheel must run next.
+     * @details This may be earlier than the next deadline when a higher
+     * level slot has to be cascaded first.
+     * @return The time on the Clock in nanoseconds, or NO_EVENT if no timers
+     * are pending.
+     */
+    static uint64_t getNextEventTime();
+
+private:
+    friend class TimerWheelTestClass;
+
+    static constexpr unsigned TICK_SHIFT = 16;
+    static constexpr uint64_t TICK_MASK = (1 << TICK_SHIFT) - 1;
+
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned NUM_SLOTS = 1 << SLOT_BITS;
+    static constexpr unsigned SLOT_MASK = NUM_SLOTS - 1;
+    static constexpr unsigned NUM_LEVELS = 5;
+
+    /// the number of ticks that the wheel covers
+    static constexpr uint64_t RANGE = 1ULL << (SLOT_BITS * NUM_LEVELS);
+
+    static SoftTimer* slots[NUM_LEVELS][NUM_SLOTS];
+
+    /// a bit for each slot that has timers
+    static uint64_t occupiedSlots[NUM_LEVELS];
+
+    /// the next tick to process
+    static uint64_t currentTick;
+
+    /**
+     * @brief Put a timer in the slot for its expiry tick.
+     */
+    static void insert(SoftTimer* timer);
+
+    /**
+     * @brief Move a higher level slot's timers to the levels below.
+     */
+    static void cascade(unsigned level, unsigned slot);
+
+    /**
+     * @brief Get the next tick at which a slot is due, or NO_EVENT.
+     */
+    static uint64_t getNextEventTick();
+
+    /**
+     * @brief Find the first occupied slot, starting at a slot and wrapping
+     * around. The bitmap must not be 0.
+     */
+    static unsigned findSlot(uint64_t bitmap, unsigned start);
+};
+
+#endif // TIMER_WHEEL_H_
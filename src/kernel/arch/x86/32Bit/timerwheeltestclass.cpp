@@ -0,0 +1,243 @@
+#include <string.h>
+#include "timerwheel.h"
+#include "unittests.h"
+
+/**
+ * @brief Runs a test on an empty wheel.
+ * @details The kernel's timers are set aside while the test runs, and they
+ * are put back when it returns (even if it fails).
+ */
+class TimerWheelTestClass::TestWheel
+{
+public:
+    /// far enough ahead of the clock that add() doesn't catch up to it,
+    /// and not aligned to a slot boundary
+    static constexpr uint64_t START_TICK = (1ULL << 40) + 37;
+    static constexpr uint64_t START_NS = START_TICK << TimerWheel::TICK_SHIFT;
+
+    TestWheel()
+    {
+        memcpy(savedSlots, TimerWheel::slots, sizeof(savedSlots));
+        memcpy(savedOccupiedSlots, TimerWheel::occupiedSlots, sizeof(savedOccupiedSlots));
+        savedCurrentTick = TimerWheel::currentTick;
+
+        memset(TimerWheel::slots, 0, sizeof(TimerWheel::slots));
+        memset(TimerWheel::occupiedSlots, 0, sizeof(TimerWheel::occupiedSlots));
+        TimerWheel::currentTick = START_TICK;
+    }
+
+    ~TestWheel()
+    {
+        memcpy(TimerWheel::slots, savedSlots, sizeof(savedSlots));
+        memcpy(TimerWheel::occupiedSlots, savedOccupiedSlots, sizeof(savedOccupiedSlots));
+        TimerWheel::currentTick = savedCurrentTick;
+    }
+
+    /**
+     * @brief Add a timer without reprogramming the clock event, which
+     * SoftTimer::start() would do.
+     */
+    static void add(SoftTimer* timer, uint64_t deadlineNs)
+    {
+        timer->deadline = deadlineNs;
+        TimerWheel::add(timer);
+    }
+
+    static uint64_t ticksToNs(uint64_t ticks)
+    {
+        return ticks << TimerWheel::TICK_SHIFT;
+    }
+
+    static uint64_t getRange()
+    {
+        return TimerWheel::RANGE;
+    }
+
+    static void countExpiry(void* data)
+    {
+        ++*static_cast<int*>(data);
+    }
+
+private:
+    SoftTimer* savedSlots[TimerWheel::NUM_LEVELS][TimerWheel::NUM_SLOTS];
+    uint64_t savedOccupiedSlots[TimerWheel::NUM_LEVELS];
+    uint64_t savedCurrentTick;
+};
+
+TimerWheelTestClass::TimerWheelTestClass() :
+    TestClass("TimerWheel")
+{
+}
+
+void TimerWheelTestClass::runTests()
+{
+    runTest("Expire", []()
+    {
+        TestWheel wheel;
+
+        int count = 0;
+        SoftTimer timer(TestWheel::countExpiry, &count);
+        uint64_t deadline = TestWheel::START_NS + TestWheel::ticksToNs(10);
+        TestWheel::add(&timer, deadline);
+
+        ASSERT_TRUE(timer.isPending());
+        ASSERT_EQ(TimerWheel::getNextEventTime(), deadline);
+
+        TimerWheel::run(deadline - 1);
+        ASSERT_EQ(count, 0);
+        ASSERT_TRUE(timer.isPending());
+
+        TimerWheel::run(deadline);
+        ASSERT_EQ(count, 1);
+        ASSERT_FALSE(timer.isPending());
+        ASSERT_EQ(TimerWheel::getNextEventTime(), TimerWheel::NO_EVENT);
+    });
+
+    runTest("RoundUpToTick", []()
+    {
+        TestWheel wheel;
+
+        int count = 0;
+        SoftTimer timer(TestWheel::countExpiry, &count);
+        uint64_t deadline = TestWheel::START_NS + TestWheel::ticksToNs(10) + 1;
+        TestWheel::add(&timer, deadline);
+
+        // the timer must not expire before its deadline
+        ASSERT_EQ(TimerWheel::getNextEventTime(), TestWheel::START_NS + TestWheel::ticksToNs(11));
+
+        TimerWheel::run(TestWheel::START_NS + TestWheel::ticksToNs(10));
+        ASSERT_EQ(count, 0);
+
+        TimerWheel::run(TestWheel::START_NS + TestWheel::ticksToNs(11));
+        ASSERT_EQ(count, 1);
+    });
+
+    runTest("PastDeadline", []()
+    {
+        TestWheel wheel;
+
+        int count = 0;
+        SoftTimer timer(TestWheel::countExpiry, &count);
+        TestWheel::add(&timer, TestWheel::START_NS - TestWheel::ticksToNs(1'000));
+
+        ASSERT_EQ(TimerWheel::getNextEventTime(), TestWheel::START_NS);
+
+        TimerWheel::run(TestWheel::START_NS);
+        ASSERT_EQ(count, 1);
+    });
+
+    runTest("Cascade", []()
+    {
+        TestWheel wheel;
+
+        // one timer in each level, run at each time the wheel asks for
+        constexpr size_t NUM_TIMERS = 5;
+        const uint64_t ticks[NUM_TIMERS] = {5, 100, 5'000, 300'000, 20'000'000};
+        int counts[NUM_TIMERS] = {};
+        SoftTimer timers[NUM_TIMERS] = {
+            {TestWheel::countExpiry, &counts[0]},
+            {TestWheel::countExpiry, &counts[1]},
+            {TestWheel::countExpiry, &counts[2]},
+            {TestWheel::countExpiry, &counts[3]},
+            {TestWheel::countExpiry, &counts[4]},
+        };
+
+        for (size_t i = 0; i < NUM_TIMERS; ++i)
+        {
+            TestWheel::add(&timers[i], TestWheel::START_NS + TestWheel::ticksToNs(ticks[i]));
+        }
+
+        size_t numRuns = 0;
+        uint64_t time = TimerWheel::getNextEventTime();
+        while (time != TimerWheel::NO_EVENT)
+        {
+            ++numRuns;
+            ASSERT_LE(numRuns, 100u, "The wheel doesn't reach the last timer.");
+
+            TimerWheel::run(time);
+
+            // each timer expires at the first run at or after its deadline
+            for (size_t i = 0; i < NUM_TIMERS; ++i)
+            {
+                int expectedCount = (time >= timers[i].getDeadline()) ? 1 : 0;
+                ASSERT_EQ(counts[i], expectedCount);
+            }
+
+            time = TimerWheel::getNextEventTime();
+        }
+
+        for (size_t i = 0; i < NUM_TIMERS; ++i)
+        {
+            ASSERT_FALSE(timers[i].isPending());
+        }
+    });
+
+    runTest("Cancel", []()
+    {
+        TestWheel wheel;
+
+        // two timers in the same slot and one in a higher level
+        int count1 = 0;
+        int count2 = 0;
+        int count3 = 0;
+        SoftTimer timer1(TestWheel::countExpiry, &count1);
+        SoftTimer timer2(TestWheel::countExpiry, &count2);
+        SoftTimer timer3(TestWheel::countExpiry, &count3);
+        uint64_t deadline = TestWheel::START_NS + TestWheel::ticksToNs(20);
+        TestWheel::add(&timer1, deadline);
+        TestWheel::add(&timer2, deadline);
+        TestWheel::add(&timer3, TestWheel::START_NS + TestWheel::ticksToNs(10'000));
+
+        timer2.cancel();
+        ASSERT_FALSE(timer2.isPending());
+        ASSERT_TRUE(timer1.isPending());
+
+        timer3.cancel();
+        ASSERT_FALSE(timer3.isPending());
+        ASSERT_EQ(TimerWheel::getNextEventTime(), deadline);
+
+        TimerWheel::run(TestWheel::START_NS + TestWheel::ticksToNs(20'000));
+        ASSERT_EQ(count1, 1);
+        ASSERT_EQ(count2, 0);
+        ASSERT_EQ(count3, 0);
+
+        // canceling a timer that expired does nothing
+        timer1.cancel();
+        ASSERT_EQ(TimerWheel::getNextEventTime(), TimerWheel::NO_EVENT);
+    });
+
+    runTest("FarFuture", []()
+    {
+        TestWheel wheel;
+
+        // a timer beyond the wheel's range waits in the last level until
+        // it is in range
+        int count = 0;
+        SoftTimer timer(TestWheel::countExpiry, &count);
+        uint64_t deadline = TestWheel::START_NS + TestWheel::ticksToNs(3 * TestWheel::getRange() + 12'345);
+        TestWheel::add(&timer, deadline);
+
+        ASSERT_LT(TimerWheel::getNextEventTime(), deadline);
+
+        size_t numRuns = 0;
+        uint64_t time = TimerWheel::getNextEventTime();
+        while (time < deadline)
+        {
+            ++numRuns;
+            ASSERT_LE(numRuns, 100u, "The wheel doesn't reach the timer.");
+
+            TimerWheel::run(time);
+            ASSERT_EQ(count, 0);
+            ASSERT_TRUE(timer.isPending());
+            ASSERT_EQ(timer.getDeadline(), deadline);
+
+            time = TimerWheel::getNextEventTime();
+        }
+
+        ASSERT_EQ(time, deadline);
+
+        TimerWheel::run(time);
+        ASSERT_EQ(count, 1);
+        ASSERT_EQ(TimerWheel::getNextEventTime(), TimerWheel::NO_EVENT);
+    });
+}
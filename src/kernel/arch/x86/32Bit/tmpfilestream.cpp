@@ -0,0 +1,140 @@
+#include <fcntl.h>
+#include "tmpfilestream.h"
+#include "tmpfilesystem.h"
+
+TmpFileStream::TmpFileStream() :
+    fileSystem(nullptr),
+    file(nullptr),
+    position(0),
+    readable(false),
+    writable(false),
+    append(false)
+{
+}
+
+void TmpFileStream::open(TmpFileSystem* fileSystemPtr, TmpFile* filePtr, int oflag)
+{
+    fileSystem = fileSystemPtr;
+    file = filePtr;
+    position = 0;
+    readable = (oflag & O_RDONLY) != 0;
+    writable = (oflag & O_WRONLY) != 0;
+    append = (oflag & O_APPEND) != 0;
+    readAhead.reset();
+}
+
+ssize_t TmpFileStream::read(uint8_t* buff, size_t nbyte)
+{
+    ssize_t rv = readAt(buff, nbyte, static_cast<off_t>(position));
+    if (rv > 0)
+    {
+        position += rv;
+    }
+
+    return rv;
+}
+
+ssize_t TmpFileStream::readAt(uint8_t* buff, size_t nbyte, off_t offset)
+{
+    if (!readable || offset < 0)
+    {
+        return -1;
+    }
+
+    return fileSystem->read(file, static_cast<size_t>(offset), buff, nbyte, readAhead);
+}
+
+ssize_t TmpFileStream::send(Stream* outStream, size_t nbyte)
+{
+    ssize_t rv = sendAt(outStream, nbyte, static_cast<off_t>(position));
+    if (rv > 0)
+    {
+        position += rv;
+    }
+
+    return rv;
+}
+
+ssize_t TmpFileStream::sendAt(Stream* outStream, size_t nbyte, off_t offset)
+{
+    if (!readable || offset < 0)
+    {
+        return -1;
+    }
+
+    return fileSystem->send(file, static_cast<size_t>(offset), outStream, nbyte, readAhead);
+}
+
+ssize_t TmpFileStream::write(const uint8_t* buff, size_t nbyte)
+{
+    if (!writable)
+    {
+        return -1;
+    }
+
+    if (append)
+    {
+        position = file->size;
+    }
+
+    ssize_t rv = fileSystem->write(file, position, buff, nbyte);
+    if (rv > 0)
+    {
+        position += rv;
+    }
+
+    return rv;
+}
+
+off_t TmpFileStream::seek(off_t offset, int whence)
+{
+    off_t base = 0;
+    switch (whence)
+    {
+        case SEEK_SET:
+            base = 0;
+            break;
+
+        case SEEK_CUR:
+            base = static_cast<off_t>(position);
+            break;
+
+        case SEEK_END:
+            base = size();
+            break;
+
+        default:
+            return -1;
+    }
+
+    off_t newPosition = base + offset;
+    if (newPosition < 0)
+    {
+        return -1;
+    }
+
+    position = static_cast<size_t>(newPosition);
+
+    return newPosition;
+}
+
+off_t TmpFileStream::size() const
+{
+    return static_cast<off_t>(file->size);
+}
+
+void TmpFileStream::close()
+{
+    if (file != nullptr)
+    {
+        fileSystem->closeFile(file);
+    }
+
+    fileSystem = nullptr;
+    file = nullptr;
+}
+
+bool TmpFileStream::isOpen() const
+{
+    return file != nullptr;
+}
@@ -0,0 +1,71 @@
+#ifndef TMP_FILE_STREAM_H_
+#define TMP_FILE_STREAM_H_
+
+#include "pagecache.h"
+#include "stream.h"
+
+class TmpFileSystem;
+struct TmpFile;
+
+class TmpFileStream : public Stream
+{
+public:
+    TmpFileStream();
+
+    /**
+     * @brief Open the stream to a file.
+     * @param fileSystemPtr The file system the file is in.
+     * @param filePtr The file.
+     * @param oflag The flags the file was opened with.
+     */
+    void open(TmpFileSystem* fileSystemPtr, TmpFile* filePtr, int oflag);
+
+    bool canRead() const override
+    {
+        return readable;
+    }
+
+    bool canWrite() const override
+    {
+        return writable;
+    }
+
+    ssize_t read(uint8_t* buff, size_t nbyte) override;
+
+    ssize_t readAt(uint8_t* buff, size_t nbyte, off_t offset) override;
+
+    ssize_t write(const uint8_t* buff, size_t nbyte) override;
+
+    ssize_t send(Stream* outStream, size_t nbyte) override;
+
+    ssize_t sendAt(Stream* outStream, size_t nbyte, off_t offset) override;
+
+    off_t seek(off_t offset, int whence) override;
+
+    off_t size() const override;
+
+    void flush() override
+    {
+    }
+
+    void close() override;
+
+    bool isOpen() const;
+
+private:
+    TmpFileSystem* fileSystem;
+    TmpFile* file;
+
+    /// offset from the start of the file
+    size_t position;
+
+    bool readable;
+    bool writable;
+
+    /// whether every write is at the end of the file
+    bool append;
+
+    PageCache::ReadAhead readAhead;
+};
+
+#endif // TMP_FILE_STREAM_H_
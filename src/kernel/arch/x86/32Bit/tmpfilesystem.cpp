@@ -0,0 +1,397 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include "kernellogger.h"
+#include "pageframemgr.h"
+#include "paging.h"
+#include "processmgr.h"
+#include "system.h"
+#include "tmpfilesystem.h"
+
+namespace
+{
+
+const char* LOG_TAG = "TmpFileSystem";
+
+} // namespace
+
+TmpFileSystem::TmpFileSystem() :
+    pageFrameMgr(nullptr)
+{
+    memset(files, 0, sizeof(files));
+    memset(pinnedPages, 0, sizeof(pinnedPages));
+}
+
+void TmpFileSystem::setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr)
+{
+    pageFrameMgr = pageFrameMgrPtr;
+}
+
+Stream* TmpFileSystem::openStream(const char* path, int oflag)
+{
+    // files can only be in the root directory
+    size_t nameLen = strlen(path);
+    if (nameLen == 0 || nameLen >= TmpFile::MAX_NAME_SIZE || strchr(path, '/') != nullptr)
+    {
+        return nullptr;
+    }
+
+    // find a stream
+    TmpFileStream* stream = nullptr;
+    for (size_t i = 0; i < MAX_NUM_STREAMS && stream == nullptr; ++i)
+    {
+        if (!streams[i].isOpen())
+        {
+            stream = &streams[i];
+        }
+    }
+
+    if (stream == nullptr)
+    {
+        return nullptr;
+    }
+
+    // find the file or create it
+    TmpFile* file = findFile(path);
+    if (file == nullptr && (oflag & O_CREAT) != 0)
+    {
+        file = createFile(path);
+    }
+
+    if (file == nullptr)
+    {
+        return nullptr;
+    }
+
+    if ( (oflag & O_TRUNC) != 0 && (oflag & O_WRONLY) != 0 )
+    {
+        truncate(file);
+    }
+
+    ++file->numStreams;
+    stream->open(this, file, oflag);
+
+    return stream;
+}
+
+bool TmpFileSystem::unlink(const char* path)
+{
+    TmpFile* file = findFile(path);
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // the file's pages are freed when its last stream is closed
+    if (file->numStreams > 0)
+    {
+        file->isUnlinked = true;
+    }
+    else
+    {
+        truncate(file);
+        file->isUsed = false;
+    }
+
+    return true;
+}
+
+size_t TmpFileSystem::getDirEntries(size_t index, dirent* entries, size_t maxEntries)
+{
+    size_t numEntries = 0;
+    for (size_t i = 0; i < MAX_NUM_FILES && numEntries < maxEntries; ++i)
+    {
+        const TmpFile& file = files[i];
+        if (!file.isUsed || file.isUnlinked)
+        {
+            continue;
+        }
+
+        if (index > 0)
+        {
+            --index;
+            continue;
+        }
+
+        // the file's index is its inode number
+        dirent& entry = entries[numEntries++];
+        entry.d_ino = i;
+        strncpy(entry.d_name, file.name, NAME_MAX);
+        entry.d_name[NAME_MAX] = '\0';
+    }
+
+    return numEntries;
+}
+
+bool TmpFileSystem::getResidentPage(uint32_t inode, size_t pageIdx, uintptr_t& physicalAddr, uintptr_t& virtualAddr)
+{
+    if (inode >= MAX_NUM_FILES || pageIdx >= files[inode].numPages)
+    {
+        return false;
+    }
+
+    uintptr_t addr = getPagePhysicalAddr(&files[inode], pageIdx);
+
+    // pin the page, so it isn't freed while it's used
+    PinnedPage* pinnedPage = nullptr;
+    for (PinnedPage& page : pinnedPages)
+    {
+        if (page.pinCount > 0 && page.physicalAddr == addr)
+        {
+            pinnedPage = &page;
+            break;
+        }
+
+        if (page.pinCount == 0 && pinnedPage == nullptr)
+        {
+            pinnedPage = &page;
+        }
+    }
+
+    if (pinnedPage == nullptr)
+    {
+        klog.logWarning(LOG_TAG, "Too many pinned pages");
+        return false;
+    }
+
+    if (pinnedPage->pinCount == 0)
+    {
+        pinnedPage->physicalAddr = addr;
+        pinnedPage->isFreed = false;
+    }
+    ++pinnedPage->pinCount;
+
+    // the file's pages are only mapped while they're accessed
+    physicalAddr = addr;
+    virtualAddr = 0;
+
+    return true;
+}
+
+void TmpFileSystem::releaseResidentPage(uint32_t /*inode*/, uintptr_t physicalAddr)
+{
+    for (PinnedPage& page : pinnedPages)
+    {
+        if (page.pinCount > 0 && page.physicalAddr == physicalAddr)
+        {
+            --page.pinCount;
+            if (page.pinCount == 0 && page.isFreed)
+            {
+                pageFrameMgr->freePageFrame(physicalAddr);
+            }
+
+            return;
+        }
+    }
+
+    PANIC("Released a page that is not pinned.");
+}
+
+ssize_t TmpFileSystem::read(const TmpFile* file, size_t position, uint8_t* buff, size_t nbyte, PageCache::ReadAhead& readAhead)
+{
+    // the file's index is its inode number
+    uint32_t inode = file - files;
+    return pageCache.read(this, inode, file->size, position, buff, nbyte, readAhead);
+}
+
+ssize_t TmpFileSystem::send(const TmpFile* file, size_t position, Stream* outStream, size_t nbyte, PageCache::ReadAhead& readAhead)
+{
+    uint32_t inode = file - files;
+    return pageCache.send(this, inode, file->size, position, outStream, nbyte, readAhead);
+}
+
+ssize_t TmpFileSystem::write(TmpFile* file, size_t position, const uint8_t* buff, size_t nbyte)
+{
+    // allocate the pages needed to hold the data
+    size_t end = position + nbyte;
+    while (file->numPages * PAGE_SIZE < end && addPage(file))
+    {
+    }
+
+    // write as much as fits in the pages that could be allocated
+    size_t capacity = file->numPages * PAGE_SIZE;
+    if (position >= capacity)
+    {
+        return nbyte == 0 ? 0 : -ENOSPC;
+    }
+
+    if (nbyte > capacity - position)
+    {
+        nbyte = capacity - position;
+    }
+
+    // copy the data one page at a time
+    size_t numWritten = 0;
+    while (numWritten < nbyte)
+    {
+        size_t pageIdx = (position + numWritten) / PAGE_SIZE;
+        size_t offset = (position + numWritten) & PAGE_SIZE_MASK;
+        size_t num = PAGE_SIZE - offset;
+        if (num > nbyte - numWritten)
+        {
+            num = nbyte - numWritten;
+        }
+
+        uint8_t* page = processMgr.mapTempPage(getPagePhysicalAddr(file, pageIdx));
+        if (page == nullptr)
+        {
+            break;
+        }
+
+        memcpy(page + offset, buff + numWritten, num);
+        processMgr.unmapTempPage(page);
+
+        numWritten += num;
+    }
+
+    // any gap between the old end and the position is already zeroed
+    if (position + numWritten > file->size)
+    {
+        file->size = position + numWritten;
+    }
+
+    return static_cast<ssize_t>(numWritten);
+}
+
+void TmpFileSystem::closeFile(TmpFile* file)
+{
+    --file->numStreams;
+
+    if (file->numStreams == 0 && file->isUnlinked)
+    {
+        truncate(file);
+        file->isUsed = false;
+        file->isUnlinked = false;
+    }
+}
+
+TmpFile* TmpFileSystem::findFile(const char* name)
+{
+    for (TmpFile& file : files)
+    {
+        if (file.isUsed && !file.isUnlinked && strcmp(file.name, name) == 0)
+        {
+            return &file;
+        }
+    }
+
+    return nullptr;
+}
+
+TmpFile* TmpFileSystem::createFile(const char* name)
+{
+    for (TmpFile& file : files)
+    {
+        if (!file.isUsed)
+        {
+            memset(&file, 0, sizeof(file));
+            strcpy(file.name, name);
+            file.isUsed = true;
+
+            return &file;
+        }
+    }
+
+    klog.logWarning(LOG_TAG, "No free file entries");
+
+    return nullptr;
+}
+
+bool TmpFileSystem::addPage(TmpFile* file)
+{
+    if (pageFrameMgr == nullptr)
+    {
+        return false;
+    }
+
+    uintptr_t physicalAddr = pageFrameMgr->allocPageFrame();
+    if (physicalAddr == 0)
+    {
+        klog.logWarning(LOG_TAG, "Could not allocate a page");
+        return false;
+    }
+
+    // zero the page, so reads past the written data return zeros
+    uint8_t* page = processMgr.mapTempPage(physicalAddr);
+    if (page == nullptr)
+    {
+        pageFrameMgr->freePageFrame(physicalAddr);
+        return false;
+    }
+
+    memset(page, 0, PAGE_SIZE);
+    processMgr.unmapTempPage(page);
+
+    // extend the last extent if the page follows it in physical memory
+    TmpFile::Extent* lastExtent = (file->numExtents > 0) ? &file->extents[file->numExtents - 1] : nullptr;
+    if (lastExtent != nullptr && lastExtent->physicalAddr + lastExtent->numPages * PAGE_SIZE == physicalAddr)
+    {
+        ++lastExtent->numPages;
+    }
+    else if (file->numExtents < TmpFile::MAX_NUM_EXTENTS)
+    {
+        file->extents[file->numExtents++] = {physicalAddr, 1};
+    }
+    else
+    {
+        klog.logWarning(LOG_TAG, "File {} has too many extents", file->name);
+        pageFrameMgr->freePageFrame(physicalAddr);
+        return false;
+    }
+
+    ++file->numPages;
+
+    return true;
+}
+
+void TmpFileSystem::truncate(TmpFile* file)
+{
+    for (size_t i = 0; i < file->numExtents; ++i)
+    {
+        const TmpFile::Extent& extent = file->extents[i];
+        for (size_t j = 0; j < extent.numPages; ++j)
+        {
+            freePage(extent.physicalAddr + j * PAGE_SIZE);
+        }
+    }
+
+    file->numExtents = 0;
+    file->numPages = 0;
+    file->size = 0;
+}
+
+void TmpFileSystem::freePage(uintptr_t physicalAddr)
+{
+    for (PinnedPage& page : pinnedPages)
+    {
+        if (page.pinCount > 0 && page.physicalAddr == physicalAddr)
+        {
+            page.isFreed = true;
+            return;
+        }
+    }
+
+    pageFrameMgr->freePageFrame(physicalAddr);
+}
+
+uintptr_t TmpFileSystem::getPagePhysicalAddr(const TmpFile* file, size_t pageIdx) const
+{
+    for (size_t i = 0; i < file->numExtents; ++i)
+    {
+        const TmpFile::Extent& extent = file->extents[i];
+        if (pageIdx < extent.numPages)
+        {
+            return extent.physicalAddr + pageIdx * PAGE_SIZE;
+        }
+
+        pageIdx -= extent.numPages;
+    }
+
+    PANIC("Page index is past the end of the file.");
+
+    return 0;
+}
+
+// create TmpFileSystem instance
+TmpFileSystem tmpFileSystem;
@@ -0,0 +1,153 @@
+#ifndef TMP_FILE_SYSTEM_H_
+#define TMP_FILE_SYSTEM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+#include "filesystem.h"
+#include "pagecache.h"
+#include "tmpfilestream.h"
+
+class PageFrameMgr;
+
+/**
+ * @brief A file in a TmpFileSystem.
+ */
+struct TmpFile
+{
+    /**
+     * @brief Page frames that are contiguous in physical memory.
+     */
+    struct Extent
+    {
+        uintptr_t physicalAddr;
+        size_t numPages;
+    };
+
+    constexpr static size_t MAX_NAME_SIZE = FileSystem::MAX_NAME_SIZE;
+    constexpr static size_t MAX_NUM_EXTENTS = 16;
+
+    char name[MAX_NAME_SIZE];
+
+    /// size of the file's data in bytes
+    size_t size;
+
+    /// the page frames that store the file's data in order
+    Extent extents[MAX_NUM_EXTENTS];
+    size_t numExtents;
+
+    /// number of pages in all extents
+    size_t numPages;
+
+    /// number of open streams to the file
+    int numStreams;
+
+    bool isUsed;
+
+    /// whether the file has been unlinked but is still open
+    bool isUnlinked;
+};
+
+/**
+ * @brief A writable file system stored in memory.
+ * @details Files are stored in page frames allocated from the page frame
+ * manager, so the files only last until the system is shut down.
+ */
+class TmpFileSystem : public FileSystem
+{
+public:
+    TmpFileSystem();
+
+    void setPageFrameMgr(PageFrameMgr* pageFrameMgrPtr);
+
+    Stream* openStream(const char* path, int oflag) override;
+
+    bool unlink(const char* path) override;
+
+    size_t getDirEntries(size_t index, dirent* entries, size_t maxEntries) override;
+
+    bool getResidentPage(uint32_t inode, size_t pageIdx, uintptr_t& physicalAddr, uintptr_t& virtualAddr) override;
+
+    void releaseResidentPage(uint32_t inode, uintptr_t physicalAddr) override;
+
+    /**
+     * @brief Read from a file through the page cache.
+     * @return The number of bytes read.
+     */
+    ssize_t read(const TmpFile* file, size_t position, uint8_t* buff, size_t nbyte, PageCache::ReadAhead& readAhead);
+
+    /**
+     * @brief Write part of a file to a stream through the page cache.
+     * @return The number of bytes written to the stream.
+     */
+    ssize_t send(const TmpFile* file, size_t position, Stream* outStream, size_t nbyte, PageCache::ReadAhead& readAhead);
+
+    /**
+     * @brief Write to a file, allocating pages as needed.
+     * @return The number of bytes written, or -ENOSPC if no memory could be
+     * allocated.
+     */
+    ssize_t write(TmpFile* file, size_t position, const uint8_t* buff, size_t nbyte);
+
+    /**
+     * @brief Called when a stream to a file is closed.
+     */
+    void closeFile(TmpFile* file);
+
+private:
+    constexpr static size_t MAX_NUM_FILES = 16;
+    TmpFile files[MAX_NUM_FILES];
+
+    constexpr static size_t MAX_NUM_STREAMS = 16;
+    TmpFileStream streams[MAX_NUM_STREAMS];
+
+    /**
+     * @brief A page the page cache is using in place.
+     * @details The page cache may block while it writes a page to a stream,
+     * so a page that is freed meanwhile is only freed once it is released.
+     */
+    struct PinnedPage
+    {
+        uintptr_t physicalAddr;
+
+        /// the number of users of the page; the entry is unused if 0
+        int pinCount;
+
+        /// whether the page was freed while it was pinned
+        bool isFreed;
+    };
+
+    // each transfer through the page cache pins one page at a time
+    constexpr static size_t MAX_NUM_PINNED_PAGES = 2 * MAX_NUM_STREAMS;
+    PinnedPage pinnedPages[MAX_NUM_PINNED_PAGES];
+
+    PageFrameMgr* pageFrameMgr;
+
+    TmpFile* findFile(const char* name);
+
+    TmpFile* createFile(const char* name);
+
+    /**
+     * @brief Append a zeroed page to a file.
+     */
+    bool addPage(TmpFile* file);
+
+    /**
+     * @brief Free all of a file's pages.
+     */
+    void truncate(TmpFile* file);
+
+    /**
+     * @brief Free a page, or defer it until it is released if it is pinned.
+     */
+    void freePage(uintptr_t physicalAddr);
+
+    /**
+     * @brief Get the physical address of one of a file's pages.
+     */
+    uintptr_t getPagePhysicalAddr(const TmpFile* file, size_t pageIdx) const;
+};
+
+extern TmpFileSystem tmpFileSystem;
+
+#endif // TMP_FILE_SYSTEM_H_
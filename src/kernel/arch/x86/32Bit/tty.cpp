@@ -0,0 +1,369 @@
+#include <errno.h>
+#include <string.h>
+
+#include "tty.h"
+
+Tty::Tty(Stream* inStream, Stream* outStream)
+{
+    input = inStream;
+    output = outStream;
+    lineSize = 0;
+    readMinSize = 1;
+
+    // start in canonical mode with echo
+    attribs.c_iflag = ICRNL;
+    attribs.c_oflag = 0;
+    attribs.c_cflag = 0;
+    attribs.c_lflag = ICANON | ECHO | ECHOE;
+    attribs.c_cc[VEOF] = '\x04';   // Ctrl+D
+    attribs.c_cc[VERASE] = '\b';
+    attribs.c_cc[VKILL] = '\x15';  // Ctrl+U
+    attribs.c_cc[VMIN] = 1;
+    attribs.c_cc[VTIME] = 0;
+
+    input->setInputHandler(handleInput, this);
+}
+
+ssize_t Tty::read(uint8_t* buff, size_t nbyte)
+{
+    processInput();
+
+    if (nbyte == 0)
+    {
+        return 0;
+    }
+
+    size_t idx = 0;
+    uint16_t item = 0;
+    if (isCanonical())
+    {
+        // return at most one line
+        bool endOfFile = false;
+        while (idx < nbyte && readyQueue.dequeue(item))
+        {
+            if (item == END_OF_FILE)
+            {
+                endOfFile = true;
+                break;
+            }
+
+            buff[idx++] = static_cast<uint8_t>(item);
+            if (item == '\n')
+            {
+                break;
+            }
+        }
+
+        if (idx == 0 && !endOfFile)
+        {
+            return -EAGAIN;
+        }
+    }
+    else
+    {
+        // wait until VMIN characters are available (0 doesn't wait, unless
+        // VTIME sets a timeout to wait for one character)
+        size_t minSize = attribs.c_cc[VMIN];
+        if (minSize == 0 && attribs.c_cc[VTIME] > 0)
+        {
+            minSize = 1;
+        }
+        if (minSize > nbyte)
+        {
+            minSize = nbyte;
+        }
+
+        if (readyQueue.getSize() < minSize)
+        {
+            // the input handler wakes the reader once there are enough
+            readMinSize = minSize;
+            return -EAGAIN;
+        }
+
+        while (idx < nbyte && readyQueue.dequeue(item))
+        {
+            // end of file only has a meaning in canonical mode
+            if (item != END_OF_FILE)
+            {
+                buff[idx++] = static_cast<uint8_t>(item);
+            }
+        }
+    }
+
+    // input left in the device while the ready queue was full
+    processInput();
+
+    return static_cast<ssize_t>(idx);
+}
+
+ssize_t Tty::write(const uint8_t* buff, size_t nbyte)
+{
+    return output->write(buff, nbyte);
+}
+
+WaitQueue* Tty::getWaitQueue()
+{
+    return input->getWaitQueue();
+}
+
+uint64_t Tty::getReadTimeout() const
+{
+    // VTIME is in tenths of a second; with VMIN set, it would time the gap
+    // between characters, which is not supported
+    if (isCanonical() || attribs.c_cc[VMIN] != 0)
+    {
+        return 0;
+    }
+
+    return attribs.c_cc[VTIME] * 100'000'000ULL;
+}
+
+int Tty::getTerminalAttributes(termios* attributes) const
+{
+    *attributes = attribs;
+    return 0;
+}
+
+int Tty::setTerminalAttributes(int optionalActions, const termios* attributes)
+{
+    if (optionalActions != TCSANOW && optionalActions != TCSADRAIN && optionalActions != TCSAFLUSH)
+    {
+        return -EINVAL;
+    }
+
+    if (optionalActions != TCSANOW)
+    {
+        output->flush();
+    }
+
+    if (optionalActions == TCSAFLUSH)
+    {
+        // discard input that hasn't been read
+        processInput();
+
+        uint16_t item = 0;
+        while (readyQueue.dequeue(item))
+        {
+        }
+
+        lineSize = 0;
+    }
+
+    bool wasCanonical = isCanonical();
+    attribs = *attributes;
+
+    // a waiting reader checks VMIN again when it is woken
+    readMinSize = 1;
+
+    // the line being edited can be read right away in raw mode; what
+    // doesn't fit in the ready queue is moved when there is room
+    if (wasCanonical && !isCanonical())
+    {
+        moveLineToReadyQueue();
+    }
+
+    return 0;
+}
+
+void Tty::flush()
+{
+    output->flush();
+}
+
+bool Tty::isCanonical() const
+{
+    return (attribs.c_lflag & ICANON) != 0;
+}
+
+bool Tty::isReadable() const
+{
+    if (isCanonical())
+    {
+        // the ready queue only has complete lines
+        return !readyQueue.isEmpty();
+    }
+
+    return readyQueue.getSize() >= readMinSize;
+}
+
+bool Tty::handleInput(void* data)
+{
+    Tty* tty = static_cast<Tty*>(data);
+    tty->processInput();
+    return tty->isReadable();
+}
+
+void Tty::processInput()
+{
+    constexpr size_t BUFF_SIZE = 32;
+    uint8_t buff[BUFF_SIZE];
+
+    // characters left in the line when raw mode was set go first
+    if (!isCanonical())
+    {
+        moveLineToReadyQueue();
+    }
+
+    // leave input in the device when there is no room for it: each
+    // character takes at most one place in the ready queue, and in
+    // canonical mode, the line being edited must still fit when it is
+    // completed
+    while (true)
+    {
+        size_t room = READY_QUEUE_SIZE - readyQueue.getSize();
+        if (room <= lineSize)
+        {
+            break;
+        }
+
+        size_t num = room - lineSize;
+        if (num > BUFF_SIZE)
+        {
+            num = BUFF_SIZE;
+        }
+
+        ssize_t numRead = input->read(buff, num);
+        if (numRead <= 0)
+        {
+            break;
+        }
+
+        for (ssize_t i = 0; i < numRead; ++i)
+        {
+            processChar(static_cast<char>(buff[i]));
+        }
+    }
+}
+
+void Tty::processChar(char ch)
+{
+    if ( (attribs.c_iflag & ICRNL) != 0 && ch == '\r' )
+    {
+        ch = '\n';
+    }
+
+    if (!isCanonical())
+    {
+        if (readyQueue.enqueue(static_cast<uint8_t>(ch)))
+        {
+            echoChar(ch);
+        }
+    }
+    else if (ch == static_cast<char>(attribs.c_cc[VERASE]) || ch == DELETE)
+    {
+        eraseChar();
+    }
+    else if (ch == static_cast<char>(attribs.c_cc[VKILL]))
+    {
+        while (lineSize > 0)
+        {
+            eraseChar();
+        }
+    }
+    else if (ch == static_cast<char>(attribs.c_cc[VEOF]))
+    {
+        // the line can be read without a newline, and an empty line is the
+        // end of file
+        completeLine(END_OF_FILE);
+    }
+    else if (ch == '\n')
+    {
+        if (completeLine('\n'))
+        {
+            echoChar(ch);
+        }
+    }
+    else if (lineSize < MAX_LINE_SIZE - 1)
+    {
+        // leave room for the newline
+        line[lineSize++] = ch;
+        echoChar(ch);
+    }
+}
+
+bool Tty::completeLine(uint16_t end)
+{
+    if (READY_QUEUE_SIZE - readyQueue.getSize() < lineSize + 1)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < lineSize; ++i)
+    {
+        readyQueue.enqueue(static_cast<uint8_t>(line[i]));
+    }
+    readyQueue.enqueue(end);
+
+    lineSize = 0;
+
+    return true;
+}
+
+void Tty::moveLineToReadyQueue()
+{
+    size_t num = 0;
+    while (num < lineSize && readyQueue.enqueue(static_cast<uint8_t>(line[num])))
+    {
+        ++num;
+    }
+
+    lineSize -= num;
+    memmove(line, line + num, lineSize);
+}
+
+void Tty::eraseChar()
+{
+    if (lineSize == 0)
+    {
+        return;
+    }
+
+    char ch = line[--lineSize];
+
+    if ( (attribs.c_lflag & ECHO) != 0 )
+    {
+        if ( (attribs.c_lflag & ECHOE) != 0 )
+        {
+            // control characters were echoed with two characters
+            echo("\b \b", 3);
+            if (isEchoedAsControl(ch))
+            {
+                echo("\b \b", 3);
+            }
+        }
+        else
+        {
+            echoChar(static_cast<char>(attribs.c_cc[VERASE]));
+        }
+    }
+}
+
+void Tty::echoChar(char ch)
+{
+    if ( (attribs.c_lflag & ECHO) == 0 )
+    {
+        return;
+    }
+
+    if (isEchoedAsControl(ch))
+    {
+        char str[2] = {'^', static_cast<char>(ch ^ 0x40)};
+        echo(str, 2);
+    }
+    else
+    {
+        echo(&ch, 1);
+    }
+}
+
+void Tty::echo(const char* str, size_t len)
+{
+    // echo is dropped if the output device is full
+    output->write(reinterpret_cast<const uint8_t*>(str), len);
+}
+
+bool Tty::isEchoedAsControl(char ch)
+{
+    bool isControl = static_cast<uint8_t>(ch) < ' ' || ch == DELETE;
+    return isControl && ch != '\n' && ch != '\t' && ch != '\b';
+}
@@ -0,0 +1,148 @@
+#ifndef TTY_H_
+#define TTY_H_
+
+#include <termios.h>
+
+#include "queue.hpp"
+#include "stream.h"
+
+/**
+ * @brief A terminal that connects an input device and an output device
+ * through a line discipline.
+ * @details In canonical mode (ICANON), input is collected in a line that
+ * can be edited with the erase and kill characters, and read() returns at
+ * most one line once it is complete. In raw mode, read() returns characters
+ * as they arrive. With ECHO set, input is echoed to the output device by the
+ * kernel.
+ *
+ * Input is run through the line discipline by the input device's bottom
+ * half as it arrives, so it is echoed even when no process is reading, and
+ * readers are only woken once there is something for them to read.
+ */
+class Tty : public Stream
+{
+public:
+    /**
+     * @brief Constructor
+     * @param inStream The device to read input from.
+     * @param outStream The device to write output and echo to.
+     */
+    Tty(Stream* inStream, Stream* outStream);
+
+    bool canRead() const override
+    {
+        return true;
+    }
+
+    bool canWrite() const override
+    {
+        return true;
+    }
+
+    /**
+     * @brief Read input that has been through the line discipline.
+     * @return The number of bytes read (0 at end of file), or -EAGAIN if no
+     * input is ready yet.
+     */
+    ssize_t read(uint8_t* buff, size_t nbyte) override;
+
+    ssize_t write(const uint8_t* buff, size_t nbyte) override;
+
+    /**
+     * @brief Get the input device's wait queue, which is woken when a line
+     * is complete or, in raw mode, when VMIN characters are ready.
+     */
+    WaitQueue* getWaitQueue() override;
+
+    /**
+     * @brief Get the read timeout, which is VTIME in raw mode when VMIN is
+     * 0.
+     */
+    uint64_t getReadTimeout() const override;
+
+    int getTerminalAttributes(termios* attributes) const override;
+
+    int setTerminalAttributes(int optionalActions, const termios* attributes) override;
+
+    void flush() override;
+
+    void close() override
+    {
+        // nothing to do
+    }
+
+private:
+    /// the maximum size of a line in canonical mode
+    static constexpr size_t MAX_LINE_SIZE = 256;
+
+    /// the size of the queue of input ready to be read
+    static constexpr size_t READY_QUEUE_SIZE = 256;
+
+    /// marks the end of a line ended by the EOF character in the ready queue
+    static constexpr uint16_t END_OF_FILE = 0x100;
+
+    static constexpr char DELETE = '\x7F';
+
+    Stream* input;
+
+    Stream* output;
+
+    termios attribs;
+
+    /// input ready to be read
+    Queue<uint16_t, READY_QUEUE_SIZE> readyQueue;
+
+    /// the line being edited in canonical mode
+    char line[MAX_LINE_SIZE];
+    size_t lineSize;
+
+    /// the number of characters the last reader waited for in raw mode
+    size_t readMinSize;
+
+    bool isCanonical() const;
+
+    /**
+     * @brief Whether a waiting reader can return.
+     */
+    bool isReadable() const;
+
+    /**
+     * @brief The input device's input handler.
+     * @param data The Tty.
+     * @return Whether waiting readers should be woken.
+     */
+    static bool handleInput(void* data);
+
+    /**
+     * @brief Run the characters available from the input device through the
+     * line discipline.
+     */
+    void processInput();
+
+    /**
+     * @brief Move as much of the line being edited to the ready queue as
+     * fits (when switching to raw mode).
+     */
+    void moveLineToReadyQueue();
+
+    void processChar(char ch);
+
+    /**
+     * @brief Move the line being edited to the ready queue.
+     * @return true if there was room for it; false, otherwise
+     */
+    bool completeLine(uint16_t end);
+
+    void eraseChar();
+
+    void echoChar(char ch);
+
+    void echo(const char* str, size_t len);
+
+    /**
+     * @brief Whether a character is echoed as a caret and a letter (e.g. ^C).
+     */
+    static bool isEchoedAsControl(char ch);
+};
+
+#endif // TTY_H_
@@ -0,0 +1,308 @@
+#include <errno.h>
+#include <string.h>
+#include <termios.h>
+#include "tty.h"
+#include "unittests.h"
+
+namespace
+{
+
+/**
+ * @brief A device that returns input added by a test and records what is
+ * written to it.
+ */
+class TestStream : public Stream
+{
+public:
+    TestStream();
+
+    void addInput(const char* str);
+
+    size_t getInputSize() const;
+
+    /**
+     * @brief Run the input handler like the device's bottom half would.
+     * @return Whether readers would be woken.
+     */
+    bool runInputHandler();
+
+    const char* getOutput() const;
+
+    bool canRead() const override
+    {
+        return true;
+    }
+
+    bool canWrite() const override
+    {
+        return true;
+    }
+
+    ssize_t read(uint8_t* buff, size_t nbyte) override;
+
+    ssize_t write(const uint8_t* buff, size_t nbyte) override;
+
+    void setInputHandler(InputHandler handler, void* data) override;
+
+    void flush() override
+    {
+        // nothing to do
+    }
+
+    void close() override
+    {
+        // nothing to do
+    }
+
+private:
+    static constexpr size_t MAX_BUFF_SIZE = 512;
+
+    char input[MAX_BUFF_SIZE];
+    size_t inputStart;
+    size_t inputEnd;
+
+    char output[MAX_BUFF_SIZE];
+    size_t outputSize;
+
+    InputHandler inputHandler;
+    void* inputHandlerData;
+};
+
+TestStream::TestStream() :
+    inputStart(0),
+    inputEnd(0),
+    outputSize(0),
+    inputHandler(nullptr),
+    inputHandlerData(nullptr)
+{
+    output[0] = '\0';
+}
+
+void TestStream::addInput(const char* str)
+{
+    size_t len = strlen(str);
+    if (len > MAX_BUFF_SIZE - inputEnd)
+    {
+        len = MAX_BUFF_SIZE - inputEnd;
+    }
+
+    memcpy(input + inputEnd, str, len);
+    inputEnd += len;
+}
+
+size_t TestStream::getInputSize() const
+{
+    return inputEnd - inputStart;
+}
+
+bool TestStream::runInputHandler()
+{
+    return inputHandler == nullptr || inputHandler(inputHandlerData);
+}
+
+const char* TestStream::getOutput() const
+{
+    return output;
+}
+
+ssize_t TestStream::read(uint8_t* buff, size_t nbyte)
+{
+    size_t num = inputEnd - inputStart;
+    if (num > nbyte)
+    {
+        num = nbyte;
+    }
+
+    if (num == 0 && nbyte > 0)
+    {
+        return -EAGAIN;
+    }
+
+    memcpy(buff, input + inputStart, num);
+    inputStart += num;
+
+    return static_cast<ssize_t>(num);
+}
+
+ssize_t TestStream::write(const uint8_t* buff, size_t nbyte)
+{
+    size_t num = MAX_BUFF_SIZE - 1 - outputSize;
+    if (num > nbyte)
+    {
+        num = nbyte;
+    }
+
+    memcpy(output + outputSize, buff, num);
+    outputSize += num;
+    output[outputSize] = '\0';
+
+    return static_cast<ssize_t>(num);
+}
+
+void TestStream::setInputHandler(InputHandler handler, void* data)
+{
+    inputHandler = handler;
+    inputHandlerData = data;
+}
+
+/**
+ * @brief Read from a Tty into a null-terminated string.
+ * @return What Tty::read() returned.
+ */
+ssize_t readStr(Tty& tty, char* str, size_t size)
+{
+    ssize_t rv = tty.read(reinterpret_cast<uint8_t*>(str), size - 1);
+    str[rv > 0 ? rv : 0] = '\0';
+    return rv;
+}
+
+void setRaw(Tty& tty, cc_t minSize, bool echo)
+{
+    termios attribs;
+    tty.getTerminalAttributes(&attribs);
+    attribs.c_lflag &= ~ICANON;
+    if (!echo)
+    {
+        attribs.c_lflag &= ~ECHO;
+    }
+    attribs.c_cc[VMIN] = minSize;
+    attribs.c_cc[VTIME] = 0;
+    tty.setTerminalAttributes(TCSANOW, &attribs);
+}
+
+} // namespace
+
+TtyTestClass::TtyTestClass() :
+    TestClass("Tty")
+{
+}
+
+void TtyTestClass::runTests()
+{
+    runTest("EditLine", []()
+    {
+        TestStream device;
+        Tty tty(&device, &device);
+        char str[64];
+
+        device.addInput("ab\bc");
+        ASSERT_FALSE(device.runInputHandler(), "Readers were woken before the line was complete.");
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), -EAGAIN);
+
+        device.addInput("\r");
+        ASSERT_TRUE(device.runInputHandler());
+        ASSERT_CSTR_EQ(device.getOutput(), "ab\b \bc\n");
+
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 3);
+        ASSERT_CSTR_EQ(str, "ac\n");
+    });
+
+    runTest("OneLinePerRead", []()
+    {
+        TestStream device;
+        Tty tty(&device, &device);
+        char str[64];
+
+        device.addInput("one\ntwo\n");
+        ASSERT_TRUE(device.runInputHandler());
+
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 4);
+        ASSERT_CSTR_EQ(str, "one\n");
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 4);
+        ASSERT_CSTR_EQ(str, "two\n");
+    });
+
+    runTest("KillLine", []()
+    {
+        TestStream device;
+        Tty tty(&device, &device);
+        char str[64];
+
+        device.addInput("abc\x15" "d\n");
+        ASSERT_TRUE(device.runInputHandler());
+
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 2);
+        ASSERT_CSTR_EQ(str, "d\n");
+    });
+
+    runTest("EndOfFile", []()
+    {
+        TestStream device;
+        Tty tty(&device, &device);
+        char str[64];
+
+        // the line is returned without a newline, and then an empty line is
+        // the end of file
+        device.addInput("ab\x04\x04");
+        ASSERT_TRUE(device.runInputHandler());
+
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 2);
+        ASSERT_CSTR_EQ(str, "ab");
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 0);
+    });
+
+    runTest("RawMinSize", []()
+    {
+        TestStream device;
+        Tty tty(&device, &device);
+        char str[64];
+
+        setRaw(tty, 3, true);
+
+        device.addInput("x");
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), -EAGAIN);
+
+        // the reader is only woken once VMIN characters are ready
+        device.addInput("y");
+        ASSERT_FALSE(device.runInputHandler(), "Readers were woken before VMIN characters were ready.");
+        device.addInput("z");
+        ASSERT_TRUE(device.runInputHandler());
+        ASSERT_CSTR_EQ(device.getOutput(), "xyz");
+
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 3);
+        ASSERT_CSTR_EQ(str, "xyz");
+    });
+
+    runTest("LineToRaw", []()
+    {
+        TestStream device;
+        Tty tty(&device, &device);
+        char str[64];
+
+        // the line being edited can be read once raw mode is set
+        device.addInput("abc");
+        ASSERT_FALSE(device.runInputHandler());
+        setRaw(tty, 1, true);
+
+        ASSERT_EQ(readStr(tty, str, sizeof(str)), 3);
+        ASSERT_CSTR_EQ(str, "abc");
+    });
+
+    runTest("FullReadyQueue", []()
+    {
+        TestStream device;
+        Tty tty(&device, &device);
+        char str[400];
+
+        setRaw(tty, 1, false);
+
+        // input that doesn't fit in the ready queue is left in the device
+        constexpr size_t NUM_CHARS = 300;
+        memset(str, 'a', NUM_CHARS);
+        str[NUM_CHARS] = '\0';
+        device.addInput(str);
+        ASSERT_TRUE(device.runInputHandler());
+        ASSERT_GT(device.getInputSize(), 0u);
+
+        size_t total = 0;
+        ssize_t rv = readStr(tty, str, sizeof(str));
+        while (rv > 0)
+        {
+            total += rv;
+            rv = readStr(tty, str, sizeof(str));
+        }
+
+        ASSERT_EQ(total, NUM_CHARS);
+        ASSERT_EQ(device.getInputSize(), 0u);
+    });
+}
@@ -15,5 +15,40 @@ bool runUnitTests(size_t& numTests, size_t& numFailed)
     numTests += loggerClass.getNumTests();
     numFailed += loggerClass.getNumFailed();
 
+    InitrdFileSystemTestClass initrdFileSystemClass;
+    initrdFileSystemClass.run();
+    numTests += initrdFileSystemClass.getNumTests();
+    numFailed += initrdFileSystemClass.getNumFailed();
+
+    BlockRequestQueueTestClass blockRequestQueueClass;
+    blockRequestQueueClass.run();
+    numTests += blockRequestQueueClass.getNumTests();
+    numFailed += blockRequestQueueClass.getNumFailed();
+
+    VirtqueueTestClass virtqueueClass;
+    virtqueueClass.run();
+    numTests += virtqueueClass.getNumTests();
+    numFailed += virtqueueClass.getNumFailed();
+
+    Ext2FileSystemTestClass ext2FileSystemClass;
+    ext2FileSystemClass.run();
+    numTests += ext2FileSystemClass.getNumTests();
+    numFailed += ext2FileSystemClass.getNumFailed();
+
+    TtyTestClass ttyClass;
+    ttyClass.run();
+    numTests += ttyClass.getNumTests();
+    numFailed += ttyClass.getNumFailed();
+
+    TimerWheelTestClass timerWheelClass;
+    timerWheelClass.run();
+    numTests += timerWheelClass.getNumTests();
+    numFailed += timerWheelClass.getNumFailed();
+
+    PciBusTestClass pciBusClass;
+    pciBusClass.run();
+    numTests += pciBusClass.getNumTests();
+    numFailed += pciBusClass.getNumFailed();
+
     return (numFailed == 0);
 }
@@ -21,6 +21,81 @@ protected:
     void runTests() override;
 };
 
+class InitrdFileSystemTestClass : public TestClass
+{
+public:
+    InitrdFileSystemTestClass();
+
+protected:
+    void runTests() override;
+};
+
+class BlockRequestQueueTestClass : public TestClass
+{
+public:
+    BlockRequestQueueTestClass();
+
+protected:
+    void runTests() override;
+};
+
+class VirtqueueTestClass : public TestClass
+{
+public:
+    VirtqueueTestClass();
+
+protected:
+    void runTests() override;
+
+private:
+    class TestQueue;
+};
+
+class Ext2FileSystemTestClass : public TestClass
+{
+public:
+    Ext2FileSystemTestClass();
+
+protected:
+    void runTests() override;
+
+private:
+    class TestFileSystem;
+};
+
+class TtyTestClass : public TestClass
+{
+public:
+    TtyTestClass();
+
+protected:
+    void runTests() override;
+};
+
+class TimerWheelTestClass : public TestClass
+{
+public:
+    TimerWheelTestClass();
+
+protected:
+    void runTests() override;
+
+private:
+    class TestWheel;
+};
+
+class PciBusTestClass : public TestClass
+{
+public:
+    PciBusTestClass();
+
+protected:
+    void runTests() override;
+
+private:
+    class TestConfig;
+};
+
 bool runUnitTests(size_t& numTests, size_t& numFailed);
 
 #endif // UNIT_TESTS_H_
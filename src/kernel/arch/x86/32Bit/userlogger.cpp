@@ -24,6 +24,15 @@ void UserLogger::flush(const char* buff, size_t len)
     for (size_t i = 0; i < streamsSize; ++i)
     {
         streams[i]->write(ptr, len, /*block=*/ true);
+    }
+}
+
+void UserLogger::flushStreams()
+{
+    Logger::flush();
+
+    for (size_t i = 0; i < streamsSize; ++i)
+    {
         streams[i]->flush();
     }
 }
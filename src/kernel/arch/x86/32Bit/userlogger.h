@@ -15,6 +15,11 @@ public:
 
     void addStream(Stream* stream);
 
+    /**
+     * @brief Wait until the streams have sent all logged messages.
+     */
+    void flushStreams();
+
 protected:
     void flush(const char* buff, size_t len) override;
 
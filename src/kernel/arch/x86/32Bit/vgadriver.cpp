@@ -1,72 +1,24 @@
-#include <ctype.h>
 #include <string.h>
 
 #include "system.h"
 #include "vgadriver.h"
 
-const VgaDriver::EColor VgaDriver::SGR_COLOR_TO_ENUM[] =
-{
-    EColor::eBlack,
-    EColor::eRed,
-    EColor::eGreen,
-    EColor::eBrown,
-    EColor::eBlue,
-    EColor::eMagenta,
-    EColor::eCyan,
-    EColor::eWhite
-};
+uint16_t VgaDriver::shadow[SCREEN_HEIGHT][SCREEN_WIDTH];
 
-VgaDriver::VgaDriver()
+VgaDriver::VgaDriver() :
+    TextConsole(shadow[0], SCREEN_WIDTH, SCREEN_HEIGHT)
 {
     textMem = reinterpret_cast<uint16_t*>(0xB8000 + KERNEL_VIRTUAL_BASE);
-    csrX = 0;
-    csrY = 0;
-    defaultBackground = EColor::eBlack;
-    defaultForeground = EColor::eWhite;
-    inEscSequence = false;
-    escSequenceChar = '\0';
-    csiState = eParameter;
-    parameterBytesSize = 0;
-    intermediateBytesSize = 0;
-
-    // disable blinking
-    setBlinking(false);
-
-    // sets attrib
-    setBackgroundColor(defaultBackground);
-    setForegroundColor(defaultForeground);
-
-    clear(0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1);
-}
-
-VgaDriver::EColor VgaDriver::getForegroundColor() const
-{
-    uint16_t color = 0x0F00 & attrib;
-    color >>= 8;
-    return static_cast<EColor>(color);
+    origin = 0;
 }
 
-void VgaDriver::setForegroundColor(EColor color)
+void VgaDriver::init()
 {
-    uint16_t temp = static_cast<uint16_t>(color);
-    temp <<= 8;
-    attrib &= 0xF000; // clear all but background color
-    attrib |= temp; // set new foreground color
-}
-
-VgaDriver::EColor VgaDriver::getBackgroundColor() const
-{
-    uint16_t color = 0xF000 & attrib;
-    color >>= 12;
-    return static_cast<EColor>(color);
-}
+    // disable blinking
+    setBlinking(false);
 
-void VgaDriver::setBackgroundColor(EColor color)
-{
-    uint16_t temp = static_cast<uint16_t>(color);
-    temp <<= 12;
-    attrib &= 0x0F00; // clear all but foreground color
-    attrib |= temp; // set new background color
+    updateStartAddress();
+    flush();
 }
 
 void VgaDriver::setBlinking(bool enabled)
@@ -100,485 +52,52 @@ void VgaDriver::setBlinking(bool enabled)
     setInt();
 }
 
-unsigned int VgaDriver::getCursorX() const
-{
-    return csrX;
-}
-
-void VgaDriver::setCursorX(unsigned int x)
+bool VgaDriver::scrollScreen(unsigned int numLines)
 {
-    csrX = x;
+    // move the lines that are still on the screen with the start address
+    origin += numLines * SCREEN_WIDTH;
+    bool moved = true;
 
-    if (x >= SCREEN_WIDTH)
+    // when the bottom of text memory is reached, start over at the top
+    // and redraw the whole screen
+    if (origin + SCREEN_WIDTH * SCREEN_HEIGHT > TEXT_MEM_SIZE)
     {
-        csrX = SCREEN_WIDTH - 1;
+        origin = 0;
+        moved = false;
     }
 
-    updateCursor();
-}
+    updateStartAddress();
 
-unsigned int VgaDriver::getCursorY() const
-{
-    return csrY;
+    return moved;
 }
 
-void VgaDriver::setCursorY(unsigned int y)
+void VgaDriver::drawLine(unsigned int y, const uint16_t* line)
 {
-    csrY = y;
-
-    if (y >= SCREEN_HEIGHT)
-    {
-        csrY = SCREEN_HEIGHT - 1;
-    }
-
-    updateCursor();
+    memcpy(textMem + getOffset(0, y), line, SCREEN_WIDTH * sizeof(uint16_t));
 }
 
-ssize_t VgaDriver::write(const uint8_t* buff, size_t nbyte)
+unsigned int VgaDriver::getOffset(unsigned int x, unsigned int y) const
 {
-    size_t i = 0;
-    for (; i < nbyte; ++i)
-    {
-        writeChar(buff[i]);
-    }
-
-    return static_cast<ssize_t>(i);
+    return origin + y * SCREEN_WIDTH + x;
 }
 
-void VgaDriver::writeChar(char ch)
+void VgaDriver::updateStartAddress()
 {
-    if (inEscSequence)
-    {
-        parseEscSequence(ch);
-    }
-    else if (ch == ESCAPE)
-    {
-        inEscSequence = true;
-    }
-    else
-    {
-        outputChar(ch);
-        scroll();
-        updateCursor();
-    }
-}
-
-void VgaDriver::outputChar(char ch)
-{
-    if (ch == '\n')
-    {
-        ++csrY;
-        csrX = 0;
-    }
-    else if (ch == '\r')
-    {
-        csrX = 0;
-    }
-    else if (ch == '\t')
-    {
-        unsigned int spaces = TAB_SIZE - (csrX % TAB_SIZE);
-        csrX += spaces;
-        if (csrX >= SCREEN_WIDTH)
-        {
-            ++csrY;
-            csrX = 0;
-        }
-    }
-    else if (ch == '\b')
-    {
-        if (csrX > 0)
-        {
-            --csrX;
-        }
-    }
-    else
-    {
-        uint16_t val = attrib | static_cast<uint16_t>(ch);
-
-        unsigned int offset = csrY * SCREEN_WIDTH + csrX;
-        *(textMem + offset) = val;
-
-        ++csrX;
-        if (csrX >= SCREEN_WIDTH)
-        {
-            ++csrY;
-            csrX = 0;
-        }
-    }
-}
-
-void VgaDriver::scroll()
-{
-    if (csrY >= SCREEN_HEIGHT)
-    {
-        // move all lines up by 1
-        for (unsigned int line = 1; line < SCREEN_HEIGHT; ++line)
-        {
-            unsigned int dstIdx = (line - 1) * SCREEN_WIDTH;
-            unsigned int srcIdx = line * SCREEN_WIDTH;
-            memcpy(textMem + dstIdx, textMem + srcIdx, SCREEN_WIDTH * sizeof(uint16_t));
-        }
-
-        // clear bottom line
-        csrX = 0;
-        csrY = SCREEN_HEIGHT - 1;
-        for (unsigned int x = 0; x < SCREEN_WIDTH; ++x)
-        {
-            outputChar(' ');
-        }
-
-        // reset cursor to the bottom left corner of the screen
-        csrX = 0;
-        csrY = SCREEN_HEIGHT - 1;
-    }
+    outb(CRTC_ADDR_REG, CRTC_START_ADDR_HIGH);
+    outb(CRTC_DATA_REG, static_cast<uint8_t>(origin >> 8));
+    outb(CRTC_ADDR_REG, CRTC_START_ADDR_LOW);
+    outb(CRTC_DATA_REG, static_cast<uint8_t>(origin));
 }
 
 void VgaDriver::updateCursor()
 {
-    unsigned int pos = csrY * SCREEN_WIDTH + csrX;
+    // the cursor location is an offset in text memory, not on the screen
+    unsigned int pos = getOffset(getCursorX(), getCursorY());
 
     // set the upper and lower bytes of the
     // blinking cursor index
-    outb(0x3D4, 14);
-    outb(0x3D5, static_cast<uint8_t>(pos >> 8));
-    outb(0x3D4, 15);
-    outb(0x3D5, static_cast<uint8_t>(pos));
-}
-
-void VgaDriver::clear(unsigned int startX, unsigned int startY, unsigned int endX, unsigned int endY)
-{
-    unsigned int startPos = startY * SCREEN_WIDTH + startX;
-    unsigned int endPos = endY * SCREEN_WIDTH + endX;
-    uint16_t* startPtr = textMem + startPos;
-    uint16_t* endPtr = textMem + endPos;
-
-    for (uint16_t* ptr = startPtr; ptr <= endPtr; ++ptr)
-    {
-        *ptr = attrib | static_cast<uint16_t>(' ');
-    }
-}
-
-void VgaDriver::parseEscSequence(char ch)
-{
-    if (escSequenceChar == '\0')
-    {
-        escSequenceChar = ch;
-    }
-    else if (escSequenceChar == CSI)
-    {
-        parseCsi(ch);
-    }
-}
-
-void VgaDriver::parseCsi(char ch)
-{
-    bool reset = false;
-
-    if (ch >= CSI_START_PARAMETER_BYTE && ch <= CSI_END_PARAMETER_BYTE)
-    {
-        if (csiState == eParameter)
-        {
-            if (parameterBytesSize < MAX_PARAMETER_BYTES_SIZE - 1)
-            {
-                parameterBytes[parameterBytesSize++] = ch;
-            }
-            else
-            {
-                // error: ran out of buffer space
-                reset = true;
-            }
-        }
-        else
-        {
-            // error: got a parameter character while not in parameter state
-            reset = true;
-        }
-    }
-    else if (ch >= CSI_START_INTERMEDIATE_BYTE && ch <= CSI_END_INTERMEDIATE_BYTE)
-    {
-        if (csiState == eParameter)
-        {
-            // go to next state
-            csiState = eIntermediate;
-        }
-
-        if (csiState == eIntermediate)
-        {
-            if (intermediateBytesSize < MAX_INTERMEDIATE_BYTES_SIZE - 1)
-            {
-                intermediateBytes[intermediateBytesSize++] = ch;
-            }
-            else
-            {
-                // error: ran out of buffer space
-                reset = true;
-            }
-        }
-        else
-        {
-            // error: got an intermidiate character while not in intermidiate state
-            reset = true;
-        }
-    }
-    else if (ch >= CSI_START_FINAL_BYTE && ch <= CSI_END_FINAL_BYTE)
-    {
-        parameterBytes[parameterBytesSize] = '\0';
-        intermediateBytes[intermediateBytesSize] = '\0';
-        finalByte = ch;
-
-        evalCsi();
-
-        // done with sequence, reset state
-        reset = true;
-    }
-
-    if (reset)
-    {
-        inEscSequence = false;
-        escSequenceChar = '\0';
-        csiState = eParameter;
-        parameterBytesSize = 0;
-        intermediateBytesSize = 0;
-    }
-}
-
-void VgaDriver::evalCsi()
-{
-    const char* ptr = nullptr;
-    bool error = false;
-
-    if (finalByte == 'A')
-    {
-        unsigned int y = 0;
-        bool done = getNumParam(y, 1, error, ptr);
-        if (done && !error)
-        {
-            setCursorY(csrY - y);
-        }
-    }
-    else if (finalByte == 'B')
-    {
-        unsigned int y = 0;
-        bool done = getNumParam(y, 1, error, ptr);
-        if (done && !error)
-        {
-            setCursorY(csrY + y);
-        }
-    }
-    else if (finalByte == 'C')
-    {
-        unsigned int x = 0;
-        bool done = getNumParam(x, 1, error, ptr);
-        if (done && !error)
-        {
-            setCursorX(csrX + x);
-        }
-    }
-    else if (finalByte == 'D')
-    {
-        unsigned int x = 0;
-        bool done = getNumParam(x, 1, error, ptr);
-        if (done && !error)
-        {
-            setCursorX(csrX - x);
-        }
-    }
-    else if (finalByte == 'E')
-    {
-        unsigned int y = 0;
-        bool done = getNumParam(y, 1, error, ptr);
-        if (done && !error)
-        {
-            setCursorX(0);
-            setCursorY(csrY + y);
-        }
-    }
-    else if (finalByte == 'F')
-    {
-        unsigned int y = 0;
-        bool done = getNumParam(y, 1, error, ptr);
-        if (done && !error)
-        {
-            setCursorX(0);
-            setCursorY(csrY - y);
-        }
-    }
-    else if (finalByte == 'G')
-    {
-        unsigned int x = 0;
-        bool done = getNumParam(x, 1, error, ptr);
-        if (done && !error)
-        {
-            if (x > 0)
-            {
-                // convert the escape sequence's 1-based index
-                // to a 0-based index
-                --x;
-            }
-            setCursorX(x);
-        }
-    }
-    else if (finalByte == 'H')
-    {
-        unsigned int x = 1;
-        unsigned int y = 1;
-        bool done = getNumParam(x, 1, error, ptr);
-        if (!done && !error)
-        {
-            done = getNumParam(y, 1, error, ptr);
-        }
-
-        if (done && !error)
-        {
-            if (x > 0)
-            {
-                // convert the escape sequence's 1-based index
-                // to a 0-based index
-                --x;
-            }
-            if (y > 0)
-            {
-                // convert the escape sequence's 1-based index
-                // to a 0-based index
-                --y;
-            }
-
-            setCursorX(x);
-            setCursorY(y);
-        }
-    }
-    else if (finalByte == 'J')
-    {
-        unsigned int n = 0;
-        bool done = getNumParam(n, 0, error, ptr);
-        if (done && !error)
-        {
-            if (n == 0)
-            {
-                // clear from cursor to end of screen
-                clear(csrX, csrY, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1);
-            }
-            else if (n == 1)
-            {
-                // clear from cursor to beginning of screen
-                clear(0, 0, csrX, csrY);
-            }
-            else if (n == 2 || n == 3)
-            {
-                // clear entire screen
-                clear(0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1);
-
-                // Note: If n == 3, the scroll buffer should be cleared as well,
-                // but we don't have a scroll buffer right now.
-            }
-        }
-    }
-    else if (finalByte == 'm')
-    {
-        evalCsiSgr();
-    }
-}
-
-bool VgaDriver::getNumParam(unsigned int& num, unsigned int def, bool& error, const char*& ptr)
-{
-    // (MAX_PARAM * 10) must fit in an unsigned int (32-bits) for
-    // the check below to work
-    constexpr unsigned int MAX_PARAM = 100'000'000;
-
-    // if this is the first time this function is called,
-    // start at the beginning of the paramter string
-    if (ptr == nullptr)
-    {
-        ptr = parameterBytes;
-    }
-
-    // if there is no number before the delimiter, use the
-    // default value
-    if (*ptr == ';' || *ptr == '\0')
-    {
-        num = def;
-        error = false;
-        // we're done if this is the end of the string
-        return (*ptr == '\0');
-    }
-
-    num = 0;
-    while (*ptr != '\0')
-    {
-        if (isdigit(*ptr))
-        {
-            num *= 10;
-            if (num > MAX_PARAM)
-            {
-                error = true;
-                return true;
-            }
-
-            num += *ptr - '0';
-        }
-        else if (*ptr == ';')
-        {
-            // increment the pointer for the next time this function is called
-            ++ptr;
-            error = false;
-            return false;
-        }
-        else // invalid character
-        {
-            num = 0;
-            error = true;
-            return true;
-        }
-
-        ++ptr;
-    }
-
-    error = false;
-    // when we get here, we're done parsing the string
-    return true;
-}
-
-void VgaDriver::evalCsiSgr()
-{
-    const char* ptr = nullptr;
-    bool error = false;
-    unsigned int n = 0;
-    bool done = getNumParam(n, 0, error, ptr);
-    while (!error)
-    {
-        if (n == 0)
-        {
-            setBackgroundColor(defaultBackground);
-            setForegroundColor(defaultForeground);
-        }
-        else if (n >= 30 && n <= 37)
-        {
-            // set foreground color
-            unsigned int colorIdx = n - 30;
-            EColor color = SGR_COLOR_TO_ENUM[colorIdx];
-            setForegroundColor(color);
-        }
-        else if (n == 39)
-        {
-            setForegroundColor(defaultForeground);
-        }
-        else if (n >= 40 && n <= 47)
-        {
-            // set background color
-            unsigned int colorIdx = n - 40;
-            EColor color = SGR_COLOR_TO_ENUM[colorIdx];
-            setBackgroundColor(color);
-        }
-        else if (n == 49)
-        {
-            setBackgroundColor(defaultBackground);
-        }
-
-        if (done)
-        {
-            break;
-        }
-
-        done = getNumParam(n, 0, error, ptr);
-    }
+    outb(CRTC_ADDR_REG, CRTC_CURSOR_HIGH);
+    outb(CRTC_DATA_REG, static_cast<uint8_t>(pos >> 8));
+    outb(CRTC_ADDR_REG, CRTC_CURSOR_LOW);
+    outb(CRTC_DATA_REG, static_cast<uint8_t>(pos));
 }
@@ -1,139 +1,66 @@
 #ifndef VGA_DRIVER_H_
 #define VGA_DRIVER_H_
 
-#include "stream.h"
+#include "textconsole.h"
 
-class VgaDriver : public Stream
+class VgaDriver : public TextConsole
 {
 public:
     static constexpr unsigned int SCREEN_WIDTH = 80;
     static constexpr unsigned int SCREEN_HEIGHT = 25;
-    static constexpr unsigned int TAB_SIZE = 4;
-
-    enum class EColor
-    {
-        eBlack        =  0,
-        eBlue         =  1,
-        eGreen        =  2,
-        eCyan         =  3,
-        eRed          =  4,
-        eMagenta      =  5,
-        eBrown        =  6,
-        eLightGray    =  7,
-        eDarkGray     =  8,
-        eLightBlue    =  9,
-        eLightGreen   = 10,
-        eLightCyan    = 11,
-        eLightRed     = 12,
-        eLightMagenta = 13,
-        eLightBrown   = 14,
-        eWhite        = 15,
-    };
 
     VgaDriver();
 
-    EColor getForegroundColor() const;
-
-    void setForegroundColor(EColor color);
-
-    EColor getBackgroundColor() const;
-
-    void setBackgroundColor(EColor color);
+    /**
+     * @brief Set up text mode and show the screen.
+     */
+    void init();
 
     void setBlinking(bool enabled);
 
-    unsigned int getCursorX() const;
-
-    void setCursorX(unsigned int x);
-
-    unsigned int getCursorY() const;
-
-    void setCursorY(unsigned int y);
-
-    bool canRead() const override
-    {
-        return false;
-    }
-
-    bool canWrite() const override
-    {
-        return true;
-    }
+protected:
+    /**
+     * @brief Move the start address down in text memory.
+     */
+    bool scrollScreen(unsigned int numLines) override;
 
-    ssize_t read(uint8_t*, size_t) override
-    {
-        return -1;
-    }
+    /**
+     * @brief Copy a line to text memory.
+     */
+    void drawLine(unsigned int y, const uint16_t* line) override;
 
-    ssize_t write(const uint8_t* buff, size_t nbyte) override;
+    void updateCursor() override;
 
-    void flush() override
-    {
-        // nothing to do
-    }
+private:
+    /// number of character cells in the 32 KiB text memory window
+    static constexpr unsigned int TEXT_MEM_SIZE = 0x8000 / sizeof(uint16_t);
 
-    void close() override
-    {
-        // nothing to do
-    }
+    /// CRT controller address and data registers
+    static constexpr uint16_t CRTC_ADDR_REG = 0x3D4;
+    static constexpr uint16_t CRTC_DATA_REG = 0x3D5;
 
-private:
-    static constexpr char ESCAPE = '\x1B';
-    static constexpr char CSI    = '[';
-    static constexpr char CSI_START_PARAMETER_BYTE    = '\x30';
-    static constexpr char CSI_END_PARAMETER_BYTE      = '\x3F';
-    static constexpr char CSI_START_INTERMEDIATE_BYTE = '\x20';
-    static constexpr char CSI_END_INTERMEDIATE_BYTE   = '\x2F';
-    static constexpr char CSI_START_FINAL_BYTE        = '\x40';
-    static constexpr char CSI_END_FINAL_BYTE          = '\x7E';
+    /// CRT controller start address and cursor location registers
+    static constexpr uint8_t CRTC_START_ADDR_HIGH = 0x0C;
+    static constexpr uint8_t CRTC_START_ADDR_LOW  = 0x0D;
+    static constexpr uint8_t CRTC_CURSOR_HIGH     = 0x0E;
+    static constexpr uint8_t CRTC_CURSOR_LOW      = 0x0F;
 
-    static const EColor SGR_COLOR_TO_ENUM[8];
+    static uint16_t shadow[SCREEN_HEIGHT][SCREEN_WIDTH];
 
     uint16_t* textMem;
-    uint16_t attrib;
-    unsigned int csrX;
-    unsigned int csrY;
-    EColor defaultBackground;
-    EColor defaultForeground;
-    bool inEscSequence;
-    char escSequenceChar;
-    enum ECsiState
-    {
-        eParameter,
-        eIntermediate,
-        eFinal
-    } csiState;
-    static constexpr size_t MAX_PARAMETER_BYTES_SIZE = 32;
-    size_t parameterBytesSize;
-    char parameterBytes[MAX_PARAMETER_BYTES_SIZE];
-    static constexpr size_t MAX_INTERMEDIATE_BYTES_SIZE = 32;
-    size_t intermediateBytesSize;
-    char intermediateBytes[MAX_INTERMEDIATE_BYTES_SIZE];
-    char finalByte;
-
-    void writeChar(char ch);
-
-    void outputChar(char ch);
-
-    void scroll();
-
-    void updateCursor();
-
-    void clear(unsigned int startX, unsigned int startY, unsigned int endX, unsigned int endY);
+
+    /// offset in text memory of the top left corner of the screen
+    unsigned int origin;
 
     /**
-     * @brief Parse a character in an escape sequence.
-     * @param ch the character to parse.
+     * @brief Get the offset in text memory of a position on the screen.
      */
-    void parseEscSequence(char ch);
+    unsigned int getOffset(unsigned int x, unsigned int y) const;
 
-    void parseCsi(char ch);
-
-    void evalCsi();
-
-    bool getNumParam(unsigned int& num, unsigned int def, bool& error, const char*& ptr);
-
-    void evalCsiSgr();
+    /**
+     * @brief Set the CRT controller's start address to the origin.
+     */
+    void updateStartAddress();
 };
 
 #endif // VGA_DRIVER_H_
@@ -0,0 +1,399 @@
+/**
+ * @brief Virtio block device driver
+ */
+
+#include <string.h>
+#include "irq.h"
+#include "kernellogger.h"
+#include "pageframemgr.h"
+#include "paging.h"
+#include "system.h"
+#include "virtioblockdevice.h"
+
+namespace
+{
+
+// PCI IDs of a transitional virtio block device
+constexpr static uint16_t PCI_VENDOR_VIRTIO = 0x1AF4;
+constexpr static uint16_t PCI_DEVICE_VIRTIO_BLOCK = 0x1001;
+
+/// I/O space BAR bit and address mask
+constexpr static uint32_t BAR_IO_SPACE = 0x1;
+constexpr static uint32_t BAR_IO_MASK = 0xFFFC;
+
+// legacy register offsets
+constexpr static uint8_t REG_DEVICE_FEATURES = 0x00;
+constexpr static uint8_t REG_GUEST_FEATURES = 0x04;
+constexpr static uint8_t REG_QUEUE_ADDRESS = 0x08;
+constexpr static uint8_t REG_QUEUE_SIZE = 0x0C;
+constexpr static uint8_t REG_QUEUE_SELECT = 0x0E;
+constexpr static uint8_t REG_QUEUE_NOTIFY = 0x10;
+constexpr static uint8_t REG_DEVICE_STATUS = 0x12;
+constexpr static uint8_t REG_ISR_STATUS = 0x13;
+constexpr static uint8_t REG_CAPACITY_LOW = 0x14;
+constexpr static uint8_t REG_CAPACITY_HIGH = 0x18;
+
+// device status bits
+constexpr static uint8_t STATUS_ACKNOWLEDGE = 0x01;
+constexpr static uint8_t STATUS_DRIVER = 0x02;
+constexpr static uint8_t STATUS_DRIVER_OK = 0x04;
+constexpr static uint8_t STATUS_FAILED = 0x80;
+
+/// the ISR status bit set when a used ring was updated
+constexpr static uint8_t ISR_QUEUE = 0x01;
+
+// request types
+constexpr static uint32_t REQUEST_TYPE_IN = 0;
+constexpr static uint32_t REQUEST_TYPE_OUT = 1;
+
+// request status
+constexpr static uint8_t REQUEST_STATUS_OK = 0;
+constexpr static uint8_t REQUEST_STATUS_PENDING = 0xFF;
+
+} // namespace
+
+VirtioBlockDevice::VirtioBlockDevice() :
+    ioBase(0),
+    irq(0),
+    numSectors(0),
+    commandPagePhysicalAddr(0),
+    commandPage(nullptr)
+{
+    for (Command& command : commands)
+    {
+        command.isUsed = false;
+        command.isDone = false;
+        command.head = 0;
+    }
+}
+
+bool VirtioBlockDevice::init(const PciBus::Function& function, PageFrameMgr* pageFrameMgr)
+{
+    uint32_t bar = function.getBar(0);
+    if ((bar & BAR_IO_SPACE) == 0)
+    {
+        return false;
+    }
+
+    ioBase = bar & BAR_IO_MASK;
+
+    // fall back to the interrupt line if there's no MSI capability or no
+    // MSI IRQ left
+    if (!pciBus.enableMsi(function, irq))
+    {
+        irq = function.getInterruptLine();
+        if (irq > IRQ15)
+        {
+            return false;
+        }
+    }
+
+    pciBus.enable(function.address, PciBus::COMMAND_IO_SPACE | PciBus::COMMAND_BUS_MASTER);
+
+    // reset the device and tell it we know how to drive it
+    outb(ioBase + REG_DEVICE_STATUS, 0);
+    outb(ioBase + REG_DEVICE_STATUS, STATUS_ACKNOWLEDGE);
+    outb(ioBase + REG_DEVICE_STATUS, STATUS_ACKNOWLEDGE | STATUS_DRIVER);
+
+    // we don't use any optional features
+    inl(ioBase + REG_DEVICE_FEATURES);
+    outl(ioBase + REG_GUEST_FEATURES, 0);
+
+    // set up the request queue
+    outw(ioBase + REG_QUEUE_SELECT, 0);
+    uint16_t queueSize = inw(ioBase + REG_QUEUE_SIZE);
+    if (queueSize < MAX_PAGES_PER_COMMAND + 2 || !queue.init(queueSize, pageFrameMgr))
+    {
+        outb(ioBase + REG_DEVICE_STATUS, STATUS_FAILED);
+        return false;
+    }
+    outl(ioBase + REG_QUEUE_ADDRESS, queue.getPhysicalAddr() / PAGE_SIZE);
+
+    // allocate the request headers and status bytes
+    commandPagePhysicalAddr = pageFrameMgr->allocPageFrame();
+    uint32_t commandPageVirtualAddr = 0;
+    if (commandPagePhysicalAddr == 0 || !mapPages((KERNEL_VIRTUAL_BASE >> 22), getKernelPageTableStart(), commandPageVirtualAddr, commandPagePhysicalAddr, 1))
+    {
+        outb(ioBase + REG_DEVICE_STATUS, STATUS_FAILED);
+        return false;
+    }
+    commandPage = reinterpret_cast<uint8_t*>(commandPageVirtualAddr);
+
+    // the capacity is in 512-byte sectors
+    uint32_t capacityLow = inl(ioBase + REG_CAPACITY_LOW);
+    uint32_t capacityHigh = inl(ioBase + REG_CAPACITY_HIGH);
+    numSectors = (capacityHigh != 0) ? 0xFFFF'FFFF : capacityLow;
+
+    outb(ioBase + REG_DEVICE_STATUS, STATUS_ACKNOWLEDGE | STATUS_DRIVER | STATUS_DRIVER_OK);
+
+    return true;
+}
+
+uint8_t VirtioBlockDevice::getIrq() const
+{
+    return irq;
+}
+
+uint32_t VirtioBlockDevice::getNumSectors() const
+{
+    return numSectors;
+}
+
+bool VirtioBlockDevice::transfer(Request& request)
+{
+    if (request.numSectors == 0 || request.sector >= numSectors || request.numSectors > numSectors - request.sector)
+    {
+        request.ok = false;
+        return false;
+    }
+
+    constexpr size_t SECTORS_PER_COMMAND = MAX_PAGES_PER_COMMAND * SECTORS_PER_PAGE;
+
+    bool intEnabled = isIntEnabled();
+    clearInt();
+
+    request.device = this;
+    request.next = nullptr;
+
+    bool ok = true;
+    size_t done = 0;
+    while (ok && done < request.numSectors)
+    {
+        // add as many commands as possible before notifying the device
+        int batch[MAX_COMMANDS_PER_BATCH];
+        size_t batchSize = 0;
+        while (batchSize < MAX_COMMANDS_PER_BATCH && done < request.numSectors)
+        {
+            size_t numCommandSectors = request.numSectors - done;
+            if (numCommandSectors > SECTORS_PER_COMMAND)
+            {
+                numCommandSectors = SECTORS_PER_COMMAND;
+            }
+
+            const uintptr_t* frames = request.frames + done / SECTORS_PER_PAGE;
+            int commandIdx = submitCommand(request.type, request.sector + done, numCommandSectors, frames);
+            if (commandIdx < 0)
+            {
+                // send what we have, or wait for other processes' commands
+                // to complete
+                if (batchSize > 0)
+                {
+                    break;
+                }
+
+                freeWaitQueue.wait();
+                continue;
+            }
+
+            batch[batchSize++] = commandIdx;
+            done += numCommandSectors;
+        }
+
+        notify();
+
+        for (size_t i = 0; i < batchSize; ++i)
+        {
+            Command& command = commands[batch[i]];
+            while (!command.isDone)
+            {
+                completionWaitQueue.wait();
+            }
+
+            ok = ok && *getStatus(batch[i]) == REQUEST_STATUS_OK;
+            command.isUsed = false;
+        }
+
+        freeWaitQueue.wakeAll();
+    }
+
+    request.ok = ok;
+
+    if (intEnabled)
+    {
+        setInt();
+    }
+
+    if (!ok)
+    {
+        klog.logError(VirtioBlockDriver::LOG_TAG, "Could not {} {} sectors at sector {}",
+                      (request.type == Request::eRead) ? "read" : "write",
+                      request.numSectors, request.sector);
+    }
+
+    return ok;
+}
+
+void VirtioBlockDevice::processInterrupt()
+{
+    // reading the ISR status acknowledges the interrupt
+    uint8_t isr = inb(ioBase + REG_ISR_STATUS);
+    if ((isr & ISR_QUEUE) == 0)
+    {
+        return;
+    }
+
+    uint16_t head = 0;
+    while (queue.getUsed(head))
+    {
+        for (Command& command : commands)
+        {
+            if (command.isUsed && command.head == head)
+            {
+                command.isDone = true;
+                break;
+            }
+        }
+    }
+
+    completionWaitQueue.wakeAll();
+    freeWaitQueue.wakeAll();
+}
+
+int VirtioBlockDevice::submitCommand(Request::EType type, uint32_t sector, size_t numCommandSectors, const uintptr_t* frames)
+{
+    int commandIdx = -1;
+    for (size_t i = 0; i < MAX_NUM_COMMANDS; ++i)
+    {
+        if (!commands[i].isUsed)
+        {
+            commandIdx = static_cast<int>(i);
+            break;
+        }
+    }
+
+    if (commandIdx < 0)
+    {
+        return -1;
+    }
+
+    bool isRead = (type == Request::eRead);
+
+    CommandHeader* header = getHeader(commandIdx);
+    header->type = isRead ? REQUEST_TYPE_IN : REQUEST_TYPE_OUT;
+    header->reserved = 0;
+    header->sector = sector;
+
+    volatile uint8_t* status = getStatus(commandIdx);
+    *status = REQUEST_STATUS_PENDING;
+
+    // the header, one buffer per page, and the status byte
+    Virtqueue::Buffer buffers[MAX_PAGES_PER_COMMAND + 2];
+    size_t numBuffers = 0;
+
+    buffers[numBuffers++] = {commandPagePhysicalAddr + commandIdx * sizeof(CommandHeader), sizeof(CommandHeader), false};
+
+    size_t numBytes = numCommandSectors * SECTOR_SIZE;
+    for (size_t offset = 0; offset < numBytes; offset += PAGE_SIZE)
+    {
+        size_t bufferSize = numBytes - offset;
+        if (bufferSize > PAGE_SIZE)
+        {
+            bufferSize = PAGE_SIZE;
+        }
+
+        buffers[numBuffers++] = {frames[offset / PAGE_SIZE], static_cast<uint32_t>(bufferSize), isRead};
+    }
+
+    uintptr_t statusPhysicalAddr = commandPagePhysicalAddr + (reinterpret_cast<uintptr_t>(status) - reinterpret_cast<uintptr_t>(commandPage));
+    buffers[numBuffers++] = {statusPhysicalAddr, 1, true};
+
+    int head = queue.add(buffers, numBuffers);
+    if (head < 0)
+    {
+        return -1;
+    }
+
+    commands[commandIdx].isUsed = true;
+    commands[commandIdx].isDone = false;
+    commands[commandIdx].head = static_cast<uint16_t>(head);
+
+    return commandIdx;
+}
+
+void VirtioBlockDevice::notify()
+{
+    if (queue.isNotifyNeeded())
+    {
+        outw(ioBase + REG_QUEUE_NOTIFY, 0);
+    }
+}
+
+VirtioBlockDevice::CommandHeader* VirtioBlockDevice::getHeader(size_t commandIdx)
+{
+    return reinterpret_cast<CommandHeader*>(commandPage) + commandIdx;
+}
+
+volatile uint8_t* VirtioBlockDevice::getStatus(size_t commandIdx)
+{
+    // the status bytes follow the headers
+    return commandPage + MAX_NUM_COMMANDS * sizeof(CommandHeader) + commandIdx;
+}
+
+const char* VirtioBlockDriver::LOG_TAG = "VirtioBlock";
+
+VirtioBlockDriver::VirtioBlockDriver() :
+    numDevices(0),
+    pageFrameMgr(nullptr)
+{
+}
+
+void VirtioBlockDriver::init(PageFrameMgr* pageFrameMgr)
+{
+    this->pageFrameMgr = pageFrameMgr;
+
+    // functions that were already found are probed right away
+    pciBus.registerDriver(this);
+}
+
+const char* VirtioBlockDriver::getName() const
+{
+    return "virtio block";
+}
+
+const PciDriver::DeviceId* VirtioBlockDriver::getDeviceIds(size_t& numIds) const
+{
+    static const DeviceId ids[] = {
+        {PCI_VENDOR_VIRTIO, PCI_DEVICE_VIRTIO_BLOCK}
+    };
+
+    numIds = sizeof(ids) / sizeof(ids[0]);
+    return ids;
+}
+
+bool VirtioBlockDriver::probe(const PciBus::Function& function)
+{
+    const PciBus::Address& address = function.address;
+    if (numDevices >= MAX_NUM_DEVICES)
+    {
+        klog.logWarning(LOG_TAG, "Too many devices; ignoring {}:{}.{}", address.bus, address.device, address.function);
+        return false;
+    }
+
+    VirtioBlockDevice& device = devices[numDevices];
+    if (!device.init(function, pageFrameMgr))
+    {
+        klog.logError(LOG_TAG, "Could not initialize device at {}:{}.{}", address.bus, address.device, address.function);
+        return false;
+    }
+
+    ++numDevices;
+    blockDeviceTable.addDevice(&device);
+    registerIrqHandler(device.getIrq(), interruptHandler);
+
+    klog.logInfo(LOG_TAG, "Device at {}:{}.{}: {} sectors, IRQ {}",
+                 address.bus, address.device, address.function, device.getNumSectors(), device.getIrq());
+
+    return true;
+}
+
+void VirtioBlockDriver::interruptHandler(const registers* /*regs*/)
+{
+    // devices may share an IRQ, so check all of them
+    for (size_t i = 0; i < virtioBlockDriver.numDevices; ++i)
+    {
+        virtioBlockDriver.devices[i].processInterrupt();
+    }
+}
+
+// create VirtioBlockDriver instance
+VirtioBlockDriver virtioBlockDriver;
@@ -0,0 +1,162 @@
+/**
+ * @brief Virtio block device driver
+ */
+
+#ifndef VIRTIO_BLOCK_DEVICE_H_
+#define VIRTIO_BLOCK_DEVICE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "blockdevice.h"
+#include "pci.h"
+#include "virtqueue.h"
+#include "waitqueue.h"
+
+class PageFrameMgr;
+struct registers;
+
+/**
+ * @brief A virtio block device (legacy PCI interface).
+ * @details A request is split into virtio requests of up to
+ * MAX_PAGES_PER_COMMAND pages. All of them are added to the virtqueue
+ * before the device is notified once. The calling process sleeps until the
+ * completion interrupt reports that they are done. Requests from several
+ * processes can be in flight at the same time.
+ */
+class VirtioBlockDevice : public BlockDevice
+{
+public:
+    VirtioBlockDevice();
+
+    /**
+     * @brief Initialize the device. Its interrupt is a message signaled
+     * interrupt if the function supports it; otherwise, it is the
+     * function's interrupt line.
+     * @return true if the device is ready; false, otherwise
+     */
+    bool init(const PciBus::Function& function, PageFrameMgr* pageFrameMgr);
+
+    /**
+     * @brief Get the device's IRQ.
+     */
+    uint8_t getIrq() const;
+
+    uint32_t getNumSectors() const override;
+
+    bool transfer(Request& request) override;
+
+    /**
+     * @brief Handle the device's interrupt.
+     */
+    void processInterrupt();
+
+private:
+    /// maximum number of pages in one virtio request
+    constexpr static size_t MAX_PAGES_PER_COMMAND = 32;
+
+    /// maximum number of virtio requests in flight
+    constexpr static size_t MAX_NUM_COMMANDS = 64;
+
+    /// maximum number of virtio requests a request is split into before
+    /// waiting for them to complete
+    constexpr static size_t MAX_COMMANDS_PER_BATCH = 8;
+
+    /**
+     * @brief The virtio request header
+     */
+    struct CommandHeader
+    {
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t sector;
+    };
+
+    /**
+     * @brief A virtio request in flight
+     */
+    struct Command
+    {
+        bool isUsed;
+
+        /// set by the interrupt handler when the device is done
+        volatile bool isDone;
+
+        /// the head descriptor of the request's chain
+        uint16_t head;
+    };
+
+    uint16_t ioBase;
+    uint8_t irq;
+    uint32_t numSectors;
+
+    Virtqueue queue;
+
+    Command commands[MAX_NUM_COMMANDS];
+
+    /// headers and status bytes of the commands, which the device reads and
+    /// writes with DMA
+    uintptr_t commandPagePhysicalAddr;
+    uint8_t* commandPage;
+
+    /// processes waiting for a command slot or descriptors
+    WaitQueue freeWaitQueue;
+
+    /// processes waiting for their commands to complete
+    WaitQueue completionWaitQueue;
+
+    /**
+     * @brief Add a virtio request to the virtqueue.
+     * @return The command's index, or -1 if there are not enough free
+     * command slots or descriptors.
+     */
+    int submitCommand(Request::EType type, uint32_t sector, size_t numSectors, const uintptr_t* frames);
+
+    /**
+     * @brief Notify the device of new requests.
+     */
+    void notify();
+
+    CommandHeader* getHeader(size_t commandIdx);
+
+    volatile uint8_t* getStatus(size_t commandIdx);
+};
+
+/**
+ * @brief Drives the virtio block devices on the PCI bus.
+ */
+class VirtioBlockDriver : public PciDriver
+{
+public:
+    /// The tag used in the kernel log
+    static const char* LOG_TAG;
+
+    VirtioBlockDriver();
+
+    /**
+     * @brief Register with the PCI bus. Devices that are found are added to
+     * the block device table.
+     */
+    void init(PageFrameMgr* pageFrameMgr);
+
+    const char* getName() const override;
+
+    const DeviceId* getDeviceIds(size_t& numIds) const override;
+
+    bool probe(const PciBus::Function& function) override;
+
+private:
+    constexpr static size_t MAX_NUM_DEVICES = 4;
+
+    VirtioBlockDevice devices[MAX_NUM_DEVICES];
+
+    size_t numDevices;
+
+    PageFrameMgr* pageFrameMgr;
+
+    static void interruptHandler(const registers* regs);
+};
+
+extern VirtioBlockDriver virtioBlockDriver;
+
+#endif // VIRTIO_BLOCK_DEVICE_H_
@@ -0,0 +1,199 @@
+/**
+ * @brief Virtio split virtqueue
+ */
+
+#include <string.h>
+#include "pageframemgr.h"
+#include "paging.h"
+#include "system.h"
+#include "utils.h"
+#include "virtqueue.h"
+
+namespace
+{
+
+/// alignment of the used ring
+constexpr static size_t USED_RING_ALIGN = PAGE_SIZE;
+
+/**
+ * @brief Prevent the compiler from reordering memory accesses. x86 doesn't
+ * reorder stores with other stores or loads with other loads, so this is
+ * enough between two stores or two loads.
+ */
+inline void barrier()
+{
+    asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief Prevent the processor from reordering a store with a later load.
+ * x86 can satisfy a load before an earlier store reaches memory, so without
+ * this the device's used flags could be read before it can see the new
+ * available index, and a notification it needs would be skipped.
+ */
+inline void fullBarrier()
+{
+    asm volatile ("mfence" : : : "memory");
+}
+
+} // namespace
+
+Virtqueue::Virtqueue() :
+    size(0),
+    physicalAddr(0),
+    descriptors(nullptr),
+    availFlags(nullptr),
+    availIdx(nullptr),
+    availRing(nullptr),
+    usedFlags(nullptr),
+    usedIdx(nullptr),
+    usedRing(nullptr),
+    freeHead(0),
+    numFree(0),
+    lastUsedIdx(0)
+{
+}
+
+bool Virtqueue::init(uint16_t queueSize, PageFrameMgr* pageFrameMgr)
+{
+    size_t numPages = align(getMemorySize(queueSize), PAGE_SIZE) / PAGE_SIZE;
+
+    physicalAddr = pageFrameMgr->allocContiguousPageFrames(numPages);
+    if (physicalAddr == 0)
+    {
+        return false;
+    }
+
+    // map the queue in the kernel page table, which every process's page
+    // directory shares, so interrupt handlers can access it
+    uint32_t virtualAddr = 0;
+    if (!mapPages((KERNEL_VIRTUAL_BASE >> 22), getKernelPageTableStart(), virtualAddr, physicalAddr, numPages))
+    {
+        for (size_t i = 0; i < numPages; ++i)
+        {
+            pageFrameMgr->freePageFrame(physicalAddr + i * PAGE_SIZE);
+        }
+        physicalAddr = 0;
+        return false;
+    }
+
+    uint8_t* base = reinterpret_cast<uint8_t*>(virtualAddr);
+    memset(base, 0, numPages * PAGE_SIZE);
+    setMemory(base, queueSize);
+
+    return true;
+}
+
+uintptr_t Virtqueue::getPhysicalAddr() const
+{
+    return physicalAddr;
+}
+
+uint16_t Virtqueue::getSize() const
+{
+    return size;
+}
+
+size_t Virtqueue::getNumFreeDescriptors() const
+{
+    return numFree;
+}
+
+int Virtqueue::add(const Buffer* buffers, size_t numBuffers)
+{
+    if (numBuffers == 0 || numBuffers > numFree)
+    {
+        return -1;
+    }
+
+    uint16_t head = freeHead;
+    uint16_t descIdx = head;
+    for (size_t i = 0; i < numBuffers; ++i)
+    {
+        volatile Descriptor& desc = descriptors[descIdx];
+        desc.physicalAddr = buffers[i].physicalAddr;
+        desc.size = buffers[i].size;
+        desc.flags = (buffers[i].deviceWritable ? DESC_F_WRITE : 0) | ((i + 1 < numBuffers) ? DESC_F_NEXT : 0);
+
+        descIdx = desc.next;
+    }
+
+    freeHead = descIdx;
+    numFree -= numBuffers;
+
+    // make the chain available
+    availRing[*availIdx % size] = head;
+    barrier();
+    *availIdx = *availIdx + 1;
+    barrier();
+
+    return head;
+}
+
+bool Virtqueue::isNotifyNeeded() const
+{
+    fullBarrier();
+    return (*usedFlags & USED_F_NO_NOTIFY) == 0;
+}
+
+size_t Virtqueue::getUsedOffset(uint16_t queueSize)
+{
+    // the descriptor table is followed by the available ring's flags,
+    // index, ring, and used event
+    size_t availOffset = queueSize * sizeof(Descriptor);
+    return align(availOffset + (3 + queueSize) * sizeof(uint16_t), USED_RING_ALIGN);
+}
+
+size_t Virtqueue::getMemorySize(uint16_t queueSize)
+{
+    return getUsedOffset(queueSize) + 3 * sizeof(uint16_t) + queueSize * sizeof(UsedElement);
+}
+
+void Virtqueue::setMemory(uint8_t* base, uint16_t queueSize)
+{
+    size = queueSize;
+    descriptors = reinterpret_cast<volatile Descriptor*>(base);
+
+    availFlags = reinterpret_cast<volatile uint16_t*>(base + queueSize * sizeof(Descriptor));
+    availIdx = availFlags + 1;
+    availRing = availFlags + 2;
+
+    usedFlags = reinterpret_cast<volatile uint16_t*>(base + getUsedOffset(queueSize));
+    usedIdx = usedFlags + 1;
+    usedRing = reinterpret_cast<volatile UsedElement*>(usedFlags + 2);
+
+    // chain all descriptors in the free list
+    for (uint16_t i = 0; i < size; ++i)
+    {
+        descriptors[i].next = i + 1;
+    }
+    freeHead = 0;
+    numFree = size;
+    lastUsedIdx = 0;
+}
+
+bool Virtqueue::getUsed(uint16_t& head)
+{
+    barrier();
+    if (lastUsedIdx == *usedIdx)
+    {
+        return false;
+    }
+
+    head = usedRing[lastUsedIdx % size].id;
+    ++lastUsedIdx;
+
+    // return the chain to the free list
+    uint16_t descIdx = head;
+    size_t numDescs = 1;
+    while ((descriptors[descIdx].flags & DESC_F_NEXT) != 0)
+    {
+        descIdx = descriptors[descIdx].next;
+        ++numDescs;
+    }
+    descriptors[descIdx].next = freeHead;
+    freeHead = head;
+    numFree += numDescs;
+
+    return true;
+}
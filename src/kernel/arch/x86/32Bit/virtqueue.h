@@ -0,0 +1,141 @@
+/**
+ * @brief Virtio split virtqueue
+ */
+
+#ifndef VIRTQUEUE_H_
+#define VIRTQUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+class PageFrameMgr;
+
+/**
+ * @brief A split virtqueue in the legacy virtio layout.
+ * @details The descriptor table and available ring are followed by the used
+ * ring on the next page boundary. The queue is physically contiguous and
+ * permanently mapped in the kernel's address space, so it can be accessed
+ * from interrupt handlers. Interrupts must be disabled when calling add()
+ * and getUsed().
+ */
+class Virtqueue
+{
+public:
+    /**
+     * @brief A buffer to add to the queue.
+     */
+    struct Buffer
+    {
+        uintptr_t physicalAddr;
+        uint32_t size;
+
+        /// whether the device writes (instead of reads) the buffer
+        bool deviceWritable;
+    };
+
+    Virtqueue();
+
+    /**
+     * @brief Allocate and map the queue's memory.
+     * @param queueSize The number of descriptors (the size the device
+     * reports).
+     * @return true if the queue was allocated; false, otherwise
+     */
+    bool init(uint16_t queueSize, PageFrameMgr* pageFrameMgr);
+
+    /**
+     * @brief Get the physical address of the queue.
+     */
+    uintptr_t getPhysicalAddr() const;
+
+    uint16_t getSize() const;
+
+    size_t getNumFreeDescriptors() const;
+
+    /**
+     * @brief Add a chain of buffers to the available ring.
+     * @details The device is not notified, so several chains can be added
+     * before one notification.
+     * @return The index of the chain's head descriptor, or -1 if there are
+     * not enough free descriptors.
+     */
+    int add(const Buffer* buffers, size_t numBuffers);
+
+    /**
+     * @brief Whether the device wants to be notified of new buffers.
+     */
+    bool isNotifyNeeded() const;
+
+    /**
+     * @brief Remove a chain the device has finished with from the used
+     * ring and free its descriptors.
+     * @param [out] head The index of the chain's head descriptor.
+     * @return true if a chain was removed; false, if the used ring is empty
+     */
+    bool getUsed(uint16_t& head);
+
+private:
+    friend class VirtqueueTestClass;
+
+    /// the buffer continues in the next descriptor
+    constexpr static uint16_t DESC_F_NEXT = 1;
+
+    /// the device writes the buffer
+    constexpr static uint16_t DESC_F_WRITE = 2;
+
+    /// the device doesn't need to be notified
+    constexpr static uint16_t USED_F_NO_NOTIFY = 1;
+
+    struct Descriptor
+    {
+        uint64_t physicalAddr;
+        uint32_t size;
+        uint16_t flags;
+        uint16_t next;
+    };
+
+    struct UsedElement
+    {
+        uint32_t id;
+        uint32_t size;
+    };
+
+    uint16_t size;
+    uintptr_t physicalAddr;
+
+    volatile Descriptor* descriptors;
+
+    volatile uint16_t* availFlags;
+    volatile uint16_t* availIdx;
+    volatile uint16_t* availRing;
+
+    volatile uint16_t* usedFlags;
+    volatile uint16_t* usedIdx;
+    volatile UsedElement* usedRing;
+
+    /// the head of the free descriptor list
+    uint16_t freeHead;
+
+    size_t numFree;
+
+    /// the next used ring entry to process
+    uint16_t lastUsedIdx;
+
+    /**
+     * @brief Get the offset of the used ring from the start of the queue.
+     */
+    static size_t getUsedOffset(uint16_t queueSize);
+
+    /**
+     * @brief Get the size of the queue's memory in bytes.
+     */
+    static size_t getMemorySize(uint16_t queueSize);
+
+    /**
+     * @brief Lay the queue out in zeroed memory, and put all descriptors in
+     * the free list.
+     */
+    void setMemory(uint8_t* base, uint16_t queueSize);
+};
+
+#endif // VIRTQUEUE_H_
@@ -0,0 +1,208 @@
+#include <string.h>
+#include "unittests.h"
+#include "virtqueue.h"
+
+/**
+ * @brief A queue in static memory, and a device that uses its buffers.
+ */
+class VirtqueueTestClass::TestQueue
+{
+public:
+    static constexpr uint16_t QUEUE_SIZE = 8;
+
+    TestQueue()
+    {
+        memset(memory, 0, sizeof(memory));
+        queue.setMemory(memory, QUEUE_SIZE);
+    }
+
+    Virtqueue& get()
+    {
+        return queue;
+    }
+
+    int add(size_t numBuffers, bool deviceWritable)
+    {
+        Virtqueue::Buffer buffers[QUEUE_SIZE];
+        for (size_t i = 0; i < numBuffers && i < QUEUE_SIZE; ++i)
+        {
+            buffers[i] = {0x1000 * (i + 1), static_cast<uint32_t>(16 * (i + 1)), deviceWritable};
+        }
+
+        return queue.add(buffers, numBuffers);
+    }
+
+    uint16_t getAvailIdx() const
+    {
+        return *queue.availIdx;
+    }
+
+    uint16_t getAvail(uint16_t idx) const
+    {
+        return queue.availRing[idx % QUEUE_SIZE];
+    }
+
+    uint16_t getFlags(uint16_t descIdx) const
+    {
+        return queue.descriptors[descIdx].flags;
+    }
+
+    uint16_t getNext(uint16_t descIdx) const
+    {
+        return queue.descriptors[descIdx].next;
+    }
+
+    uint64_t getPhysicalAddr(uint16_t descIdx) const
+    {
+        return queue.descriptors[descIdx].physicalAddr;
+    }
+
+    static uint16_t getNextFlag()
+    {
+        return Virtqueue::DESC_F_NEXT;
+    }
+
+    static uint16_t getWriteFlag()
+    {
+        return Virtqueue::DESC_F_WRITE;
+    }
+
+    /**
+     * @brief Put a chain in the used ring like the device does.
+     */
+    void use(uint16_t head)
+    {
+        queue.usedRing[*queue.usedIdx % QUEUE_SIZE].id = head;
+        queue.usedRing[*queue.usedIdx % QUEUE_SIZE].size = 0;
+        *queue.usedIdx = *queue.usedIdx + 1;
+    }
+
+    void setNoNotify(bool noNotify)
+    {
+        *queue.usedFlags = noNotify ? Virtqueue::USED_F_NO_NOTIFY : 0;
+    }
+
+private:
+    static uint8_t memory[2 * 4096];
+
+    Virtqueue queue;
+};
+
+uint8_t VirtqueueTestClass::TestQueue::memory[2 * 4096];
+
+VirtqueueTestClass::VirtqueueTestClass() :
+    TestClass("Virtqueue")
+{
+}
+
+void VirtqueueTestClass::runTests()
+{
+    runTest("AddChain", []()
+    {
+        TestQueue testQueue;
+        Virtqueue& queue = testQueue.get();
+        ASSERT_EQ(queue.getNumFreeDescriptors(), TestQueue::QUEUE_SIZE);
+
+        int head = testQueue.add(3, true);
+        ASSERT_EQ(head, 0);
+        ASSERT_EQ(queue.getNumFreeDescriptors(), TestQueue::QUEUE_SIZE - 3u);
+
+        // the chain is linked through the next flag and published in the
+        // available ring
+        uint16_t descIdx = static_cast<uint16_t>(head);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            ASSERT_EQ(testQueue.getPhysicalAddr(descIdx), 0x1000 * (i + 1));
+
+            uint16_t flags = testQueue.getFlags(descIdx);
+            ASSERT_TRUE((flags & TestQueue::getWriteFlag()) != 0);
+            ASSERT_EQ((flags & TestQueue::getNextFlag()) != 0, i < 2);
+
+            descIdx = testQueue.getNext(descIdx);
+        }
+
+        ASSERT_EQ(testQueue.getAvailIdx(), 1);
+        ASSERT_EQ(testQueue.getAvail(0), 0);
+
+        head = testQueue.add(2, false);
+        ASSERT_EQ(head, 3);
+        ASSERT_EQ(testQueue.getFlags(3), TestQueue::getNextFlag());
+        ASSERT_EQ(testQueue.getFlags(4), 0);
+        ASSERT_EQ(testQueue.getAvailIdx(), 2);
+        ASSERT_EQ(testQueue.getAvail(1), 3);
+    });
+
+    runTest("NotEnoughDescriptors", []()
+    {
+        TestQueue testQueue;
+        Virtqueue& queue = testQueue.get();
+
+        ASSERT_EQ(testQueue.add(0, false), -1);
+        ASSERT_EQ(testQueue.add(6, false), 0);
+        ASSERT_EQ(testQueue.add(3, false), -1);
+
+        // a failed add doesn't change the queue
+        ASSERT_EQ(queue.getNumFreeDescriptors(), 2u);
+        ASSERT_EQ(testQueue.getAvailIdx(), 1);
+    });
+
+    runTest("GetUsed", []()
+    {
+        TestQueue testQueue;
+        Virtqueue& queue = testQueue.get();
+
+        int head1 = testQueue.add(3, false);
+        int head2 = testQueue.add(2, false);
+
+        uint16_t head = 0;
+        ASSERT_FALSE(queue.getUsed(head));
+
+        // chains can complete out of order, and their descriptors are
+        // reused first
+        testQueue.use(static_cast<uint16_t>(head2));
+        ASSERT_TRUE(queue.getUsed(head));
+        ASSERT_EQ(head, head2);
+        ASSERT_EQ(queue.getNumFreeDescriptors(), TestQueue::QUEUE_SIZE - 3u);
+        ASSERT_FALSE(queue.getUsed(head));
+
+        ASSERT_EQ(testQueue.add(1, false), head2);
+
+        testQueue.use(static_cast<uint16_t>(head1));
+        ASSERT_TRUE(queue.getUsed(head));
+        ASSERT_EQ(head, head1);
+        ASSERT_EQ(queue.getNumFreeDescriptors(), TestQueue::QUEUE_SIZE - 1u);
+    });
+
+    runTest("RingWrap", []()
+    {
+        TestQueue testQueue;
+        Virtqueue& queue = testQueue.get();
+
+        // the indexes keep counting up, and wrap around the rings
+        for (uint16_t i = 0; i < 3 * TestQueue::QUEUE_SIZE; ++i)
+        {
+            int head = testQueue.add(2, false);
+            ASSERT_GE(head, 0);
+            ASSERT_EQ(testQueue.getAvailIdx(), i + 1);
+            ASSERT_EQ(testQueue.getAvail(i), head);
+
+            testQueue.use(static_cast<uint16_t>(head));
+            uint16_t usedHead = 0;
+            ASSERT_TRUE(queue.getUsed(usedHead));
+            ASSERT_EQ(usedHead, head);
+            ASSERT_EQ(queue.getNumFreeDescriptors(), TestQueue::QUEUE_SIZE);
+        }
+    });
+
+    runTest("NotifySuppression", []()
+    {
+        TestQueue testQueue;
+        Virtqueue& queue = testQueue.get();
+
+        ASSERT_TRUE(queue.isNotifyNeeded());
+        testQueue.setNoNotify(true);
+        ASSERT_FALSE(queue.isNotifyNeeded());
+        testQueue.setNoNotify(false);
+        ASSERT_TRUE(queue.isNotifyNeeded());
+    });
+}
@@ -0,0 +1,97 @@
+#include "apic.h"
+#include "clock.h"
+#include "cpu.h"
+#include "irq.h"
+#include "kernellock.h"
+#include "system.h"
+#include "waitqueue.h"
+
+void WaitQueue::wait()
+{
+    if (processMgr.isInProcess())
+    {
+        // a process that was woken by something else (e.g. its alarm) may
+        // already be waiting
+        ProcessMgr::ProcessInfo* currentProc = processMgr.getCurrentProcessInfo();
+        if (!waiters.contains(currentProc))
+        {
+            waiters.add(currentProc);
+        }
+        processMgr.blockCurrentProcess();
+        clearInt();
+    }
+    else
+    {
+        // the interrupt may be delivered to another processor, so wakeAll()
+        // sends this one the reschedule IPI
+        unsigned int cpuIdx = Cpu::getCurrent()->index;
+        if (!waitingCpus.contains(cpuIdx))
+        {
+            waitingCpus.add(cpuIdx);
+        }
+
+        // the other processor needs the kernel lock to handle the interrupt
+        bool locked = KernelLock::isHeld();
+        if (locked)
+        {
+            KernelLock::release();
+        }
+
+        // sti only takes effect after hlt, so the interrupt (or the IPI)
+        // can't be missed
+        asm volatile ("sti; hlt; cli");
+
+        if (locked)
+        {
+            KernelLock::acquire();
+        }
+
+        waitingCpus.remove(cpuIdx);
+    }
+}
+
+bool WaitQueue::wait(uint64_t deadlineNs)
+{
+    if (!processMgr.isInProcess())
+    {
+        wait();
+        return Clock::getNs() < deadlineNs;
+    }
+
+    ProcessMgr::ProcessInfo* currentProc = processMgr.getCurrentProcessInfo();
+    currentProc->sleepTimer.start(deadlineNs);
+
+    wait();
+
+    // the timer isn't pending anymore if it woke the process (or if the
+    // process's alarm went off)
+    bool timedOut = !currentProc->sleepTimer.isPending();
+    currentProc->sleepTimer.cancel();
+    if (timedOut)
+    {
+        waiters.remove(currentProc);
+    }
+
+    return !timedOut;
+}
+
+void WaitQueue::wakeAll()
+{
+    for (size_t i = 0; i < waiters.getSize(); ++i)
+    {
+        processMgr.unblockProcess(waiters[i]);
+    }
+
+    waiters.clear();
+
+    unsigned int cpuIdx = Cpu::getCurrent()->index;
+    for (size_t i = 0; i < waitingCpus.getSize(); ++i)
+    {
+        if (waitingCpus[i] != cpuIdx)
+        {
+            Apic::sendFixedIpi(Cpu::get(waitingCpus[i])->apicId, IRQ_START_NUM + IRQ_RESCHEDULE);
+        }
+    }
+
+    waitingCpus.clear();
+}
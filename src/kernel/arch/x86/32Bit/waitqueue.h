@@ -0,0 +1,52 @@
+/**
+ * @brief Wait queue
+ */
+
+#ifndef WAIT_QUEUE_H_
+#define WAIT_QUEUE_H_
+
+#include "processmgr.h"
+#include "set.hpp"
+
+/**
+ * @brief Processes waiting for an event (e.g. an I/O completion interrupt).
+ */
+class WaitQueue
+{
+public:
+    constexpr static size_t MAX_NUM_WAITERS = 32;
+
+    /**
+     * @brief Block the caller until wakeAll() is called.
+     * @details Interrupts must be disabled when calling this, and the caller
+     * must check its wait condition again when this returns. Interrupts are
+     * disabled when this returns. If called outside of a process (e.g.
+     * during boot), this halts the processor until the next interrupt,
+     * letting other processors into the kernel meanwhile; wakeAll() on
+     * another processor interrupts it.
+     */
+    void wait();
+
+    /**
+     * @brief Block the caller until wakeAll() is called or the Clock reaches
+     * a deadline.
+     * @details The same rules apply as for wait().
+     * @param deadlineNs The deadline on the Clock in nanoseconds.
+     * @return false if the deadline passed; true, otherwise
+     */
+    bool wait(uint64_t deadlineNs);
+
+    /**
+     * @brief Wake all waiting processes. Safe to call from an interrupt
+     * handler.
+     */
+    void wakeAll();
+
+private:
+    Set<ProcessMgr::ProcessInfo*, MAX_NUM_WAITERS> waiters;
+
+    /// the indices of the processors waiting outside of a process
+    Set<unsigned int, MadtInfo::MAX_NUM_CPUS> waitingCpus;
+};
+
+#endif // WAIT_QUEUE_H_
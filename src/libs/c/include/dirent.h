@@ -0,0 +1,35 @@
+#ifndef _DIRENT_H
+#define _DIRENT_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define NAME_MAX (31)
+
+struct dirent
+{
+    uint32_t d_ino;
+    char d_name[NAME_MAX + 1];
+};
+
+typedef struct DIR DIR;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int closedir(DIR* dirp);
+
+ssize_t getdents(int fildes, struct dirent* buf, size_t nbyte);
+
+DIR* opendir(const char* dirname);
+
+struct dirent* readdir(DIR* dirp);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _DIRENT_H */
@@ -0,0 +1,33 @@
+#ifndef _ERRNO_H
+#define _ERRNO_H 1
+
+#define EPERM        (1)
+#define ENOENT       (2)
+#define EIO          (5)
+#define ENXIO        (6)
+#define EBADF        (9)
+#define EAGAIN      (11)
+#define EWOULDBLOCK (EAGAIN)
+#define ENOMEM      (12)
+#define EACCES      (13)
+#define ENODEV      (19)
+#define ENOTDIR     (20)
+#define EINVAL      (22)
+#define EMFILE      (24)
+#define ENOTTY      (25)
+#define ENOSPC      (28)
+#define ESPIPE      (29)
+#define ENOSYS      (38)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern int errno;
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _ERRNO_H */
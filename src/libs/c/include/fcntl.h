@@ -9,11 +9,21 @@
 
 #define O_ACCMODE (O_RDONLY | O_WRONLY | O_RDWR | O_EXEC | O_SEARCH)
 
+#define O_APPEND (0x08)
+#define O_CREAT  (0x10)
+#define O_TRUNC  (0x20)
+#define O_NONBLOCK (0x40)
+
+#define F_GETFL (1)
+#define F_SETFL (2)
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+int fcntl(int fildes, int cmd, ...);
+
 int open(const char* path, int oflag, ...);
 
 #ifdef __cplusplus
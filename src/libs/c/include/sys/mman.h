@@ -0,0 +1,32 @@
+#ifndef _MMAN_H
+#define _MMAN_H 1
+
+#include <stddef.h>
+
+#define PROT_NONE  (0x0)
+#define PROT_READ  (0x1)
+#define PROT_WRITE (0x2)
+#define PROT_EXEC  (0x4)
+
+#define MAP_SHARED  (0x1)
+#define MAP_PRIVATE (0x2)
+#define MAP_FIXED   (0x4)
+
+#define MAP_FAILED ((void*)-1)
+
+typedef long off_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+void* mmap(void* addr, size_t len, int prot, int flags, int fildes, off_t off);
+
+int munmap(void* addr, size_t len);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _MMAN_H */
@@ -0,0 +1,18 @@
+#ifndef _SENDFILE_H
+#define _SENDFILE_H 1
+
+#include <stddef.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _SENDFILE_H */
@@ -0,0 +1,35 @@
+#ifndef _STAT_H
+#define _STAT_H 1
+
+#define S_IFMT  (0xF000)
+#define S_IFCHR (0x2000)
+#define S_IFREG (0x8000)
+
+#define S_IRUSR (0400)
+#define S_IWUSR (0200)
+#define S_IXUSR (0100)
+
+#define S_ISCHR(m) (((m) & S_IFMT) == S_IFCHR)
+#define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
+
+typedef unsigned int mode_t;
+typedef long off_t;
+
+struct stat
+{
+    mode_t st_mode;
+    off_t st_size;
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int fstat(int fildes, struct stat* buf);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _STAT_H */
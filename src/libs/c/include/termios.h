@@ -0,0 +1,46 @@
+#ifndef _TERMIOS_H
+#define _TERMIOS_H 1
+
+typedef unsigned int tcflag_t;
+typedef unsigned char cc_t;
+
+#define VEOF   (0)
+#define VERASE (1)
+#define VKILL  (2)
+#define VMIN   (3)
+#define VTIME  (4)
+#define NCCS   (5)
+
+#define ICRNL (0x01)
+
+#define ECHO   (0x01)
+#define ECHOE  (0x02)
+#define ICANON (0x04)
+
+#define TCSANOW   (0)
+#define TCSADRAIN (1)
+#define TCSAFLUSH (2)
+
+struct termios
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_cc[NCCS];
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int tcgetattr(int fildes, struct termios* termios_p);
+
+int tcsetattr(int fildes, int optional_actions, const struct termios* termios_p);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _TERMIOS_H */
@@ -0,0 +1,28 @@
+#ifndef _TIME_H
+#define _TIME_H 1
+
+#define CLOCK_MONOTONIC (1)
+
+typedef long long time_t;
+typedef int clockid_t;
+
+struct timespec
+{
+    time_t tv_sec;
+    long tv_nsec;
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+int clock_gettime(clockid_t clock_id, struct timespec* tp);
+
+int nanosleep(const struct timespec* rqtp, struct timespec* rmtp);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* _TIME_H */
@@ -5,15 +5,22 @@
 #define STDOUT_FILENO (1)
 #define STDERR_FILENO (2)
 
+#define SEEK_SET (0)
+#define SEEK_CUR (1)
+#define SEEK_END (2)
+
 typedef int pid_t;
 typedef __SIZE_TYPE__ size_t;
 typedef long ssize_t;
+typedef long off_t;
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+unsigned int alarm(unsigned int seconds);
+
 int close(int fildes);
 
 int dup(int fildes);
@@ -30,8 +37,16 @@ pid_t getpid();
 
 pid_t getppid();
 
+off_t lseek(int fildes, off_t offset, int whence);
+
+ssize_t pread(int fildes, void* buf, size_t nbyte, off_t offset);
+
 ssize_t read(int fildes, void* buf, size_t nbyte);
 
+unsigned int sleep(unsigned int seconds);
+
+int unlink(const char* path);
+
 ssize_t write(int fildes, const void* buf, size_t nbyte);
 
 #ifdef __cplusplus
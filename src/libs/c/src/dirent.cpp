@@ -0,0 +1,91 @@
+#include "dirent.h"
+#include "fcntl.h"
+#include "unistd.h"
+
+#include "systemcall.h"
+
+struct DIR
+{
+    static constexpr size_t MAX_NUM_ENTRIES = 16;
+
+    bool isOpen;
+    int fildes;
+
+    /// entries read from the directory by the last getdents call
+    struct dirent entries[MAX_NUM_ENTRIES];
+    size_t numEntries;
+    size_t entryIdx;
+};
+
+namespace
+{
+
+constexpr size_t MAX_NUM_DIRS = 2;
+DIR dirs[MAX_NUM_DIRS];
+
+} // namespace
+
+extern "C"
+{
+
+int closedir(DIR* dirp)
+{
+    dirp->isOpen = false;
+    return close(dirp->fildes);
+}
+
+ssize_t getdents(int fildes, struct dirent* buf, size_t nbyte)
+{
+    return checkError<ssize_t>(systemCall(SYSTEM_CALL_GETDENTS, fildes, buf, nbyte));
+}
+
+DIR* opendir(const char* dirname)
+{
+    DIR* dirp = nullptr;
+    for (size_t i = 0; i < MAX_NUM_DIRS && dirp == nullptr; ++i)
+    {
+        if (!dirs[i].isOpen)
+        {
+            dirp = &dirs[i];
+        }
+    }
+
+    if (dirp == nullptr)
+    {
+        return nullptr;
+    }
+
+    int fildes = open(dirname, O_RDONLY);
+    if (fildes < 0)
+    {
+        return nullptr;
+    }
+
+    dirp->isOpen = true;
+    dirp->fildes = fildes;
+    dirp->numEntries = 0;
+    dirp->entryIdx = 0;
+
+    return dirp;
+}
+
+struct dirent* readdir(DIR* dirp)
+{
+    // read the next batch of entries when all of the previous ones have been
+    // returned
+    if (dirp->entryIdx >= dirp->numEntries)
+    {
+        ssize_t numBytes = getdents(dirp->fildes, dirp->entries, sizeof(dirp->entries));
+        if (numBytes <= 0)
+        {
+            return nullptr;
+        }
+
+        dirp->numEntries = numBytes / sizeof(struct dirent);
+        dirp->entryIdx = 0;
+    }
+
+    return &dirp->entries[dirp->entryIdx++];
+}
+
+} // extern "C"
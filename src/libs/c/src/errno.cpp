@@ -0,0 +1,8 @@
+#include "errno.h"
+
+extern "C"
+{
+
+int errno = 0;
+
+} // extern "C"
@@ -1,13 +1,28 @@
 #include "fcntl.h"
+#include "stdarg.h"
 
 #include "systemcall.h"
 
 extern "C"
 {
 
+int fcntl(int fildes, int cmd, ...)
+{
+    int arg = 0;
+    if (cmd == F_SETFL)
+    {
+        va_list args;
+        va_start(args, cmd);
+        arg = va_arg(args, int);
+        va_end(args);
+    }
+
+    return checkError<int>(systemCall(SYSTEM_CALL_FCNTL, fildes, cmd, arg));
+}
+
 int open(const char* path, int oflag, ...)
 {
-    return systemCall(SYSTEM_CALL_OPEN, path, oflag);
+    return checkError<int>(systemCall(SYSTEM_CALL_OPEN, path, oflag));
 }
 
 } // extern "C"
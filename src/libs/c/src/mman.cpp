@@ -0,0 +1,19 @@
+#include "sys/mman.h"
+#include "systemcall.h"
+
+extern "C"
+{
+
+void* mmap(void* addr, size_t len, int prot, int flags, int fildes, off_t off)
+{
+    // an error is returned as MAP_FAILED, which is -1
+    intptr_t rv = checkError<intptr_t>(systemCall(SYSTEM_CALL_MMAP, addr, len, prot, flags, fildes, off));
+    return reinterpret_cast<void*>(rv);
+}
+
+int munmap(void* addr, size_t len)
+{
+    return checkError<int>(systemCall(SYSTEM_CALL_MUNMAP, addr, len));
+}
+
+} // extern "C"
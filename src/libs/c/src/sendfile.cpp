@@ -0,0 +1,12 @@
+#include "sys/sendfile.h"
+#include "systemcall.h"
+
+extern "C"
+{
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    return checkError<ssize_t>(systemCall(SYSTEM_CALL_SENDFILE, out_fd, in_fd, offset, count));
+}
+
+} // extern "C"
@@ -0,0 +1,12 @@
+#include "sys/stat.h"
+#include "systemcall.h"
+
+extern "C"
+{
+
+int fstat(int fildes, struct stat* buf)
+{
+    return checkError<int>(systemCall(SYSTEM_CALL_FSTAT, fildes, buf));
+}
+
+} // extern "C"
@@ -1,6 +1,7 @@
 #ifndef SYSTEM_CALLS_H_
 #define SYSTEM_CALLS_H_
 
+#include "errno.h"
 #include "stdint.h"
 
 const uint32_t SYSTEM_CALL_WRITE            =  0;
@@ -12,13 +13,25 @@ const uint32_t SYSTEM_CALL_SCHED_YIELD      =  5;
 const uint32_t SYSTEM_CALL_GETPPID          =  6;
 const uint32_t SYSTEM_CALL_WAITPID          =  7;
 const uint32_t SYSTEM_CALL_EXECV            =  8;
-const uint32_t SYSTEM_CALL_GET_NUM_MODULES  =  9;
-const uint32_t SYSTEM_CALL_GET_MODULE_NAME  = 10;
 const uint32_t SYSTEM_CALL_RUN_KERNEL_TESTS = 11;
 const uint32_t SYSTEM_CALL_OPEN             = 12;
 const uint32_t SYSTEM_CALL_CLOSE            = 13;
 const uint32_t SYSTEM_CALL_DUP              = 14;
 const uint32_t SYSTEM_CALL_DUP2             = 15;
+const uint32_t SYSTEM_CALL_MMAP             = 16;
+const uint32_t SYSTEM_CALL_MUNMAP           = 17;
+const uint32_t SYSTEM_CALL_LSEEK            = 18;
+const uint32_t SYSTEM_CALL_PREAD            = 19;
+const uint32_t SYSTEM_CALL_FSTAT            = 20;
+const uint32_t SYSTEM_CALL_UNLINK           = 21;
+const uint32_t SYSTEM_CALL_SENDFILE         = 22;
+const uint32_t SYSTEM_CALL_FCNTL            = 23;
+const uint32_t SYSTEM_CALL_GETDENTS         = 24;
+const uint32_t SYSTEM_CALL_TCGETATTR        = 25;
+const uint32_t SYSTEM_CALL_TCSETATTR        = 26;
+const uint32_t SYSTEM_CALL_CLOCK_GETTIME    = 27;
+const uint32_t SYSTEM_CALL_NANOSLEEP        = 28;
+const uint32_t SYSTEM_CALL_ALARM            = 29;
 
 extern "C"
 uint32_t systemCallNumArgs(uint32_t sysCallNum, uint32_t numArgs, ...);
@@ -29,4 +42,22 @@ uint32_t systemCall(uint32_t sysCallNum, Ts... ts)
     return systemCallNumArgs(sysCallNum, sizeof...(ts), ts...);
 }
 
+/**
+ * @brief Convert a system call's return value to the libc convention.
+ * @details System calls that report why they failed return the negated
+ * error number. This stores it in errno and returns -1 instead.
+ */
+template<typename T>
+T checkError(uint32_t rc)
+{
+    T value = static_cast<T>(rc);
+    if (value < 0)
+    {
+        errno = -value;
+        value = -1;
+    }
+
+    return value;
+}
+
 #endif // SYSTEM_CALLS_H_
@@ -0,0 +1,18 @@
+#include "termios.h"
+
+#include "systemcall.h"
+
+extern "C"
+{
+
+int tcgetattr(int fildes, struct termios* termios_p)
+{
+    return checkError<int>(systemCall(SYSTEM_CALL_TCGETATTR, fildes, termios_p));
+}
+
+int tcsetattr(int fildes, int optional_actions, const struct termios* termios_p)
+{
+    return checkError<int>(systemCall(SYSTEM_CALL_TCSETATTR, fildes, optional_actions, termios_p));
+}
+
+} // extern "C"
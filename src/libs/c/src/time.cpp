@@ -0,0 +1,18 @@
+#include "time.h"
+
+#include "systemcall.h"
+
+extern "C"
+{
+
+int clock_gettime(clockid_t clock_id, struct timespec* tp)
+{
+    return checkError<int>(systemCall(SYSTEM_CALL_CLOCK_GETTIME, clock_id, tp));
+}
+
+int nanosleep(const struct timespec* rqtp, struct timespec* rmtp)
+{
+    return checkError<int>(systemCall(SYSTEM_CALL_NANOSLEEP, rqtp, rmtp));
+}
+
+} // extern "C"
@@ -1,4 +1,5 @@
 #include "stdarg.h"
+#include "time.h"
 #include "unistd.h"
 
 #include "systemcall.h"
@@ -6,6 +7,11 @@
 extern "C"
 {
 
+unsigned int alarm(unsigned int seconds)
+{
+    return systemCall(SYSTEM_CALL_ALARM, seconds);
+}
+
 int close(int fildes)
 {
     return systemCall(SYSTEM_CALL_CLOSE, fildes);
@@ -72,21 +78,50 @@ pid_t getppid()
     return systemCall(SYSTEM_CALL_GETPPID);
 }
 
+off_t lseek(int fildes, off_t offset, int whence)
+{
+    return checkError<off_t>(systemCall(SYSTEM_CALL_LSEEK, fildes, offset, whence));
+}
+
+ssize_t pread(int fildes, void* buf, size_t nbyte, off_t offset)
+{
+    ssize_t rc = checkError<ssize_t>(systemCall(SYSTEM_CALL_PREAD,
+                                                fildes,
+                                                buf,
+                                                nbyte,
+                                                offset));
+    return rc;
+}
+
 ssize_t read(int fildes, void* buf, size_t nbyte)
 {
-    ssize_t rc = systemCall(SYSTEM_CALL_READ,
-                            fildes,
-                            buf,
-                            nbyte);
+    ssize_t rc = checkError<ssize_t>(systemCall(SYSTEM_CALL_READ,
+                                                fildes,
+                                                buf,
+                                                nbyte));
     return rc;
 }
 
+unsigned int sleep(unsigned int seconds)
+{
+    timespec duration = {seconds, 0};
+    timespec remaining = {0, 0};
+    nanosleep(&duration, &remaining);
+
+    return static_cast<unsigned int>(remaining.tv_sec);
+}
+
+int unlink(const char* path)
+{
+    return checkError<int>(systemCall(SYSTEM_CALL_UNLINK, path));
+}
+
 ssize_t write(int fildes, const void* buf, size_t nbyte)
 {
-    ssize_t rc = systemCall(SYSTEM_CALL_WRITE,
-                            fildes,
-                            buf,
-                            nbyte);
+    ssize_t rc = checkError<ssize_t>(systemCall(SYSTEM_CALL_WRITE,
+                                                fildes,
+                                                buf,
+                                                nbyte));
     return rc;
 }
 
@@ -1,7 +1,25 @@
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
 
+/**
+ * @brief Copy the rest of a file through a buffer.
+ */
+void copyFile(int infd, int outfd)
+{
+    constexpr size_t BUFF_SIZE = 512;
+    char buff[BUFF_SIZE];
+
+    ssize_t numRead = read(infd, buff, BUFF_SIZE);
+    while (numRead > 0)
+    {
+        write(outfd, buff, numRead);
+
+        numRead = read(infd, buff, BUFF_SIZE);
+    }
+}
+
 bool writeFile(const char* filename, int outfd)
 {
     bool ok = false;
@@ -13,15 +31,20 @@ bool writeFile(const char* filename, int outfd)
     }
     else
     {
-        constexpr size_t BUFF_SIZE = 512;
-        char buff[BUFF_SIZE];
+        // let the kernel copy the file without going through a user buffer
+        constexpr size_t CHUNK_SIZE = 64 * 1024;
 
-        ssize_t numRead = read(infd, buff, BUFF_SIZE);
-        while (numRead > 0)
+        ssize_t numSent = sendfile(outfd, infd, nullptr, CHUNK_SIZE);
+        while (numSent > 0)
         {
-            write(outfd, buff, numRead);
+            numSent = sendfile(outfd, infd, nullptr, CHUNK_SIZE);
+        }
 
-            numRead = read(infd, buff, BUFF_SIZE);
+        // sendfile doesn't work with every pair of streams, so copy the
+        // rest the usual way
+        if (numSent < 0)
+        {
+            copyFile(infd, outfd);
         }
 
         close(infd);
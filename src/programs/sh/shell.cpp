@@ -1,9 +1,9 @@
 #include <ctype.h>
-#include "os.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
 #include "sys/wait.h"
+#include "termios.h"
 #include "unistd.h"
 
 #include "shell.h"
@@ -11,10 +11,17 @@
 const char ESCAPE = '\x1b';
 const char DELETE = '\x7f';
 
-Shell::Commands::iterator::iterator(int builtInIndex, int moduleIndex)
+Shell::Commands::iterator::iterator(DIR* moduleDir, int builtInIndex)
 {
+    dir = moduleDir;
     builtInIdx = builtInIndex;
-    moduleIdx = moduleIndex;
+    moduleEntry = nullptr;
+
+    // the modules start after the built-in commands
+    if (dir != nullptr && builtInIdx >= Shell::NUM_BUILT_IN_COMMANDS)
+    {
+        moduleEntry = readdir(dir);
+    }
 }
 
 Shell::Commands::iterator Shell::Commands::iterator::operator++()
@@ -22,10 +29,14 @@ Shell::Commands::iterator Shell::Commands::iterator::operator++()
     if (builtInIdx < Shell::NUM_BUILT_IN_COMMANDS)
     {
         ++builtInIdx;
+        if (builtInIdx == Shell::NUM_BUILT_IN_COMMANDS && dir != nullptr)
+        {
+            moduleEntry = readdir(dir);
+        }
     }
-    else if (moduleIdx < getNumModules())
+    else if (moduleEntry != nullptr)
     {
-        ++moduleIdx;
+        moduleEntry = readdir(dir);
     }
 
     return *this;
@@ -37,10 +48,9 @@ const char* Shell::Commands::iterator::operator*()
     {
         return Shell::BUILT_IN_COMMANDS[builtInIdx];
     }
-    else if (moduleIdx < getNumModules())
+    else if (moduleEntry != nullptr)
     {
-        getModuleName(moduleIdx, moduleName);
-        return moduleName;
+        return moduleEntry->d_name;
     }
     else
     {
@@ -50,7 +60,7 @@ const char* Shell::Commands::iterator::operator*()
 
 bool Shell::Commands::iterator::operator==(const Shell::Commands::iterator& other) const
 {
-    return builtInIdx == other.builtInIdx && moduleIdx == other.moduleIdx;
+    return builtInIdx == other.builtInIdx && moduleEntry == other.moduleEntry;
 }
 
 bool Shell::Commands::iterator::operator!=(const Shell::Commands::iterator& other) const
@@ -58,14 +68,26 @@ bool Shell::Commands::iterator::operator!=(const Shell::Commands::iterator& othe
     return !(*this == other);
 }
 
+Shell::Commands::Commands()
+{
+    dir = nullptr;
+}
+
 Shell::Commands::iterator Shell::Commands::begin()
 {
-    return iterator();
+    // reopen the directory, so the modules are read from the start
+    if (dir != nullptr)
+    {
+        closedir(dir);
+    }
+    dir = opendir("/");
+
+    return iterator(dir);
 }
 
 Shell::Commands::iterator Shell::Commands::end()
 {
-    return iterator(Shell::NUM_BUILT_IN_COMMANDS, getNumModules());
+    return iterator(nullptr, Shell::NUM_BUILT_IN_COMMANDS);
 }
 
 const char* Shell::BUILT_IN_COMMANDS[] =
@@ -178,6 +200,19 @@ void Shell::getCommand()
 {
     printf("%s", Shell::PROMPT);
 
+    // the shell edits the command itself, so read keys as they are typed
+    // without the terminal echoing them, and restore the terminal's mode
+    // for the command
+    termios savedAttribs;
+    bool isTerminal = (tcgetattr(STDIN_FILENO, &savedAttribs) == 0);
+    if (isTerminal)
+    {
+        termios rawAttribs = savedAttribs;
+        rawAttribs.c_lflag &= ~(ICANON | ECHO);
+        rawAttribs.c_cc[VMIN] = 1;
+        tcsetattr(STDIN_FILENO, TCSANOW, &rawAttribs);
+    }
+
     // reset history index
     historyIdx = 0;
 
@@ -247,6 +282,11 @@ void Shell::getCommand()
         key = getchar();
     }
 
+    if (isTerminal)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &savedAttribs);
+    }
+
     putchar('\n');
 }
 
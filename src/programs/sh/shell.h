@@ -1,6 +1,7 @@
 #ifndef SHELL_H_
 #define SHELL_H_
 
+#include <dirent.h>
 #include <stddef.h>
 
 class Shell
@@ -25,7 +26,7 @@ private:
         class iterator
         {
         public:
-            iterator(int builtInIndex = 0, int moduleIndex = 0);
+            iterator(DIR* moduleDir = nullptr, int builtInIndex = 0);
 
             iterator operator++();
 
@@ -35,14 +36,23 @@ private:
 
             bool operator!=(const iterator& other) const;
         private:
+            DIR* dir;
             int builtInIdx;
-            int moduleIdx;
-            char moduleName[Shell::MAX_CMD_SIZE];
+
+            /// the current module's directory entry, or nullptr after the
+            /// last module
+            const dirent* moduleEntry;
         };
 
+        Commands();
+
         iterator begin();
 
         iterator end();
+
+    private:
+        /// the root directory, which the modules are read from
+        DIR* dir;
     } commands;
 
     char cmd[MAX_CMD_SIZE];
@@ -0,0 +1,23 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int main(int argc, const char* argv[])
+{
+    if (argc != 2)
+    {
+        printf("Usage: sleep <seconds>\n");
+        return 1;
+    }
+
+    int seconds = atoi(argv[1]);
+    if (seconds < 0)
+    {
+        printf("Invalid number of seconds: %s\n", argv[1]);
+        return 1;
+    }
+
+    sleep(static_cast<unsigned int>(seconds));
+
+    return 0;
+}
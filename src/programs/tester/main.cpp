@@ -169,17 +169,16 @@ int getNumber(const char* prompt)
 {
     printf("%s", prompt);
 
+    // the terminal echoes the line and returns it once it is complete
     char ch;
     char str[32];
     char* ptr = str;
-    for (int i = 0; i < 32; ++i)
+    for (int i = 0; i < 31; ++i)
     {
         ch = getchar();
-        putchar(ch);
 
-        if (ch == '\r')
+        if (ch == '\n')
         {
-            putchar('\n');
             break;
         }
         else
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+
+# Create an initrd archive that the kernel's InitrdFileSystem can read.
+#
+# Format (all integers are 32-bit little-endian):
+#   header:    magic ('INRD'), version, number of files, reserved
+#   directory: one entry per file sorted by name, each with a
+#              NUL-padded 32-byte name, the file's offset from the start
+#              of the archive, and the file's size
+#   bodies:    each file's data starting on a page boundary
+
+import os, struct, sys
+
+MAGIC = b'INRD'
+VERSION = 1
+PAGE_SIZE = 4096
+MAX_NAME_SIZE = 32
+
+HEADER_FORMAT = '<4sIII'
+DIR_ENTRY_FORMAT = '<{}sII'.format(MAX_NAME_SIZE)
+
+def alignPage(value):
+    return (value + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1)
+
+def createInitrd(outputPath, inputPaths):
+    files = []
+    for path in inputPaths:
+        name = os.path.basename(path).encode('ascii')
+
+        # leave room for the NUL terminator
+        if len(name) >= MAX_NAME_SIZE:
+            print('Error: file name is too long: {}'.format(path))
+            sys.exit(1)
+
+        with open(path, 'rb') as f:
+            files.append((name, f.read()))
+
+    # the kernel does a binary search on the names, so they must be in
+    # the same order as strcmp()
+    files.sort(key=lambda file: file[0])
+
+    for prev, curr in zip(files, files[1:]):
+        if prev[0] == curr[0]:
+            print('Error: duplicate file name: {}'.format(curr[0].decode('ascii')))
+            sys.exit(1)
+
+    dirSize = struct.calcsize(HEADER_FORMAT) + len(files) * struct.calcsize(DIR_ENTRY_FORMAT)
+
+    # lay out the bodies on page boundaries after the directory
+    offsets = []
+    offset = alignPage(dirSize)
+    for name, data in files:
+        offsets.append(offset)
+        offset = alignPage(offset + len(data))
+
+    with open(outputPath, 'wb') as out:
+        out.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(files), 0))
+
+        for (name, data), offset in zip(files, offsets):
+            out.write(struct.pack(DIR_ENTRY_FORMAT, name, offset, len(data)))
+
+        for (name, data), offset in zip(files, offsets):
+            out.write(b'\0' * (offset - out.tell()))
+            out.write(data)
+
+def parseArgs():
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-o', '--output', required=True, help='the initrd file to create')
+    parser.add_argument('files', nargs='+', help='the files to add to the initrd')
+
+    args = parser.parse_args()
+    return args
+
+def main():
+    args = parseArgs()
+    createInitrd(args.output, args.files)
+
+if __name__ == '__main__':
+    main()
@@ -71,13 +71,15 @@ def waitForPrompt(qemuProc, timeout):
         p.terminate()
         raise PromptTimeoutExpired()
 
-def runQemu(logFilename):
+def runQemu(logFilename, numCpus):
     scriptDir = os.path.dirname(__file__)
     isoPath = os.path.join(scriptDir, '..', 'bin', 'OS-x86.iso')
     isoPath = os.path.abspath(isoPath)
 
     qemu = 'qemu-system-i386'
     cmd = [qemu, '-nographic', '-serial', 'mon:stdio', '-serial', 'file:{}'.format(logFilename), '-cdrom', isoPath]
+    if numCpus is not None:
+        cmd += ['-smp', str(numCpus)]
 
     proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
 
@@ -187,6 +189,7 @@ def parseArgs():
 
     parser = argparse.ArgumentParser()
     parser.add_argument('-o', '--output', default=None, help='the output file for test results')
+    parser.add_argument('--smp', type=int, default=None, help='the number of processors QEMU emulates')
 
     args = parser.parse_args()
     return args
@@ -197,7 +200,7 @@ def main():
     rc = RC_SUCCESS
     logFilename = 'kernel-x86.log'
 
-    runSuccessful = runQemu(logFilename)
+    runSuccessful = runQemu(logFilename, args.smp)
 
     testSuite = parseLog(logFilename)
     if args.output is None: